@@ -0,0 +1,259 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  clockjitter.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+//---------------------------------------------------------
+//   muse_clock_jitter
+//    Records midi clock through a jack midi input port,
+//     timestamps every clock with its jack frame and reports
+//     how evenly the clocks were spaced.
+//    Connect MusE's clock output to it, directly or through
+//     a hardware loopback cable, and start the transport.
+//---------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <signal.h>
+#include <math.h>
+#include <stdint.h>
+
+#include <vector>
+#include <algorithm>
+
+#include <jack/jack.h>
+#include <jack/midiport.h>
+#include <jack/ringbuffer.h>
+
+struct ClockStamp
+{
+      jack_nframes_t frame;
+      unsigned char type;
+};
+
+static jack_client_t* client;
+static jack_port_t* inPort;
+static jack_ringbuffer_t* ring;
+static volatile sig_atomic_t quit = 0;
+static volatile int lost = 0;
+
+//---------------------------------------------------------
+//   process
+//    Jack process thread.
+//---------------------------------------------------------
+
+static int process(jack_nframes_t nframes, void*)
+      {
+      void* buf = jack_port_get_buffer(inPort, nframes);
+      const jack_nframes_t base = jack_last_frame_time(client);
+      const jack_nframes_t n = jack_midi_get_event_count(buf);
+      for (jack_nframes_t i = 0; i < n; ++i) {
+            jack_midi_event_t ev;
+            if (jack_midi_event_get(&ev, buf, i) != 0 || ev.size == 0)
+                  continue;
+            const unsigned char type = ev.buffer[0];
+            // Clock, start, continue and stop.
+            if (type != 0xf8 && type != 0xfa && type != 0xfb && type != 0xfc)
+                  continue;
+            ClockStamp cs;
+            cs.frame = base + ev.time;
+            cs.type = type;
+            if (jack_ringbuffer_write_space(ring) < sizeof(cs)) {
+                  ++lost;
+                  continue;
+                  }
+            jack_ringbuffer_write(ring, (const char*)&cs, sizeof(cs));
+            }
+      return 0;
+      }
+
+//---------------------------------------------------------
+//   signalHandler
+//---------------------------------------------------------
+
+static void signalHandler(int)
+      {
+      quit = 1;
+      }
+
+//---------------------------------------------------------
+//   percentile
+//    Of a sorted list.
+//---------------------------------------------------------
+
+static double percentile(const std::vector<double>& v, double p)
+      {
+      if (v.empty())
+            return 0.0;
+      size_t idx = (size_t)(p * (v.size() - 1) + 0.5);
+      if (idx >= v.size())
+            idx = v.size() - 1;
+      return v[idx];
+      }
+
+//---------------------------------------------------------
+//   report
+//---------------------------------------------------------
+
+static void report(const std::vector<double>& intervals, double sampleRate, double bpm)
+      {
+      const size_t n = intervals.size();
+      if (n == 0) {
+            printf("No clock intervals recorded\n");
+            return;
+            }
+      const double toMs = 1000.0 / sampleRate;
+
+      double sum = 0.0;
+      double minIv = intervals[0];
+      double maxIv = intervals[0];
+      for (size_t i = 0; i < n; ++i) {
+            sum += intervals[i];
+            if (intervals[i] < minIv)
+                  minIv = intervals[i];
+            if (intervals[i] > maxIv)
+                  maxIv = intervals[i];
+            }
+      const double mean = sum / n;
+
+      // Deviation from the expected interval if the tempo is known, otherwise from the mean.
+      const double ref = bpm > 0.0 ? sampleRate * 60.0 / (bpm * 24.0) : mean;
+      double var = 0.0;
+      std::vector<double> dev(n);
+      for (size_t i = 0; i < n; ++i) {
+            const double d = intervals[i] - mean;
+            var += d * d;
+            dev[i] = fabs(intervals[i] - ref);
+            }
+      std::sort(dev.begin(), dev.end());
+
+      printf("clocks:             %zu (%zu intervals)\n", n + 1, n);
+      printf("mean interval:      %.3f frames  %.4f ms\n", mean, mean * toMs);
+      printf("implied tempo:      %.4f bpm\n", sampleRate * 60.0 / (mean * 24.0));
+      printf("std deviation:      %.3f frames  %.4f ms\n", sqrt(var / n), sqrt(var / n) * toMs);
+      printf("min/max interval:   %.0f / %.0f frames\n", minIv, maxIv);
+      printf("deviation from %s: p50 %.3f  p99 %.3f  max %.3f frames (max %.4f ms)\n",
+             bpm > 0.0 ? "expected" : "mean",
+             percentile(dev, 0.5), percentile(dev, 0.99), dev[n - 1], dev[n - 1] * toMs);
+      if (bpm > 0.0)
+            printf("drift:              %.3f frames over %zu clocks (%.2f ppm)\n",
+                   sum - ref * n, n, (sum - ref * n) / (ref * n) * 1000000.0);
+      if (lost)
+            printf("lost:               %d events, ring buffer full\n", (int)lost);
+      }
+
+//---------------------------------------------------------
+//   usage
+//---------------------------------------------------------
+
+static void usage(const char* prog)
+      {
+      fprintf(stderr, "usage: %s [-c source port] [-n clocks] [-t bpm]\n"
+                      "   -c port   connect the input to this jack midi port\n"
+                      "   -n clocks stop after this many clocks, default until interrupted\n"
+                      "   -t bpm    the transport tempo, to report the error against it\n", prog);
+      }
+
+//---------------------------------------------------------
+//   main
+//---------------------------------------------------------
+
+int main(int argc, char* argv[])
+      {
+      const char* source = 0;
+      long count = 0;
+      double bpm = 0.0;
+      int c;
+      while ((c = getopt(argc, argv, "c:n:t:h")) != EOF) {
+            switch (c) {
+                  case 'c':
+                        source = optarg;
+                        break;
+                  case 'n':
+                        count = atol(optarg);
+                        break;
+                  case 't':
+                        bpm = atof(optarg);
+                        break;
+                  case 'h':
+                  default:
+                        usage(argv[0]);
+                        return 1;
+                  }
+            }
+
+      client = jack_client_open("muse_clock_jitter", JackNoStartServer, NULL);
+      if (!client) {
+            fprintf(stderr, "cannot connect to the jack server\n");
+            return 1;
+            }
+      inPort = jack_port_register(client, "clock_in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+      ring = jack_ringbuffer_create(4096 * sizeof(ClockStamp));
+      if (!inPort || !ring) {
+            fprintf(stderr, "cannot create the input port\n");
+            jack_client_close(client);
+            return 1;
+            }
+      jack_set_process_callback(client, process, 0);
+      if (jack_activate(client)) {
+            fprintf(stderr, "cannot activate the client\n");
+            jack_client_close(client);
+            return 1;
+            }
+      if (source && jack_connect(client, source, jack_port_name(inPort)))
+            fprintf(stderr, "cannot connect %s\n", source);
+
+      signal(SIGINT, signalHandler);
+      signal(SIGTERM, signalHandler);
+
+      const double sampleRate = jack_get_sample_rate(client);
+      printf("recording midi clock on %s, ctrl-c to stop\n", jack_port_name(inPort));
+
+      std::vector<double> intervals;
+      if (count > 0)
+            intervals.reserve(count);
+      bool haveLast = false;
+      jack_nframes_t last = 0;
+      while (!quit && (count <= 0 || (long)intervals.size() + 1 < count)) {
+            ClockStamp cs;
+            while (jack_ringbuffer_read_space(ring) >= sizeof(cs)) {
+                  jack_ringbuffer_read(ring, (char*)&cs, sizeof(cs));
+                  if (cs.type != 0xf8) {
+                        // Start, continue or stop. Spacing across it means nothing.
+                        haveLast = false;
+                        continue;
+                        }
+                  if (haveLast)
+                        intervals.push_back(double(jack_nframes_t(cs.frame - last)));
+                  last = cs.frame;
+                  haveLast = true;
+                  }
+            usleep(10000);
+            }
+
+      jack_deactivate(client);
+      jack_client_close(client);
+      jack_ringbuffer_free(ring);
+
+      report(intervals, sampleRate, bpm);
+      return 0;
+      }
@@ -310,13 +310,13 @@ void EvData::setData(const unsigned char* p, int l)
       if (refCount && (--(*refCount) == 0)) 
       {
         delete refCount;
-        refCount = 0;
         
         if(data)
           delete[] data;
       }
-      // Clear the data variable.
+      // Clear the data variable and the reference.
       data = 0;  
+      refCount = 0;
         
       if(l > 0) 
       {
@@ -324,7 +324,7 @@ void EvData::setData(const unsigned char* p, int l)
         memcpy(data, p, l);
         
         // Setting the data destroys any reference. Create a new reference now.
-        refCount = new int(1);
+        refCount = new std::atomic<int>(1);
       }
       dataLen = l;
 }
@@ -339,13 +339,13 @@ void EvData::setData(const SysExInputProcessor* q)
       if (refCount && (--(*refCount) == 0)) 
       {
         delete refCount;
-        refCount = 0;
         
         if(data)
           delete[] data;
       }
-      // Clear the data variable.
+      // Clear the data variable and the reference.
       data = 0;  
+      refCount = 0;
         
       const size_t l = q->size();
       if(l > 0) 
@@ -355,10 +355,42 @@ void EvData::setData(const SysExInputProcessor* q)
         // Copy the non-contiguous chunks of data to the contiguous data.
         q->copy(data, l);
         // Setting the data destroys any reference. Create a new reference now.
-        refCount = new int(1);
+        refCount = new std::atomic<int>(1);
       }
       dataLen = l;
 }
 
+//---------------------------------------------------------
+//   EvDataPool
+//---------------------------------------------------------
+
+EvDataPool::EvDataPool(int buffers, int capacity)
+  : _buffers(buffers), _capacity(capacity), _next(0)
+{
+  std::vector<unsigned char> zero(capacity, 0);
+  for(std::vector<EvData>::iterator i = _buffers.begin(); i != _buffers.end(); ++i)
+    i->setData(zero.data(), capacity);
+}
+
+bool EvDataPool::get(EvData* dst, const unsigned char* p, int l)
+{
+  if(l <= 0 || l > _capacity)
+    return false;
+  const size_t sz = _buffers.size();
+  for(size_t n = 0; n < sz; ++n)
+  {
+    EvData& b = _buffers[_next];
+    _next = (_next + 1) % sz;
+    // Only the pool holds it. Nobody can take a new reference but us.
+    if(b.useCount() != 1)
+      continue;
+    memcpy(b.data, p, l);
+    *dst = b;
+    dst->dataLen = l;
+    return true;
+  }
+  return false;
+}
+
 } // namespace MusECore
 
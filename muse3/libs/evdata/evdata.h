@@ -24,6 +24,9 @@
 #ifndef __EVDATA_H__
 #define __EVDATA_H__
 
+#include <atomic>
+#include <vector>
+
 #include "memory.h"
 
 namespace MusECore {
@@ -36,7 +39,8 @@ class SysExInputProcessor;
 //---------------------------------------------------------
 
 class EvData {
-      int* refCount;
+      // Atomic, since events sharing the data are handed between threads.
+      std::atomic<int>* refCount;
 
    public:
       unsigned char* data;
@@ -88,6 +92,30 @@ class EvData {
             }
       void setData(const unsigned char* p, int l);
       void setData(const SysExInputProcessor* q);
+      // Number of EvData sharing the data. Zero if there is no data.
+      int useCount() const { return refCount ? refCount->load() : 0; }
+      };
+
+//---------------------------------------------------------
+//   EvDataPool
+//    Data buffers for events created in a realtime thread,
+//     allocated up front. The pool keeps a reference to each
+//     buffer, and hands a buffer out again only when no event
+//     shares it any more. So queued events never see their
+//     data change, and the realtime thread never allocates
+//     or frees.
+//---------------------------------------------------------
+
+class EvDataPool {
+      std::vector<EvData> _buffers;
+      int _capacity;
+      size_t _next;
+
+   public:
+      EvDataPool(int buffers, int capacity);
+      // Realtime safe. Points dst at a free buffer holding a copy of p.
+      // Returns false if all buffers are in use or l exceeds the capacity.
+      bool get(EvData* dst, const unsigned char* p, int l);
       };
 
 
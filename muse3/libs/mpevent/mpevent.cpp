@@ -391,6 +391,42 @@ void SeqMPEventList::add(const MidiPlayEvent& ev)
   insert(ev);
 }
 
+//---------------------------------------------------------
+//   MidiRecFifo
+//---------------------------------------------------------
+
+MidiRecFifo::MidiRecFifo(unsigned capacity)
+      {
+      fifo = 0;
+      wIndex = 0;
+      rIndex = 0;
+      _overflows = 0;
+      setCapacity(capacity);
+      }
+
+MidiRecFifo::~MidiRecFifo()
+      {
+      delete[] fifo;
+      }
+
+//---------------------------------------------------------
+//   setCapacity
+//    The capacity is rounded up to a power of two.
+//---------------------------------------------------------
+
+void MidiRecFifo::setCapacity(unsigned capacity)
+      {
+      unsigned cap = 1;
+      while (cap < capacity)
+            cap <<= 1;
+      delete[] fifo;
+      fifo = new MidiRecordEvent[cap];
+      _capacity = cap;
+      _capacityMask = cap - 1;
+      wIndex.store(0);
+      rIndex.store(0);
+      }
+
 //---------------------------------------------------------
 //   put
 //    return true on fifo overflow
@@ -398,13 +434,14 @@ void SeqMPEventList::add(const MidiPlayEvent& ev)
 
 bool MidiRecFifo::put(const MidiRecordEvent& event)
       {
-      if (size < MIDI_REC_FIFO_SIZE) {
-            fifo[wIndex] = event;
-            wIndex = (wIndex + 1) % MIDI_REC_FIFO_SIZE;
-            ++size;
-            return false;
+      const unsigned w = wIndex.load(std::memory_order_relaxed);
+      if (w - rIndex.load(std::memory_order_acquire) >= _capacity) {
+            _overflows.fetch_add(1, std::memory_order_relaxed);
+            return true;
             }
-      return true;
+      fifo[w & _capacityMask] = event;
+      wIndex.store(w + 1, std::memory_order_release);
+      return false;
       }
 
 //---------------------------------------------------------
@@ -413,9 +450,9 @@ bool MidiRecFifo::put(const MidiRecordEvent& event)
 
 MidiRecordEvent MidiRecFifo::get()
       {
-      MidiRecordEvent event(fifo[rIndex]);
-      rIndex = (rIndex + 1) % MIDI_REC_FIFO_SIZE;
-      --size;
+      const unsigned r = rIndex.load(std::memory_order_relaxed);
+      MidiRecordEvent event(fifo[r & _capacityMask]);
+      rIndex.store(r + 1, std::memory_order_release);
       return event;
       }
 
@@ -425,18 +462,16 @@ MidiRecordEvent MidiRecFifo::get()
 
 const MidiRecordEvent& MidiRecFifo::peek(int n)
       {
-      int idx = (rIndex + n) % MIDI_REC_FIFO_SIZE;
-      return fifo[idx];
+      return fifo[(rIndex.load(std::memory_order_relaxed) + n) & _capacityMask];
       }
 
 //---------------------------------------------------------
 //   remove
 //---------------------------------------------------------
 
-void MidiRecFifo::remove()
+void MidiRecFifo::remove(int n)
       {
-      rIndex = (rIndex + 1) % MIDI_REC_FIFO_SIZE;
-      --size;
+      rIndex.store(rIndex.load(std::memory_order_relaxed) + n, std::memory_order_release);
       }
       
 } // namespace MusECore
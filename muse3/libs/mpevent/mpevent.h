@@ -26,6 +26,7 @@
 #define __MPEVENT_H__
 
 #include <set>
+#include <atomic>
 #include "evdata.h"
 #include "memory.h"
 #include <cstddef>
@@ -33,8 +34,10 @@
 // Play events ring buffer size
 #define MIDI_FIFO_SIZE    4096         
 
-// Record events ring buffer size
+// Record events ring buffer size, per channel. Must be a power of two.
 #define MIDI_REC_FIFO_SIZE  256
+// Record events ring buffer size, per channel, for hardware input devices.
+#define MIDI_REC_FIFO_DEVICE_SIZE  4096
 
 namespace MusECore {
 
@@ -162,23 +165,41 @@ class MidiPlayEvent : public MEvent {
 
 //---------------------------------------------------------
 //   MidiRecFifo
+//    Lock free ring buffer. One producer (the driver),
+//     one consumer (the audio thread). The buffer is
+//     allocated up front. Events which do not fit are
+//     dropped and counted.
 //---------------------------------------------------------
 
 class MidiRecFifo {
-      MidiRecordEvent fifo[MIDI_REC_FIFO_SIZE];
-      volatile int size;
-      int wIndex;
-      int rIndex;
+      MidiRecordEvent* fifo;
+      unsigned _capacity;
+      unsigned _capacityMask;
+      // Free running indices.
+      std::atomic<unsigned> wIndex;
+      std::atomic<unsigned> rIndex;
+      std::atomic<unsigned> _overflows;
+
+      MidiRecFifo(const MidiRecFifo&);
+      MidiRecFifo& operator=(const MidiRecFifo&);
 
    public:
-      MidiRecFifo()  { clear(); }
+      MidiRecFifo(unsigned capacity = MIDI_REC_FIFO_SIZE);
+      ~MidiRecFifo();
+      // Not realtime safe. Discards all events. Only call while the device is not being read.
+      void setCapacity(unsigned capacity);
+      unsigned capacity() const { return _capacity; }
       bool put(const MidiRecordEvent& event);   // returns true on fifo overflow
       MidiRecordEvent get();
       const MidiRecordEvent& peek(int = 0);
-      void remove();
-      bool isEmpty() const { return size == 0; }
-      void clear()         { size = 0, wIndex = 0, rIndex = 0; }
-      int getSize() const  { return size; }
+      void remove(int n = 1);
+      bool isEmpty() const { return getSize() == 0; }
+      // Consumer only.
+      void clear()         { rIndex.store(wIndex.load(std::memory_order_acquire), std::memory_order_release); }
+      int getSize() const  { return wIndex.load(std::memory_order_acquire) - rIndex.load(std::memory_order_acquire); }
+      // Number of events dropped because the fifo was full.
+      unsigned overflows() const { return _overflows.load(std::memory_order_relaxed); }
+      void resetOverflows()      { _overflows.store(0, std::memory_order_relaxed); }
       };
 
 //---------------------------------------------------------
@@ -47,6 +47,7 @@ Xml::Xml(FILE* _f)
       {
       f          = _f;
       _destStr   = 0;
+      _destBytes = 0;
       _destIODev = 0;
       _line      = 0;
       _col       = 0;
@@ -63,6 +64,7 @@ Xml::Xml(const char* buf)
       {
       f         = 0;
       _destStr  = 0;
+      _destBytes = 0;
       _destIODev = 0;
       _line     = 0;
       _col      = 0;
@@ -77,6 +79,7 @@ Xml::Xml(const char* buf)
 Xml::Xml(QString* s)
       {
       f         = 0;
+      _destBytes = 0;
       _destIODev = 0;
       _line     = 0;
       _col      = 0;
@@ -94,6 +97,7 @@ Xml::Xml(QIODevice* d)
       {
       f         = 0;
       _destStr   = 0;
+      _destBytes = 0;
       _destIODev = d;
       _line     = 0;
       _col      = 0;
@@ -106,6 +110,22 @@ Xml::Xml(QIODevice* d)
       _majorVersion = -1;
       }
 
+Xml::Xml(QByteArray* ba)
+      {
+      f         = 0;
+      _destStr   = 0;
+      _destIODev = 0;
+      _destBytes = ba;
+      _line     = 0;
+      _col      = 0;
+      level     = 0;
+      inTag     = false;
+      inComment = false;
+      lbuffer[0] = 0;
+      bufptr     = lbuffer;
+      _minorVersion = -1;
+      _majorVersion = -1;
+      }
 
 //---------------------------------------------------------
 //   BEGIN Read functions:
@@ -738,6 +758,74 @@ void Xml::unknown(const char* s)
 //---------------------------------------------------------
 
 
+//---------------------------------------------------------
+//   vbput
+//    printf style output to a FILE or byte array destination.
+//---------------------------------------------------------
+
+void Xml::vbput(const char* format, va_list args)
+      {
+      if(f)
+      {
+        vfprintf(f, format, args);
+        return;
+      }
+      if(!_destBytes)
+        return;
+      char buf[256];
+      va_list args2;
+      va_copy(args2, args);
+      const int n = vsnprintf(buf, sizeof(buf), format, args);
+      if(n >= (int)sizeof(buf))
+      {
+        const int sz = _destBytes->size();
+        _destBytes->resize(sz + n + 1);
+        vsnprintf(_destBytes->data() + sz, n + 1, format, args2);
+        _destBytes->resize(sz + n);
+      }
+      else if(n > 0)
+        _destBytes->append(buf, n);
+      va_end(args2);
+      }
+
+void Xml::bput(const char* format, ...)
+      {
+      va_list args;
+      va_start(args, format);
+      vbput(format, args);
+      va_end(args);
+      }
+
+//---------------------------------------------------------
+//   bputc
+//---------------------------------------------------------
+
+void Xml::bputc(char ch)
+      {
+      if(f)
+        putc(ch, f);
+      else if(_destBytes)
+        _destBytes->append(ch);
+      }
+
+//---------------------------------------------------------
+//   putBytes
+//---------------------------------------------------------
+
+void Xml::putBytes(const QByteArray& ba)
+      {
+      if(ba.isEmpty())
+        return;
+      if(f)
+        fwrite(ba.constData(), 1, ba.size(), f);
+      else if(_destBytes)
+        _destBytes->append(ba);
+      else if(_destIODev)
+        _destIODev->write(ba);
+      else if(_destStr)
+        _destStr->append(QString::fromLatin1(ba));
+      }
+
 //---------------------------------------------------------
 //   header
 //---------------------------------------------------------
@@ -745,8 +833,8 @@ void Xml::unknown(const char* s)
 void Xml::header()
       {
       const char* s = "<?xml version=\"1.0\"?>\n";
-      if(f)
-        fprintf(f, "%s", s);
+      if(writesBytes())
+        bput("%s", s);
       else
       {
         if(_destIODev)
@@ -775,11 +863,11 @@ void Xml::put(const char* format, ...)
       va_list args;
       va_start(args, format);
 
-      if(f)
+      if(writesBytes())
       {
-        vfprintf(f, format, args);
+        vbput(format, args);
         va_end(args);
-        putc('\n', f);
+        bputc('\n');
       }
       else
       {
@@ -798,11 +886,11 @@ void Xml::put(int level, const char* format, ...)
       va_start(args, format);
       putLevel(level);
 
-      if(f)
+      if(writesBytes())
       {
-        vfprintf(f, format, args);
+        vbput(format, args);
         va_end(args);
-        putc('\n', f);
+        bputc('\n');
       }
       else
       {
@@ -825,9 +913,9 @@ void Xml::nput(int level, const char* format, ...)
       va_start(args, format);
       putLevel(level);
 
-      if(f)
+      if(writesBytes())
       {
-        vfprintf(f, format, args);
+        vbput(format, args);
         va_end(args);
       }
       else
@@ -846,9 +934,9 @@ void Xml::nput(const char* format, ...)
       va_list args;
       va_start(args, format);
 
-      if(f)
+      if(writesBytes())
       {
-        vfprintf(f, format, args);
+        vbput(format, args);
         va_end(args);
       }
       else
@@ -872,13 +960,13 @@ void Xml::tag(int level, const char* format, ...)
       va_start(args, format);
       putLevel(level);
 
-      if(f)
+      if(writesBytes())
       {
-        putc('<', f);
-        vfprintf(f, format, args);
+        bputc('<');
+        vbput(format, args);
         va_end(args);
-        putc('>', f);
-        putc('\n', f);
+        bputc('>');
+        bputc('\n');
       }
       else
       {
@@ -901,14 +989,14 @@ void Xml::etag(int level, const char* format, ...)
       va_start(args, format);
       putLevel(level);
 
-      if(f)
+      if(writesBytes())
       {
-        putc('<', f);
-        putc('/', f);
-        vfprintf(f, format, args);
+        bputc('<');
+        bputc('/');
+        vbput(format, args);
         va_end(args);
-        putc('>', f);
-        putc('\n', f);
+        bputc('>');
+        bputc('\n');
       }
       else
       {
@@ -928,6 +1016,11 @@ void Xml::putLevel(int n)
         for (int i = 0; i < n*2; ++i)
               putc(' ', f);
       }
+      else if(_destBytes)
+      {
+        if(n > 0)
+          _destBytes->append(QByteArray(n*2, ' '));
+      }
       else if(_destIODev)
       {
         for (int i = 0; i < n*2; ++i)
@@ -943,9 +1036,9 @@ void Xml::putLevel(int n)
 void Xml::intTag(int level, const char* name, int val)
       {
       putLevel(level);
-      if(f)
+      if(writesBytes())
       {
-        fprintf(f, "<%s>%d</%s>\n", name, val, name);
+        bput("<%s>%d</%s>\n", name, val, name);
       }
       else
       {
@@ -960,9 +1053,9 @@ void Xml::intTag(int level, const char* name, int val)
 void Xml::uintTag(int level, const char* name, unsigned int val)
       {
       putLevel(level);
-      if(f)
+      if(writesBytes())
       {
-        fprintf(f, "<%s>%u</%s>\n", name, val, name);
+        bput("<%s>%u</%s>\n", name, val, name);
       }
       else
       {
@@ -977,9 +1070,9 @@ void Xml::uintTag(int level, const char* name, unsigned int val)
 void Xml::longLongTag(int level, const char* name, long long val)
       {
       putLevel(level);
-      if(f)
+      if(writesBytes())
       {
-        fprintf(f, "<%s>%lld</%s>\n", name, val, name);
+        bput("<%s>%lld</%s>\n", name, val, name);
       }
       else
       {
@@ -994,9 +1087,9 @@ void Xml::longLongTag(int level, const char* name, long long val)
 void Xml::uLongLongTag(int level, const char* name, unsigned long long val)
       {
       putLevel(level);
-      if(f)
+      if(writesBytes())
       {
-        fprintf(f, "<%s>%llu</%s>\n", name, val, name);
+        bput("<%s>%llu</%s>\n", name, val, name);
       }
       else
       {
@@ -1011,13 +1104,13 @@ void Xml::uLongLongTag(int level, const char* name, unsigned long long val)
 void Xml::floatTag(int level, const char* name, float val)
       {
       putLevel(level);
-      if(f)
+      if(writesBytes())
       {
         // using QString to format decimal values since we know that
         // toLatin1 will make a string with decimal point instead of
         // decimal comma that some locales use
         QString s("<%1>%2</%3>\n");
-        fprintf(f, "%s", s.arg(name).arg(val).arg(name).toLatin1().constData());
+        bput("%s", s.arg(name).arg(val).arg(name).toLatin1().constData());
       }
       else
       {
@@ -1032,13 +1125,13 @@ void Xml::floatTag(int level, const char* name, float val)
 void Xml::doubleTag(int level, const char* name, double val)
       {
       putLevel(level);
-      if(f)
+      if(writesBytes())
       {
         // using QString to format decimal values since we know that
         // toLatin1 will make a string with decimal point instead of
         // decimal comma that some locales use
         QString s("<%1>%2</%3>\n");
-        fprintf(f, "%s", s.arg(name).arg(val).arg(name).toLatin1().constData());
+        bput("%s", s.arg(name).arg(val).arg(name).toLatin1().constData());
       }
       else
       {
@@ -1053,23 +1146,23 @@ void Xml::doubleTag(int level, const char* name, double val)
 void Xml::strTag(int level, const char* name, const char* val)
       {
       putLevel(level);
-      if(f)
+      if(writesBytes())
       {
-        fprintf(f, "<%s>", name);
+        bput("<%s>", name);
         if (val) {
               while (*val) {
                     switch(*val) {
-                          case '&': fprintf(f, "&amp;"); break;
-                          case '<': fprintf(f, "&lt;"); break;
-                          case '>': fprintf(f, "&gt;"); break;
-                          case '\'': fprintf(f, "&apos;"); break;
-                          case '"': fprintf(f, "&quot;"); break;
-                          default: fputc(*val, f); break;
+                          case '&': bput("&amp;"); break;
+                          case '<': bput("&lt;"); break;
+                          case '>': bput("&gt;"); break;
+                          case '\'': bput("&apos;"); break;
+                          case '"': bput("&quot;"); break;
+                          default: bputc(*val); break;
                           }
                     ++val;
                     }
               }
-        fprintf(f, "</%s>\n", name);
+        bput("</%s>\n", name);
       }
       else
       {
@@ -1102,9 +1195,9 @@ void Xml::strTag(int level, const char* name, const char* val)
 void Xml::colorTag(int level, const char* name, const QColor& color)
       {
       putLevel(level);
-      if(f)
+      if(writesBytes())
       {
-        fprintf(f, "<%s r=\"%d\" g=\"%d\" b=\"%d\"></%s>\n",
+        bput("<%s r=\"%d\" g=\"%d\" b=\"%d\"></%s>\n",
 	      name, color.red(), color.green(), color.blue(), name);
       }
       else
@@ -1139,9 +1232,9 @@ void Xml::geometryTag(int level, const char* name, const QWidget* g)
 void Xml::qrectTag(int level, const char* name, const QRect& r)
       {
       putLevel(level);
-      if(f)
+      if(writesBytes())
       {
-        fprintf(f, "<%s x=\"%d\" y=\"%d\" w=\"%d\" h=\"%d\"></%s>\n",
+        bput("<%s x=\"%d\" y=\"%d\" w=\"%d\" h=\"%d\"></%s>\n",
            name, r.x(), r.y(), r.width(), r.height(), name);
       }
       else
@@ -25,8 +25,10 @@
 #define __XML_H__
 
 #include <stdio.h>
+#include <stdarg.h>
 
 #include <QString>
+#include <QByteArray>
 #include <QColor>
 #include <QRect>
 #include <QWidget>
@@ -46,6 +48,8 @@ class Xml {
       QString* _destStr;
       // When constructed with a QIODevice* parameter, this will be valid.
       QIODevice* _destIODev;
+      // When constructed with a QByteArray* parameter, this will be valid.
+      QByteArray* _destBytes;
       int _line;
       int _col;
       QString _s1, _s2, _tag;
@@ -74,6 +78,10 @@ class Xml {
       void stoken();
       QString strip(const QString& s);
       void putLevel(int n);
+      // Formatted output for the FILE and byte array destinations.
+      void vbput(const char* format, va_list args);
+      void bput(const char* format, ...);
+      void bputc(char ch);
 
    public:
       enum Token {Error, TagStart, TagEnd, Flag,
@@ -97,6 +105,15 @@ class Xml {
       Xml(QString*);
       // For writing and reading a QIODevice. Constructs an xml from a QIODevice.
       Xml(QIODevice*);
+      // For writing to a QByteArray only. Reading may cause error. Writes exactly
+      //  the same bytes as a FILE would get, so the result can be put into a FILE
+      //  with putBytes(). Constructs an xml from a QByteArray.
+      Xml(QByteArray*);
+
+      // Whether the destination takes raw bytes, ie. a FILE or a QByteArray.
+      bool writesBytes() const { return f || _destBytes; }
+      // Writes already formatted xml, such as from a QByteArray xml.
+      void putBytes(const QByteArray&);
 
       Token parse();
       QString parse(const QString&);
@@ -1546,6 +1546,8 @@ bool MusE::save(const QString& name, bool overwriteWarn, bool writeTopwins)
       FILE* f = MusEGui::fileOpen(this, name, QString(".med"), "w", popenFlag, false, overwriteWarn);
       if (f == 0)
             return false;
+      // Songs can be large. Write them out in big blocks.
+      setvbuf(f, NULL, _IOFBF, 1 << 20);
       MusECore::Xml xml(f);
       write(xml, writeTopwins);
       if (ferror(f)) {
@@ -2268,7 +2268,7 @@ void PartCanvas::drawMidiPart(QPainter& p, const QRect&, const MusECore::EventLi
   }
 }
 
-void PartCanvas::drawWaveSndFile(QPainter &p, MusECore::SndFileR &f, int samplePos, unsigned rootFrame, unsigned startFrame, unsigned lengthFrames, int startY, int startX, int endX, int rectHeight)
+void PartCanvas::drawWaveSndFile(QPainter &p, MusECore::SndFileR &f, int samplePos, unsigned rootFrame, unsigned startFrame, unsigned lengthFrames, int startY, int startX, int endX, int rectHeight, const MusECore::Event* event)
 {
    int h = rectHeight >> 1;
    int x1 = startX;
@@ -2314,7 +2314,10 @@ void PartCanvas::drawWaveSndFile(QPainter &p, MusECore::SndFileR &f, int sampleP
          for (; i < ex; i++) {
                MusECore::SampleV sa[channels];
                xScale = MusEGlobal::tempomap.deltaTick2frame(postick, postick + tickstep);
-               f.read(sa, xScale, pos, true, false);
+               if(event)
+                 event->readPeaks(sa, xScale, pos, true, false);
+               else
+                 f.read(sa, xScale, pos, true, false);
                postick += tickstep;
                pos += xScale;
                int peak = 0;
@@ -2348,7 +2351,10 @@ void PartCanvas::drawWaveSndFile(QPainter &p, MusECore::SndFileR &f, int sampleP
                int y  = startY + hm;
                MusECore::SampleV sa[channels];
                xScale = MusEGlobal::tempomap.deltaTick2frame(postick, postick + tickstep);
-               f.read(sa, xScale, pos, true, false);
+               if(event)
+                 event->readPeaks(sa, xScale, pos, true, false);
+               else
+                 f.read(sa, xScale, pos, true, false);
                postick += tickstep;
                pos += xScale;
                for (unsigned k = 0; k < channels; ++k) {
@@ -2404,7 +2410,7 @@ void PartCanvas::drawWavePart(QPainter& p,
 
             MusECore::Event event = e->second;
             MusECore::SndFileR f = event.sndFile();
-            drawWaveSndFile(p, f, event.spos(), wp->frame(), event.frame(), event.lenFrame(), startY, x1, x2, hh);
+            drawWaveSndFile(p, f, event.spos(), wp->frame(), event.frame(), event.lenFrame(), startY, x1, x2, hh, &event);
 
 
             }
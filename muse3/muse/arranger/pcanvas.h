@@ -176,7 +176,8 @@ class PartCanvas : public Canvas {
                              bool toTrack = true, unsigned int* finalPosPtr = NULL,
                              std::set<MusECore::Track*>* affected_tracks = NULL);
       void drawWaveSndFile(QPainter &p, MusECore::SndFileR &f, int samplePos, unsigned rootFrame,
-                           unsigned startFrame, unsigned lengthFrames, int startY, int startX, int endX, int rectHeight);
+                           unsigned startFrame, unsigned lengthFrames, int startY, int startX, int endX, int rectHeight,
+                           const MusECore::Event* event = NULL);
       void drawWavePart(QPainter&, const QRect&, MusECore::WavePart*, const QRect&);
       void drawMidiPart(QPainter&, const QRect& rect, const MusECore::EventList& events,
                         MusECore::MidiTrack* mt, MusECore::MidiPart* midipart,
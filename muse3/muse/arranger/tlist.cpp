@@ -72,6 +72,7 @@
 #include "ctrl.h"
 #include "plugin.h"
 #include "operations.h"
+#include "trackfreeze.h"
 
 
 #ifdef DSSI_SUPPORT
@@ -1984,6 +1985,29 @@ void TList::mousePressEvent(QMouseEvent* ev)
                           // 1016 is occupied.
                           p->addSeparator();
                         }
+
+                        if (t->type() == MusECore::Track::WAVE || t->type() == MusECore::Track::AUDIO_SOFTSYNTH)
+                        {
+                          const MusECore::TrackFreeze* fr = static_cast<MusECore::AudioTrack*>(t)->freeze();
+                          QAction* tmp;
+                          tmp=p->addAction(tr("Freeze track before effects"));
+                          tmp->setData(1020);
+                          tmp->setCheckable(true);
+                          tmp->setChecked(fr->mode() == MusECore::TrackFreeze::PreRack);
+                          tmp->setEnabled(fr->canFreeze());
+                          tmp=p->addAction(tr("Freeze track after effects"));
+                          tmp->setData(1021);
+                          tmp->setCheckable(true);
+                          tmp->setChecked(fr->mode() == MusECore::TrackFreeze::PostRack);
+                          tmp->setEnabled(fr->canFreeze());
+                          tmp=p->addAction(tr("Unfreeze track"));
+                          tmp->setData(1022);
+                          tmp->setEnabled(fr->mode() != MusECore::TrackFreeze::Off);
+                          tmp=p->addAction(tr("Render frozen tracks"));
+                          tmp->setData(1023);
+                          tmp->setEnabled(!MusEGlobal::audio->isPlaying());
+                          p->addSeparator();
+                        }
                         addTrackMenu->setTitle(tr("Insert Track"));
                         addTrackMenu->setIcon(QIcon(*edit_track_addIcon));
                         p->addMenu(addTrackMenu);
@@ -2048,6 +2072,22 @@ void TList::mousePressEvent(QMouseEvent* ev)
                                     case 1014:
                                       copyTrackDrummap((MusECore::MidiTrack*)t, true);
                                       break;
+
+                                    case 1020:
+                                      static_cast<MusECore::AudioTrack*>(t)->freeze()->setMode(MusECore::TrackFreeze::PreRack);
+                                      break;
+
+                                    case 1021:
+                                      static_cast<MusECore::AudioTrack*>(t)->freeze()->setMode(MusECore::TrackFreeze::PostRack);
+                                      break;
+
+                                    case 1022:
+                                      static_cast<MusECore::AudioTrack*>(t)->freeze()->setMode(MusECore::TrackFreeze::Off);
+                                      break;
+
+                                    case 1023:
+                                      MusECore::renderFrozenTracks();
+                                      break;
                                     
                                     default:
                                           printf("action %d\n", n);
@@ -36,6 +36,8 @@
 #include "alsamidi.h"
 #include "synth.h"
 #include "audioprefetch.h"
+#include "audiobuffers.h"
+#include "telemetry.h"
 #include "plugin.h"
 #include "audio.h"
 #include "wave.h"
@@ -160,6 +162,9 @@ Audio::Audio()
       precountMidiClickFrameRemainder = 0;
       precountTotalFrames = 0;
       _syncPlayStarting = false;
+      _latencyDirty = true;
+      _latencyCompensation = false;
+      _latencyVisit = 0;
       // Set for way beyond the end of the expected count.
       _antiSeekFloodCounter = 100000.0;
       
@@ -264,6 +269,9 @@ bool Audio::start()
       
       MusEGlobal::audioDevice->seekTransport(MusEGlobal::song->cPos());   
       
+      if (MusEGlobal::debugMsg)
+            MusEGlobal::audioBufferPool.report();
+
       // Should be OK to start this 'leisurely' timer only after everything
       //  else has been started.
       MusEGlobal::muse->setHeartBeat();
@@ -745,7 +753,7 @@ void Audio::process(unsigned frames)
             if (!freewheel())
                   MusEGlobal::audioPrefetch->msgTick(isRecording(), true);
 
-            if (_bounce && _pos >= MusEGlobal::song->rPos()) {
+            if (_bounce && _pos >= _bounceEnd) {
                   _bounce = false;
                   write(sigFd, "F", 1);
                   return;
@@ -845,6 +853,9 @@ void Audio::process(unsigned frames)
             //  set curTickPos (above) from the reported current tick.
             curTickPos = nextTickPos; 
             }
+
+      // Hand meters, automation values and transport to the gui.
+      MusEGlobal::telemetry.process(frames);
       
       // If external sync has started but the transport has not started yet,
       //  don't reset the clock history yet, just let it pile up until the transport starts.
@@ -892,6 +903,8 @@ void Audio::process1(unsigned samplePos, unsigned offset, unsigned frames)
       // Pre-process the metronome.
       ((AudioTrack*)metronome)->preProcessAlways();
       
+      updateLatencyCompensation();
+      
       // Process Aux tracks first.
       for(ciTrack it = tl->begin(); it != tl->end(); ++it)
       {
@@ -942,6 +955,69 @@ void Audio::process1(unsigned samplePos, unsigned offset, unsigned frames)
       }      
     }
 
+//---------------------------------------------------------
+//   updateLatencyCompensation
+//    Each track is delayed so that it reaches its destinations
+//     together with the slowest signal arriving there.
+//    A track feeding several destinations gets the largest of
+//     the delays they ask for.
+//    Called from audio thread only.
+//---------------------------------------------------------
+
+void Audio::updateLatencyCompensation()
+      {
+      TrackList* tl = MusEGlobal::song->tracks();
+      bool changed = _latencyDirty;
+      _latencyDirty = false;
+      if(_latencyCompensation != MusEGlobal::config.latencyCompensation)
+      {
+        _latencyCompensation = MusEGlobal::config.latencyCompensation;
+        changed = true;
+      }
+
+      // Cheap check for plugins added, removed, switched or reporting a new latency,
+      //  and for tracks armed or disarmed in live monitoring mode.
+      for(ciTrack it = tl->begin(); it != tl->end(); ++it)
+      {
+        if((*it)->isMidiTrack())
+          continue;
+        if(static_cast<AudioTrack*>(*it)->updateLatencyState())
+          changed = true;
+      }
+      if(!changed)
+        return;
+
+      const int visit = ++_latencyVisit;
+      for(ciTrack it = tl->begin(); it != tl->end(); ++it)
+      {
+        if(!(*it)->isMidiTrack())
+          static_cast<AudioTrack*>(*it)->pathLatency(visit);
+      }
+
+      for(ciTrack it = tl->begin(); it != tl->end(); ++it)
+      {
+        if((*it)->isMidiTrack())
+          continue;
+        AudioTrack* track = static_cast<AudioTrack*>(*it);
+        float delay = 0.0;
+        // Tracks bypassed for live monitoring go straight through.
+        if(_latencyCompensation && !track->liveMonitorBypass())
+        {
+          const float path = track->pathLatency(visit);
+          const RouteList* rl = track->outRoutes();
+          for(ciRoute ir = rl->begin(); ir != rl->end(); ++ir)
+          {
+            if(ir->type != Route::TRACK_ROUTE || !ir->track || ir->track->isMidiTrack())
+              continue;
+            const float d = static_cast<AudioTrack*>(ir->track)->inputLatency() - path;
+            if(d > delay)
+              delay = d;
+          }
+        }
+        track->setCompensationDelay((unsigned long)(delay + 0.5));
+      }
+      }
+
 //---------------------------------------------------------
 //   processMsg
 //---------------------------------------------------------
@@ -1312,6 +1388,18 @@ void Audio::recordStop(bool restart, Undo* ops)
             mt->events.clear();    // ** Driver should not be touching this right now.
             mt->mpevents.clear();  // ** Driver should not be touching this right now.
             }
+
+      // Report any input which was lost because a device's recording fifos were full.
+      for(iMidiDevice id = MusEGlobal::midiDevices.begin(); id != MusEGlobal::midiDevices.end(); ++id)
+      {
+        MidiDevice* md = *id;
+        const unsigned lost = md->recordOverflows();
+        if(lost == 0)
+          continue;
+        fprintf(stderr, "MusE: Midi device %s: %u input events lost, recording fifo full\n",
+                md->name().toLatin1().constData(), lost);
+        md->resetRecordOverflows();
+      }
       
       //
       // bounce to file operates on the only
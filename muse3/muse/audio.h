@@ -139,6 +139,7 @@ class Audio {
       bool idle;              // do nothing in idle mode
       bool _freewheel;
       bool _bounce;
+      Pos _bounceEnd;               // position where the bounce stops
       unsigned _loopFrame;     // Startframe of loop if in LOOP mode. Not quite the same as left marker !
       int _loopCount;         // Number of times we have looped so far
 
@@ -200,6 +201,12 @@ class Audio {
 
       long m_Xruns;
       
+      // Plugin delay compensation. Set when routes or tracks change, so that
+      //  the latency graph is rebuilt at the start of the next cycle.
+      volatile bool _latencyDirty;
+      bool _latencyCompensation;
+      int _latencyVisit;
+      
       // Can be called by any thread.
       void sendLocalOff();
       
@@ -211,6 +218,9 @@ class Audio {
       void panic();
       void processMsg(AudioMsg* msg);
       void process1(unsigned samplePos, unsigned offset, unsigned samples);
+      // Rebuilds the track delays if any latency, route or armed track changed.
+      // Call from audio thread only.
+      void updateLatencyCompensation();
 
       void collectEvents(MidiTrack*, unsigned int startTick, unsigned int endTick, unsigned int frames);
       
@@ -244,6 +254,8 @@ class Audio {
       void reSyncAudio();
       void shutdown();
       void writeTick();
+      // Asks for the plugin delay compensation to be recomputed. Can be called by any thread.
+      void setLatencyDirty() { _latencyDirty = true; }
 
       // transport:
       // To be called from audio thread only.
@@ -294,6 +306,7 @@ class Audio {
       void msgIdle(bool);
       void msgAudioWait();
       void msgBounce();
+      void msgBounce(const Pos& start, const Pos& end);
       void msgSwapControllerIDX(AudioTrack*, int, int);
       void msgClearControllerEvents(AudioTrack*, int);
       void msgSeekPrevACEvent(AudioTrack*, int);
@@ -0,0 +1,160 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  audiobuffers.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "audiobuffers.h"
+#include "globals.h"
+#include "gconfig.h"
+
+namespace MusEGlobal {
+MusECore::AudioBufferPool audioBufferPool;
+}
+
+namespace MusECore {
+
+// Bytes held in all audio buffers.
+static std::atomic<size_t> heldBytes(0);
+
+//---------------------------------------------------------
+//   allocAudioBuffer
+//    The size is kept in front of the buffer, one alignment
+//     unit before it, so freeing needs no bookkeeping.
+//---------------------------------------------------------
+
+float* allocAudioBuffer(unsigned frames)
+      {
+      const size_t bytes = sizeof(float) * frames;
+      void* mem;
+#ifdef _WIN32
+      mem = _aligned_malloc(AUDIO_BUFFER_ALIGN + bytes, AUDIO_BUFFER_ALIGN);
+      if (mem == NULL) {
+            fprintf(stderr, "ERROR: allocAudioBuffer: _aligned_malloc returned error: NULL. Aborting!\n");
+            abort();
+            }
+#else
+      int rv = posix_memalign(&mem, AUDIO_BUFFER_ALIGN, AUDIO_BUFFER_ALIGN + bytes);
+      if (rv != 0) {
+            fprintf(stderr, "ERROR: allocAudioBuffer: posix_memalign returned error:%d. Aborting!\n", rv);
+            abort();
+            }
+#endif
+      *(size_t*)mem = bytes;
+      heldBytes += bytes;
+
+      float* buf = (float*)((char*)mem + AUDIO_BUFFER_ALIGN);
+      if (MusEGlobal::config.useDenormalBias) {
+            for (unsigned q = 0; q < frames; ++q)
+                  buf[q] = MusEGlobal::denormalBias;
+            }
+      else
+            memset(buf, 0, bytes);
+      return buf;
+      }
+
+//---------------------------------------------------------
+//   freeAudioBuffer
+//---------------------------------------------------------
+
+void freeAudioBuffer(float* buf)
+      {
+      if (!buf)
+            return;
+      void* mem = (char*)buf - AUDIO_BUFFER_ALIGN;
+      heldBytes -= *(size_t*)mem;
+#ifdef _WIN32
+      _aligned_free(mem);
+#else
+      free(mem);
+#endif
+      }
+
+//---------------------------------------------------------
+//   audioBufferBytes
+//---------------------------------------------------------
+
+size_t audioBufferBytes()
+      {
+      return heldBytes;
+      }
+
+//---------------------------------------------------------
+//   AudioBufferPool
+//---------------------------------------------------------
+
+AudioBufferPool::AudioBufferPool()
+      {
+      _frames = 0;
+      _silence = 0;
+      _dummy = 0;
+      for (int i = 0; i < MAX_CHANNELS; ++i)
+            _pipeline[i] = 0;
+      }
+
+AudioBufferPool::~AudioBufferPool()
+      {
+      freeAudioBuffer(_silence);
+      freeAudioBuffer(_dummy);
+      for (int i = 0; i < MAX_CHANNELS; ++i)
+            freeAudioBuffer(_pipeline[i]);
+      for (std::vector<float*>::iterator i = _retired.begin(); i != _retired.end(); ++i)
+            freeAudioBuffer(*i);
+      }
+
+//---------------------------------------------------------
+//   prepare
+//---------------------------------------------------------
+
+void AudioBufferPool::prepare()
+      {
+      if (_frames >= MusEGlobal::segmentSize)
+            return;
+      if (_silence) {
+            _retired.push_back(_silence);
+            _retired.push_back(_dummy);
+            for (int i = 0; i < MAX_CHANNELS; ++i)
+                  _retired.push_back(_pipeline[i]);
+            }
+      _frames = MusEGlobal::segmentSize;
+      _silence = allocAudioBuffer(_frames);
+      _dummy = allocAudioBuffer(_frames);
+      for (int i = 0; i < MAX_CHANNELS; ++i)
+            _pipeline[i] = allocAudioBuffer(_frames);
+      }
+
+//---------------------------------------------------------
+//   report
+//---------------------------------------------------------
+
+void AudioBufferPool::report() const
+      {
+      const size_t shared = sizeof(float) * _frames * (2 + MAX_CHANNELS);
+      fprintf(stderr, "Audio buffers: %zu bytes held, %zu of them shared by all tracks and plugins, segment size %u\n",
+              audioBufferBytes(), shared, _frames);
+      }
+
+} // namespace MusECore
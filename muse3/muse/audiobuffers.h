@@ -0,0 +1,91 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  audiobuffers.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __AUDIOBUFFERS_H__
+#define __AUDIOBUFFERS_H__
+
+#include <vector>
+#include <atomic>
+#include <stddef.h>
+
+#include "globaldefs.h"
+
+namespace MusECore {
+
+// Alignment of all engine audio buffers. A whole cache line,
+//  which also suits the widest vector loads.
+const size_t AUDIO_BUFFER_ALIGN = 64;
+
+// Allocates an aligned buffer of the given number of frames, cleared
+//  to silence, or to the denormal bias if it is in use. Aborts if out of memory.
+extern float* allocAudioBuffer(unsigned frames);
+// Frees a buffer allocated by allocAudioBuffer. Null is allowed.
+extern void freeAudioBuffer(float* buf);
+// Total bytes currently held in buffers allocated by allocAudioBuffer.
+extern size_t audioBufferBytes();
+
+//---------------------------------------------------------
+//   AudioBufferPool
+//    Buffers shared by all tracks and plugins, where their
+//     lifetimes never overlap or nobody reads them:
+//    - The silence buffer, connected to unused inputs. Never written.
+//    - The dummy buffer, connected to unused outputs. Never read.
+//    - The effect rack scratch buffers. Only live during one
+//       Pipeline::apply(), and the audio thread never runs
+//       two of those at once.
+//    prepare() must be called from the gui thread by anyone
+//     about to use them, so that the audio thread never allocates.
+//---------------------------------------------------------
+
+class AudioBufferPool
+{
+      unsigned _frames;
+      float* _silence;
+      float* _dummy;
+      float* _pipeline[MAX_CHANNELS];
+      // Buffers replaced when the segment size grew. Plugins may
+      //  still be connected to them, so they are kept until exit.
+      std::vector<float*> _retired;
+
+   public:
+      AudioBufferPool();
+      ~AudioBufferPool();
+
+      // Gui thread. Allocates the buffers, or reallocates them
+      //  if the segment size grew since.
+      void prepare();
+
+      float* silence() const { return _silence; }
+      float* dummy() const { return _dummy; }
+      float** pipelineBuffers() { return _pipeline; }
+
+      // Prints the memory held by the engine buffers.
+      void report() const;
+};
+
+} // namespace MusECore
+
+namespace MusEGlobal {
+extern MusECore::AudioBufferPool audioBufferPool;
+}
+
+#endif
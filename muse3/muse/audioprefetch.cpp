@@ -34,6 +34,7 @@
 #include "song.h"
 #include "audio.h"
 #include "sync.h"
+#include "trackfreeze.h"
 
 namespace MusEGlobal {
 MusECore::AudioPrefetch* audioPrefetch;
@@ -119,6 +120,9 @@ void AudioPrefetch::processMsg1(const void* m)
                         MusEGlobal::audio->writeTick();
                   }
 
+                  // Write what frozen tracks captured since the last tick.
+                  writeFreezeCaptures();
+
                   // Indicate do not seek file before each read.
                   if(msg->_isPlayTick) // Was the tick generated when audio playback was on?
                   {
@@ -211,6 +215,9 @@ void AudioPrefetch::prefetch(bool doSeek)
             // Save time. Don't bother if track is off. Track On/Off not designed for rapid repeated response (but mute is). (p3.3.29)
             if(track->off())
               continue;
+            // A frozen track streams its cache instead, see below.
+            if(track->freeze()->state() == TrackFreeze::Frozen)
+              continue;
             
             int ch           = track->channels();
             float* bp[ch];
@@ -221,9 +228,27 @@ void AudioPrefetch::prefetch(bool doSeek)
             track->fetchData(writePos, MusEGlobal::segmentSize, bp, doSeek, true);
             
             }
+      TrackList* atl = MusEGlobal::song->tracks();
+      for (iTrack it = atl->begin(); it != atl->end(); ++it) {
+            if (!(*it)->isMidiTrack())
+                  static_cast<AudioTrack*>(*it)->freeze()->fetch(writePos, MusEGlobal::segmentSize);
+            }
       writePos += MusEGlobal::segmentSize;
       }
 
+//---------------------------------------------------------
+//   writeFreezeCaptures
+//---------------------------------------------------------
+
+void AudioPrefetch::writeFreezeCaptures()
+      {
+      TrackList* tl = MusEGlobal::song->tracks();
+      for (iTrack it = tl->begin(); it != tl->end(); ++it) {
+            if (!(*it)->isMidiTrack())
+                  static_cast<AudioTrack*>(*it)->freeze()->writeCaptured();
+            }
+      }
+
 //---------------------------------------------------------
 //   seek
 //---------------------------------------------------------
@@ -256,6 +281,11 @@ void AudioPrefetch::seek(unsigned seekTo)
             WaveTrack* track = *it;
             track->clearPrefetchFifo();
             }
+      TrackList* atl = MusEGlobal::song->tracks();
+      for (iTrack it = atl->begin(); it != atl->end(); ++it) {
+            if (!(*it)->isMidiTrack())
+                  static_cast<AudioTrack*>(*it)->freeze()->clearPlayFifo();
+            }
       
       bool isFirstPrefetch = true;
       for (unsigned int i = 0; i < (MusEGlobal::fifoLength)-1; ++i)//prevent compiler warning: comparison of signed/unsigned
@@ -39,6 +39,7 @@ class AudioPrefetch : public Thread {
       virtual void processMsg1(const void*);
       void prefetch(bool doSeek);
       void seek(unsigned pos);
+      void writeFreezeCaptures();
 
       volatile int seekCount;
       
@@ -45,6 +45,9 @@
 #include "controlfifo.h"
 #include "fastlog.h"
 #include "gconfig.h"
+#include "latency_compensator.h"
+#include "audiobuffers.h"
+#include "trackfreeze.h"
 
 namespace MusECore {
 
@@ -109,152 +112,46 @@ void AudioTrack::initBuffers()
   {
     outBuffers = new float*[chans];
     for(int i = 0; i < chans; ++i)
-    {
-#ifdef _WIN32
-      outBuffers[i] = (float *) _aligned_malloc(16, sizeof(float) * MusEGlobal::segmentSize);
-      if(outBuffers[i] == NULL)
-      {
-          fprintf(stderr, "ERROR: AudioTrack::init_buffers: _aligned_malloc returned error: NULL. Aborting!\n");
-          abort();
-      }
-#else
-      int rv = posix_memalign((void**)&outBuffers[i], 16, sizeof(float) * MusEGlobal::segmentSize);
-      if(rv != 0)
-      {
-        fprintf(stderr, "ERROR: AudioTrack::init_buffers: posix_memalign returned error:%d. Aborting!\n", rv);
-        abort();
-      }
-#endif
-    }
+      outBuffers[i] = allocAudioBuffer(MusEGlobal::segmentSize);
   }
-  for(int i = 0; i < chans; ++i)
+  else
   {
-    if(MusEGlobal::config.useDenormalBias)
+    for(int i = 0; i < chans; ++i)
     {
-      for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-        outBuffers[i][q] = MusEGlobal::denormalBias;
+      if(MusEGlobal::config.useDenormalBias)
+      {
+        for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
+          outBuffers[i][q] = MusEGlobal::denormalBias;
+      }
+      else
+        memset(outBuffers[i], 0, sizeof(float) * MusEGlobal::segmentSize);
     }
-    else
-      memset(outBuffers[i], 0, sizeof(float) * MusEGlobal::segmentSize);
   }
 
   if(!outBuffersExtraMix)
   {
     outBuffersExtraMix = new float*[MusECore::MAX_CHANNELS];
     for(int i = 0; i < MusECore::MAX_CHANNELS; ++i)
-    {
-#ifdef _WIN32
-      outBuffersExtraMix[i] = (float *) _aligned_malloc(16, sizeof(float) * MusEGlobal::segmentSize);
-      if(outBuffersExtraMix[i] == NULL)
-      {
-          fprintf(stderr, "ERROR: AudioTrack::init_buffers: _aligned_malloc outBuffersMonoMix returned error: NULL. Aborting!\n");
-          abort();
-      }
-#else
-      int rv = posix_memalign((void**)&outBuffersExtraMix[i], 16, sizeof(float) * MusEGlobal::segmentSize);
-      if(rv != 0)
-      {
-        fprintf(stderr, "ERROR: AudioTrack::init_buffers: posix_memalign outBuffersMonoMix returned error:%d. Aborting!\n", rv);
-        abort();
-      }
-#endif
-    }
-  }
-  for(int i = 0; i < MusECore::MAX_CHANNELS; ++i)
-  {
-    if(MusEGlobal::config.useDenormalBias)
-    {
-      for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-        outBuffersExtraMix[i][q] = MusEGlobal::denormalBias;
-    }
-    else
-      memset(outBuffersExtraMix[i], 0, sizeof(float) * MusEGlobal::segmentSize);
+      outBuffersExtraMix[i] = allocAudioBuffer(MusEGlobal::segmentSize);
   }
-
-  if(!_dataBuffers)
+  else
   {
-    _dataBuffers = new float*[_totalOutChannels];
-    for(int i = 0; i < _totalOutChannels; ++i)
+    for(int i = 0; i < MusECore::MAX_CHANNELS; ++i)
     {
-#ifdef _WIN32
-      _dataBuffers[i] = (float *) _aligned_malloc(16, sizeof(float) * MusEGlobal::segmentSize);
-      if(_dataBuffers[i] == NULL)
-      {
-          fprintf(stderr, "ERROR: AudioTrack::init_buffers: _aligned_malloc _dataBuffers returned error: NULL. Aborting!\n");
-          abort();
-      }
-#else
-      int rv = posix_memalign((void**)&_dataBuffers[i], 16, sizeof(float) * MusEGlobal::segmentSize);
-      if(rv != 0)
+      if(MusEGlobal::config.useDenormalBias)
       {
-        fprintf(stderr, "ERROR: AudioTrack::init_buffers: posix_memalign _dataBuffers returned error:%d. Aborting!\n", rv);
-        abort();
+        for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
+          outBuffersExtraMix[i][q] = MusEGlobal::denormalBias;
       }
-#endif
-    }
-  }
-  for(int i = 0; i < _totalOutChannels; ++i)
-  {
-    if(MusEGlobal::config.useDenormalBias)
-    {
-      for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-        _dataBuffers[i][q] = MusEGlobal::denormalBias;
-    }
-    else
-      memset(_dataBuffers[i], 0, sizeof(float) * MusEGlobal::segmentSize);
-  }
-
-  if(!audioInSilenceBuf)
-  {
-#ifdef _WIN32
-    audioInSilenceBuf = (float *) _aligned_malloc(16, sizeof(float) * MusEGlobal::segmentSize);
-    if(audioInSilenceBuf == NULL)
-    {
-      fprintf(stderr, "ERROR: AudioTrack::init_buffers: _aligned_malloc returned error: NULL. Aborting!\n");
-      abort();
-    }
-#else
-    int rv = posix_memalign((void**)&audioInSilenceBuf, 16, sizeof(float) * MusEGlobal::segmentSize);
-    if(rv != 0)
-    {
-      fprintf(stderr, "ERROR: AudioTrack::init_buffers: posix_memalign returned error:%d. Aborting!\n", rv);
-      abort();
-    }
-#endif
-    if(MusEGlobal::config.useDenormalBias)
-    {
-      for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-        audioInSilenceBuf[q] = MusEGlobal::denormalBias;
+      else
+        memset(outBuffersExtraMix[i], 0, sizeof(float) * MusEGlobal::segmentSize);
     }
-    else
-      memset(audioInSilenceBuf, 0, sizeof(float) * MusEGlobal::segmentSize);
   }
 
-  if(!audioOutDummyBuf)
-  {
-#ifdef _WIN32
-    audioOutDummyBuf = (float *) _aligned_malloc(16, sizeof(float) * MusEGlobal::segmentSize);
-    if(audioOutDummyBuf == NULL)
-    {
-      fprintf(stderr, "ERROR: AudioTrack::init_buffers: _aligned_malloc returned error: NULL. Aborting!\n");
-      abort();
-    }
-#else
-    int rv = posix_memalign((void**)&audioOutDummyBuf, 16, sizeof(float) * MusEGlobal::segmentSize);
-    if(rv != 0)
-    {
-      fprintf(stderr, "ERROR: AudioTrack::init_buffers: posix_memalign returned error:%d. Aborting!\n", rv);
-      abort();
-    }
-#endif
-    if(MusEGlobal::config.useDenormalBias)
-    {
-      for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-        audioOutDummyBuf[q] = MusEGlobal::denormalBias;
-    }
-    else
-      memset(audioOutDummyBuf, 0, sizeof(float) * MusEGlobal::segmentSize);
-  }
+  // The silence and dummy buffers are shared by all tracks and plugins.
+  MusEGlobal::audioBufferPool.prepare();
+  audioInSilenceBuf = MusEGlobal::audioBufferPool.silence();
+  audioOutDummyBuf = MusEGlobal::audioBufferPool.dummy();
 
   if(!_controls && _controlPorts != 0)
   {
@@ -291,6 +188,14 @@ AudioTrack::AudioTrack(TrackType t)
       _sendMetronome = false;
       _prefader = false;
       _efxPipe  = new Pipeline();
+      _latencyComp = new LatencyCompensator(MusECore::MAX_CHANNELS);
+      _ownLatency = 0.0;
+      _liveBypass = false;
+      _inputLatency = 0.0;
+      _pathLatency = 0.0;
+      _latencyVisit = 0;
+      _compDelay = 0;
+      _freeze = new TrackFreeze(this);
       recFileNumber = 1;
       _channels = 0;
       _automationType = AUTO_OFF;
@@ -310,7 +215,6 @@ AudioTrack::AudioTrack(TrackType t)
       outBuffersExtraMix = 0;
       audioInSilenceBuf = 0;
       audioOutDummyBuf = 0;
-      _dataBuffers = 0;
 
       _totalOutChannels = MusECore::MAX_CHANNELS;
 
@@ -329,6 +233,14 @@ AudioTrack::AudioTrack(const AudioTrack& t, int flags)
       _processed      = false;
       _haveData       = false;
       _efxPipe        = new Pipeline();                 // Start off with a new pipeline.
+      _latencyComp    = new LatencyCompensator(MusECore::MAX_CHANNELS);
+      _ownLatency     = 0.0;
+      _liveBypass     = false;
+      _inputLatency   = 0.0;
+      _pathLatency    = 0.0;
+      _latencyVisit   = 0;
+      _compDelay      = 0;
+      _freeze         = new TrackFreeze(this);  // Copies start off live.
       recFileNumber = 1;
 
       addController(new CtrlList(AC_VOLUME,"Volume",0.001,3.163 /* roughly 10 db */, VAL_LOG));
@@ -346,7 +258,6 @@ AudioTrack::AudioTrack(const AudioTrack& t, int flags)
       outBuffersExtraMix = 0;
       audioInSilenceBuf = 0;
       audioOutDummyBuf = 0;
-      _dataBuffers = 0;
 
       _totalOutChannels = 0;
 
@@ -593,29 +504,14 @@ void AudioTrack::assign(const Track& t, int flags)
 AudioTrack::~AudioTrack()
 {
       delete _efxPipe;
-
-      if(audioInSilenceBuf)
-        free(audioInSilenceBuf);
-
-      if(audioOutDummyBuf)
-        free(audioOutDummyBuf);
-
-      if(_dataBuffers)
-      {
-        for(int i = 0; i < _totalOutChannels; ++i)
-        {
-          if(_dataBuffers[i])
-            free(_dataBuffers[i]);
-        }
-        delete[] _dataBuffers;
-      }
+      delete _latencyComp;
+      delete _freeze;
 
       if(outBuffersExtraMix)
       {
         for(int i = 0; i < MusECore::MAX_CHANNELS; ++i)
         {
-          if(outBuffersExtraMix[i])
-            free(outBuffersExtraMix[i]);
+          freeAudioBuffer(outBuffersExtraMix[i]);
         }
         delete[] outBuffersExtraMix;
       }
@@ -628,8 +524,7 @@ AudioTrack::~AudioTrack()
       {
         for(int i = 0; i < chans; ++i)
         {
-          if(outBuffers[i])
-            free(outBuffers[i]);
+          freeAudioBuffer(outBuffers[i]);
         }
         delete[] outBuffers;
       }
@@ -1166,6 +1061,93 @@ float AudioTrack::latency(int /*channel*/)
   return _efxPipe->latency();
 }
 
+//---------------------------------------------------------
+//   ownLatency
+//---------------------------------------------------------
+
+float AudioTrack::ownLatency()
+{
+  if(!_efxPipe)
+    return 0.0;
+  return _efxPipe->latency(liveMonitorBypass() ? (float)MusEGlobal::config.liveMonitoringMaxLatency : -1.0);
+}
+
+//---------------------------------------------------------
+//   liveMonitorBypass
+//---------------------------------------------------------
+
+bool AudioTrack::liveMonitorBypass() const
+{
+  return MusEGlobal::config.liveMonitoring && canRecord() && recordFlag();
+}
+
+//---------------------------------------------------------
+//   updateLatencyState
+//   Called from audio thread only.
+//---------------------------------------------------------
+
+bool AudioTrack::updateLatencyState()
+{
+  const bool bypass = liveMonitorBypass();
+  const float own = ownLatency();
+  if(own == _ownLatency && bypass == _liveBypass)
+    return false;
+  _ownLatency = own;
+  _liveBypass = bypass;
+  return true;
+}
+
+//---------------------------------------------------------
+//   pathLatency
+//   Latency of the slowest source plus our own.
+//   Tracks bypassed for live monitoring are not waited for,
+//    and aux sends are not part of the graph.
+//   Called from audio thread only.
+//---------------------------------------------------------
+
+float AudioTrack::pathLatency(int visit)
+{
+  if(_latencyVisit == visit)
+    return _pathLatency;
+
+  // Mark before walking the sources, so that a feedback loop ends here.
+  _latencyVisit = visit;
+  _inputLatency = 0.0;
+  _pathLatency = _ownLatency;
+
+  const RouteList* rl = inRoutes();
+  for(ciRoute ir = rl->begin(); ir != rl->end(); ++ir)
+  {
+    if(ir->type != Route::TRACK_ROUTE || !ir->track || ir->track->isMidiTrack())
+      continue;
+    AudioTrack* src = static_cast<AudioTrack*>(ir->track);
+    const float l = src->pathLatency(visit);
+    if(src->_liveBypass)
+      continue;
+    if(l > _inputLatency)
+      _inputLatency = l;
+  }
+
+  _pathLatency = _inputLatency + _ownLatency;
+  return _pathLatency;
+}
+
+//---------------------------------------------------------
+//   setCompensationDelay
+//   Called from audio thread only.
+//---------------------------------------------------------
+
+void AudioTrack::setCompensationDelay(unsigned long delay)
+{
+  if(delay == _compDelay)
+    return;
+  // The delay line is not run while there is no delay. Don't replay stale audio from last time.
+  if(_compDelay == 0)
+    _latencyComp->clear();
+  _latencyComp->setDelay(delay);
+  _compDelay = _latencyComp->delay(0);
+}
+
 //---------------------------------------------------------
 //   volume
 //---------------------------------------------------------
@@ -1521,6 +1503,7 @@ void AudioTrack::writeProperties(int level, Xml& xml) const
                   (*ip)->writeConfiguration(level, xml);
             }
       _controller.write(level, xml);
+      _freeze->write(level, xml);
       }
 
 //---------------------------------------------------------
@@ -1651,6 +1634,8 @@ bool AudioTrack::readProperties(Xml& xml, const QString& tag)
             }
       else if (tag == "midiMapper")
             _controller.midiControls()->read(xml);
+      else if (tag == "freeze")
+            _freeze->read(xml);
       else
             return Track::readProperties(xml, tag);
       return false;
@@ -2202,28 +2187,7 @@ AudioAux::AudioAux()
       {
         if(i < channels())
         {
-#ifdef _WIN32
-          buffer[i] = (float *) _aligned_malloc(16, sizeof(float) * MusEGlobal::segmentSize);
-          if(buffer[i] == NULL)
-          {
-            fprintf(stderr, "ERROR: AudioAux ctor: _aligned_malloc returned error: NULL. Aborting!\n");
-            abort();
-          }
-#else
-          int rv = posix_memalign((void**)(buffer + i), 16, sizeof(float) * MusEGlobal::segmentSize);
-          if(rv != 0)
-          {
-            fprintf(stderr, "ERROR: AudioAux ctor: posix_memalign returned error:%d. Aborting!\n", rv);
-            abort();
-          }
-#endif
-          if(MusEGlobal::config.useDenormalBias)
-          {
-            for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-              buffer[i][q] = MusEGlobal::denormalBias;
-          }
-          else
-            memset(buffer[i], 0, sizeof(float) * MusEGlobal::segmentSize);
+          buffer[i] = allocAudioBuffer(MusEGlobal::segmentSize);
         }
         else
           buffer[i] = 0;
@@ -2238,28 +2202,7 @@ AudioAux::AudioAux(const AudioAux& t, int flags)
       {
         if(i < channels())
         {
-#ifdef _WIN32
-          buffer[i] = (float *) _aligned_malloc(16, sizeof(float) * MusEGlobal::segmentSize);
-          if(buffer[i] == NULL)
-          {
-            fprintf(stderr, "ERROR: AudioAux ctor: _aligned_malloc returned error: NULL. Aborting!\n");
-            abort();
-          }
-#else
-          int rv = posix_memalign((void**)(buffer + i), 16, sizeof(float) * MusEGlobal::segmentSize);
-          if(rv != 0)
-          {
-            fprintf(stderr, "ERROR: AudioAux ctor: posix_memalign returned error:%d. Aborting!\n", rv);
-            abort();
-          }
-#endif
-          if(MusEGlobal::config.useDenormalBias)
-          {
-            for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-              buffer[i][q] = MusEGlobal::denormalBias;
-          }
-          else
-            memset(buffer[i], 0, sizeof(float) * MusEGlobal::segmentSize);
+          buffer[i] = allocAudioBuffer(MusEGlobal::segmentSize);
         }
         else
           buffer[i] = 0;
@@ -2272,8 +2215,7 @@ AudioAux::AudioAux(const AudioAux& t, int flags)
 AudioAux::~AudioAux()
 {
       for (int i = 0; i < MusECore::MAX_CHANNELS; ++i) {
-            if (buffer[i])
-                free(buffer[i]);
+            freeAudioBuffer(buffer[i]);
       }
 }
 
@@ -2353,36 +2295,14 @@ void AudioAux::setChannels(int n)
   {
     for(int i = channels(); i < n; ++i)
     {
-#ifdef _WIN32
-      buffer[i] = (float *) _aligned_malloc(16, sizeof(float) * MusEGlobal::segmentSize);
-      if(buffer[i] == NULL)
-      {
-        fprintf(stderr, "ERROR: AudioTrack::setChannels: _aligned_malloc returned error: NULL. Aborting!\n");
-        abort();
-      }
-#else
-      int rv = posix_memalign((void**)(buffer + i), 16, sizeof(float) * MusEGlobal::segmentSize);
-      if(rv != 0)
-      {
-        fprintf(stderr, "ERROR: AudioAux::setChannels: posix_memalign returned error:%d. Aborting!\n", rv);
-        abort();
-      }
-#endif
-      if(MusEGlobal::config.useDenormalBias)
-      {
-        for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-          buffer[i][q] = MusEGlobal::denormalBias;
-      }
-      else
-        memset(buffer[i], 0, sizeof(float) * MusEGlobal::segmentSize);
+      buffer[i] = allocAudioBuffer(MusEGlobal::segmentSize);
     }
   }
   else if(n < channels())
   {
     for(int i = n; i < channels(); ++i)
     {
-      if(buffer[i])
-        free(buffer[i]);
+      freeAudioBuffer(buffer[i]);
     }
   }
   AudioTrack::setChannels(n);
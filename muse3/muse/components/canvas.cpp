@@ -333,6 +333,11 @@ void Canvas::draw(QPainter& p, const QRect& mr, const QRegion& mrg)
       //  actually begins at x=-1 and needs to include that small adjustment during updates...
       ux_2lim += rmapxDev(1);
       
+      // Items are keyed by their left edge, so anything starting further left
+      //  than the widest item cannot reach into the rectangle. Skip them instead
+      //  of walking every item in the song on each paint.
+      const int ux_lim = mapxDev(mx) - rmapxDev(1) - items.maxWidth();
+      
       std::vector<CItem*> list1;
       std::vector<CItem*> list2;
       std::vector<CItem*> list4;
@@ -355,8 +360,10 @@ void Canvas::draw(QPainter& p, const QRect& mr, const QRegion& mrg)
 //             else
 //               fprintf(stderr, "...item found\n");
             
+            iCItem from(items.lower_bound(ux_lim));
+            
             int ii = 0;
-            for(iCItem i = items.begin(); i != to; ++i, ++ii)
+            for(iCItem i = from; i != to; ++i, ++ii)
             { 
               CItem* ci = i->second;
               // NOTE Optimization: For each item call this once now, then use cached results later via cachedHasHiddenEvents().
@@ -822,6 +829,7 @@ void Canvas::viewMousePressEvent(QMouseEvent* event)
                         setCursor();
                         int dx = start.x() - curItem->x();
                         curItem->setWidth(dx);
+                        items.updateMaxWidth(curItem);
                         start.setX(curItem->x());
                         deselectAll();
                         selectItem(curItem, true);
@@ -903,6 +911,7 @@ void Canvas::viewMousePressEvent(QMouseEvent* event)
                                   if(resizeDirection == RESIZE_TO_THE_RIGHT){
                                     int dx = start.x() - curItem->x();
                                     curItem->setWidth(dx);
+                                    items.updateMaxWidth(curItem);
                                   }else{
                                     int endX = curItem->x() + curItem->width();
                                     end = QPoint(endX, curItem->y());
@@ -1172,6 +1181,7 @@ void Canvas::scrollTimerDone()
                     if(w < 1)
                       w = 1;
                     newCItem->setWidth(w);
+                    items.updateMaxWidth(newCItem);
                   }
                   redraw();
                 }
@@ -1183,6 +1193,7 @@ void Canvas::scrollTimerDone()
                       if(w < 1)
                         w = 1;
                       curItem->setWidth(w);
+                      items.updateMaxWidth(curItem);
                       redraw();
                       }
                 break;
@@ -1441,6 +1452,7 @@ void Canvas::viewMouseMoveEvent(QMouseEvent* event)
                             if(w < 1)
                               w = 1;
                             newCItem->setWidth(w);
+                            items.updateMaxWidth(newCItem);
                           }
                           }
                     if (last_dist.y()) {
@@ -1464,6 +1476,7 @@ void Canvas::viewMouseMoveEvent(QMouseEvent* event)
                            if(w < 1)
                              w = 1;
                            curItem->setWidth(w);
+                           items.updateMaxWidth(curItem);
                         }else{
                            resizeToTheLeft(ev_pos);
                         }
@@ -1851,6 +1864,7 @@ void Canvas::resizeToTheLeft(const QPoint &pos)
       newX = end.x() - 1;
    int dx = end.x() - newX;
    curItem->setWidth(dx);
+   items.updateMaxWidth(curItem);
    QPoint mp(newX, curItem->y());
    curItem->setMp(mp);
    curItem->move(mp);
@@ -123,6 +123,9 @@ CItem* CItemMap::find(const QPoint& pos) const
 void CItemMap::add(CItem* item)
       {
       std::multimap<int, CItem*, std::less<int> >::insert(std::pair<const int, CItem*> (item->bbox().x(), item));
+      const int w = item->bbox().width();
+      if (w > _maxWidth)
+            _maxWidth = w;
       }
 
 } // namespace MusEGui
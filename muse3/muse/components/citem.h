@@ -172,13 +172,25 @@ typedef std::multimap<int, CItem*, std::less<int> >::const_reverse_iterator rciC
 typedef std::pair<iCItem, iCItem> iCItemRange;
 
 class CItemMap: public std::multimap<int, CItem*, std::less<int> > {
+      // Widest item since the last clearDelete(). Never shrinks on erase,
+      //  so it is always safe to use as a search window. Items widened
+      //  in place must be reported with updateMaxWidth().
+      int _maxWidth;
+
    public:
+      CItemMap() : _maxWidth(0) {}
       void add(CItem*);
       CItem* find(const QPoint& pos) const;
+      int maxWidth() const { return _maxWidth; }
+      void updateMaxWidth(const CItem* item) {
+            if (item->bbox().width() > _maxWidth)
+                  _maxWidth = item->bbox().width();
+            }
       void clearDelete() {
             for (iCItem i = begin(); i != end(); ++i)
                   delete i->second;
             clear();
+            _maxWidth = 0;
             }
       };
 
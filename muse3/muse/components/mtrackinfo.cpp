@@ -1156,6 +1156,8 @@ void MidiTrackInfo::instrPopup()
         {
           if((*i)->iname() == s) 
           {
+            // Read the instrument's file before the audio is stopped.
+            (*i)->load();
             MusEGlobal::audio->msgIdle(true); // Make it safe to edit structures
             MusEGlobal::midiPorts[port].changeInstrument(*i);
             MusEGlobal::audio->msgIdle(false);
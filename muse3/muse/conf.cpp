@@ -1153,6 +1153,18 @@ void readConfiguration(Xml& xml, bool doReadMidiPortConfig, bool doReadGlobalCon
                               MusEGlobal::config.mixdownPath = xml.parse1();
                         else if (tag == "showNoteNamesInPianoRoll")
                               MusEGlobal::config.showNoteNamesInPianoRoll = xml.parseInt();
+                        else if (tag == "latencyCompensation")
+                              MusEGlobal::config.latencyCompensation = xml.parseInt();
+                        else if (tag == "liveMonitoring")
+                              MusEGlobal::config.liveMonitoring = xml.parseInt();
+                        else if (tag == "liveMonitoringMaxLatency")
+                              MusEGlobal::config.liveMonitoringMaxLatency = xml.parseInt();
+                        else if (tag == "midiHighResTimer")
+                              MusEGlobal::config.midiHighResTimer = xml.parseInt();
+                        else if (tag == "midiTimingReport")
+                              MusEGlobal::config.midiTimingReport = xml.parseInt();
+                        else if (tag == "undoMemoryBudget")
+                              MusEGlobal::config.undoMemoryBudget = xml.parseInt();
 
 
                         // ---- the following only skips obsolete entries ----
@@ -1743,6 +1755,12 @@ void MusE::writeGlobalConfiguration(int level, MusECore::Xml& xml) const
       xml.intTag(level, "lv2UiBehavior", static_cast<int>(MusEGlobal::config.lv2UiBehavior));
       xml.strTag(level, "mixdownPath", MusEGlobal::config.mixdownPath);
       xml.intTag(level, "showNoteNamesInPianoRoll", MusEGlobal::config.showNoteNamesInPianoRoll);
+      xml.intTag(level, "latencyCompensation", MusEGlobal::config.latencyCompensation);
+      xml.intTag(level, "liveMonitoring", MusEGlobal::config.liveMonitoring);
+      xml.intTag(level, "liveMonitoringMaxLatency", MusEGlobal::config.liveMonitoringMaxLatency);
+      xml.intTag(level, "midiHighResTimer", MusEGlobal::config.midiHighResTimer);
+      xml.intTag(level, "midiTimingReport", MusEGlobal::config.midiTimingReport);
+      xml.intTag(level, "undoMemoryBudget", MusEGlobal::config.undoMemoryBudget);
 
       for (int i = 0; i < NUM_FONTS; ++i) {
             xml.strTag(level, QString("font") + QString::number(i), MusEGlobal::config.fonts[i].toString());
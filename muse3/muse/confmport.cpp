@@ -943,6 +943,8 @@ void MPConfig::rbClicked(QTableWidgetItem* item)
                   for (MusECore::iMidiInstrument i = MusECore::midiInstruments.begin(); i
                      != MusECore::midiInstruments.end(); ++i) {
                         if ((*i)->iname() == s) {
+                              // Read the instrument's file before the audio is stopped.
+                              (*i)->load();
                               MusEGlobal::audio->msgIdle(true); // Make it safe to edit structures
                               port->changeInstrument(*i);
                               MusEGlobal::audio->msgIdle(false);
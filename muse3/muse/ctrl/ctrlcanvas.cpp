@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <limits.h>
+#include <algorithm>
 
 #include <QApplication>
 #include <QPainter>
@@ -290,6 +291,10 @@ CtrlCanvas::CtrlCanvas(MidiEditor* e, QWidget* parent, int xmag,
         _panel->setVeloPerNoteMode(_perNoteVeloMode);
       
       filterTrack=false;
+      _itemsRev = 1;
+      _partItemCacheRev = 0;
+      _itemsFrom = 0;
+      _itemsTo = 0;
 
       ctrl   = &veloList;
       _controller = &MusECore::veloCtrl;
@@ -520,6 +525,7 @@ QPoint CtrlCanvas::raster(const QPoint& p) const
 
 void CtrlCanvas::deselectAll()
       {
+        itemsChanged();
         // To save time searching the potentially large 'items' list, a selection list is used.
         for(iCItemList i = selection.begin(); i != selection.end(); ++i)
             (*i)->setSelected(false);
@@ -534,6 +540,7 @@ void CtrlCanvas::deselectAll()
 
 void CtrlCanvas::selectItem(CEvent* e)
       {
+      itemsChanged();
       e->setSelected(true);
       for (iCItemList i = selection.begin(); i != selection.end(); ++i) {
             if (*i == e) {
@@ -553,6 +560,7 @@ void CtrlCanvas::selectItem(CEvent* e)
 
 void CtrlCanvas::deselectItem(CEvent* e)
       {
+      itemsChanged();
       e->setSelected(false);
       // The item cannot be removed yet from the selection list.
       // Only itemSelectionsChanged() does that.
@@ -621,7 +629,14 @@ void CtrlCanvas::tagItems(MusECore::TagEventList* tag_list, const MusECore::Even
   {
     if(tagAllItems || tagAllParts)
     {
-      for(ciCItemList i = items.cbegin(); i != items.cend(); ++i)
+      // Items are only kept around the view, see addItem().
+      // Tagging all items must include the events that have none.
+      CItemList hidden;
+      if(tagAllItems)
+        collectItems(&hidden, BuildHidden, p0.tick(), p1.tick());
+      const CItemList* lists[2] = { &items, &hidden };
+      for(int l = 0; l < 2; ++l)
+      for(ciCItemList i = lists[l]->cbegin(); i != lists[l]->cend(); ++i)
       {
         item = static_cast<CEvent*>(*i);
         part = item->part();
@@ -645,6 +660,7 @@ void CtrlCanvas::tagItems(MusECore::TagEventList* tag_list, const MusECore::Even
           tag_list->add(part, new_e);
         }
       }
+      hidden.clearDelete();
     }
     else
     {
@@ -689,7 +705,14 @@ void CtrlCanvas::tagItems(MusECore::TagEventList* tag_list, const MusECore::Even
   {
     if(tagAllItems || tagAllParts)
     {
-      for(ciCItemList i = items.cbegin(); i != items.cend(); ++i)
+      // Items are only kept around the view, see addItem().
+      // Tagging all items must include the events that have none.
+      CItemList hidden;
+      if(tagAllItems)
+        collectItems(&hidden, BuildHidden, 0, UINT_MAX);
+      const CItemList* lists[2] = { &items, &hidden };
+      for(int l = 0; l < 2; ++l)
+      for(ciCItemList i = lists[l]->cbegin(); i != lists[l]->cend(); ++i)
       {
         item = static_cast<CEvent*>(*i);
         part = item->part();
@@ -704,6 +727,7 @@ void CtrlCanvas::tagItems(MusECore::TagEventList* tag_list, const MusECore::Even
           applyYOffset(new_e, offset_y);
         tag_list->add(part, new_e);
       }
+      hidden.clearDelete();
     }
     else
     {
@@ -854,7 +878,7 @@ void CtrlCanvas::songChanged(MusECore::SongChangedStruct_t type)
 
 void CtrlCanvas::partControllers(const MusECore::MidiPart* part, int num, int* dnum, int* didx,
                                  MusECore::MidiController** mc, MusECore::MidiCtrlValList** mcvl,
-                                 CtrlCanvasInfoStruct* ctrlInfo)
+                                 CtrlCanvasInfoStruct* ctrlInfo) const
 {
   if(num == MusECore::CTRL_VELOCITY) // special case
   {    
@@ -1056,132 +1080,254 @@ bool CtrlCanvas::itemSelectionsChanged(MusECore::Undo* operations, bool deselect
 }
 
 //---------------------------------------------------------
-//   updateItems
+//   addItem
+//    Create the item of one event if it belongs in the list.
+//    start and end are the absolute ticks its value or bar
+//     covers. Kept items are the selected ones and those
+//     reaching into the kept range. Hidden items are the
+//     others, reaching into from - to.
 //---------------------------------------------------------
 
-void CtrlCanvas::updateItems()
+void CtrlCanvas::addItem(CItemList* list, ItemBuildMode mode, unsigned from, unsigned to,
+                         const MusECore::Event& e, MusECore::Part* part, int val, int ex,
+                         unsigned start, unsigned end) const
       {
-      selection.clear();
-      items.clearDelete();
-      moving.clear();
-      cancelMouseOps();
-      
-      if(!editor->parts()->empty())
+      const bool kept = e.selected() || (start < _itemsTo && end > _itemsFrom);
+      if(mode == BuildKept ? !kept : (kept || start >= to || end <= from))
+        return;
+      CEvent* ce = new CEvent(e, part, val);
+      ce->setEX(ex);
+      if(e.selected())
+        ce->setSelected(true);
+      list->add(ce);
+      }
+
+//---------------------------------------------------------
+//   collectItems
+//    Walk the events of the shown parts and create the
+//     items of those the canvas shows, see addItem().
+//---------------------------------------------------------
+
+void CtrlCanvas::collectItems(CItemList* list, ItemBuildMode mode, unsigned from, unsigned to) const
       {
-        CEvent *newev = 0;
-  
-        for (MusECore::iPart p = editor->parts()->begin(); p != editor->parts()->end(); ++p) 
-        {
-              MusECore::Event last;
-              CEvent* lastce  = 0;
-              
-              MusECore::MidiPart* part = (MusECore::MidiPart*)(p->second);
-              
-              if (filterTrack && part->track() != curTrack)
-                continue;
-              
-              MusECore::MidiCtrlValList* mcvl;
-              partControllers(part, _cnum, 0, 0, 0, &mcvl, 0);
-              unsigned len = part->lenTick();
+      if(editor->parts()->empty())
+        return;
 
-              for (MusECore::ciEvent i = part->events().begin(); i != part->events().end(); ++i) 
-              {
-                    const MusECore::Event& e = i->second;
-                    // Do not add events which are past the end of the part.
-                    if(e.tick() >= len)
-                      break;
-                    
-                    if(_cnum == MusECore::CTRL_VELOCITY && e.type() == MusECore::Note) 
+      for (MusECore::ciPart p = editor->parts()->begin(); p != editor->parts()->end(); ++p) 
+      {
+            MusECore::MidiPart* part = (MusECore::MidiPart*)(p->second);
+            
+            if (filterTrack && part->track() != curTrack)
+              continue;
+            
+            MusECore::MidiCtrlValList* mcvl;
+            partControllers(part, _cnum, 0, 0, 0, &mcvl, 0);
+            const unsigned len = part->lenTick();
+            const unsigned ptick = part->tick();
+
+            // A controller value lasts until the next one, so each controller
+            //  item is only created once the next event is known.
+            bool first = true;
+            bool pending = false;
+            MusECore::Event pendingEvent;
+            int pendingVal = 0;
+            unsigned pendingStart = 0;
+
+            for (MusECore::ciEvent i = part->events().begin(); i != part->events().end(); ++i) 
+            {
+                  const MusECore::Event& e = i->second;
+                  // Do not add events which are past the end of the part.
+                  if(e.tick() >= len)
+                    break;
+                  
+                  if(_cnum == MusECore::CTRL_VELOCITY && e.type() == MusECore::Note) 
+                  {
+                        // Zero note on vel is not allowed now.
+                        int vel = e.velo();
+                        if(vel == 0)
+                        {
+                          fprintf(stderr, "CtrlCanvas::collectItems: Warning: Event has zero note on velocity!\n");
+                          vel = 1;
+                        }
+                        // If curDrumPitch==-2, the same note test is never true.
+                        if (curDrumPitch == -1 || !_perNoteVeloMode || e.dataA() == curDrumPitch)
+                        {
+                          const unsigned tick = e.tick() + ptick;
+                          addItem(list, mode, from, to, e, part, vel, e.tick(), tick, tick + 1);
+                        }
+                  }
+                  else if (e.type() == MusECore::Controller) 
+                  {
+                    int ctl = e.dataA();
+                    if(part->track() && part->track()->type() == MusECore::Track::DRUM && (_cnum & 0xff) == 0xff)
                     {
-                          newev = 0;
-                          // Zero note on vel is not allowed now.
-                          int vel = e.velo();
-                          if(vel == 0)
-                          {
-                            fprintf(stderr, "CtrlCanvas::updateItems: Warning: Event has zero note on velocity!\n");
-                            vel = 1;
-                          }
-                          if (curDrumPitch == -1 || !_perNoteVeloMode) // and NOT >=0
-                                items.add(newev = new CEvent(e, part, vel));
-                          else if (e.dataA() == curDrumPitch) //same note. if curDrumPitch==-2, this never is true
-                                items.add(newev = new CEvent(e, part, vel));
-                          if(newev && e.selected())
-                          {
-                            newev->setSelected(true);
-                            selection.push_back(newev);
-                          }
+                      if(curDrumPitch < 0)
+                        continue;
+                      // Default to track port if -1 and track channel if -1.
+                      int port = MusEGlobal::drumMap[ctl & 0x7f].port;
+                      if(port == -1)
+                        port = part->track()->outPort();
+                      int chan = MusEGlobal::drumMap[ctl & 0x7f].channel;
+                      if(chan == -1)
+                        chan = part->track()->outChannel();
+                      int cur_port = MusEGlobal::drumMap[curDrumPitch].port;
+                      if(cur_port == -1)
+                        cur_port = part->track()->outPort();
+                      int cur_chan = MusEGlobal::drumMap[curDrumPitch].channel;
+                      if(cur_chan == -1)
+                        cur_chan = part->track()->outChannel();
+                      if((port != cur_port) || (chan != cur_chan))
+                        continue;
+                      ctl = (ctl & ~0xff) | MusEGlobal::drumMap[ctl & 0x7f].anote;
                     }
-                    else if (e.type() == MusECore::Controller) 
+                    else if(part->track() && part->track()->type() == MusECore::Track::NEW_DRUM && (_cnum & 0xff) == 0xff)
                     {
-                      int ctl = e.dataA();
-                      if(part->track() && part->track()->type() == MusECore::Track::DRUM && (_cnum & 0xff) == 0xff)
-                      {
-                        if(curDrumPitch < 0)
-                          continue;
-                        // Default to track port if -1 and track channel if -1.
-                        int port = MusEGlobal::drumMap[ctl & 0x7f].port;
-                        if(port == -1)
-                          port = part->track()->outPort();
-                        int chan = MusEGlobal::drumMap[ctl & 0x7f].channel;
-                        if(chan == -1)
-                          chan = part->track()->outChannel();
-                        int cur_port = MusEGlobal::drumMap[curDrumPitch].port;
-                        if(cur_port == -1)
-                          cur_port = part->track()->outPort();
-                        int cur_chan = MusEGlobal::drumMap[curDrumPitch].channel;
-                        if(cur_chan == -1)
-                          cur_chan = part->track()->outChannel();
-                        if((port != cur_port) || (chan != cur_chan))
-                          continue;
-                        ctl = (ctl & ~0xff) | MusEGlobal::drumMap[ctl & 0x7f].anote;
-                      }
-                      else if(part->track() && part->track()->type() == MusECore::Track::NEW_DRUM && (_cnum & 0xff) == 0xff)
-                      {
-                        if(curDrumPitch < 0)
-                          continue;
-                        // Default to track port if -1 and track channel if -1.
-                        int port = part->track()->drummap()[ctl & 0x7f].port;
-                        if(port == -1)
-                          port = part->track()->outPort();
-                        int chan = part->track()->drummap()[ctl & 0x7f].channel;
-                        if(chan == -1)
-                          chan = part->track()->outChannel();
-
-                        int cur_port = part->track()->drummap()[curDrumPitch].port;
-                        if(cur_port == -1)
-                          cur_port = part->track()->outPort();
-                        int cur_chan = part->track()->drummap()[curDrumPitch].channel;
-                        if(cur_chan == -1)
-                          cur_chan = part->track()->outChannel();
-
-                        if((port != cur_port) || (chan != cur_chan))
-                          continue;
-                        ctl = (ctl & ~0xff) | part->track()->drummap()[ctl & 0x7f].anote;
-                      }
-
-                      if(ctl == _dnum)
-                      {
-                          if(mcvl && last.empty()) 
-                          {
-                                lastce = new CEvent(MusECore::Event(), part, mcvl->value(part->tick()));
-                                items.add(lastce);
-                          }
-                          if (lastce)
-                                lastce->setEX(e.tick());
-                          lastce = new CEvent(e, part, e.dataB());
-                          lastce->setEX(-1);
-                          items.add(lastce);
-                          if(e.selected())
-                          {
-                            lastce->setSelected(true);
-                            selection.push_back(lastce);
-                          }
-                          last = e;
-                      }
-                    }    
-              }
-        }
-      }  
+                      if(curDrumPitch < 0)
+                        continue;
+                      // Default to track port if -1 and track channel if -1.
+                      int port = part->track()->drummap()[ctl & 0x7f].port;
+                      if(port == -1)
+                        port = part->track()->outPort();
+                      int chan = part->track()->drummap()[ctl & 0x7f].channel;
+                      if(chan == -1)
+                        chan = part->track()->outChannel();
+
+                      int cur_port = part->track()->drummap()[curDrumPitch].port;
+                      if(cur_port == -1)
+                        cur_port = part->track()->outPort();
+                      int cur_chan = part->track()->drummap()[curDrumPitch].channel;
+                      if(cur_chan == -1)
+                        cur_chan = part->track()->outChannel();
+
+                      if((port != cur_port) || (chan != cur_chan))
+                        continue;
+                      ctl = (ctl & ~0xff) | part->track()->drummap()[ctl & 0x7f].anote;
+                    }
+
+                    if(ctl == _dnum)
+                    {
+                        // The value at the start of the part, drawn from the beginning up to the first event.
+                        if(mcvl && first) 
+                        {
+                              pendingEvent = MusECore::Event();
+                              pendingVal = mcvl->value(ptick);
+                              pendingStart = 0;
+                              pending = true;
+                        }
+                        first = false;
+                        if(pending)
+                              addItem(list, mode, from, to, pendingEvent, part, pendingVal, e.tick(),
+                                      pendingStart, e.tick() + ptick);
+                        pendingEvent = e;
+                        pendingVal = e.dataB();
+                        pendingStart = e.tick() + ptick;
+                        pending = true;
+                    }
+                  }    
+            }
+            // The last value lasts forever.
+            if(pending)
+                  addItem(list, mode, from, to, pendingEvent, part, pendingVal, -1, pendingStart, UINT_MAX);
+      }
+      }
+
+//---------------------------------------------------------
+//   visibleItemRange
+//    The tick range items are kept for at the current view:
+//     the visible ticks and a full view width on either
+//     side, so that scrolling a little does not rebuild them.
+//---------------------------------------------------------
+
+void CtrlCanvas::visibleItemRange(unsigned* from, unsigned* to) const
+      {
+      const int x1 = mapxDev(0);
+      const int x2 = mapxDev(width());
+      const int w = x2 > x1 ? x2 - x1 : 0;
+      *from = x1 > w ? x1 - w : 0;
+      *to = x2 + w > 0 ? x2 + w + 1 : 1;
+      }
+
+//---------------------------------------------------------
+//   itemRangeCurrent
+//    Whether the kept items still cover the view, and are
+//     not kept for a range much wider than needed.
+//---------------------------------------------------------
+
+bool CtrlCanvas::itemRangeCurrent() const
+      {
+      unsigned from, to;
+      visibleItemRange(&from, &to);
+      const int x1 = mapxDev(0);
+      const int x2 = mapxDev(width());
+      if((unsigned)(x1 > 0 ? x1 : 0) < _itemsFrom || (unsigned)(x2 > 0 ? x2 : 0) >= _itemsTo)
+        return false;
+      return (_itemsTo - _itemsFrom) <= 2 * (to - from);
+      }
+
+//---------------------------------------------------------
+//   rebuildItems
+//    Recreate the kept items for the given tick range.
+//    Any item pointers held are invalid afterwards.
+//---------------------------------------------------------
+
+void CtrlCanvas::rebuildItems(unsigned from, unsigned to)
+      {
+      itemsChanged();
+      selection.clear();
+      items.clearDelete();
+      curItem = NULL;
+      _movingItemUnderCursor = NULL;
+
+      _itemsFrom = from;
+      _itemsTo = to;
+      collectItems(&items, BuildKept, 0, 0);
+      for(ciCItemList i = items.begin(); i != items.end(); ++i)
+        if((*i)->isSelected())
+          selection.push_back(*i);
+      }
+
+//---------------------------------------------------------
+//   coverItemRange
+//    Make sure the items from x1 to x2 are kept, so that the
+//     value tools never miss an existing event. While
+//     operations or moving items are pending, the items cannot
+//     be rebuilt, so the range is clipped to the kept range.
+//    Returns false if nothing of the range is left.
+//---------------------------------------------------------
+
+bool CtrlCanvas::coverItemRange(int& x1, int& x2)
+      {
+      const unsigned lo = std::max(0, std::min(x1, x2));
+      const unsigned hi = std::max(0, std::max(x1, x2));
+      if(lo >= _itemsFrom && hi < _itemsTo)
+        return true;
+      if(moving.empty() && _operations.empty())
+      {
+        unsigned from, to;
+        visibleItemRange(&from, &to);
+        rebuildItems(std::min(from, lo), std::max(to, hi + 1));
+        return true;
+      }
+      if(hi < _itemsFrom || lo >= _itemsTo)
+        return false;
+      const int kfrom = _itemsFrom;
+      const int kto = _itemsTo - 1;
+      x1 = x1 < kfrom ? kfrom : (x1 > kto ? kto : x1);
+      x2 = x2 < kfrom ? kfrom : (x2 > kto ? kto : x2);
+      return true;
+      }
+
+//---------------------------------------------------------
+//   updateItems
+//---------------------------------------------------------
+
+void CtrlCanvas::updateItems()
+      {
+      moving.clear();
+      unsigned from, to;
+      visibleItemRange(&from, &to);
+      rebuildItems(from, to);
+      cancelMouseOps();
       redraw();
     }
 
@@ -1191,18 +1337,9 @@ void CtrlCanvas::updateItems()
 
 void CtrlCanvas::updateItemSelections()
       {
-      selection.clear();
       cancelMouseOps();
-      
-      bool obj_selected;
-      for(ciCItemList i = items.begin(); i != items.end(); ++i) {
-            // To save time searching the potentially large 'items' list, a selection list is used.
-            CItem* item = *i;
-            obj_selected = item->objectIsSelected();
-            item->setSelected(obj_selected);
-            if(obj_selected)
-              selection.push_back(item);
-      }
+      // Events selected elsewhere may have no item yet, see addItem().
+      rebuildItems(_itemsFrom, _itemsTo);
       redraw();
 }
 
@@ -1213,6 +1350,7 @@ void CtrlCanvas::updateItemSelections()
 
 void CtrlCanvas::startMoving(const QPoint& pos, int dir, bool rasterize)
       {
+      itemsChanged();
       CItem* first_item = NULL;
       for (iCItemList i = items.begin(); i != items.end(); ++i) {
             CItem* item = *i;
@@ -1316,6 +1454,7 @@ void CtrlCanvas::moveItems(const QPoint& pos, int dir, bool rasterize)
 
 void CtrlCanvas::endMoveItems()
 {
+  itemsChanged();
   if(!curPart)
     return;
   
@@ -1923,6 +2062,11 @@ void CtrlCanvas::viewMouseReleaseEvent(QMouseEvent* event)
                   // Don't change anything if the current item is moving.
                   if(!curItem || !curItem->isMoving())
                   {
+                    lasso = lasso.normalized();
+                    int lx1 = lasso.left();
+                    int lx2 = lasso.right();
+                    coverItemRange(lx1, lx2);
+
                     if (!ctrlKey)
                     {
                       deselectAll();
@@ -1930,7 +2074,6 @@ void CtrlCanvas::viewMouseReleaseEvent(QMouseEvent* event)
                     
                     if(_controller)  
                     {
-                      lasso = lasso.normalized();
                       int h = height();
                       CEvent* item;
                       for (iCItemList i = items.begin(); i != items.end(); ++i) {
@@ -2010,6 +2153,8 @@ void CtrlCanvas::newValRamp(int x1, int y1, int x2, int y2)
       //  which is not good - there should always be a spread. Nudge by +1 and recompute.
       if(xx1 == xx2)
         xx2  = editor->rasterVal2(x2 + 1);
+      if(!coverItemRange(xx1, xx2))
+        return;
       
       int type = _controller->num();
 
@@ -2081,9 +2226,13 @@ void CtrlCanvas::newValRamp(int x1, int y1, int x2, int y2)
 
 void CtrlCanvas::changeValRamp(int x1, int y1, int x2, int y2)
       {
+      itemsChanged();
       if(!curPart || !_controller)
         return;
       
+      int cx1 = x1, cx2 = x2;
+      coverItemRange(cx1, cx2);
+
       int h   = height();
       int type = _controller->num();
 
@@ -2141,9 +2290,13 @@ void CtrlCanvas::changeValRamp(int x1, int y1, int x2, int y2)
 
 void CtrlCanvas::changeVal(int x1, int x2, int y)
       {
+      itemsChanged();
       if(!curPart || !_controller)         
         return;
       
+      if(!coverItemRange(x1, x2))
+        return;
+
       bool changed = false;
       int newval = computeVal(_controller, y, height());
       int type = _controller->num();
@@ -2203,6 +2356,7 @@ void CtrlCanvas::changeVal(int x1, int x2, int y)
 
 void CtrlCanvas::newVal(int x1, int y)
       {
+      itemsChanged();
       if(!curPart || !_controller)         
         return;
       
@@ -2214,6 +2368,8 @@ void CtrlCanvas::newVal(int x1, int y)
       //  which is not good - there should always be a spread. Nudge by +1 and recompute.
       if(xx1 == xx2)
         xx2  = editor->rasterVal2(x1 + 1);
+      if(!coverItemRange(xx1, xx2))
+        return;
         
       int newval = computeVal(_controller, y, height());
       int type = _controller->num();
@@ -2406,6 +2562,7 @@ void CtrlCanvas::newVal(int x1, int y)
 
 void CtrlCanvas::newVal(int x1, int y1, int x2, int y2)
       {
+      itemsChanged();
       if(!curPart || !_controller)         
         return;
       
@@ -2438,6 +2595,8 @@ void CtrlCanvas::newVal(int x1, int y1, int x2, int y2)
       //  which is not good - there should always be a spread. Nudge by +1 and recompute.
       if(xx1 == xx2)
         xx2  = editor->rasterVal2(x2 + 1);
+      if(!coverItemRange(xx1, xx2))
+        return;
       
       int type = _controller->num();
 
@@ -2590,6 +2749,7 @@ void CtrlCanvas::newVal(int x1, int y1, int x2, int y2)
 
 void CtrlCanvas::deleteVal(int x1, int x2, int)
       {
+      itemsChanged();
       if(!curPart)         
         return;
       
@@ -2611,6 +2771,8 @@ void CtrlCanvas::deleteVal(int x1, int x2, int)
       //  which is not good - there should always be a spread. Nudge by +1 and recompute.
       if(xx1 == xx2)
         xx2  = editor->rasterVal2(x2 + 1);
+      if(!coverItemRange(xx1, xx2))
+        return;
 
       int partTick = curPart->tick();
       xx1 -= partTick;
@@ -2924,6 +3086,109 @@ void CtrlCanvas::drawMoving(QPainter& p, const QRect& rect, const QRegion& /*reg
   }
 }
 
+//---------------------------------------------------------
+//   partItemCache
+//---------------------------------------------------------
+
+CtrlCanvas::PartItemCache& CtrlCanvas::partItemCache(const MusECore::Part* part)
+{
+  if(_partItemCacheRev != _itemsRev)
+  {
+    _partItemCache.clear();
+    // Items are built part by part in time order, so each part's list comes out in time order.
+    const MusECore::Part* last_part = 0;
+    PartItemCache* pic = 0;
+    for(ciCItemList i = items.begin(); i != items.end(); ++i)
+    {
+      CEvent* e = static_cast<CEvent*>(*i);
+      if(!pic || e->part() != last_part)
+      {
+        last_part = e->part();
+        pic = &_partItemCache[last_part];
+      }
+      pic->items.push_back(e);
+    }
+    _partItemCacheRev = _itemsRev;
+  }
+
+  PartItemCache& pic = _partItemCache[part];
+  return pic;
+}
+
+//---------------------------------------------------------
+//   itemColumns
+//---------------------------------------------------------
+
+const std::vector<CtrlCanvas::ItemColumn>& CtrlCanvas::itemColumns(const MusECore::MidiPart* part, bool velo, int filter)
+{
+  PartItemCache& pic = partItemCache(part);
+  std::vector<ItemColumn>& cols = pic.columns;
+  if(!cols.empty() && pic.columnsRev == _itemsRev && pic.columnsXmag == xmag && pic.columnsXorg == xorg &&
+     pic.columnsVelo == velo && pic.columnsFilter == filter)
+    return cols;
+
+  cols.clear();
+  pic.columnsRev = _itemsRev;
+  pic.columnsXmag = xmag;
+  pic.columnsXorg = xorg;
+  pic.columnsVelo = velo;
+  pic.columnsFilter = filter;
+
+  const bool is_program = !velo && _cnum == MusECore::CTRL_PROGRAM;
+  for(std::vector<CEvent*>::const_iterator i = pic.items.begin(); i != pic.items.end(); ++i)
+  {
+    const CEvent* e = *i;
+    const MusECore::Event ev = e->event();
+    if(filter != -1 && ev.type() == MusECore::Controller && ev.dataA() != filter)
+      continue;
+    const int x = mapx(!ev.empty() ? ev.tick() + part->tick() : 0) + xpos;
+    int val = e->val();
+    if(is_program && val != MusECore::CTRL_VAL_UNKNOWN)
+    {
+      if((val & 0xff) == 0xff)
+        // What to do here? prog = 0xff should not be allowed, but may still be encountered.
+        val = 1;
+      else
+        val = (val & 0x7f) + 1;
+    }
+
+    if(cols.empty() || cols.back().x != x)
+    {
+      ItemColumn c;
+      c.x = x;
+      c.count = 0;
+      c.minVal = c.maxVal = MusECore::CTRL_VAL_UNKNOWN;
+      c.anySelected = c.anyMoving = false;
+      cols.push_back(c);
+    }
+    ItemColumn& c = cols.back();
+    ++c.count;
+    if(val != MusECore::CTRL_VAL_UNKNOWN)
+    {
+      if(c.minVal == MusECore::CTRL_VAL_UNKNOWN || val < c.minVal)
+        c.minVal = val;
+      if(c.maxVal == MusECore::CTRL_VAL_UNKNOWN || val > c.maxVal)
+        c.maxVal = val;
+    }
+    c.lastVal = val;
+    c.lastSelected = e->isSelected();
+    c.lastMoving = e->isMoving();
+    c.anySelected |= c.lastSelected;
+    c.anyMoving |= c.lastMoving;
+  }
+  return cols;
+}
+
+//---------------------------------------------------------
+//   ItemColumnBefore
+//    For searching columns by x.
+//---------------------------------------------------------
+
+struct ItemColumnBefore
+{
+  template <class C> bool operator()(int x, const C& c) const { return x < c.x; }
+};
+
 //---------------------------------------------------------
 //   pdrawItems
 //---------------------------------------------------------
@@ -2947,23 +3212,21 @@ void CtrlCanvas::pdrawItems(QPainter& p, const QRect& rect, const MusECore::Midi
   if(velo) 
   {
     noEvents=false;
-    for(iCItemList i = items.begin(); i != items.end(); ++i) 
+    const std::vector<ItemColumn>& cols = itemColumns(part, true, -1);
+    // Skip straight to the first column inside the rectangle.
+    std::vector<ItemColumn>::const_iterator ic = std::upper_bound(cols.begin(), cols.end(), x + xpos, ItemColumnBefore());
+    for( ; ic != cols.end(); ++ic) 
     {
-      CEvent* e = static_cast<CEvent*>(*i);
       // Draw selected part velocity events on top of unselected part events.
-      if(e->part() != part)
-        continue;
-      MusECore::Event event = e->event();
-      int tick = mapx(event.tick() + e->part()->tick());
-      if (tick <= x)
-            continue;
+      // A column holding several notes shows the loudest one.
+      int tick = ic->x - xpos;
       if (tick > x+w)
             break;
-      int y1 = wh - (e->val() * wh / 128);
+      int y1 = wh - (ic->maxVal * wh / 128);
       // fg means 'draw selected parts'.
       if(fg)
       {
-        if(e->isSelected())
+        if(ic->anySelected)
           //p.setPen(QPen(Qt::blue, 3));
           p.setPen(QPen(selection_color, 3));
         else
@@ -3026,46 +3289,32 @@ void CtrlCanvas::pdrawItems(QPainter& p, const QRect& rect, const MusECore::Midi
       max  = mc->maxVal();
       bias  = mc->bias();
     }
+
+    if(!items.empty())
+      noEvents=false;
+    // Draw drum controllers from another drum on top of ones from this drum.
+    const std::vector<ItemColumn>& cols = itemColumns(part, false, (is_drum_ctl || is_newdrum_ctl) ? _didx : -1);
+    
     int x1   = rect.x();
     int lval = MusECore::CTRL_VAL_UNKNOWN;
     bool selected = false;
     bool is_moving = false;
-    for (iCItemList i = items.begin(); i != items.end(); ++i) 
+    // Skip straight to the first column inside the rectangle.
+    // The column before it gives the value carried into the rectangle.
+    std::vector<ItemColumn>::const_iterator ic = std::upper_bound(cols.begin(), cols.end(), x + xpos, ItemColumnBefore());
+    if(ic != cols.begin())
+    {
+      std::vector<ItemColumn>::const_iterator prev = ic - 1;
+      if (prev->lastVal != MusECore::CTRL_VAL_UNKNOWN)
+            lval = wh - ((prev->lastVal - min - bias) * wh / (max - min));
+      selected = prev->lastSelected;
+      is_moving = prev->lastMoving;
+    }
+    
+    for ( ; ic != cols.end(); ++ic) 
     {
-      noEvents=false;
-      CEvent* e = static_cast<CEvent*>(*i);
       // Draw unselected part controller events (lines) on top of selected part events (bars).
-      if(e->part() != part)
-        continue;
-      MusECore::Event ev = e->event();
-      // Draw drum controllers from another drum on top of ones from this drum.
-      if((is_drum_ctl || is_newdrum_ctl) && ev.type() == MusECore::Controller && ev.dataA() != _didx)
-        continue;
-      int tick = mapx(!ev.empty() ? ev.tick() + e->part()->tick() : 0);
-      int val = e->val();
-      int pval = val;
-      if(cnum == MusECore::CTRL_PROGRAM)
-      {
-        if((val & 0xff) == 0xff)
-          // What to do here? prog = 0xff should not be allowed, but may still be encountered.
-          pval = 1;
-        else  
-          pval = (val & 0x7f) + 1;
-      }
-      if (tick <= x) {
-            if (val == MusECore::CTRL_VAL_UNKNOWN)
-                  lval = MusECore::CTRL_VAL_UNKNOWN;
-            else
-            {
-                  if(cnum == MusECore::CTRL_PROGRAM)
-                    lval = wh - ((pval - min - bias) * wh / (max - min));
-                  else  
-                    lval = wh - ((val - min - bias) * wh / (max - min));
-            }
-            selected = e->isSelected();
-            is_moving = e->isMoving();
-            continue;
-            }
+      int tick = ic->x - xpos;
       if (tick > x+w)
             break;
 
@@ -3085,17 +3334,32 @@ void CtrlCanvas::pdrawItems(QPainter& p, const QRect& rect, const MusECore::Midi
       }
       
       x1 = tick;
-      if (val == MusECore::CTRL_VAL_UNKNOWN)
+      // Several values on one pixel column. Draw the whole range they cover,
+      //  rather than only the last one which would hide any peaks.
+      if (ic->count > 1 && ic->maxVal != MusECore::CTRL_VAL_UNKNOWN)
+      {
+        const int ytop = wh - ((ic->maxVal - min - bias) * wh / (max - min));
+        if(fg)
+        {
+          const int ybot = wh - ((ic->minVal - min - bias) * wh / (max - min));
+          pen.setColor(gray_color);
+          p.setPen(pen);
+          p.drawLine(tick, ytop, tick, ybot);
+        }
+        else
+        {
+          fill_color = ic->anyMoving ? light_gray_color : (ic->anySelected ? selection_color : graph_fg_color);
+          p.fillRect(tick, ytop, 1, wh - ytop, fill_color);
+          ++x1;
+        }
+      }
+      
+      if (ic->lastVal == MusECore::CTRL_VAL_UNKNOWN)
             lval = MusECore::CTRL_VAL_UNKNOWN;
       else
-      {
-            if(cnum == MusECore::CTRL_PROGRAM)
-              lval = wh - ((pval - min - bias) * wh / (max - min));
-            else  
-              lval = wh - ((val - min - bias) * wh / (max - min));
-      } 
-      selected = e->isSelected();     
-      is_moving = e->isMoving();
+            lval = wh - ((ic->lastVal - min - bias) * wh / (max - min));
+      selected = ic->lastSelected;     
+      is_moving = ic->lastMoving;
     }
     
     if (lval != MusECore::CTRL_VAL_UNKNOWN)
@@ -3180,13 +3444,12 @@ void CtrlCanvas::pdrawExtraDrumCtrlItems(QPainter& p, const QRect& rect, const M
     }
     int x1   = rect.x();
     int lval = MusECore::CTRL_VAL_UNKNOWN;
-    for (iCItemList i = items.begin(); i != items.end(); ++i) 
-    {
+    if(!items.empty())
       noEvents=false;
-      CEvent* e = static_cast<CEvent*>(*i);
-      // Draw unselected part controller events (lines) on top of selected part events (bars).
-      if(e->part() != part)
-        continue;
+    const std::vector<CEvent*>& part_items = partItemCache(part).items;
+    for (std::vector<CEvent*>::const_iterator i = part_items.begin(); i != part_items.end(); ++i) 
+    {
+      CEvent* e = *i;
       MusECore::Event ev = e->event();
       // Draw drum controllers from another drum on top of ones from this drum.
       // FIXME TODO Finish this off, not correct yet.
@@ -3257,6 +3520,15 @@ void CtrlCanvas::pdraw(QPainter& p, const QRect& rect, const QRegion& region)
       if(!_controller)   
         return;
 
+      // The view has scrolled or zoomed away from the kept items.
+      // Not while dragging, the items are in use then.
+      if(drag == DRAG_OFF && moving.empty() && _operations.empty() && !itemRangeCurrent())
+      {
+        unsigned from, to;
+        visibleItemRange(&from, &to);
+        rebuildItems(from, to);
+      }
+
       QPen pen;
       pen.setCosmetic(true);
       
@@ -3556,6 +3828,7 @@ void CtrlCanvas::setMouseGrab(bool grabbed)
 
 bool CtrlCanvas::clearMoving()
 {
+  itemsChanged();
   bool changed = false;
   // Be sure to clear the moving list and especially the item moving flags!
   if(!moving.empty())
@@ -24,6 +24,8 @@
 #define __CTRLCANVAS_H__
 
 #include <set>
+#include <map>
+#include <vector>
 
 #include "type_defs.h"
 #include "view.h"
@@ -146,6 +148,80 @@ class CtrlCanvas : public MusEGui::View {
       unsigned int _dragFirstXPos;
       //Qt::CursorShape _cursorShape;
 
+      //---------------------------------------------------------
+      //   ItemColumn
+      //    All of a part's items which land on one pixel column
+      //     at the current zoom, reduced to their envelope.
+      //---------------------------------------------------------
+
+      struct ItemColumn
+      {
+        // Column in unscrolled view coordinates, mapx(tick) + xpos.
+        int x;
+        int count;
+        // Lowest and highest known value. Program values are already mapped to 1..128.
+        // Both are CTRL_VAL_UNKNOWN if no item in the column has a known value.
+        int minVal;
+        int maxVal;
+        // The last item in the column carries on to the next one.
+        int lastVal;
+        bool lastSelected;
+        bool lastMoving;
+        bool anySelected;
+        bool anyMoving;
+      };
+
+      //---------------------------------------------------------
+      //   PartItemCache
+      //    A part's items in time order, and their columns.
+      //    Drawing walks the columns instead of the items, so a
+      //     dense controller stream costs one draw per pixel.
+      //---------------------------------------------------------
+
+      struct PartItemCache
+      {
+        std::vector<CEvent*> items;
+        std::vector<ItemColumn> columns;
+        // What the columns were built for.
+        unsigned columnsRev;
+        int columnsXmag;
+        int columnsXorg;
+        int columnsFilter;
+        bool columnsVelo;
+      };
+
+      std::map<const MusECore::Part*, PartItemCache> _partItemCache;
+      // Bumped on any change to the items, their values, selection or moving state.
+      unsigned _itemsRev;
+      // The item revision _partItemCache was grouped at.
+      unsigned _partItemCacheRev;
+      // Items are only kept for events whose value reaches into this tick
+      //  range, which follows the view, and for the selected events.
+      unsigned _itemsFrom;
+      unsigned _itemsTo;
+
+      enum ItemBuildMode { BuildKept, BuildHidden };
+      void addItem(CItemList* list, ItemBuildMode mode, unsigned from, unsigned to,
+                   const MusECore::Event& e, MusECore::Part* part, int val, int ex,
+                   unsigned start, unsigned end) const;
+      // Creates the kept items, or with BuildHidden the others reaching into from - to.
+      void collectItems(CItemList* list, ItemBuildMode mode, unsigned from, unsigned to) const;
+      // The range items should be kept for at the current view.
+      void visibleItemRange(unsigned* from, unsigned* to) const;
+      bool itemRangeCurrent() const;
+      // Recreates the kept items for the range. Invalidates all item pointers.
+      void rebuildItems(unsigned from, unsigned to);
+      // Makes sure the items from x1 to x2 are kept, or clips the range to the kept items.
+      // Returns false if nothing of the range is left.
+      bool coverItemRange(int& x1, int& x2);
+
+      void itemsChanged() { ++_itemsRev; }
+      // The part's items in time order. Regroups all items if they changed since the last call.
+      PartItemCache& partItemCache(const MusECore::Part* part);
+      // The part's columns at the current zoom. Only controller items whose
+      //  dataA is filter are included if filter is not -1.
+      const std::vector<ItemColumn>& itemColumns(const MusECore::MidiPart* part, bool velo, int filter);
+
       void applyYOffset(MusECore::Event& e, int yoffset) const;
 
       void viewMousePressEvent(QMouseEvent* event);
@@ -174,7 +250,7 @@ class CtrlCanvas : public MusEGui::View {
         const MusECore::MidiPart* part, int num,
         int* dnum, int* didx,
         MusECore::MidiController** mc, MusECore::MidiCtrlValList** mcvl,
-        CtrlCanvasInfoStruct* ctrlInfo);
+        CtrlCanvasInfoStruct* ctrlInfo) const;
       // Checks if the current drum pitch requires setting the midi controller and rebuilding the items.
       // Returns whether setMidiController() and updateItems() were in fact called.
       bool drumPitchChanged();
@@ -557,6 +557,10 @@ bool MidiAlsaDevice::processEvent(const MidiPlayEvent& ev)
               event.data.control.value = a;
               event.type = SND_SEQ_EVENT_SONGPOS;
               break;
+        case ME_MTC_QUARTER:
+              event.data.control.value = a;
+              event.type = SND_SEQ_EVENT_QFRAME;
+              break;
         case ME_CLOCK:
               event.type = SND_SEQ_EVENT_CLOCK;
               break;
@@ -1044,6 +1048,9 @@ void MidiAlsaDevice::processMidi(unsigned int curFrame)
       processEvent(e);
     }
     
+    // How late the event was dispatched, against the audio clock.
+    MusEGlobal::midiSeq->timingHistogram().add(curFrame - e.time());
+    
     // Successfully processed event. Remove it from FIFO.
     // C++11.
     if(using_pb)
@@ -1053,6 +1060,38 @@ void MidiAlsaDevice::processMidi(unsigned int curFrame)
   }
 }
 
+//---------------------------------------------------------
+//   nextProcessFrame
+//   Called from ALSA midi sequencer thread only.
+//---------------------------------------------------------
+
+bool MidiAlsaDevice::nextProcessFrame(unsigned int* frame)
+{
+  bool found = false;
+  unsigned int fr = 0;
+
+  SysExOutputProcessor* sop = sysExOutProcessor();
+  if(sop->state() != SysExOutputProcessor::Clear)
+  {
+    fr = sop->curChunkFrame();
+    found = true;
+  }
+  if(!_outPlaybackEvents.empty() && (!found || _outPlaybackEvents.begin()->time() < fr))
+  {
+    fr = _outPlaybackEvents.begin()->time();
+    found = true;
+  }
+  if(!_outUserEvents.empty() && (!found || _outUserEvents.begin()->time() < fr))
+  {
+    fr = _outUserEvents.begin()->time();
+    found = true;
+  }
+
+  if(found)
+    *frame = fr;
+  return found;
+}
+
 //---------------------------------------------------------
 //   initMidiAlsa
 //    return true on error
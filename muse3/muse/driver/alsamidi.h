@@ -87,6 +87,7 @@ class MidiAlsaDevice : public MidiDevice {
       
       // Play all events up to current frame.
       virtual void processMidi(unsigned int curFrame = 0);
+      virtual bool nextProcessFrame(unsigned int* frame);
 
       virtual void setAddressClient(int client) { adr.client = client; }
       virtual void setAddressPort(int port) { adr.port = port; }
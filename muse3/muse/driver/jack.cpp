@@ -107,6 +107,7 @@ bool jack1_port_by_name_workaround = false;
 jack_get_version_type             jack_get_version_fp = NULL;  
 jack_port_set_name_type           jack_port_set_name_fp = NULL;
 jack_port_rename_type             jack_port_rename_fp = NULL;
+jack_set_port_rename_callback_type jack_set_port_rename_callback_fp = NULL;
 
 
 //---------------------------------------------------------
@@ -435,6 +436,8 @@ JackAudioDevice::~JackAudioDevice()
       {
       if (JACK_DEBUG)
             fprintf(stderr, "~JackAudioDevice()\n");
+      // The graph thread talks to the client, stop it first.
+      _graph.stopGraph();
       if (_client) {
             if (jack_client_close(_client)) {
                   fprintf(stderr,"jack_client_close() failed: %s\n", strerror(errno));
@@ -515,6 +518,9 @@ bool initJackAudio()
       {
       }
       
+      jack_set_port_rename_callback_fp = reinterpret_cast<jack_set_port_rename_callback_type>(dlsym(RTLD_DEFAULT, "jack_set_port_rename_callback"));
+      DEBUG_PRST_ROUTES(stderr, "initJackAudio jack_set_port_rename_callback() address:%p \n", jack_set_port_rename_callback_fp);
+      
       if (MusEGlobal::debugMsg) {
             fprintf(stderr, "initJackAudio(): registering error and info callbacks...\n");
             jack_set_error_function(jackError);
@@ -632,7 +638,7 @@ static int srate_callback(jack_nframes_t n, void*)
 //   registration_callback
 //---------------------------------------------------------
 
-static void registration_callback(jack_port_id_t port_id, int is_register, void*)
+static void registration_callback(jack_port_id_t port_id, int is_register, void* arg)
 {
   if(MusEGlobal::debugMsg || JACK_DEBUG)
     fprintf(stderr, "JACK: registration_callback\n");
@@ -649,6 +655,7 @@ static void registration_callback(jack_port_id_t port_id, int is_register, void*
   ev.port_id_A = port_id;
 
   jackCallbackFifo.put(ev);
+  ((JackAudioDevice*)arg)->graph().portRegistered(port_id, is_register);
 
   // NOTE: Jack-1 does not issue a graph order callback after a registration call. 
   // Jack-1 callbacks: [ port connect -> graph order -> registration ] {...}
@@ -710,6 +717,34 @@ static void port_connect_callback(jack_port_id_t a, jack_port_id_t b, int isConn
     }
     
     jackCallbackFifo.put(ev);
+    jad->graph().portConnected(a, b, isConnect);
+}
+
+//---------------------------------------------------------
+//   port_rename_callback
+//    Jack-2 declares this returning void, Jack-1 returning int.
+//    Returning int is harmless for both.
+//---------------------------------------------------------
+
+static int port_rename_callback(jack_port_id_t port, const char* old_name, const char* new_name, void* arg)
+{
+  if (MusEGlobal::debugMsg || JACK_DEBUG)
+      fprintf(stderr, "JACK: port renamed: id:%d old:%s new:%s\n", port, old_name, new_name);
+  
+  DEBUG_PRST_ROUTES(stderr, "JACK: port_rename_callback id:%d old:%s new:%s\n", port, old_name, new_name);
+
+  ((JackAudioDevice*)arg)->graph().portRenamed(port, old_name);
+
+  // Let the routes pick up the new name. Jack does not issue a graph order callback for this.
+  JackCallbackEvent ev;
+  ev.type = GraphChanged;
+  jackCallbackFifo.put(ev);
+  if(muse_atomic_read(&atomicGraphChangedPending) == 0)
+  {
+    muse_atomic_set(&atomicGraphChangedPending, 1);
+    MusEGlobal::audio->sendMsgToGui('C');
+  }
+  return 0;
 }
 
 //---------------------------------------------------------
@@ -753,7 +788,7 @@ void JackAudioDevice::processJackCallbackEvents(const Route& our_node, jack_port
 
   if(our_port && our_port_name && jack1_port_by_name_workaround)
   {
-    jack_port_t* jp = jack_port_by_name(client, our_port_name);
+    jack_port_t* jp = graphPortByName(our_port_name);
     if(jp && jp != our_port)
     {
       DEBUG_PRST_ROUTES(stderr, "JackAudioDevice::processJackCallbackEvents: changing audio input port!: channel:%d our_port:%p new port:%p\n", 
@@ -768,13 +803,21 @@ void JackAudioDevice::processJackCallbackEvents(const Route& our_node, jack_port
     if((ir->type != Route::JACK_ROUTE) || (our_node.channel != -1 && ir->channel != our_node.channel))
       continue;
     const char* route_jpname = ir->persistentJackPortName;
-    // FIXME: TODO: Maybe switch to get_ports
-    jack_port_t* jp = jack_port_by_name(client, route_jpname);
+    jack_port_t* jp = graphPortByName(route_jpname);
     if(jp)
     {
-      // TODO: For Jack-2 maybe alter this? Before calling jack_port_connected_to(), maybe first check if the IDs 
-      //        (hence jack ports) passed in the connect callback match here, to avoid calling jack_port_connected_to() ?
-      if(our_port && jack_port_connected_to(our_port, route_jpname)) 
+      bool is_connected = false;
+      if(our_port)
+      {
+        const JackGraphPort* our_gp = _graphSnapshot ? _graphSnapshot->find(our_port_name) : NULL;
+        const JackGraphPort* route_gp = _graphSnapshot ? _graphSnapshot->find(route_jpname) : NULL;
+        if(our_gp && route_gp)
+          is_connected = _graphSnapshot->connected(*our_gp, *route_gp);
+        else
+          is_connected = jack_port_connected_to(our_port, route_jpname);
+      }
+      
+      if(is_connected) 
       {
         // The ports are connected. Keep the route node but update its jack port pointer if necessary.
         const char* s = NULL;
@@ -786,7 +829,7 @@ void JackAudioDevice::processJackCallbackEvents(const Route& our_node, jack_port
         }
         // Find a more appropriate name if necessary.
         char fin_name[ROUTE_PERSISTENT_NAME_SIZE];
-        portName(jp, fin_name, ROUTE_PERSISTENT_NAME_SIZE);
+        graphPortName(route_jpname, jp, fin_name, ROUTE_PERSISTENT_NAME_SIZE);
         if(strcmp(ir->persistentJackPortName, fin_name) != 0)
         {
           DEBUG_PRST_ROUTES(stderr, "processJackCallbackEvents: Ports connected. Modifying route name: route_persistent_name:%s new name:%s\n", route_jpname, fin_name);
@@ -853,7 +896,7 @@ void JackAudioDevice::processJackCallbackEvents(const Route& our_node, jack_port
                   // Find a more appropriate name if necessary.
                   const char* s = ir->persistentJackPortName;
                   char fin_name[ROUTE_PERSISTENT_NAME_SIZE];
-                  portName(jp, fin_name, ROUTE_PERSISTENT_NAME_SIZE);
+                  graphPortName(route_jpname, jp, fin_name, ROUTE_PERSISTENT_NAME_SIZE);
                   if(strcmp(ir->persistentJackPortName, fin_name) != 0)
                   {
                     DEBUG_PRST_ROUTES(stderr, "processJackCallbackEvents: Ports connected. Modifying route name: route_persistent_name:%s new name:%s\n", route_jpname, fin_name);
@@ -944,7 +987,12 @@ void JackAudioDevice::graphChanged()
     for(int i = 0; i <= last_gc_idx; ++i)
       jackCallbackEvents.push_back(jackCallbackFifo.get());
   }
+  // Let the graph thread catch up with the callbacks so far,
+  //  so the route checks can use it instead of asking jack.
+  // This is the only place which waits for it, once per batch of changes.
+  _graphSnapshot = _graph.sync() ? _graph.snapshot() : JackGraphSnapshotRef();
   processGraphChanges();
+  _graphSnapshot.reset();
   
   if(!operations.empty())
   {
@@ -1029,14 +1077,28 @@ void JackAudioDevice::checkNewRouteConnections(jack_port_t* our_port, int channe
   DEBUG_PRST_ROUTES(stderr, "JackAudioDevice::checkNewRouteConnections(): client:%p our_port:%p channel:%d route_list:%p\n", 
           _client, our_port, channel, route_list);
   // Check for new connections...
-  const char** ports = jack_port_get_all_connections(_client, our_port);
-  if(ports) 
+  // Take them from the graph if possible, otherwise ask jack.
+  std::vector<const char*> names;
+  const char** ports = NULL;
+  const JackGraphPort* our_gp = _graphSnapshot ? _graphSnapshot->find(jack_port_name(our_port)) : NULL;
+  if(our_gp)
+  {
+    for(std::vector<int>::const_iterator ic = our_gp->connections.begin(); ic != our_gp->connections.end(); ++ic)
+      names.push_back(_graphSnapshot->port(*ic).name.c_str());
+  }
+  else
   {
-    const char** pn = ports;
-    while(*pn) 
+    ports = jack_port_get_all_connections(_client, our_port);
+    for(const char** pn = ports; pn && *pn; ++pn)
+      names.push_back(*pn);
+  }
+  
+  if(!names.empty()) 
+  {
+    for(std::vector<const char*>::const_iterator pn = names.begin(); pn != names.end(); ++pn)
     {
       // Should be safe and quick search here, we know that the port name is valid.
-      jack_port_t* jp = jack_port_by_name(_client, *pn);
+      jack_port_t* jp = graphPortByName(*pn);
       if(jp)
       {
         bool found = false;
@@ -1081,8 +1143,7 @@ void JackAudioDevice::checkNewRouteConnections(jack_port_t* our_port, int channe
             continue; // Ignore the route node - it has been scheduled for deletion.
           }
           
-          // TODO: Maybe switch to get_ports
-          if(op_jp == jp || jack_port_by_name(_client, op_ppname) == jp)
+          if(op_jp == jp || graphPortByName(op_ppname) == jp)
           {
             found = true;
             break;
@@ -1092,16 +1153,49 @@ void JackAudioDevice::checkNewRouteConnections(jack_port_t* our_port, int channe
         {
           Route r(Route::JACK_ROUTE, 0, jp, channel, 0, 0, NULL);
           // Find a better name.
-          portName(jp, r.persistentJackPortName, ROUTE_PERSISTENT_NAME_SIZE);
+          graphPortName(*pn, jp, r.persistentJackPortName, ROUTE_PERSISTENT_NAME_SIZE);
           DEBUG_PRST_ROUTES(stderr, " adding route: route_jp:%p portname:%s route_persistent_name:%s\n", 
                   jp, *pn, r.persistentJackPortName);
           operations.add(PendingOperationItem(route_list, r, PendingOperationItem::AddRouteNode));
         }
       }
-      ++pn;
     }
-    jack_free(ports);
   }
+  if(ports)
+    jack_free(ports);
+}
+
+//---------------------------------------------------------
+//   currentGraph
+//---------------------------------------------------------
+
+JackGraphSnapshotRef JackAudioDevice::currentGraph() const
+{
+  return _graph.currentSnapshot();
+}
+
+//---------------------------------------------------------
+//   graphPortByName
+//---------------------------------------------------------
+
+jack_port_t* JackAudioDevice::graphPortByName(const char* name)
+{
+  const JackGraphPort* gp = _graphSnapshot ? _graphSnapshot->find(name) : NULL;
+  if(!gp)
+    return jack_port_by_name(_client, name);
+  return gp->port;
+}
+
+//---------------------------------------------------------
+//   graphPortName
+//---------------------------------------------------------
+
+char* JackAudioDevice::graphPortName(const char* name, jack_port_t* port, char* str, int str_size)
+{
+  const JackGraphPort* gp = _graphSnapshot ? _graphSnapshot->find(name) : NULL;
+  if(!gp)
+    return portName(port, str, str_size);
+  return MusELib::strntcpy(str, gp->persistentName.c_str(), str_size);
 }
 
 int JackAudioDevice::checkDisconnectCallback(const jack_port_t* our_port, const jack_port_t* port)
@@ -1202,13 +1296,16 @@ void JackAudioDevice::registerClient()
       jack_set_port_registration_callback(_client, registration_callback, this);
       jack_set_client_registration_callback(_client, client_registration_callback, 0);
       jack_set_port_connect_callback(_client, port_connect_callback, this);
-      // Can't use this! Incompatible in jack 1/2 and unimplemented in jack1.
-      //jack_set_port_rename_callback(_client, port_rename_callback, 0);
+      // Looked up with dlsym since the callback type differs in jack 1/2. Unimplemented in jack1.
+      if(jack_set_port_rename_callback_fp)
+        jack_set_port_rename_callback_fp(_client, port_rename_callback, this);
       jack_set_graph_order_callback(_client, graph_callback, this);
 //      jack_set_xrun_callback(client, xrun_callback, 0);
       jack_set_freewheel_callback (_client, freewheel_callback, 0);
 
       jack_set_xrun_callback(_client, static_JackXRunCallback, this);
+      
+      _graph.startGraph(_client);
       }
 
 //---------------------------------------------------------
@@ -1348,6 +1445,15 @@ bool JackAudioDevice::portsCanDisconnect(void* src, void* dst) const
   if(!src || !dst)
     return false;
   
+  JackGraphSnapshotRef graph = currentGraph();
+  if(graph)
+  {
+    const JackGraphPort* src_gp = graph->find(jack_port_name((jack_port_t*)src));
+    const JackGraphPort* dst_gp = graph->find(jack_port_name((jack_port_t*)dst));
+    if(src_gp && dst_gp)
+      return graph->connected(*src_gp, *dst_gp);
+  }
+  
   const char** ports = jack_port_get_all_connections(_client, (jack_port_t*)src);
   if(!ports)
     return false;
@@ -1391,6 +1497,15 @@ bool JackAudioDevice::portsCanConnect(void* src, void* dst) const
   if(!(jack_port_flags((jack_port_t*)src) & JackPortIsOutput) || !(jack_port_flags((jack_port_t*)dst) & JackPortIsInput))
     return false;
   
+  JackGraphSnapshotRef graph = currentGraph();
+  if(graph)
+  {
+    const JackGraphPort* src_gp = graph->find(jack_port_name((jack_port_t*)src));
+    const JackGraphPort* dst_gp = graph->find(jack_port_name((jack_port_t*)dst));
+    if(src_gp && dst_gp)
+      return !graph->connected(*src_gp, *dst_gp);
+  }
+  
   const char** ports = jack_port_get_all_connections(_client, (jack_port_t*)src);
   if(!ports)
     return true;
@@ -1466,6 +1581,9 @@ bool JackAudioDevice::start(int /*priority*/)
             
       MusEGlobal::undoSetuid();
       
+      // Ports registered while inactive did not send callbacks. List everything again.
+      _graph.requestRescan();
+      
       /* connect the ports. Note: you can't do this before
          the client is activated, because we can't allow
          connections to be made to clients that aren't
@@ -1762,6 +1880,55 @@ void JackAudioDevice::getJackPorts(const char** ports, std::list<QString>& name_
             }
       }
       
+//---------------------------------------------------------
+//   getGraphPorts
+//    Same as getJackPorts(), from the graph.
+//---------------------------------------------------------
+
+void JackAudioDevice::getGraphPorts(const JackGraphSnapshot& graph, std::list<QString>& name_list, bool midi, bool is_output, bool physical, int aliases)
+      {
+      QString qname;
+      QString cname(jack_get_client_name(_client));
+      const int dir_flag = is_output ? JackPortIsOutput : JackPortIsInput;
+      
+      for (int i = 0; i < graph.size(); ++i) {
+            const JackGraphPort& port = graph.port(i);
+            if(!(port.flags & dir_flag) || (midi ? !port.midi : !port.audio))
+              continue;
+            // Ignore our own client ports.
+            if(port.mine)
+              continue;         
+
+            bool mthrough = false;
+            
+            if(midi && port.aliasCount >= 1)
+            {  
+              qname = QString(port.aliases[0].c_str());
+              // Ignore our own ALSA client!
+              if(qname.startsWith(QString("alsa_pcm:") + cname + QString("/")))
+                continue;
+              // Put Midi Through after all others.
+              mthrough = qname.startsWith(QString("alsa_pcm:Midi-Through/"));  
+            }  
+            // Put physical/terminal ports before others.
+            bool is_phys = (port.flags & (JackPortIsTerminal | JackPortIsPhysical)) && !mthrough;
+            if((physical && !is_phys) || (!physical && is_phys))
+              continue;
+
+            if(((aliases == 0) || (aliases == 1)) && port.aliasCount > 0) 
+            {
+              int a = aliases;
+              if(a >= port.aliasCount)
+                a = port.aliasCount - 1;
+              qname = QString(port.aliases[a].c_str());
+            }
+            else
+              qname = QString(port.name.c_str());
+            
+            name_list.push_back(qname);
+            }
+      }
+      
 //---------------------------------------------------------
 //   outputPorts
 //---------------------------------------------------------
@@ -1772,6 +1939,15 @@ std::list<QString> JackAudioDevice::outputPorts(bool midi, int aliases)
             fprintf(stderr, "JackAudioDevice::outputPorts()\n");
       std::list<QString> clientList;
       if(!checkJackClient(_client)) return clientList;
+      
+      JackGraphSnapshotRef graph = currentGraph();
+      if(graph)
+      {
+        getGraphPorts(*graph, clientList, midi, true, true, aliases);   // Get physical ports first.
+        getGraphPorts(*graph, clientList, midi, true, false, aliases);  // Get non-physical ports last.
+        return clientList;
+      }
+      
       const char* type = midi ? JACK_DEFAULT_MIDI_TYPE : JACK_DEFAULT_AUDIO_TYPE;
       const char** ports = jack_get_ports(_client, 0, type, JackPortIsOutput);
       
@@ -1796,6 +1972,15 @@ std::list<QString> JackAudioDevice::inputPorts(bool midi, int aliases)
       
       std::list<QString> clientList;
       if(!checkJackClient(_client)) return clientList;
+      
+      JackGraphSnapshotRef graph = currentGraph();
+      if(graph)
+      {
+        getGraphPorts(*graph, clientList, midi, false, true, aliases);   // Get physical ports first.
+        getGraphPorts(*graph, clientList, midi, false, false, aliases);  // Get non-physical ports last.
+        return clientList;
+      }
+      
       const char* type = midi ? JACK_DEFAULT_MIDI_TYPE : JACK_DEFAULT_AUDIO_TYPE;
       const char** ports = jack_get_ports(_client, 0, type, JackPortIsInput);
       
@@ -28,6 +28,7 @@
 #include <list> 
 #include "audiodev.h"
 #include "operations.h" 
+#include "jackgraph.h"
 
 class QString;
 
@@ -64,8 +65,23 @@ class JackAudioDevice : public AudioDevice {
       PendingOperationList operations;
       // Temporary, for processing callback event FIFO.
       JackCallbackEventList jackCallbackEvents; 
+      // Ports and connections, kept by a background thread.
+      // Mutable since the const connection queries read it.
+      mutable JackGraph _graph;
+      // Temporary, the graph while processing graph changes. Null if the graph is not available.
+      JackGraphSnapshotRef _graphSnapshot;
       
       void getJackPorts(const char** ports, std::list<QString>& name_list, bool midi, bool physical, int aliases);
+      void getGraphPorts(const JackGraphSnapshot& graph, std::list<QString>& name_list, bool midi, bool is_output, bool physical, int aliases);
+      // The current graph, or null if it is not available or still has changes
+      //  to apply, in which case the callers ask jack. Never waits, so queries
+      //  made one after another from the gui cannot stall it.
+      JackGraphSnapshotRef currentGraph() const;
+      // While processing graph changes: Finds a port by name in the graph, or through jack if the graph
+      //  is not available or does not know the name.
+      jack_port_t* graphPortByName(const char* name);
+      // While processing graph changes: The persistent name of a port found by name. 
+      char* graphPortName(const char* name, jack_port_t* port, char* str, int str_size);
       static int processAudio(jack_nframes_t frames, void*);
       
       void processGraphChanges();
@@ -95,6 +111,7 @@ class JackAudioDevice : public AudioDevice {
       virtual unsigned framesSinceCycleStart() const;
 
       jack_client_t* jackClient() const { return _client; }
+      JackGraph& graph() { return _graph; }
       virtual void registerClient();
       virtual const char* clientName() { return jackRegisteredName; }
       virtual void nullify_client() { _client = 0; }
@@ -176,6 +193,10 @@ extern jack_port_set_name_type           jack_port_set_name_fp;
 typedef int(*jack_port_rename_type)(jack_client_t*, jack_port_t*, const char*);
 extern jack_port_rename_type             jack_port_rename_fp;
 
+typedef int(*jack_port_rename_callback_type)(jack_port_id_t, const char*, const char*, void*);
+typedef int(*jack_set_port_rename_callback_type)(jack_client_t*, jack_port_rename_callback_type, void*);
+extern jack_set_port_rename_callback_type jack_set_port_rename_callback_fp;
+
 
 } // namespace MusECore
 
@@ -0,0 +1,608 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  jackgraph.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+
+#include <string.h>
+#include <algorithm>
+
+#include <QMutexLocker>
+
+#include "jackgraph.h"
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   JackGraphSnapshot
+//---------------------------------------------------------
+
+const JackGraphPort* JackGraphSnapshot::find(const char* name) const
+{
+  if(!name || name[0] == '\0')
+    return NULL;
+  std::unordered_map<std::string, int>::const_iterator i = _byName.find(name);
+  if(i == _byName.end())
+    return NULL;
+  return &_ports[i->second];
+}
+
+bool JackGraphSnapshot::connected(const JackGraphPort& a, const JackGraphPort& b) const
+{
+  const int idx = &b - &_ports[0];
+  for(std::vector<int>::const_iterator i = a.connections.begin(); i != a.connections.end(); ++i)
+    if(*i == idx)
+      return true;
+  return false;
+}
+
+//---------------------------------------------------------
+//   persistentPortName
+//    Same choice as JackAudioDevice::portName() with no
+//     preference: the first of the name and the aliases
+//     which is not on the "system:" client.
+//---------------------------------------------------------
+
+static const std::string& persistentPortName(const JackGraphPort& p)
+{
+  // TODO: Make this a user editable blacklist of client names!
+  if(!p.name.empty() && p.name.compare(0, 7, "system:") != 0)
+    return p.name;
+  for(int i = 0; i < p.aliasCount; ++i)
+    if(!p.aliases[i].empty() && p.aliases[i].compare(0, 7, "system:") != 0)
+      return p.aliases[i];
+  if(!p.name.empty())
+    return p.name;
+  for(int i = 0; i < p.aliasCount; ++i)
+    if(!p.aliases[i].empty())
+      return p.aliases[i];
+  return p.name;
+}
+
+//---------------------------------------------------------
+//   JackGraph
+//---------------------------------------------------------
+
+JackGraph::JackGraph()
+   : _nextOrder(0), _client(NULL), _postedSerial(0), _appliedSerial(0)
+{
+}
+
+JackGraph::~JackGraph()
+{
+  stopGraph();
+}
+
+//---------------------------------------------------------
+//   startGraph
+//---------------------------------------------------------
+
+void JackGraph::startGraph(jack_client_t* client)
+{
+  if(isRunning() || !client)
+    return;
+  _client = client;
+  start(QThread::LowPriority);
+  requestRescan();
+}
+
+//---------------------------------------------------------
+//   stopGraph
+//---------------------------------------------------------
+
+void JackGraph::stopGraph()
+{
+  if(!isRunning())
+    return;
+  post(DeltaQuit);
+  wait();
+
+  QMutexLocker ml(&_mutex);
+  _queue.clear();
+  _snapshot.reset();
+  _appliedSerial = _postedSerial;
+  _applied.wakeAll();
+  _ports.clear();
+  _idNames.clear();
+  _formerNames.clear();
+  _client = NULL;
+}
+
+//---------------------------------------------------------
+//   post
+//---------------------------------------------------------
+
+void JackGraph::post(DeltaType type, jack_port_id_t a, jack_port_id_t b, const char* name)
+{
+  Delta d;
+  d.type = type;
+  d.a = a;
+  d.b = b;
+  if(name)
+    d.name = name;
+  QMutexLocker ml(&_mutex);
+  _queue.push_back(d);
+  ++_postedSerial;
+  _queued.wakeOne();
+}
+
+//---------------------------------------------------------
+//   sync
+//---------------------------------------------------------
+
+bool JackGraph::sync(unsigned long timeout_ms)
+{
+  QMutexLocker ml(&_mutex);
+  if(!isRunning())
+    return false;
+  const unsigned target = _postedSerial;
+  while((int)(_appliedSerial - target) < 0)
+  {
+    if(!_applied.wait(&_mutex, timeout_ms))
+      return false;
+  }
+  return true;
+}
+
+//---------------------------------------------------------
+//   snapshot
+//---------------------------------------------------------
+
+JackGraphSnapshotRef JackGraph::snapshot()
+{
+  QMutexLocker ml(&_mutex);
+  return _snapshot;
+}
+
+//---------------------------------------------------------
+//   currentSnapshot
+//---------------------------------------------------------
+
+JackGraphSnapshotRef JackGraph::currentSnapshot()
+{
+  QMutexLocker ml(&_mutex);
+  if(_appliedSerial != _postedSerial)
+    return JackGraphSnapshotRef();
+  return _snapshot;
+}
+
+//---------------------------------------------------------
+//   run
+//    Graph thread.
+//---------------------------------------------------------
+
+void JackGraph::run()
+{
+  std::vector<Delta> batch;
+  for(;;)
+  {
+    _mutex.lock();
+    while(_queue.empty())
+      _queued.wait(&_mutex);
+    batch.swap(_queue);
+    const unsigned serial = _postedSerial;
+    _mutex.unlock();
+
+    bool quit = false;
+    for(std::vector<Delta>::const_iterator i = batch.begin(); i != batch.end(); ++i)
+    {
+      if(i->type == DeltaQuit)
+      {
+        quit = true;
+        break;
+      }
+      apply(*i);
+    }
+    batch.clear();
+    if(quit)
+      return;
+
+    // One snapshot per batch. A burst of callbacks, for example a client
+    //  registering dozens of ports, is published once.
+    JackGraphSnapshot* snap = new JackGraphSnapshot;
+    publish(snap);
+
+    QMutexLocker ml(&_mutex);
+    _snapshot.reset(snap);
+    _appliedSerial = serial;
+    _applied.wakeAll();
+  }
+}
+
+//---------------------------------------------------------
+//   apply
+//    Graph thread.
+//---------------------------------------------------------
+
+void JackGraph::apply(const Delta& d)
+{
+  switch(d.type)
+  {
+    case DeltaRegister:
+    {
+      // Make sure a stale name from a recycled id is not used.
+      _idNames.erase(d.a);
+      const std::string* name = idName(d.a);
+      if(name)
+      {
+        std::unordered_map<std::string, Port>::iterator ip = _ports.find(*name);
+        if(ip != _ports.end())
+          readConnections(ip->second);
+      }
+    }
+    break;
+
+    case DeltaUnregister:
+    {
+      std::unordered_map<jack_port_id_t, std::string>::iterator in = _idNames.find(d.a);
+      if(in != _idNames.end())
+      {
+        removePort(in->second);
+        _idNames.erase(in);
+      }
+      else
+      {
+        // Not seen by id yet, it was listed by a scan. Jack1 may no longer
+        //  find the port by its id once it is gone, so drop every port
+        //  jack no longer knows by name instead.
+        std::vector<std::string> gone;
+        for(std::unordered_map<std::string, Port>::const_iterator ip = _ports.begin(); ip != _ports.end(); ++ip)
+          if(!jack_port_by_name(_client, ip->first.c_str()))
+            gone.push_back(ip->first);
+        for(std::vector<std::string>::const_iterator ig = gone.begin(); ig != gone.end(); ++ig)
+          removePort(*ig);
+      }
+    }
+    break;
+
+    case DeltaConnect:
+    case DeltaDisconnect:
+    {
+      const std::string* na = idName(d.a);
+      const std::string* nb = idName(d.b);
+      if(!na || !nb)
+        break;
+      std::unordered_map<std::string, Port>::iterator ia = _ports.find(*na);
+      std::unordered_map<std::string, Port>::iterator ib = _ports.find(*nb);
+      if(ia == _ports.end() || ib == _ports.end())
+        break;
+      // Jack has no callback for alias changes. Clients often set them
+      //  right after registering, so look again whenever a port is used.
+      readAliases(ia->second.info);
+      readAliases(ib->second.info);
+      if(d.type == DeltaConnect)
+      {
+        ia->second.peers.insert(ib->first);
+        ib->second.peers.insert(ia->first);
+      }
+      else
+      {
+        ia->second.peers.erase(ib->first);
+        ib->second.peers.erase(ia->first);
+      }
+    }
+    break;
+
+    case DeltaRename:
+    {
+      jack_port_t* p = jack_port_by_id(_client, d.a);
+      if(p)
+        renamePort(d.name, p);
+    }
+    break;
+
+    case DeltaRescan:
+      rescan();
+    break;
+
+    case DeltaQuit:
+    break;
+  }
+}
+
+//---------------------------------------------------------
+//   rescan
+//    Graph thread.
+//---------------------------------------------------------
+
+void JackGraph::rescan()
+{
+  _ports.clear();
+  _idNames.clear();
+  _nextOrder = 0;
+
+  const char** ports = jack_get_ports(_client, 0, 0, 0);
+  if(!ports)
+    return;
+  for(const char** p = ports; *p; ++p)
+    addPort(*p);
+  jack_free(ports);
+
+  for(std::unordered_map<std::string, Port>::iterator ip = _ports.begin(); ip != _ports.end(); ++ip)
+    readConnections(ip->second);
+
+  for(std::unordered_map<std::string, std::string>::iterator i = _formerNames.begin(); i != _formerNames.end(); )
+  {
+    if(_ports.find(i->second) == _ports.end())
+      i = _formerNames.erase(i);
+    else
+      ++i;
+  }
+}
+
+//---------------------------------------------------------
+//   addPort
+//    Graph thread. Returns the existing port if it is known.
+//---------------------------------------------------------
+
+JackGraph::Port* JackGraph::addPort(const char* name)
+{
+  std::unordered_map<std::string, Port>::iterator ip = _ports.find(name);
+  if(ip != _ports.end())
+    return &ip->second;
+
+  jack_port_t* jp = jack_port_by_name(_client, name);
+  if(!jp)
+    return NULL;
+  const char* cname = jack_port_name(jp);
+  if(!cname || cname[0] == '\0')
+    return NULL;
+  // The given name may have been an alias.
+  ip = _ports.find(cname);
+  if(ip != _ports.end())
+    return &ip->second;
+
+  Port& port = _ports[cname];
+  port.order = _nextOrder++;
+  JackGraphPort& info = port.info;
+  info.name = cname;
+  info.port = jp;
+  info.flags = jack_port_flags(jp);
+  const char* type = jack_port_type(jp);
+  info.audio = type && strcmp(type, JACK_DEFAULT_AUDIO_TYPE) == 0;
+  info.midi = type && strcmp(type, JACK_DEFAULT_MIDI_TYPE) == 0;
+  info.mine = jack_port_is_mine(_client, jp);
+  info.aliasCount = 0;
+  readAliases(info);
+  info.persistentName = persistentPortName(info);
+  return &port;
+}
+
+//---------------------------------------------------------
+//   readAliases
+//    Graph thread. Aliases that are gone are remembered
+//     as former names of the port.
+//---------------------------------------------------------
+
+void JackGraph::readAliases(JackGraphPort& info)
+{
+  const int nsz = jack_port_name_size();
+  char a1[nsz];
+  char a2[nsz];
+  char* al[2];
+  al[0] = &a1[0];
+  al[1] = &a2[0];
+  a1[0] = a2[0] = '\0';
+  const int na = jack_port_get_aliases(info.port, al);
+  int cnt = 0;
+  for(int i = 0; i < na && i < 2; ++i)
+    if(al[i][0] != '\0')
+      ++cnt;
+
+  bool changed = cnt != info.aliasCount;
+  for(int i = 0; i < cnt && !changed; ++i)
+    changed = info.aliases[i] != al[i];
+  if(!changed)
+    return;
+
+  for(int i = 0; i < info.aliasCount; ++i)
+  {
+    bool gone = info.aliases[i] != info.name;
+    for(int k = 0; k < cnt && gone; ++k)
+      gone = info.aliases[i] != al[k];
+    if(gone)
+      _formerNames[info.aliases[i]] = info.name;
+  }
+  info.aliasCount = 0;
+  for(int i = 0; i < na && i < 2; ++i)
+    if(al[i][0] != '\0')
+      info.aliases[info.aliasCount++] = al[i];
+  info.persistentName = persistentPortName(info);
+}
+
+//---------------------------------------------------------
+//   renamePort
+//    Graph thread. Moves a port to the name jack now has
+//     for it, keeping its connections.
+//---------------------------------------------------------
+
+void JackGraph::renamePort(const std::string& old_name, jack_port_t* jp)
+{
+  const char* n = jack_port_name(jp);
+  if(!n || n[0] == '\0')
+    return;
+  const std::string new_name(n);
+
+  std::unordered_map<std::string, Port>::iterator ip = _ports.find(old_name);
+  if(ip == _ports.end() || new_name == old_name)
+  {
+    // Not known under the old name. Take it as it is now.
+    Port* port = addPort(n);
+    if(port)
+    {
+      readAliases(port->info);
+      readConnections(*port);
+    }
+    return;
+  }
+
+  Port port = ip->second;
+  _ports.erase(ip);
+  port.info.name = new_name;
+  port.info.port = jp;
+  Port& np = _ports[new_name] = port;
+
+  for(std::set<std::string>::const_iterator i = np.peers.begin(); i != np.peers.end(); ++i)
+  {
+    std::unordered_map<std::string, Port>::iterator ipeer = _ports.find(*i);
+    if(ipeer != _ports.end())
+    {
+      ipeer->second.peers.erase(old_name);
+      ipeer->second.peers.insert(new_name);
+    }
+  }
+  for(std::unordered_map<jack_port_id_t, std::string>::iterator i = _idNames.begin(); i != _idNames.end(); ++i)
+    if(i->second == old_name)
+      i->second = new_name;
+  for(std::unordered_map<std::string, std::string>::iterator i = _formerNames.begin(); i != _formerNames.end(); ++i)
+    if(i->second == old_name)
+      i->second = new_name;
+  _formerNames.erase(new_name);
+  _formerNames[old_name] = new_name;
+
+  readAliases(np.info);
+  np.info.persistentName = persistentPortName(np.info);
+}
+
+//---------------------------------------------------------
+//   removePort
+//    Graph thread.
+//---------------------------------------------------------
+
+void JackGraph::removePort(const std::string& name)
+{
+  std::unordered_map<std::string, Port>::iterator ip = _ports.find(name);
+  if(ip == _ports.end())
+    return;
+  for(std::set<std::string>::const_iterator i = ip->second.peers.begin(); i != ip->second.peers.end(); ++i)
+  {
+    std::unordered_map<std::string, Port>::iterator ipeer = _ports.find(*i);
+    if(ipeer != _ports.end())
+      ipeer->second.peers.erase(name);
+  }
+  _ports.erase(ip);
+
+  for(std::unordered_map<std::string, std::string>::iterator i = _formerNames.begin(); i != _formerNames.end(); )
+  {
+    if(i->second == name)
+      i = _formerNames.erase(i);
+    else
+      ++i;
+  }
+}
+
+//---------------------------------------------------------
+//   readConnections
+//    Graph thread. Asks jack for one port's connections.
+//---------------------------------------------------------
+
+void JackGraph::readConnections(Port& port)
+{
+  const char** conns = jack_port_get_all_connections(_client, port.info.port);
+  if(!conns)
+    return;
+  for(const char** c = conns; *c; ++c)
+  {
+    Port* peer = addPort(*c);
+    if(!peer)
+      continue;
+    port.peers.insert(peer->info.name);
+    peer->peers.insert(port.info.name);
+  }
+  jack_free(conns);
+}
+
+//---------------------------------------------------------
+//   idName
+//    Graph thread. Canonical name of the port with the id.
+//    Adds the port if it is not known yet.
+//---------------------------------------------------------
+
+const std::string* JackGraph::idName(jack_port_id_t id)
+{
+  std::unordered_map<jack_port_id_t, std::string>::iterator in = _idNames.find(id);
+  if(in != _idNames.end())
+    return &in->second;
+  jack_port_t* p = jack_port_by_id(_client, id);
+  const char* n = p ? jack_port_name(p) : NULL;
+  if(!n || n[0] == '\0')
+    return NULL;
+  Port* port = addPort(n);
+  if(!port)
+    return NULL;
+  std::string& s = _idNames[id];
+  s = port->info.name;
+  return &s;
+}
+
+//---------------------------------------------------------
+//   PortOrder
+//---------------------------------------------------------
+
+struct PortOrder
+{
+  template <class P> bool operator()(const P* a, const P* b) const { return a->order < b->order; }
+};
+
+//---------------------------------------------------------
+//   publish
+//    Graph thread. Fills a snapshot from the model.
+//---------------------------------------------------------
+
+void JackGraph::publish(JackGraphSnapshot* snap)
+{
+  std::vector<const Port*> ports;
+  ports.reserve(_ports.size());
+  for(std::unordered_map<std::string, Port>::const_iterator ip = _ports.begin(); ip != _ports.end(); ++ip)
+    ports.push_back(&ip->second);
+  std::sort(ports.begin(), ports.end(), PortOrder());
+
+  snap->_ports.reserve(ports.size());
+  for(size_t i = 0; i < ports.size(); ++i)
+  {
+    snap->_ports.push_back(ports[i]->info);
+    snap->_byName[ports[i]->info.name] = i;
+  }
+  // Aliases last, so that they never hide a canonical name.
+  for(size_t i = 0; i < ports.size(); ++i)
+    for(int a = 0; a < ports[i]->info.aliasCount; ++a)
+      snap->_byName.insert(std::pair<std::string, int>(ports[i]->info.aliases[a], i));
+  // Former names after that, so that they never hide a current one.
+  for(std::unordered_map<std::string, std::string>::const_iterator i = _formerNames.begin(); i != _formerNames.end(); ++i)
+  {
+    std::unordered_map<std::string, int>::const_iterator ib = snap->_byName.find(i->second);
+    if(ib != snap->_byName.end() && snap->_ports[ib->second].name == i->second)
+      snap->_byName.insert(std::pair<std::string, int>(i->first, ib->second));
+  }
+
+  for(size_t i = 0; i < ports.size(); ++i)
+  {
+    JackGraphPort& p = snap->_ports[i];
+    p.connections.clear();
+    for(std::set<std::string>::const_iterator ic = ports[i]->peers.begin(); ic != ports[i]->peers.end(); ++ic)
+    {
+      std::unordered_map<std::string, int>::const_iterator ib = snap->_byName.find(*ic);
+      if(ib != snap->_byName.end())
+        p.connections.push_back(ib->second);
+    }
+  }
+}
+
+} // namespace MusECore
@@ -0,0 +1,181 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  jackgraph.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+
+#ifndef __JACKGRAPH_H__
+#define __JACKGRAPH_H__
+
+#include <jack/jack.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <memory>
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   JackGraphPort
+//    What MusE needs to know about one jack port.
+//---------------------------------------------------------
+
+struct JackGraphPort
+{
+      // Canonical full name, and up to two aliases.
+      std::string name;
+      std::string aliases[2];
+      int aliasCount;
+      // The name JackAudioDevice::portName() would pick, without preference.
+      std::string persistentName;
+      // As returned by jack_port_by_name().
+      jack_port_t* port;
+      int flags;
+      // Default jack audio or midi type. Ports of other types are neither.
+      bool audio;
+      bool midi;
+      // One of our own client's ports.
+      bool mine;
+      // Indices into the snapshot of the ports connected to this one.
+      std::vector<int> connections;
+};
+
+//---------------------------------------------------------
+//   JackGraphSnapshot
+//    Copy of the port graph at one moment.
+//    Never changed once published, so it can be read from any
+//     thread for as long as a reference is held.
+//---------------------------------------------------------
+
+class JackGraphSnapshot
+{
+      friend class JackGraph;
+
+      // In jack's registration order.
+      std::vector<JackGraphPort> _ports;
+      // Canonical names, aliases, and former names and aliases of renamed ports.
+      std::unordered_map<std::string, int> _byName;
+
+   public:
+      int size() const { return _ports.size(); }
+      const JackGraphPort& port(int idx) const { return _ports[idx]; }
+      // Finds a port by canonical name or alias, or by a name or alias it had
+      //  before it was renamed. Returns null if not found.
+      const JackGraphPort* find(const char* name) const;
+      bool connected(const JackGraphPort& a, const JackGraphPort& b) const;
+};
+
+typedef std::shared_ptr<const JackGraphSnapshot> JackGraphSnapshotRef;
+
+//---------------------------------------------------------
+//   JackGraph
+//    Keeps MusE's view of jack's ports and connections.
+//    The jack callbacks only queue small deltas. A dedicated
+//     thread applies them to a model keyed by port name and
+//     publishes a new snapshot after each batch, so the gui
+//     and the route checks never have to list all ports or
+//     search them by name through jack.
+//    A full rescan is only done when the client is activated.
+//---------------------------------------------------------
+
+class JackGraph : public QThread
+{
+      enum DeltaType { DeltaRegister, DeltaUnregister, DeltaConnect, DeltaDisconnect, DeltaRename, DeltaRescan, DeltaQuit };
+      struct Delta
+      {
+            DeltaType type;
+            jack_port_id_t a;
+            jack_port_id_t b;
+            // The old name, for renames.
+            std::string name;
+      };
+
+      // Graph thread only.
+      struct Port
+      {
+            JackGraphPort info;
+            unsigned order;
+            std::set<std::string> peers;
+      };
+      std::unordered_map<std::string, Port> _ports;
+      std::unordered_map<jack_port_id_t, std::string> _idNames;
+      // Former names and aliases of renamed ports, to their canonical name.
+      // Routes keep the name they were made with, so it must still be found.
+      std::unordered_map<std::string, std::string> _formerNames;
+      unsigned _nextOrder;
+
+      jack_client_t* _client;
+
+      // Guards everything below.
+      QMutex _mutex;
+      QWaitCondition _queued;
+      QWaitCondition _applied;
+      std::vector<Delta> _queue;
+      unsigned _postedSerial;
+      unsigned _appliedSerial;
+      JackGraphSnapshotRef _snapshot;
+
+      void post(DeltaType type, jack_port_id_t a = 0, jack_port_id_t b = 0, const char* name = NULL);
+      void apply(const Delta& d);
+      void rescan();
+      Port* addPort(const char* name);
+      void readAliases(JackGraphPort& info);
+      void renamePort(const std::string& old_name, jack_port_t* jp);
+      void removePort(const std::string& name);
+      void readConnections(Port& port);
+      const std::string* idName(jack_port_id_t id);
+      void publish(JackGraphSnapshot* snap);
+
+   protected:
+      virtual void run();
+
+   public:
+      JackGraph();
+      virtual ~JackGraph();
+
+      // Gui thread.
+      void startGraph(jack_client_t* client);
+      void stopGraph();
+
+      // Jack notification thread. Queue a delta for the graph thread.
+      void portRegistered(jack_port_id_t id, bool is_register) { post(is_register ? DeltaRegister : DeltaUnregister, id); }
+      void portConnected(jack_port_id_t a, jack_port_id_t b, bool is_connect) { post(is_connect ? DeltaConnect : DeltaDisconnect, a, b); }
+      void portRenamed(jack_port_id_t id, const char* old_name) { post(DeltaRename, id, 0, old_name); }
+      // Any thread. Throw away the model and list everything again.
+      void requestRescan() { post(DeltaRescan); }
+
+      // Any thread. Waits, for at most the given time, until every delta
+      //  queued so far has been applied. Returns true if the snapshot is current.
+      bool sync(unsigned long timeout_ms = 200);
+      // Any thread. The latest snapshot. Null until the first scan is done.
+      JackGraphSnapshotRef snapshot();
+      // Any thread. The latest snapshot if every delta queued so far has been
+      //  applied, otherwise null. Never waits.
+      JackGraphSnapshotRef currentSnapshot();
+};
+
+} // namespace MusECore
+
+#endif
@@ -548,9 +548,9 @@ void MidiJackDevice::recordEvent(MidiRecordEvent& event)
         return;
       
       // Split the events up into channel fifos. Special 'channel' number 17 for sysex events.
+      // An overflow is counted by the fifo and reported when recording stops.
       unsigned int ch = (typ == ME_SYSEX)? MusECore::MUSE_MIDI_CHANNELS : event.channel();
-      if(_recordFifo[ch].put(event))
-        printf("MidiJackDevice::recordEvent: fifo channel %d overflow\n", ch);
+      _recordFifo[ch].put(event);
       }
 
 //---------------------------------------------------------
@@ -869,6 +869,23 @@ bool MidiJackDevice::queueEvent(const MidiPlayEvent& e, void* evBuffer)
                   p[2] = (pos >> 7) & 0x7f;  // MSB
                   }
                   break;
+            case ME_MTC_QUARTER:
+                  {
+                  #ifdef JACK_MIDI_DEBUG
+                  printf("MidiJackDevice::queueEvent mtc quarter %x\n", e.dataA());
+                  #endif  
+                    
+                  unsigned char* p = jack_midi_event_reserve(evBuffer, ft, 2);
+                  if (p == 0) {
+                        #ifdef JACK_MIDI_DEBUG
+                        fprintf(stderr, "MidiJackDevice::queueEvent mtc quarter: buffer overflow, stopping until next cycle\n");  
+                        #endif  
+                        return false;
+                        }
+                  p[0] = e.type();
+                  p[1] = e.dataA() & 0x7f;
+                  }
+                  break;
             case ME_CLOCK:
             case ME_START:
             case ME_CONTINUE:
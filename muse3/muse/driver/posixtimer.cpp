@@ -0,0 +1,212 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  posixtimer.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "posixtimer.h"
+
+namespace MusECore {
+
+// Coarser clocks than this can not do better than the RTC, so leave them to it.
+static const long MAX_CLOCK_RESOLUTION_NS = 10000;
+
+PosixTimer::PosixTimer()
+    {
+    timerFd = -1;
+    _freq = 0;
+    _periodNs = 0;
+    _running = false;
+    }
+
+PosixTimer::~PosixTimer()
+    {
+    if (timerFd != -1)
+      close(timerFd);
+    }
+
+//---------------------------------------------------------
+//   now
+//    Current CLOCK_MONOTONIC time in nanoseconds.
+//---------------------------------------------------------
+
+uint64_t PosixTimer::now()
+    {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+//---------------------------------------------------------
+//   arm
+//    Expire first at the given absolute time, then
+//     periodically at the tick frequency.
+//---------------------------------------------------------
+
+bool PosixTimer::arm(uint64_t firstNs)
+    {
+    struct itimerspec its;
+    its.it_value.tv_sec = firstNs / 1000000000ULL;
+    its.it_value.tv_nsec = firstNs % 1000000000ULL;
+    its.it_interval.tv_sec = _periodNs / 1000000000ULL;
+    its.it_interval.tv_nsec = _periodNs % 1000000000ULL;
+    if (timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &its, NULL) == -1) {
+          fprintf(stderr, "PosixTimer::arm(): timerfd_settime failed: %s\n", strerror(errno));
+          return false;
+          }
+    return true;
+    }
+
+signed int PosixTimer::initTimer(unsigned long desiredFrequency)
+    {
+    if(TIMER_DEBUG)
+          printf("PosixTimer::initTimer()\n");
+    if (timerFd != -1) {
+          fprintf(stderr,"PosixTimer::initTimer(): called on initialised timer!\n");
+          return -1;
+          }
+
+    struct timespec res;
+    if (clock_getres(CLOCK_MONOTONIC, &res) == -1 || res.tv_sec != 0 || res.tv_nsec > MAX_CLOCK_RESOLUTION_NS) {
+          fprintf(stderr, "PosixTimer::initTimer(): no high resolution monotonic clock available\n");
+          return -1;
+          }
+
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd == -1) {
+          fprintf(stderr, "PosixTimer::initTimer(): timerfd_create failed: %s\n", strerror(errno));
+          return -1;
+          }
+    if (!setTimerFreq(desiredFrequency)) {
+          close(timerFd);
+          timerFd = -1;
+          return -1;
+          }
+    return timerFd;
+    }
+
+unsigned long PosixTimer::setTimerResolution(unsigned long resolution)
+    {
+    if(TIMER_DEBUG)
+      printf("PosixTimer::setTimerResolution(%lu)\n",resolution);
+    // The resolution is that of the monotonic clock, it can not be set.
+    return 0;
+    }
+
+unsigned long PosixTimer::getTimerResolution()
+    {
+    struct timespec res;
+    if (clock_getres(CLOCK_MONOTONIC, &res) == -1)
+          return 0;
+    return res.tv_nsec;
+    }
+
+unsigned long PosixTimer::setTimerFreq(unsigned long freq)
+    {
+    if (freq == 0) {
+          fprintf(stderr, "PosixTimer::setTimerFreq(): invalid frequency 0\n");
+          return 0;
+          }
+    _freq = freq;
+    _periodNs = 1000000000ULL / freq;
+    // Pick up the new period straight away.
+    if (_running && !arm(now() + _periodNs))
+          return 0;
+    return freq;
+    }
+
+unsigned long PosixTimer::getTimerFreq()
+    {
+    return _freq;
+    }
+
+bool PosixTimer::startTimer()
+    {
+    if(TIMER_DEBUG)
+      printf("PosixTimer::startTimer()\n");
+    if (timerFd == -1) {
+          fprintf(stderr, "PosixTimer::startTimer(): no timer open to start!\n");
+          return false;
+          }
+    if (!arm(now() + _periodNs))
+          return false;
+    _running = true;
+    return true;
+    }
+
+bool PosixTimer::stopTimer()
+    {
+    if(TIMER_DEBUG)
+      printf("PosixTimer::stopTimer\n");
+    if (timerFd == -1) {
+          fprintf(stderr,"PosixTimer::stopTimer(): no timer to stop!\n");
+          return false;
+          }
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    timerfd_settime(timerFd, 0, &its, NULL);
+    _running = false;
+    return true;
+    }
+
+unsigned long PosixTimer::getTimerTicks(bool /*printTicks*/)
+    {
+    if(TIMER_DEBUG)
+      printf("PosixTimer::getTimerTicks()\n");
+    if (timerFd == -1) {
+        fprintf(stderr,"PosixTimer::getTimerTicks(): no timer open to read!\n");
+        return 0;
+        }
+    uint64_t expirations;
+    if (read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        // EAGAIN: The fd was polled, but the timer has since been re-armed.
+        if (errno != EAGAIN)
+              fprintf(stderr,"PosixTimer::getTimerTicks(): error reading timer: %s\n", strerror(errno));
+        return 0;
+        }
+    return expirations;
+    }
+
+//---------------------------------------------------------
+//   setNextWakeup
+//    Called from the midi thread after each tick. A wakeup
+//     beyond the next periodic tick is ignored, the ticks
+//     still catch events which arrive in the meantime.
+//---------------------------------------------------------
+
+bool PosixTimer::setNextWakeup(unsigned long nsecs)
+    {
+    if (timerFd == -1 || !_running)
+          return false;
+    if (nsecs > _periodNs)
+          nsecs = _periodNs;
+    // Zero would disarm the timer.
+    if (nsecs == 0)
+          nsecs = 1;
+    return arm(now() + nsecs);
+    }
+
+} // namespace MusECore
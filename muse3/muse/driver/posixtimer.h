@@ -0,0 +1,68 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  posixtimer.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __POSIXTIMER_H__
+#define __POSIXTIMER_H__
+
+#include <stdint.h>
+
+#include "timerdev.h"
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   PosixTimer
+//    Timer based on a CLOCK_MONOTONIC timerfd. Needs no
+//     special permissions and, with high resolution kernel
+//     timers, can be armed to wake at any nanosecond rather
+//     than only on a fixed grid of ticks.
+//---------------------------------------------------------
+
+class PosixTimer : public Timer {
+      int timerFd;
+      unsigned long _freq;
+      uint64_t _periodNs;
+      bool _running;
+
+      static uint64_t now();
+      bool arm(uint64_t firstNs);
+
+    public:
+       PosixTimer();
+       virtual ~PosixTimer();
+
+       virtual signed int initTimer(unsigned long desiredFrequency);
+       virtual unsigned long setTimerResolution(unsigned long resolution);
+       virtual unsigned long getTimerResolution();
+       virtual unsigned long setTimerFreq(unsigned long freq);
+       virtual unsigned long getTimerFreq();
+
+       virtual bool startTimer();
+       virtual bool stopTimer();
+       virtual unsigned long getTimerTicks(bool printTicks=false);
+
+       virtual bool setNextWakeup(unsigned long nsecs);
+};
+
+} // namespace MusECore
+
+#endif //__POSIXTIMER_H__
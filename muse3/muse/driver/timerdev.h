@@ -50,6 +50,10 @@ class Timer {
        virtual bool startTimer() = 0;
        virtual bool stopTimer() = 0;
        virtual unsigned long getTimerTicks(bool printTicks = false) = 0;
+
+       // Wake once after the given number of nanoseconds, then resume the
+       //  periodic ticks. Returns false if the timer can only tick periodically.
+       virtual bool setNextWakeup(unsigned long /*nsecs*/) { return false; }
         
 };
 
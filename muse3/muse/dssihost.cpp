@@ -60,6 +60,7 @@
 #include "app.h"
 #include "globals.h"
 #include "gconfig.h"
+#include "audiobuffers.h"
 #include "popupmenu.h"
 #include "lock_free_buffer.h"
 #include "pluglist.h"
@@ -418,19 +419,9 @@ bool DssiSynthIF::init(DssiSynth* s)
       int inports = _synth->_inports;
       if(inports != 0)
       {
-        int rv = posix_memalign((void**)&_audioInSilenceBuf, 16, sizeof(float) * MusEGlobal::segmentSize);
-        if(rv != 0)
-        {
-          fprintf(stderr, "ERROR: DssiSynthIF::init: posix_memalign returned error:%d. Aborting!\n", rv);
-          abort();
-        }
-        if(MusEGlobal::config.useDenormalBias)
-        {
-          for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-            _audioInSilenceBuf[q] = MusEGlobal::denormalBias;
-        }
-        else
-          memset(_audioInSilenceBuf, 0, sizeof(float) * MusEGlobal::segmentSize);
+        // Shared by all plugins.
+        MusEGlobal::audioBufferPool.prepare();
+        _audioInSilenceBuf = MusEGlobal::audioBufferPool.silence();
         
         _audioInBuffers = new float*[inports];
         for(int k = 0; k < inports; ++k)
@@ -742,9 +733,6 @@ DssiSynthIF::~DssiSynthIF()
         delete[] _audioInBuffers;
       }  
       
-      if(_audioInSilenceBuf)
-        free(_audioInSilenceBuf);
-      
       if(_audioOutBuffers)
       {
         for(unsigned long i = 0; i < _synth->_outports; ++i)
@@ -260,6 +260,8 @@ bool Event::empty() const      { return ev == 0; }
 EventType Event::type() const  { return ev ? ev->type() : Note;  }
 EventID_t Event::id() const { return ev ? ev->id() : MUSE_INVALID_EVENT_ID; }
 void Event::shareId(const Event& e) { if(ev && e.ev) ev->shareId(e.ev); }
+EventID_t Event::uniqueId() const { return ev ? ev->uniqueId() : MUSE_INVALID_EVENT_ID; }
+void Event::restoreIds(EventID_t uniqueId, EventID_t id) { if(ev) ev->restoreIds(uniqueId, id); }
 
 void Event::setType(EventType t) {
             if (ev && --(ev->refCount) == 0) {
@@ -394,11 +396,20 @@ void Event::setSndFile(MusECore::SndFileR& sf)
   #endif
 }
 
+const WaveEditList* Event::waveEdits() const { return ev ? ev->waveEdits() : 0; }
+void Event::addWaveEdit(const WaveEdit& edit) { if(ev) ev->addWaveEdit(edit); }
+void Event::clearWaveEdits()                 { if(ev) ev->clearWaveEdits(); }
+
 void Event::readAudio(MusECore::WavePart* part, unsigned offset, float** bpp, int channels, int nn, bool doSeek, bool overwrite)
       {
         if(ev) ev->readAudio(part, offset, bpp, channels, nn, doSeek, overwrite);
       }
 
+void Event::readPeaks(MusECore::SampleV* s, int mag, unsigned pos, bool overwrite, bool allowSeek) const
+      {
+        if(ev) ev->readPeaks(s, mag, pos, overwrite, allowSeek);
+      }
+
 //--------------------------------------------------------
 // 'Agnostic' position methods - can be TICKS and FRAMES.
 //--------------------------------------------------------
@@ -33,6 +33,7 @@
 #include "evdata.h"
 #include "mpevent.h"
 #include "wave.h" // for SndFileR
+#include "waveedits.h"
 
 class QString;
 
@@ -68,6 +69,10 @@ class Event {
       // Shared and non-shared clone events have the same id. An empty event returns MUSE_INVALID_EVENT_ID.
       EventID_t id() const; 
       void shareId(const Event& e); // Makes id same as given event's. Effectively makes the events non-shared clones.
+      // The always unique id, which deClone() restores. An empty event returns MUSE_INVALID_EVENT_ID.
+      EventID_t uniqueId() const;
+      // Gives a recreated event back the ids of the one it replaces. Used by the undo store.
+      void restoreIds(EventID_t uniqueId, EventID_t id);
 
       void setType(EventType t);
       Event& operator=(const Event& e); // Makes the two events true shared clones. They share the same event base pointer.
@@ -129,7 +134,14 @@ class Event {
       MusECore::SndFileR sndFile() const;
       virtual void setSndFile(MusECore::SndFileR& sf);
       
+      // Wave events only. Non-destructive edits, see WaveEdit.
+      const WaveEditList* waveEdits() const;
+      void addWaveEdit(const WaveEdit& edit);
+      void clearWaveEdits();
+      
       virtual void readAudio(MusECore::WavePart* part, unsigned offset, float** bpp, int channels, int nn, bool doSeek, bool overwrite);
+      // Peaks of the edited sound file. Same arguments as SndFile::read.
+      void readPeaks(MusECore::SampleV* s, int mag, unsigned pos, bool overwrite = true, bool allowSeek = true) const;
       
       //--------------------------------------------------------
       // 'Agnostic' position methods - can be TICKS and FRAMES.
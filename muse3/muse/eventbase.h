@@ -61,6 +61,9 @@ class EventBase : public PosLen {
       EventID_t id() const       { return _id; }
       EventID_t newId()          { return idGen++; }
       void shareId(const EventBase* ev) { _id = ev->_id; } // Makes id same as given event's. Effectively makes the events non-shared clones.
+      EventID_t uniqueId() const { return _uniqueId; }
+      // Gives a recreated event back the ids of the one it replaces. Used by the undo store.
+      void restoreIds(EventID_t uniqueId, EventID_t id) { _uniqueId = uniqueId; _id = id; }
       virtual void assign(const EventBase& ev);            // Assigns to this event, excluding the _id. 
       
       EventType type() const     { return _type;  }
@@ -114,6 +117,9 @@ class EventBase : public PosLen {
       virtual void setSpos(int)                     { }
       virtual SndFileR sndFile() const              { return 0;      }
       virtual void setSndFile(SndFileR&)            { }
+      virtual const WaveEditList* waveEdits() const { return 0; }
+      virtual void addWaveEdit(const WaveEdit&)     { }
+      virtual void clearWaveEdits()                 { }
       // Creates a non-shared clone, having the same 'group' _id.
       // NOTE: Certain pointer members may still be SHARED. Such as the sysex MidiEventBase::edata.
       //       Be aware when iterating or modifying clones.
@@ -126,6 +132,7 @@ class EventBase : public PosLen {
       
       virtual void readAudio(WavePart* /*part*/, unsigned /*offset*/, 
                              float** /*bpp*/, int /*channels*/, int /*nn*/, bool /*doSeek*/, bool /*overwrite*/) { }
+      virtual void readPeaks(SampleV* /*s*/, int /*mag*/, unsigned /*pos*/, bool /*overwrite*/, bool /*allowSeek*/) { }
       };
 
 } // namespace MusECore
@@ -63,6 +63,11 @@
 #include <QClipboard>
 #include <QSet>
 
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+
 
 using namespace std;
 
@@ -1830,6 +1835,129 @@ void PasteEraseCtlMap::tidy()
   }
 }
 
+//---------------------------------------------------------
+//   NoteColumns
+//    Columnar snapshot of the notes among one part's tagged
+//     events, in list (time) order. The batch functions below
+//     compute new values column by column, in parallel for
+//     large parts, and only create Events for notes which
+//     actually change.
+//---------------------------------------------------------
+
+struct NoteColumns
+{
+  std::vector<const Event*> events;
+  std::vector<unsigned> tick;
+  std::vector<unsigned> len;
+  std::vector<int> pitch;
+  std::vector<int> velo;
+
+  explicit NoteColumns(const EventList& el)
+  {
+    const size_t sz = el.size();
+    events.reserve(sz);
+    tick.reserve(sz);
+    len.reserve(sz);
+    pitch.reserve(sz);
+    velo.reserve(sz);
+    for(ciEvent ie = el.begin(); ie != el.end(); ++ie)
+    {
+      const Event& e = ie->second;
+      // The batch operations only apply to notes.
+      if(e.type() != Note)
+        continue;
+      events.push_back(&e);
+      tick.push_back(e.tick());
+      len.push_back(e.lenTick());
+      pitch.push_back(e.pitch());
+      velo.push_back(e.velo());
+    }
+  }
+
+  size_t size() const { return events.size(); }
+};
+
+// Below this many notes the transforms run on the calling thread.
+static const size_t PARALLEL_EDIT_MIN_NOTES = 16384;
+
+//---------------------------------------------------------
+//   parallel_for_range
+//    Calls func(begin, end) on consecutive ranges of [0, n),
+//     spread over the available cores if work is large enough.
+//    func must only write to its own range, and must not create
+//     or copy Events since their reference counts and ids are
+//     not thread safe.
+//---------------------------------------------------------
+
+template <class Func>
+static void parallel_for_range(size_t n, size_t work, Func& func)
+{
+  unsigned threads = std::thread::hardware_concurrency();
+  if(threads > 16)
+    threads = 16;
+  if(work < PARALLEL_EDIT_MIN_NOTES || threads < 2 || n < 2)
+  {
+    func(0, n);
+    return;
+  }
+  if(threads > n)
+    threads = n;
+
+  const size_t chunk = (n + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for(size_t begin = chunk; begin < n; begin += chunk)
+    workers.push_back(std::thread(std::ref(func), begin, std::min(n, begin + chunk)));
+  func(0, std::min(n, chunk));
+  for(size_t i = 0; i < workers.size(); ++i)
+    workers[i].join();
+}
+
+//---------------------------------------------------------
+//   push_event_batch
+//    Adds the batch as one ModifyEventBatch operation,
+//     or deletes it if nothing changed.
+//---------------------------------------------------------
+
+static void push_event_batch(Undo& operations, const Part* part, UndoEventBatch* batch)
+{
+  if(batch->empty())
+  {
+    delete batch;
+    return;
+  }
+  operations.push_back(UndoOp(UndoOp::ModifyEventBatch, part, batch, false, false));
+}
+
+//---------------------------------------------------------
+//   add_event_batched
+//    Adds an AddEvent operation, merging runs of midi event
+//     additions to the same part into one ModifyEventBatch.
+//---------------------------------------------------------
+
+static void add_event_batched(Undo& operations, const Event& e, const Part* part, bool doCtrls, bool doClones)
+{
+  // Wave events need their sound files handled by the operation stages. Keep them separate.
+  if(e.type() == Wave)
+  {
+    operations.push_back(UndoOp(UndoOp::AddEvent, e, part, doCtrls, doClones));
+    return;
+  }
+  if(!operations.empty())
+  {
+    UndoOp& last = operations.back();
+    if(last.type == UndoOp::ModifyEventBatch && last.part == part &&
+       last.doCtrls == doCtrls && last.doClones == doClones)
+    {
+      last._eventBatch->add(Event(), e);
+      return;
+    }
+  }
+  UndoEventBatch* batch = new UndoEventBatch();
+  batch->add(Event(), e);
+  operations.push_back(UndoOp(UndoOp::ModifyEventBatch, part, batch, doCtrls, doClones));
+}
+
 bool erase_items(TagEventList* tag_list, int velo_threshold, bool velo_thres_used, int len_threshold, bool len_thres_used)
 {
   Undo operations;
@@ -1905,71 +2033,92 @@ bool crescendo_items(TagEventList* tag_list, int start_val, int end_val, bool ab
   return MusEGlobal::song->applyOperationGroup(operations);
 }
 
-bool delete_overlaps_items(TagEventList* tag_list)
+// Resolves overlaps among the notes of one pitch, in time order.
+struct DeleteOverlapsTransform
 {
-  Undo operations;
-  
-  set<const Event*> deleted_events;
-  int new_len;
-  Event new_event1;
-  const Part* part;
-    
-  for(ciTagEventList itl = tag_list->begin(); itl != tag_list->end(); ++itl)
+  const NoteColumns& cols;
+  const std::vector<std::vector<size_t> >& byPitch;
+  std::vector<unsigned>& newLen;
+  std::vector<char>& deleted;
+
+  DeleteOverlapsTransform(const NoteColumns& c, const std::vector<std::vector<size_t> >& bp,
+                          std::vector<unsigned>& nl, std::vector<char>& del)
+    : cols(c), byPitch(bp), newLen(nl), deleted(del) { }
+
+  void operator()(size_t begin, size_t end)
   {
-    part = itl->first;
-    const EventList& el = itl->second.evlist();
-    for(ciEvent ie = el.begin(); ie != el.end(); ie++)
+    for(size_t p = begin; p < end; ++p)
     {
-      const Event& e = ie->second;
-
-      // This operation can only apply to notes.
-      if(e.type() != Note)
-        continue;
-      
-      // Has this event already been scheduled for deletion? Ignore it.
-      if(deleted_events.find(&e) != deleted_events.end())
-        continue;
-            
-      ciEvent ie2 = ie;
-      ++ie2;
-      for( ; ie2 != el.end(); ++ie2)
+      const std::vector<size_t>& idx = byPitch[p];
+      const size_t sz = idx.size();
+      for(size_t a = 0; a < sz; ++a)
       {
-        const Event& e2 = ie2->second;
-        // This operation can only apply to notes.
-        if(e2.type() != Note)
-          continue;
-        
-        // Do e2 and e point to the same event? Or has e2 already been scheduled for deletion? Ignore it.
-        if(e == e2 || deleted_events.find(&e2) != deleted_events.end())
+        const size_t i = idx[a];
+        // Has this note already been scheduled for deletion? Ignore it.
+        if(deleted[i])
           continue;
-        
-        if ( (e.pitch() == e2.pitch()) &&
-            (e.tick() <= e2.tick()) &&
-            (e.endTick() > e2.tick()) ) //they overlap
+        const unsigned end_tick = cols.tick[i] + cols.len[i];
+        for(size_t b = a + 1; b < sz; ++b)
         {
-          new_len = e2.tick() - e.tick();
-
-          if(new_len==0)
-          {
-            operations.push_back(UndoOp(UndoOp::DeleteEvent, e2, part, false, false));
-            deleted_events.insert(&e2);
-          }
+          const size_t j = idx[b];
+          if(deleted[j])
+            continue;
+          // Notes are sorted, so no later note can overlap either.
+          if(cols.tick[j] >= end_tick)
+            break;
+          // They overlap.
+          const unsigned new_len = cols.tick[j] - cols.tick[i];
+          if(new_len == 0)
+            deleted[j] = 1;
           else
           {
-            new_event1 = e.clone();
-            new_event1.setLenTick(new_len);
-            
-            operations.push_back(UndoOp(UndoOp::ModifyEvent, new_event1, e, part, false, false));
-            
-            // After resizing the event, it should not be necessary to continue with any further
-            //  events in this loop since any more sorted events will come at or AFTER e2's position
-            //  which we have just resized the end of e to.
+            // Any further notes come at or after this one's position, which we have just cut the note to.
+            newLen[i] = new_len;
             break;
           }
         }
       }
     }
   }
+};
+
+bool delete_overlaps_items(TagEventList* tag_list)
+{
+  Undo operations;
+  
+  for(ciTagEventList itl = tag_list->begin(); itl != tag_list->end(); ++itl)
+  {
+    const Part* part = itl->first;
+    const NoteColumns cols(itl->second.evlist());
+    const size_t sz = cols.size();
+    if(sz == 0)
+      continue;
+
+    // Only notes of the same pitch can overlap, so each pitch is independent.
+    std::vector<std::vector<size_t> > byPitch(128);
+    for(size_t i = 0; i < sz; ++i)
+      byPitch[cols.pitch[i] & 0x7f].push_back(i);
+
+    std::vector<unsigned> newLen(cols.len);
+    std::vector<char> deleted(sz, 0);
+    DeleteOverlapsTransform transform(cols, byPitch, newLen, deleted);
+    parallel_for_range(byPitch.size(), sz, transform);
+
+    UndoEventBatch* batch = new UndoEventBatch();
+    for(size_t i = 0; i < sz; ++i)
+    {
+      const Event& e = *cols.events[i];
+      if(deleted[i])
+        batch->add(e, Event());
+      else if(newLen[i] != cols.len[i])
+      {
+        Event newEvent = e.clone();
+        newEvent.setLenTick(newLen[i]);
+        batch->add(e, newEvent);
+      }
+    }
+    push_event_batch(operations, part, batch);
+  }
   
   return MusEGlobal::song->applyOperationGroup(operations);
 }
@@ -2024,57 +2173,62 @@ bool modify_notelen_items(TagEventList* tag_list, int rate, int offset)
   return MusEGlobal::song->applyOperationGroup(operations);
 }
 
+// Extends each note up to the nearest relevant following note.
+struct LegatoTransform
+{
+  const NoteColumns& cols;
+  unsigned min_len;
+  bool dont_shorten;
+  std::vector<unsigned>& newLen;
+
+  LegatoTransform(const NoteColumns& c, unsigned ml, bool ds, std::vector<unsigned>& nl)
+    : cols(c), min_len(ml), dont_shorten(ds), newLen(nl) { }
+
+  void operator()(size_t begin, size_t end)
+  {
+    for(size_t i = begin; i < end; ++i)
+    {
+      // Following notes must not be too near (respect min_len and dont_shorten).
+      unsigned first = cols.tick[i] + min_len;
+      if(dont_shorten && cols.tick[i] + cols.len[i] > first)
+        first = cols.tick[i] + cols.len[i];
+      // Notes are sorted by time, so the nearest relevant following note is the first one at or after that.
+      std::vector<unsigned>::const_iterator it = std::lower_bound(cols.tick.begin(), cols.tick.end(), first);
+      // If no following note was found, keep the length.
+      newLen[i] = (it == cols.tick.end()) ? cols.len[i] : *it - cols.tick[i];
+    }
+  }
+};
+
 bool legato_items(TagEventList* tag_list, int min_len, bool dont_shorten)
 {
   Undo operations;
   
   if (min_len<=0) min_len=1;
   
-  unsigned len = INT_MAX;
-  bool relevant;
-  Event new_event1;
-  const Part* part;
-    
   for(ciTagEventList itl = tag_list->begin(); itl != tag_list->end(); ++itl)
   {
-    part = itl->first;
-    const EventList& el = itl->second.evlist();
-    for(ciEvent ie = el.begin(); ie != el.end(); ie++)
-    {
-      const Event& e = ie->second;
+    const Part* part = itl->first;
+    const NoteColumns cols(itl->second.evlist());
+    const size_t sz = cols.size();
+    if(sz == 0)
+      continue;
 
-      // This operation can only apply to notes.
-      if(e.type() != Note)
-        continue;
-      
-      ciEvent ie2 = ie;
-      ++ie2;
-      for( ; ie2 != el.end(); ++ie2)
-      {
-        const Event& e2 = ie2->second;
-        // This operation can only apply to notes.
-        if(e2.type() != Note)
-          continue;
+    std::vector<unsigned> newLen(sz);
+    LegatoTransform transform(cols, min_len, dont_shorten, newLen);
+    parallel_for_range(sz, sz, transform);
 
-        relevant = (e2.tick() >= e.tick() + min_len);
-        if (dont_shorten)
-          relevant = relevant && (e2.tick() >= e.endTick());
-        
-        if ( relevant &&                      // they're not too near (respect min_len and dont_shorten)
-              (e2.tick() - e.tick() < len ) )  // that's the nearest relevant following note
-          len = e2.tick() - e.tick();
-      }            
-      
-      if (len==INT_MAX) len = e.lenTick(); // if no following note was found, keep the length
-      
-      if (e.lenTick() != len)
-      {
-        new_event1 = e.clone();
-        new_event1.setLenTick(len);
-        
-        operations.push_back(UndoOp(UndoOp::ModifyEvent, new_event1, e, part, false, false));
-      }
+    UndoEventBatch* batch = new UndoEventBatch();
+    for(size_t i = 0; i < sz; ++i)
+    {
+      if(newLen[i] == cols.len[i])
+        continue;
+      const Event& e = *cols.events[i];
+      Event newEvent = e.clone();
+      newEvent.setLenTick(newLen[i]);
+      batch->add(e, newEvent);
     }
+    push_event_batch(operations, part, batch);
   }
   
   return MusEGlobal::song->applyOperationGroup(operations);
@@ -2138,46 +2292,37 @@ bool move_items(TagEventList* tag_list, signed int ticks)
   return MusEGlobal::song->applyOperationGroup(operations);
 }
 
-bool quantize_items(TagEventList* tag_list, int raster_idx, bool quant_len, int strength, int swing, int threshold)
+struct QuantizeTransform
 {
-  const int rv = MusEGui::functionQuantizeRasterVals[raster_idx];
-  if(rv <= 0)
-    return false;
-  
-  const int raster = (MusEGlobal::config.division*4) / rv;
-  
-  Undo operations;
-  
-  unsigned begin_tick;
-  int begin_diff;
-  unsigned len;
-  unsigned end_tick;
-  int len_diff;
-  Event newEvent;
-  const Part* part;
-    
-  for(ciTagEventList itl = tag_list->begin(); itl != tag_list->end(); ++itl)
+  const NoteColumns& cols;
+  unsigned part_tick;
+  int raster;
+  bool quant_len;
+  int strength;
+  int swing;
+  int threshold;
+  std::vector<unsigned>& newTick;
+  std::vector<unsigned>& newLen;
+
+  QuantizeTransform(const NoteColumns& c, unsigned pt, int r, bool ql, int st, int sw, int th,
+                    std::vector<unsigned>& nt, std::vector<unsigned>& nl)
+    : cols(c), part_tick(pt), raster(r), quant_len(ql), strength(st), swing(sw), threshold(th),
+      newTick(nt), newLen(nl) { }
+
+  void operator()(size_t begin, size_t end)
   {
-    part = itl->first;
-    const EventList& el = itl->second.evlist();
-    for(ciEvent ie = el.begin(); ie != el.end(); ie++)
+    for(size_t i = begin; i < end; ++i)
     {
-      const Event& e = ie->second;
-
-      // This operation can only apply to notes.
-      if(e.type() != Note)
-        continue;
-      
-      begin_tick = e.tick() + part->tick();
-      begin_diff = quantize_tick(begin_tick, raster, swing) - begin_tick;
+      unsigned begin_tick = cols.tick[i] + part_tick;
+      const int begin_diff = quantize_tick(begin_tick, raster, swing) - begin_tick;
 
       if (abs(begin_diff) > threshold)
         begin_tick = begin_tick + begin_diff*strength/100;
 
-      len = e.lenTick();
+      unsigned len = cols.len[i];
       
-      end_tick = begin_tick + len;
-      len_diff = quantize_tick(end_tick, raster, swing) - end_tick;
+      const unsigned end_tick = begin_tick + len;
+      const int len_diff = quantize_tick(end_tick, raster, swing) - end_tick;
         
       if ((abs(len_diff) > threshold) && quant_len)
         len = len + len_diff*strength/100;
@@ -2185,16 +2330,48 @@ bool quantize_items(TagEventList* tag_list, int raster_idx, bool quant_len, int
       if (len <= 0)
         len = 1;
 
-        
-      if ( (e.lenTick() != len) || (e.tick() + part->tick() != begin_tick) )
-      {
-        newEvent = e.clone();
-        newEvent.setTick(begin_tick - part->tick());
-        newEvent.setLenTick(len);
-        operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, e, part, false, false));
-      }
+      newTick[i] = begin_tick - part_tick;
+      newLen[i] = len;
     }
   }
+};
+
+bool quantize_items(TagEventList* tag_list, int raster_idx, bool quant_len, int strength, int swing, int threshold)
+{
+  const int rv = MusEGui::functionQuantizeRasterVals[raster_idx];
+  if(rv <= 0)
+    return false;
+  
+  const int raster = (MusEGlobal::config.division*4) / rv;
+  
+  Undo operations;
+  
+  for(ciTagEventList itl = tag_list->begin(); itl != tag_list->end(); ++itl)
+  {
+    const Part* part = itl->first;
+    const NoteColumns cols(itl->second.evlist());
+    const size_t sz = cols.size();
+    if(sz == 0)
+      continue;
+
+    std::vector<unsigned> newTick(sz);
+    std::vector<unsigned> newLen(sz);
+    QuantizeTransform transform(cols, part->tick(), raster, quant_len, strength, swing, threshold, newTick, newLen);
+    parallel_for_range(sz, sz, transform);
+
+    UndoEventBatch* batch = new UndoEventBatch();
+    for(size_t i = 0; i < sz; ++i)
+    {
+      if(newLen[i] == cols.len[i] && newTick[i] == cols.tick[i])
+        continue;
+      const Event& e = *cols.events[i];
+      Event newEvent = e.clone();
+      newEvent.setTick(newTick[i]);
+      newEvent.setLenTick(newLen[i]);
+      batch->add(e, newEvent);
+    }
+    push_event_batch(operations, part, batch);
+  }
   
   return MusEGlobal::song->applyOperationGroup(operations);
 }
@@ -2204,6 +2381,27 @@ bool set_notelen_items(TagEventList* tag_list, int len)
   return modify_notelen_items(tag_list, 0, len);
 }
 
+struct TransposeTransform
+{
+  const NoteColumns& cols;
+  int halftonesteps;
+  std::vector<int>& newPitch;
+
+  TransposeTransform(const NoteColumns& c, int h, std::vector<int>& np)
+    : cols(c), halftonesteps(h), newPitch(np) { }
+
+  void operator()(size_t begin, size_t end)
+  {
+    for(size_t i = begin; i < end; ++i)
+    {
+      int pitch = cols.pitch[i] + halftonesteps;
+      if (pitch > 127) pitch = 127;
+      if (pitch < 0) pitch = 0;
+      newPitch[i] = pitch;
+    }
+  }
+};
+
 bool transpose_items(TagEventList* tag_list, signed int halftonesteps)
 {
   if(halftonesteps == 0)
@@ -2211,57 +2409,49 @@ bool transpose_items(TagEventList* tag_list, signed int halftonesteps)
   
   Undo operations;
   
-  Event newEvent;
-  int pitch;
-  const Part* part;
-    
   for(ciTagEventList itl = tag_list->begin(); itl != tag_list->end(); ++itl)
   {
-    part = itl->first;
-    const EventList& el = itl->second.evlist();
-    for(ciEvent ie = el.begin(); ie != el.end(); ie++)
-    {
-      const Event& e = ie->second;
+    const Part* part = itl->first;
+    const NoteColumns cols(itl->second.evlist());
+    const size_t sz = cols.size();
+    if(sz == 0)
+      continue;
 
-      // This operation can only apply to notes.
-      if(e.type() != Note)
+    std::vector<int> newPitch(sz);
+    TransposeTransform transform(cols, halftonesteps, newPitch);
+    parallel_for_range(sz, sz, transform);
+
+    UndoEventBatch* batch = new UndoEventBatch();
+    for(size_t i = 0; i < sz; ++i)
+    {
+      if(newPitch[i] == cols.pitch[i])
         continue;
-      
-      newEvent = e.clone();
-      pitch = e.pitch() + halftonesteps;
-      if (pitch > 127) pitch = 127;
-      if (pitch < 0) pitch = 0;
-      newEvent.setPitch(pitch);
-      operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, e, part, false, false));
+      const Event& e = *cols.events[i];
+      Event newEvent = e.clone();
+      newEvent.setPitch(newPitch[i]);
+      batch->add(e, newEvent);
     }
+    push_event_batch(operations, part, batch);
   }
   
   return MusEGlobal::song->applyOperationGroup(operations);
 }
 
-bool modify_velocity_items(TagEventList* tag_list, int rate, int offset)
+struct VelocityTransform
 {
-  if(rate == 100 && offset == 0)
-    return false;
-  
-  Undo operations;
-  int velo;
-  Event newEvent;
-  const Part* part;
-    
-  for(ciTagEventList itl = tag_list->begin(); itl != tag_list->end(); ++itl)
+  const NoteColumns& cols;
+  int rate;
+  int offset;
+  std::vector<int>& newVelo;
+
+  VelocityTransform(const NoteColumns& c, int r, int o, std::vector<int>& nv)
+    : cols(c), rate(r), offset(o), newVelo(nv) { }
+
+  void operator()(size_t begin, size_t end)
   {
-    part = itl->first;
-    const EventList& el = itl->second.evlist();
-    for(ciEvent ie = el.begin(); ie != el.end(); ie++)
+    for(size_t i = begin; i < end; ++i)
     {
-      const Event& e = ie->second;
-
-      // This operation can only apply to notes.
-      if(e.type() != Note)
-        continue;
-      
-      velo = e.velo();
+      int velo = cols.velo[i];
 
       velo = (velo * rate) / 100;
       velo += offset;
@@ -2270,14 +2460,42 @@ bool modify_velocity_items(TagEventList* tag_list, int rate, int offset)
         velo = 1;
       else if (velo > 127)
         velo = 127;
-        
-      if (e.velo() != velo)
-      {
-        newEvent = e.clone();
-        newEvent.setVelo(velo);
-        operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, e, part, false, false));
-      }
+
+      newVelo[i] = velo;
+    }
+  }
+};
+
+bool modify_velocity_items(TagEventList* tag_list, int rate, int offset)
+{
+  if(rate == 100 && offset == 0)
+    return false;
+  
+  Undo operations;
+    
+  for(ciTagEventList itl = tag_list->begin(); itl != tag_list->end(); ++itl)
+  {
+    const Part* part = itl->first;
+    const NoteColumns cols(itl->second.evlist());
+    const size_t sz = cols.size();
+    if(sz == 0)
+      continue;
+
+    std::vector<int> newVelo(sz);
+    VelocityTransform transform(cols, rate, offset, newVelo);
+    parallel_for_range(sz, sz, transform);
+
+    UndoEventBatch* batch = new UndoEventBatch();
+    for(size_t i = 0; i < sz; ++i)
+    {
+      if(newVelo[i] == cols.velo[i])
+        continue;
+      const Event& e = *cols.events[i];
+      Event newEvent = e.clone();
+      newEvent.setVelo(newVelo[i]);
+      batch->add(e, newEvent);
     }
+    push_event_batch(operations, part, batch);
   }
   
   return MusEGlobal::song->applyOperationGroup(operations);
@@ -2627,7 +2845,7 @@ void pasteEventList(
             if(create_new_part)
               ((Part*)dest_part)->addEvent(e);
             else
-              add_operations.push_back(UndoOp(UndoOp::AddEvent, e, dest_part, false, false));
+              add_event_batched(add_operations, e, dest_part, false, false);
           //}
         break;
         
@@ -2651,7 +2869,7 @@ void pasteEventList(
               // Don't event bother replacing it using DeletEvent or ModifyEvent.
               if(el.empty())
               {
-                add_operations.push_back(UndoOp(UndoOp::AddEvent, e, dest_part, false, false));
+                add_event_batched(add_operations, e, dest_part, false, false);
               }
               else
               {
@@ -2716,7 +2934,7 @@ void pasteEventList(
             }
             
             // Do port controller values and clone parts. 
-            add_operations.push_back(UndoOp(UndoOp::AddEvent, e, dest_part, true, true));
+            add_event_batched(add_operations, e, dest_part, true, true);
           }
         }
         break;
@@ -2738,7 +2956,7 @@ void pasteEventList(
             // Don't event bother replacing it using DeletEvent or ModifyEvent.
             if(el.empty())
             {
-              add_operations.push_back(UndoOp(UndoOp::AddEvent, e, dest_part, false, false));
+              add_event_batched(add_operations, e, dest_part, false, false);
             }
             else
             {
@@ -2779,7 +2997,7 @@ void pasteEventList(
             // Don't event bother replacing it using DeletEvent or ModifyEvent.
             if(el.empty())
             {
-              add_operations.push_back(UndoOp(UndoOp::AddEvent, e, dest_part, false, false));
+              add_event_batched(add_operations, e, dest_part, false, false);
             }
             else
             {
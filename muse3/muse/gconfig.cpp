@@ -313,7 +313,13 @@ GlobalConfigValues config = {
       2,                            // routerGroupingChannels
       "",                           // mixdownPath
       true,                         // showNoteNamesInPianoRoll
-      false                         // selectionsUndoable Whether selecting parts or events is undoable.
+      false,                        // selectionsUndoable Whether selecting parts or events is undoable.
+      true,                         // latencyCompensation
+      false,                        // liveMonitoring
+      64,                           // liveMonitoringMaxLatency
+      true,                         // midiHighResTimer
+      false,                        // midiTimingReport
+      0                             // undoMemoryBudget
     };
 
 } // namespace MusEGlobal
@@ -322,6 +322,22 @@ struct GlobalConfigValues {
       // Whether selecting parts or events is undoable.
       // If set, it can be somewhat tedious for the user to step through all the undo/redo items.
       bool selectionsUndoable;
+      // Delay audio tracks so that signals meeting at a track or output are aligned,
+      //  whatever the latency of the plugins on their way.
+      bool latencyCompensation;
+      // Bypass plugins with more than liveMonitoringMaxLatency samples of latency on
+      //  record armed tracks, and leave those tracks out of the compensation.
+      bool liveMonitoring;
+      int liveMonitoringMaxLatency;
+      // Drive the ALSA midi sequencer from a high resolution timer, woken
+      //  at the next due event rather than only at every rtcTicks tick.
+      bool midiHighResTimer;
+      // Print a histogram of ALSA midi output timing to the console on each transport stop.
+      bool midiTimingReport;
+      // Memory in megabytes the undo history may hold before its oldest event
+      //  changes are compressed, then moved to disk. Zero, the default, means
+      //  no limit and the undo store is not used.
+      int undoMemoryBudget;
       };
 
 
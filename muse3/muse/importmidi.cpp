@@ -231,7 +231,10 @@ bool MusE::importMidi(const QString name, bool merge)
         {
           // this overwrites any instrument set for this port:
           if(mp->instrument() != instr)
+          {
+            instr->load();
             mp->changeInstrument(instr);
+          }
         }
       }
       
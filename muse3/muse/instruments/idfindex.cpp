@@ -0,0 +1,287 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  idfindex.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "idfindex.h"
+
+namespace MusECore {
+
+// Bump the version whenever the cache layout changes. Old caches are then simply rebuilt.
+static const quint32 IDF_INDEX_MAGIC   = 0x4d494458; // "MIDX"
+static const quint32 IDF_INDEX_VERSION = 1;
+
+//---------------------------------------------------------
+//   IdfFingerprint
+//---------------------------------------------------------
+
+IdfFingerprint::IdfFingerprint(const QFileInfo& fi)
+{
+  size = fi.size();
+  modified = fi.lastModified().toMSecsSinceEpoch();
+}
+
+//---------------------------------------------------------
+//   read
+//---------------------------------------------------------
+
+bool IdfIndex::read(const QString& path)
+{
+  _files.clear();
+  // Until a valid cache has been read, anything found must be saved.
+  _changed = true;
+
+  QFile f(path);
+  if(!f.open(QIODevice::ReadOnly))
+    return false;
+  const qint64 size = f.size();
+  uchar* map = size > 0 ? f.map(0, size) : 0;
+  if(!map)
+    return false;
+
+  // Read straight from the mapped file, without copying it.
+  const QByteArray raw = QByteArray::fromRawData((const char*)map, size);
+  QDataStream ds(raw);
+  ds.setVersion(QDataStream::Qt_5_0);
+
+  quint32 magic = 0, version = 0, fileCount = 0;
+  ds >> magic >> version >> fileCount;
+  bool ok = ds.status() == QDataStream::Ok && magic == IDF_INDEX_MAGIC && version == IDF_INDEX_VERSION;
+  for(quint32 i = 0; ok && i < fileCount; ++i)
+  {
+    QByteArray filePath;
+    IdfIndexFile file;
+    quint32 entryCount = 0;
+    ds >> filePath >> file.fingerprint.size >> file.fingerprint.modified >> entryCount;
+    file.used = false;
+    for(quint32 k = 0; ds.status() == QDataStream::Ok && k < entryCount; ++k)
+    {
+      QByteArray name;
+      IdfIndexEntry e;
+      ds >> name >> e.offset;
+      e.name = QString::fromUtf8(name);
+      file.entries.push_back(e);
+    }
+    if(ds.status() != QDataStream::Ok)
+      ok = false;
+    else
+      _files[QString::fromUtf8(filePath)] = file;
+  }
+
+  f.unmap(map);
+  if(!ok)
+  {
+    fprintf(stderr, "IdfIndex::read: Ignoring invalid instrument index: %s\n", path.toLatin1().constData());
+    _files.clear();
+    return false;
+  }
+  _changed = false;
+  return true;
+}
+
+//---------------------------------------------------------
+//   save
+//---------------------------------------------------------
+
+bool IdfIndex::save(const QString& path)
+{
+  for(std::map<QString, IdfIndexFile>::iterator i = _files.begin(); i != _files.end(); )
+  {
+    if(i->second.used)
+      ++i;
+    else
+    {
+      _files.erase(i++);
+      _changed = true;
+    }
+  }
+  if(!_changed)
+    return true;
+
+  QSaveFile f(path);
+  if(!f.open(QIODevice::WriteOnly))
+  {
+    fprintf(stderr, "IdfIndex::save: Cannot write instrument index: %s\n", path.toLatin1().constData());
+    return false;
+  }
+  QDataStream ds(&f);
+  ds.setVersion(QDataStream::Qt_5_0);
+  ds << IDF_INDEX_MAGIC << IDF_INDEX_VERSION << (quint32)_files.size();
+  for(std::map<QString, IdfIndexFile>::const_iterator i = _files.begin(); i != _files.end(); ++i)
+  {
+    const IdfIndexFile& file = i->second;
+    ds << i->first.toUtf8() << file.fingerprint.size << file.fingerprint.modified << (quint32)file.entries.size();
+    for(IdfIndexEntryList::const_iterator e = file.entries.begin(); e != file.entries.end(); ++e)
+      ds << e->name.toUtf8() << e->offset;
+  }
+  if(ds.status() != QDataStream::Ok || !f.commit())
+  {
+    fprintf(stderr, "IdfIndex::save: Error writing instrument index: %s\n", path.toLatin1().constData());
+    return false;
+  }
+  _changed = false;
+  return true;
+}
+
+//---------------------------------------------------------
+//   entries
+//---------------------------------------------------------
+
+const IdfIndexEntryList& IdfIndex::entries(const QFileInfo& fi)
+{
+  const QString path = fi.absoluteFilePath();
+  const IdfFingerprint fp(fi);
+  std::map<QString, IdfIndexFile>::iterator i = _files.find(path);
+  if(i != _files.end() && i->second.fingerprint == fp)
+  {
+    i->second.used = true;
+    return i->second.entries;
+  }
+
+  IdfIndexFile& file = _files[path];
+  file.fingerprint = fp;
+  file.used = true;
+  file.entries.clear();
+  scan(path, &file.entries);
+  _changed = true;
+  return file.entries;
+}
+
+//---------------------------------------------------------
+//   isTagAt
+//    Whether the tag starts at pos, which is a '<'.
+//---------------------------------------------------------
+
+static bool isTagAt(const QByteArray& data, int pos, const char* tag)
+{
+  const int len = strlen(tag);
+  if(pos + 1 + len >= data.size() || strncmp(data.constData() + pos + 1, tag, len) != 0)
+    return false;
+  const char c = data.at(pos + 1 + len);
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '>' || c == '/';
+}
+
+//---------------------------------------------------------
+//   tagAttribute
+//    Value of the attribute in the tag between start and end,
+//     decoded the same way the Xml reader does.
+//---------------------------------------------------------
+
+static QString tagAttribute(const QByteArray& data, int start, int end, const char* attr)
+{
+  const QByteArray name(attr);
+  int pos = start;
+  while((pos = data.indexOf(name, pos)) >= 0 && pos < end)
+  {
+    const char before = data.at(pos - 1);
+    pos += name.size();
+    if(before != ' ' && before != '\t' && before != '\n' && before != '\r')
+      continue;
+    while(pos < end && (data.at(pos) == ' ' || data.at(pos) == '\t'))
+      ++pos;
+    if(pos >= end || data.at(pos) != '=')
+      continue;
+    ++pos;
+    while(pos < end && (data.at(pos) == ' ' || data.at(pos) == '\t'))
+      ++pos;
+
+    int valueEnd;
+    if(pos < end && data.at(pos) == '"')
+    {
+      ++pos;
+      valueEnd = data.indexOf('"', pos);
+      if(valueEnd < 0 || valueEnd > end)
+        return QString();
+    }
+    else
+    {
+      valueEnd = pos;
+      while(valueEnd < end && data.at(valueEnd) != ' ' && data.at(valueEnd) != '\t' &&
+            data.at(valueEnd) != '\n' && data.at(valueEnd) != '/')
+        ++valueEnd;
+    }
+
+    QString value = QString::fromLatin1(data.constData() + pos, valueEnd - pos);
+    value.replace("&quot;", "\"");
+    value.replace("&lt;", "<");
+    value.replace("&gt;", ">");
+    value.replace("&apos;", "'");
+    value.replace("&amp;", "&");
+    return value;
+  }
+  return QString();
+}
+
+//---------------------------------------------------------
+//   scan
+//    Only the tags are looked at, the definitions
+//     themselves are left for MidiInstrument::load().
+//---------------------------------------------------------
+
+bool IdfIndex::scan(const QString& path, IdfIndexEntryList* entries)
+{
+  entries->clear();
+  QFile f(path);
+  if(!f.open(QIODevice::ReadOnly))
+    return false;
+  const QByteArray data = f.readAll();
+  f.close();
+
+  bool inMuse = false;
+  int pos = 0;
+  while((pos = data.indexOf('<', pos)) >= 0)
+  {
+    if(data.mid(pos, 4) == "<!--")
+    {
+      const int endComment = data.indexOf("-->", pos + 4);
+      if(endComment < 0)
+        break;
+      pos = endComment + 3;
+      continue;
+    }
+    if(!inMuse)
+      inMuse = isTagAt(data, pos, "muse");
+    else if(isTagAt(data, pos, "MidiInstrument"))
+    {
+      const int tagEnd = data.indexOf('>', pos);
+      if(tagEnd < 0)
+        break;
+      IdfIndexEntry e;
+      e.name = tagAttribute(data, pos, tagEnd, "name");
+      e.offset = pos;
+      entries->push_back(e);
+    }
+    ++pos;
+  }
+  return true;
+}
+
+} // namespace MusECore
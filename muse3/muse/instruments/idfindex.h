@@ -0,0 +1,110 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  idfindex.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+
+#ifndef __IDFINDEX_H__
+#define __IDFINDEX_H__
+
+#include <map>
+#include <vector>
+#include <QString>
+
+class QFileInfo;
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   IdfFingerprint
+//    Identifies the version of an instrument definition
+//     file which an index entry was made from.
+//---------------------------------------------------------
+
+struct IdfFingerprint
+{
+      qint64 size;
+      // Last modification time in milliseconds since the epoch.
+      qint64 modified;
+
+      IdfFingerprint() : size(-1), modified(-1) { }
+      IdfFingerprint(const QFileInfo& fi);
+      bool operator==(const IdfFingerprint& other) const { return size == other.size && modified == other.modified; }
+      bool operator!=(const IdfFingerprint& other) const { return !(*this == other); }
+};
+
+//---------------------------------------------------------
+//   IdfIndexEntry
+//---------------------------------------------------------
+
+struct IdfIndexEntry
+{
+      QString name;
+      // Byte offset of the instrument's <MidiInstrument> tag in the file.
+      qint64 offset;
+};
+
+typedef std::vector<IdfIndexEntry> IdfIndexEntryList;
+
+//---------------------------------------------------------
+//   IdfIndexFile
+//---------------------------------------------------------
+
+struct IdfIndexFile
+{
+      IdfFingerprint fingerprint;
+      IdfIndexEntryList entries;
+      // Whether the file was seen this session. Files which were not are dropped when saving.
+      bool used;
+};
+
+//---------------------------------------------------------
+//   IdfIndex
+//    Cache of the instruments found in each instrument
+//     definition file, so that startup only needs the names
+//     and the full definitions are read when first used.
+//    Files are recognized by path, size and modification
+//     time. Anything else is scanned again.
+//---------------------------------------------------------
+
+class IdfIndex
+{
+      std::map<QString, IdfIndexFile> _files;
+      bool _changed;
+
+   public:
+      IdfIndex() : _changed(false) { }
+
+      // Reads a cache file written by save(). The file is memory mapped.
+      // Returns false, leaving the index empty, if it is missing or not valid.
+      bool read(const QString& path);
+      // Writes the cache file if anything changed since read(). Returns false on error.
+      bool save(const QString& path);
+
+      // Entries for the file, taken from the cache if the file is unchanged, otherwise scanned.
+      const IdfIndexEntryList& entries(const QFileInfo& fi);
+
+      // Finds the offsets of the instruments in the file without parsing their definitions.
+      static bool scan(const QString& path, IdfIndexEntryList* entries);
+};
+
+} // namespace MusECore
+
+#endif
@@ -167,91 +167,30 @@ static void readEventList(Xml& xml, EventList* el, const char* name)
 //---------------------------------------------------------
 
 //---------------------------------------------------------
-//   loadIDF
+//   addIndexedInstruments
+//    Adds the instruments of a definition file, as found
+//     in the index. Their definitions are loaded when used.
 //---------------------------------------------------------
 
-static void loadIDF(QFileInfo* fi)
+static void addIndexedInstruments(IdfIndex* index, const QFileInfo& fi)
       {
-      FILE* f = fopen(fi->filePath().toLatin1().constData(), "r");
-      if (f == 0)
-            return;
-      if (MusEGlobal::debugMsg)
-            printf("READ IDF %s\n", fi->filePath().toLatin1().constData());
-      Xml xml(f);
-
-      bool skipmode = true;
-      for (;;) {
-            Xml::Token token = xml.parse();
-            const QString& tag = xml.s1();
-            switch (token) {
-                  case Xml::Error:
-                  case Xml::End:
-                        return;
-                  case Xml::TagStart:
-                        if (skipmode && tag == "muse")
-                              skipmode = false;
-                        else if (skipmode)
-                              break;
-                        else if (tag == "MidiInstrument") {
-                              MidiInstrument* i = new MidiInstrument();
-                              i->setFilePath(fi->filePath());
-                              i->read(xml);
-                              // Ignore duplicate named instruments.
-                              iMidiInstrument ii = midiInstruments.begin();
-                              for(; ii != midiInstruments.end(); ++ii)
-                              {
-                                if((*ii)->iname() == i->iname())
-                                  break;
-                              }
-                              if(ii == midiInstruments.end())
-                              {
-
-#ifdef _USE_INSTRUMENT_OVERRIDES_
-                                // Add in the drum map overrides that were found in config.
-                                // They can only be added now that the instrument has been loaded.
-                                ciWorkingDrumMapInstrumentList_t iwdmil =
-                                  MusEGlobal::workingDrumMapInstrumentList.find(i->iname().toStdString());
-                                if(iwdmil != MusEGlobal::workingDrumMapInstrumentList.end())
-                                {
-                                  const WorkingDrumMapPatchList& wdmil = iwdmil->second;
-                                  patch_drummap_mapping_list_t* pdml = i->get_patch_drummap_mapping();
-                                  int patch;
-                                  for(ciWorkingDrumMapPatchList_t iwdmpl = wdmil.begin(); iwdmpl != wdmil.end(); ++iwdmpl)
-                                  {
-                                    patch = iwdmpl->first;
-                                    iPatchDrummapMapping_t ipdm = pdml->find(patch, false); // No default.
-                                    if(ipdm != pdml->end())
-                                    {
-                                      patch_drummap_mapping_t& pdm = *ipdm;
-                                      const WorkingDrumMapList& wdml = iwdmpl->second;
-                                      pdm._workingDrumMapList = wdml;
-                                    }
-                                  }
-                                  // TODO: Done with the config override, so erase it? Hm, maybe we might need it later...
-                                  //MusEGlobal::workingDrumMapInstrumentList.erase(iwdmil);
-                                }
-#endif
-                                midiInstruments.push_back(i);
-                              }
-                              else
-                                delete i;
-                            }
-                        else
-                              xml.unknown("muse");
-                        break;
-                  case Xml::Attribut:
-                        break;
-                  case Xml::TagEnd:
-                        if (!skipmode && tag == "muse") {
-                              return;
-                              }
-                  default:
-                        break;
-                  }
+      const IdfIndexEntryList& entries = index->entries(fi);
+      for (IdfIndexEntryList::const_iterator ie = entries.begin(); ie != entries.end(); ++ie) {
+            // Ignore duplicate named instruments.
+            iMidiInstrument ii = midiInstruments.begin();
+            for(; ii != midiInstruments.end(); ++ii)
+            {
+              if((*ii)->iname() == ie->name)
+                break;
             }
-      fclose(f);
-
+            if(ii != midiInstruments.end())
+              continue;
 
+            MidiInstrument* i = new MidiInstrument(ie->name);
+            i->setFilePath(fi.filePath());
+            i->setDeferred(ie->offset, IdfFingerprint(fi));
+            midiInstruments.push_back(i);
+            }
       }
 
 //---------------------------------------------------------
@@ -292,6 +231,14 @@ void initMidiInstruments()
       }
 #endif
 
+      genericMidiInstrument->updateLookupTables();
+
+      // The index of the instruments found last time. Files which have
+      //  not changed since are not read at all.
+      const QString indexPath = MusEGlobal::configPath + QString("/instruments.idx");
+      IdfIndex index;
+      index.read(indexPath);
+
       if (MusEGlobal::debugMsg)
         printf("load user instrument definitions from <%s>\n", MusEGlobal::museUserInstruments.toLatin1().constData());
       QDir usrInstrumentsDir(MusEGlobal::museUserInstruments, QString("*.idf"));
@@ -299,7 +246,7 @@ void initMidiInstruments()
             QFileInfoList list = usrInstrumentsDir.entryInfoList();
             QFileInfoList::iterator it=list.begin(); // ddskrjo
             while(it != list.end()) { // ddskrjo
-                  loadIDF(&*it);
+                  addIndexedInstruments(&index, *it);
                   ++it;
                   }
             }
@@ -311,25 +258,31 @@ void initMidiInstruments()
             QFileInfoList list = instrumentsDir.entryInfoList();
             QFileInfoList::iterator it=list.begin(); // ddskrjo
             while(it!=list.end()) {
-                  loadIDF(&*it);
+                  addIndexedInstruments(&index, *it);
                   ++it;
                   }
             }
       else
         printf("Instrument directory not found: %s\n", MusEGlobal::museInstruments.toLatin1().constData());
 
+      if (QDir().mkpath(MusEGlobal::configPath))
+            index.save(indexPath);
       }
 
 //---------------------------------------------------------
 //   registerMidiInstrument
+//    The instrument is returned loaded, ready to be
+//     given to a port.
 //---------------------------------------------------------
 
 MidiInstrument* registerMidiInstrument(const QString& name)
       {
       for (iMidiInstrument i = midiInstruments.begin();
          i != midiInstruments.end(); ++i) {
-            if ((*i)->iname() == name)
+            if ((*i)->iname() == name) {
+                  (*i)->load();
                   return *i;
+                  }
             }
       return genericMidiInstrument;
       }
@@ -409,6 +362,11 @@ void MidiInstrument::init()
       _controller->add(prog);
       _dirty = false;
 
+      _loaded = true;
+      _fileOffset = -1;
+      _lookupValid = false;
+      for (int i = 0; i <= MUSE_MIDI_CHANNELS; ++i)
+            _drumMappingLookupIdx[i] = -1;
       }
 
 MidiInstrument::MidiInstrument()
@@ -464,6 +422,182 @@ MidiInstrument::~MidiInstrument()
       _channelDrumMapping.clear();
       }
 
+//---------------------------------------------------------
+//   setDeferred
+//---------------------------------------------------------
+
+void MidiInstrument::setDeferred(qint64 fileOffset, const IdfFingerprint& fingerprint)
+      {
+      _loaded = false;
+      _fileOffset = fileOffset;
+      _fileFingerprint = fingerprint;
+      }
+
+//---------------------------------------------------------
+//   load
+//    Reads the full definition of an instrument which was
+//     added from the index. Returns false on error, in which
+//     case the instrument stays empty.
+//---------------------------------------------------------
+
+bool MidiInstrument::load()
+      {
+      if (_loaded)
+            return true;
+      // Set first. The accessors used while reading must not come back here.
+      _loaded = true;
+
+      qint64 offset = _fileOffset;
+      if (IdfFingerprint(QFileInfo(_filePath)) != _fileFingerprint) {
+            // The file was changed since it was indexed. Find the instrument again.
+            offset = -1;
+            IdfIndexEntryList entries;
+            IdfIndex::scan(_filePath, &entries);
+            for (IdfIndexEntryList::const_iterator ie = entries.begin(); ie != entries.end(); ++ie) {
+                  if (ie->name == _name) {
+                        offset = ie->offset;
+                        break;
+                        }
+                  }
+            }
+
+      bool ok = false;
+      FILE* f = offset >= 0 ? fopen(_filePath.toLatin1().constData(), "r") : 0;
+      if (f) {
+            if (MusEGlobal::debugMsg)
+                  printf("READ IDF %s instrument %s\n", _filePath.toLatin1().constData(), _name.toLatin1().constData());
+            if (fseek(f, offset, SEEK_SET) == 0) {
+                  Xml xml(f);
+                  if (xml.parse() == Xml::TagStart && xml.s1() == "MidiInstrument") {
+                        read(xml);
+                        ok = true;
+                        }
+                  }
+            fclose(f);
+            }
+      if (!ok) {
+            fprintf(stderr, "MidiInstrument::load: Cannot read instrument %s from %s\n",
+               _name.toLatin1().constData(), _filePath.toLatin1().constData());
+            return false;
+            }
+
+#ifdef _USE_INSTRUMENT_OVERRIDES_
+      // Add in the drum map overrides that were found in config.
+      // They can only be added now that the instrument has been loaded.
+      ciWorkingDrumMapInstrumentList_t iwdmil =
+        MusEGlobal::workingDrumMapInstrumentList.find(iname().toStdString());
+      if(iwdmil != MusEGlobal::workingDrumMapInstrumentList.end())
+      {
+        const WorkingDrumMapPatchList& wdmil = iwdmil->second;
+        patch_drummap_mapping_list_t* pdml = get_patch_drummap_mapping(-1, false);
+        int patch;
+        for(ciWorkingDrumMapPatchList_t iwdmpl = wdmil.begin(); pdml && iwdmpl != wdmil.end(); ++iwdmpl)
+        {
+          patch = iwdmpl->first;
+          iPatchDrummapMapping_t ipdm = pdml->find(patch, false); // No default.
+          if(ipdm != pdml->end())
+          {
+            patch_drummap_mapping_t& pdm = *ipdm;
+            const WorkingDrumMapList& wdml = iwdmpl->second;
+            pdm._workingDrumMapList = wdml;
+          }
+        }
+        // TODO: Done with the config override, so erase it? Hm, maybe we might need it later...
+        //MusEGlobal::workingDrumMapInstrumentList.erase(iwdmil);
+      }
+#endif
+
+      updateLookupTables();
+      return true;
+      }
+
+//---------------------------------------------------------
+//   updateLookupTables
+//---------------------------------------------------------
+
+void MidiInstrument::updateLookupTables()
+      {
+      _lookupValid = false;
+
+      for (int drum = 0; drum < 2; ++drum)
+            _patchLookup[drum].clear();
+      int rank = 0;
+      for (ciPatchGroup g = pg.begin(); g != pg.end(); ++g, ++rank) {
+            const PatchList& pl = (*g)->patches;
+            for (ciPatch p = pl.begin(); p != pl.end(); ++p) {
+                  const Patch* pp = *p;
+                  _patchLookup[pp->drum ? 1 : 0].add(pp, pp->patch(), pp->dontCare(), rank);
+                  }
+            }
+
+      for (int i = 0; i <= MUSE_MIDI_CHANNELS; ++i)
+            _drumMappingLookupIdx[i] = -1;
+      _drumMappingLookup.clear();
+      _drumMappingLookup.resize(_channelDrumMapping.size());
+      int idx = 0;
+      for (ciChannelDrumMappingList_t icdml = _channelDrumMapping.begin(); icdml != _channelDrumMapping.end(); ++icdml, ++idx) {
+            const int channel = icdml->first;
+            if (channel == -1)
+                  _drumMappingLookupIdx[MUSE_MIDI_CHANNELS] = idx;
+            else if (channel >= 0 && channel < MUSE_MIDI_CHANNELS)
+                  _drumMappingLookupIdx[channel] = idx;
+            const patch_drummap_mapping_list_t& pdml = icdml->second;
+            for (ciPatchDrummapMapping_t ipdm = pdml.begin(); ipdm != pdml.end(); ++ipdm)
+                  _drumMappingLookup[idx].add(&(*ipdm), ipdm->_patch, ipdm->dontCare());
+            }
+
+      _lookupValid = true;
+      }
+
+//---------------------------------------------------------
+//   drumMappingLookup
+//    Same as ChannelDrumMappingList::find(), on the tables.
+//---------------------------------------------------------
+
+const DrumMappingLookup* MidiInstrument::drumMappingLookup(int channel, bool includeDefault) const
+      {
+      int idx = -1;
+      if (channel >= 0 && channel < MUSE_MIDI_CHANNELS)
+            idx = _drumMappingLookupIdx[channel];
+      else if (channel == -1)
+            idx = _drumMappingLookupIdx[MUSE_MIDI_CHANNELS];
+      if (idx < 0 && includeDefault)
+            idx = _drumMappingLookupIdx[MUSE_MIDI_CHANNELS];
+      if (idx < 0)
+            return 0;
+      return &_drumMappingLookup[idx];
+      }
+
+//---------------------------------------------------------
+//   findDrumMapping
+//    Uses the lookup tables if they are up to date,
+//     otherwise searches the lists.
+//---------------------------------------------------------
+
+bool MidiInstrument::findDrumMapping(int channel, bool includeDefaultChannel, int patch, bool useDefaultPatch,
+                                     const patch_drummap_mapping_t** pdm) const
+      {
+      ensureLoaded();
+      if (_lookupValid) {
+            const DrumMappingLookup* l = drumMappingLookup(channel, includeDefaultChannel);
+            if (!l)
+                  return false;
+            *pdm = l->find(patch, false); // Don't include defaults here.
+            if (!*pdm && useDefaultPatch)
+                  *pdm = l->find(CTRL_PROGRAM_VAL_DONT_CARE, false);
+            return true;
+            }
+
+      const patch_drummap_mapping_list_t* pdml = _channelDrumMapping.find(channel, includeDefaultChannel);
+      if (!pdml)
+            return false;
+      ciPatchDrummapMapping_t ipdm = pdml->find(patch, false); // Don't include defaults here.
+      if (ipdm == pdml->end() && useDefaultPatch)
+            ipdm = pdml->find(CTRL_PROGRAM_VAL_DONT_CARE, false);
+      *pdm = ipdm == pdml->end() ? 0 : &(*ipdm);
+      return true;
+      }
+
 //---------------------------------------------------------
 //   assign
 //---------------------------------------------------------
@@ -474,6 +608,10 @@ MidiInstrument& MidiInstrument::assign(const MidiInstrument& ins)
   // TODO: Copy the _initScript (if and when it is ever used)
   //---------------------------------------------------------
 
+  ins.ensureLoaded();
+  // Everything is replaced, so there is nothing left to load.
+  _loaded = true;
+
   for(iMidiController i = _controller->begin(); i != _controller->end(); ++i)
       delete i->second;
   
@@ -546,6 +684,8 @@ MidiInstrument& MidiInstrument::assign(const MidiInstrument& ins)
 
   _channelDrumMapping = ins._channelDrumMapping;
 
+  updateLookupTables();
+
   // Hmm, dirty, yes? But init sets it to false... DELETETHIS
   //_dirty = ins._dirty;
   //_dirty = false;
@@ -579,6 +719,7 @@ MType MidiInstrument::midiType() const
 
 void MidiInstrument::reset(int portNo)
 {
+      ensureLoaded();
       MusECore::MidiPort* port = &MusEGlobal::midiPorts[portNo];
       if(port->device() == 0)
         return;
@@ -1047,6 +1188,7 @@ void MidiInstrument::read(Xml& xml)
 
 void MidiInstrument::write(int level, Xml& xml)
       {
+      ensureLoaded();
       xml.header();
       xml.tag(level, "muse version=\"1.0\"");
       level++;
@@ -1111,10 +1253,23 @@ void MidiInstrument::writeDrummapOverrides(int level, Xml& xml) const
 
 patch_drummap_mapping_list_t* MidiInstrument::get_patch_drummap_mapping(int channel, bool includeDefault)
 {
+  ensureLoaded();
+  _lookupValid = false;
   patch_drummap_mapping_list_t* pdml = _channelDrumMapping.find(channel, includeDefault);
+  if(!pdml)
+    // Not found? Search the global mapping list. Only our own lookup is
+    //  invalidated, the generic instrument's stays valid.
+    return genericMidiInstrument->_channelDrumMapping.find(channel, includeDefault);
+  return pdml;
+}
+
+const patch_drummap_mapping_list_t* MidiInstrument::get_patch_drummap_mapping(int channel, bool includeDefault) const
+{
+  ensureLoaded();
+  const patch_drummap_mapping_list_t* pdml = _channelDrumMapping.find(channel, includeDefault);
   if(!pdml)
     // Not found? Search the global mapping list.
-    return genericMidiInstrument->getChannelDrumMapping()->find(channel, includeDefault);
+    return genericMidiInstrument->_channelDrumMapping.find(channel, includeDefault);
   return pdml;
 }
 
@@ -1144,6 +1299,7 @@ void MidiInstrument::populateInstrPopup(MusEGui::PopupMenu* menu, MidiInstrument
 
 void MidiInstrument::populatePatchPopup(MusEGui::PopupMenu* menu, int /*chan*/, bool drum)
       {
+      ensureLoaded();
       menu->clear();
       //int mask = 7;
 
@@ -1191,55 +1347,40 @@ overrideType
 #endif
 ) const
 {
-  const patch_drummap_mapping_list_t* pdml = _channelDrumMapping.find(channel, true); // Include default.
-  if(!pdml)
+#ifdef _USE_INSTRUMENT_OVERRIDES_
+  const bool useDefaultPatch = overrideType & WorkingDrumMapEntry::InstrumentDefaultOverride;
+#else
+  const bool useDefaultPatch = true;
+#endif
+
+  // Always search this instrument's mapping first.
+  const patch_drummap_mapping_t* ppdm = 0;
+  if(!findDrumMapping(channel, true, patch, useDefaultPatch, &ppdm)) // Include default channel.
   {
     fprintf(stderr, "MidiInstrument::getMapItem Error: No channel:%d mapping or default found. Using iNewDrumMap.\n", channel);
     dest_map = iNewDrumMap[index];
     return;
   }
 
-  // Always search this instrument's mapping first.
-  ciPatchDrummapMapping_t ipdm = pdml->find(patch, false); // Don't include defaults here.
-  if(ipdm == pdml->end())
+  if(!ppdm)
   {
-    // Not found? Is there a default patch mapping?
-#ifdef _USE_INSTRUMENT_OVERRIDES_
-    if(overrideType & WorkingDrumMapEntry::InstrumentDefaultOverride)
-#endif
-      ipdm = pdml->find(CTRL_PROGRAM_VAL_DONT_CARE, false); // Don't include defaults here.
-
-    if(ipdm == pdml->end())
+    // Not found? Search the global mapping list.
+    if(!genericMidiInstrument->findDrumMapping(channel, false, patch, useDefaultPatch, &ppdm))
     {
-      // Not found? Search the global mapping list.
-      patch_drummap_mapping_list_t* def_pdml = genericMidiInstrument->get_patch_drummap_mapping(channel, false);
-      if(!def_pdml)
-      {
-        //fprintf(stderr, "MidiInstrument::getMapItem Error: No default patch mapping found in genericMidiInstrument. Using iNewDrumMap.\n");
-        dest_map = iNewDrumMap[index];
-        return;
-      }
-      ipdm = def_pdml->find(patch, false); // Don't include defaults here.
-      if(ipdm == def_pdml->end())
-      {
-        // Not found? Is there a default patch mapping?
-#ifdef _USE_INSTRUMENT_OVERRIDES_
-        if(overrideType & WorkingDrumMapEntry::InstrumentDefaultOverride)
-#endif
-          ipdm = def_pdml->find(CTRL_PROGRAM_VAL_DONT_CARE, false); // Don't include defaults here.
-
-        if(ipdm == def_pdml->end())
-        {
-          // Not found? Use the global drum map.
-          // Update: This shouldn't really happen now, since we have added a default patch drum map to the genericMidiInstrument.
-          fprintf(stderr, "MidiInstrument::getMapItem Error: No default patch mapping found in genericMidiInstrument. Using iNewDrumMap.\n");
-          dest_map = iNewDrumMap[index];
-          return;
-        }
-      }
+      //fprintf(stderr, "MidiInstrument::getMapItem Error: No default patch mapping found in genericMidiInstrument. Using iNewDrumMap.\n");
+      dest_map = iNewDrumMap[index];
+      return;
+    }
+    if(!ppdm)
+    {
+      // Not found? Use the global drum map.
+      // Update: This shouldn't really happen now, since we have added a default patch drum map to the genericMidiInstrument.
+      fprintf(stderr, "MidiInstrument::getMapItem Error: No default patch mapping found in genericMidiInstrument. Using iNewDrumMap.\n");
+      dest_map = iNewDrumMap[index];
+      return;
     }
   }
-  const patch_drummap_mapping_t& pdm = (*ipdm);
+  const patch_drummap_mapping_t& pdm = (*ppdm);
 
   dest_map = pdm.drummap[index];
 
@@ -1456,7 +1597,13 @@ bool MidiInstrument::setWorkingDrumMapItem(int patch, int index, const WorkingDr
 
 QString MidiInstrument::getPatchName(int /*channel*/, int prog, bool drum, bool includeDefault) const
       {
-  if(MusECore::Patch* p = pg.findPatch(prog, drum, includeDefault))
+  ensureLoaded();
+  const MusECore::Patch* p;
+  if(_lookupValid)
+    p = _patchLookup[drum ? 1 : 0].find(prog, includeDefault);
+  else
+    p = pg.findPatch(prog, drum, includeDefault);
+  if(p)
     return p->name;
   return "<unknown>";
       }
@@ -1523,6 +1670,7 @@ unsigned MidiInstrument::getPrevPatch(int channel, unsigned patch, bool drum)
 
 QList<dumb_patchlist_entry_t> MidiInstrument::getPatches(int /*channel*/, bool drum)
       {
+      ensureLoaded();
       //int tmask = 1;
       QList<dumb_patchlist_entry_t> tmp;
 
@@ -32,6 +32,7 @@
 #include <string>
 #include <QString>
 #include "midiedit/drummap.h"
+#include "idfindex.h"
 
 // REMOVE Tim. newdrums. Added.
 // Adds the ability to override at instrument level.
@@ -338,6 +339,82 @@ class ChannelDrumMappingList : public ChannelDrumMappingList_t {
 
 
 
+//---------------------------------------------------------
+//   PatchLookupTable
+//    Flattened form of a patch list, for the lookups done
+//     during playback. Entries are bucketed by program number,
+//     so a lookup only compares the few entries sharing the
+//     program instead of walking the whole list.
+//    Gives the same result as the list's find(). Built by the
+//     gui thread. Lookups do not allocate.
+//---------------------------------------------------------
+
+template <class T> class PatchLookupTable
+{
+      struct Entry
+      {
+            int patch;
+            int rank;
+            const T* item;
+      };
+
+      // Indexed by program. The last bucket holds the don't care programs.
+      std::vector<Entry> _buckets[129];
+      const T* _default;
+      int _defaultRank;
+
+      static int bucket(int patch) { const int pr = patch & 0xff; return pr > 127 ? 128 : pr; }
+
+   public:
+      PatchLookupTable() : _default(0), _defaultRank(0) { }
+
+      void clear()
+      {
+            for(int i = 0; i < 129; ++i)
+                  _buckets[i].clear();
+            _default = 0;
+            _defaultRank = 0;
+      }
+
+      // Items must be added in list order. Rank is the index of
+      //  the item's patch group, where a default found in an earlier
+      //  group wins over an exact match found in a later one.
+      void add(const T* item, int patch, bool dontCare, int rank = 0)
+      {
+            Entry e;
+            e.patch = patch;
+            e.rank = rank;
+            e.item = item;
+            _buckets[bucket(patch)].push_back(e);
+            if(dontCare && !_default)
+            {
+                  _default = item;
+                  _defaultRank = rank;
+            }
+      }
+
+      // An unknown patch (CTRL_VAL_UNKNOWN) never matches exactly,
+      //  since the entries hold 24 bit patch numbers.
+      const T* find(int patch, bool includeDefault) const
+      {
+            const std::vector<Entry>& b = _buckets[bucket(patch)];
+            const Entry* exact = 0;
+            for(typename std::vector<Entry>::const_iterator i = b.begin(); i != b.end(); ++i)
+            {
+                  if(i->patch == patch)
+                  {
+                        exact = &(*i);
+                        break;
+                  }
+            }
+            if(includeDefault && _default && (!exact || _defaultRank < exact->rank))
+                  return _default;
+            return exact ? exact->item : 0;
+      }
+};
+
+typedef PatchLookupTable<patch_drummap_mapping_t> DrumMappingLookup;
+
 //---------------------------------------------------------
 //   MidiInstrument
 //---------------------------------------------------------
@@ -358,7 +435,26 @@ class MidiInstrument {
       bool _waitForLSB; // Whether 14-bit controllers wait for LSB, or MSB and LSB are separate.
       NoteOffMode _noteOffMode;
 
+      // False while only the index entry is known. See load().
+      bool _loaded;
+      qint64 _fileOffset;
+      IdfFingerprint _fileFingerprint;
+
+      // Flattened patch and drum map lookups, rebuilt by updateLookupTables().
+      // Indexed by drum.
+      PatchLookupTable<Patch> _patchLookup[2];
+      std::vector<DrumMappingLookup> _drumMappingLookup;
+      // Index into _drumMappingLookup for each channel, or -1. The last one is the default channel.
+      int _drumMappingLookupIdx[MUSE_MIDI_CHANNELS + 1];
+      // Cleared whenever the patches or drum mappings are handed out for editing.
+      bool _lookupValid;
+
       void init();
+      void ensureLoaded() const { if(!_loaded) const_cast<MidiInstrument*>(this)->load(); }
+      const DrumMappingLookup* drumMappingLookup(int channel, bool includeDefault) const;
+      // Finds this instrument's mapping for the patch. Returns false if there is no mapping list for the channel.
+      bool findDrumMapping(int channel, bool includeDefaultChannel, int patch, bool useDefaultPatch,
+                           const patch_drummap_mapping_t** pdm) const;
 
    protected:
       EventList* _midiInit;
@@ -390,9 +486,19 @@ class MidiInstrument {
       bool dirty() const                     { return _dirty;      }
       void setDirty(bool v)                  { _dirty = v;         }
 
-      const QList<SysEx*>& sysex() const     { return _sysex; }
-      void removeSysex(SysEx* sysex)         { _sysex.removeAll(sysex); }
-      void addSysex(SysEx* sysex)            { _sysex.append(sysex); }
+      // Instruments found at startup start out with only their name, file and
+      //  offset from the instrument index. The full definition is read on first
+      //  use, or when a port selects the instrument. Gui thread only.
+      void setDeferred(qint64 fileOffset, const IdfFingerprint& fingerprint);
+      bool isLoaded() const                  { return _loaded; }
+      bool load();
+      // Rebuilds the flattened patch and drum map lookups after the patches
+      //  or drum mappings were changed. Gui thread, or audio idle.
+      void updateLookupTables();
+
+      const QList<SysEx*>& sysex() const     { ensureLoaded(); return _sysex; }
+      void removeSysex(SysEx* sysex)         { ensureLoaded(); _sysex.removeAll(sysex); }
+      void addSysex(SysEx* sysex)            { ensureLoaded(); _sysex.append(sysex); }
 
 
       QList<dumb_patchlist_entry_t> getPatches(int channel, bool drum);
@@ -412,18 +518,18 @@ class MidiInstrument {
       //  WorkingDrumMapEntry::OverrideType instrument overrides. Channel can be -1 meaning default.
       virtual void getMapItem(int channel, int patch, int index, DrumMap& dest_map, int overrideType = WorkingDrumMapEntry::AllOverrides) const;
 
-      EventList* midiInit() const            { return _midiInit; }
-      EventList* midiReset() const           { return _midiReset; }
-      EventList* midiState() const           { return _midiState; }
-      const char* initScript() const         { return _initScript; }
-      MidiControllerList* controller() const { return _controller; }
-      bool waitForLSB() { return _waitForLSB; }
-      void setWaitForLSB(bool v) { _waitForLSB = v; }
+      EventList* midiInit() const            { ensureLoaded(); return _midiInit; }
+      EventList* midiReset() const           { ensureLoaded(); return _midiReset; }
+      EventList* midiState() const           { ensureLoaded(); return _midiState; }
+      const char* initScript() const         { ensureLoaded(); return _initScript; }
+      MidiControllerList* controller() const { ensureLoaded(); return _controller; }
+      bool waitForLSB() { ensureLoaded(); return _waitForLSB; }
+      void setWaitForLSB(bool v) { ensureLoaded(); _waitForLSB = v; }
       
       // Virtual so that inheriters (synths etc) can return whatever they want.
-      virtual NoteOffMode noteOffMode() const { return _noteOffMode; }
+      virtual NoteOffMode noteOffMode() const { ensureLoaded(); return _noteOffMode; }
       // For non-synths, users can set this value.
-      void setNoteOffMode(NoteOffMode mode) { _noteOffMode = mode; }
+      void setNoteOffMode(NoteOffMode mode) { ensureLoaded(); _noteOffMode = mode; }
 
       void readMidiState(Xml& xml);
       virtual void reset(int); 
@@ -436,9 +542,11 @@ class MidiInstrument {
       void writeDrummapOverrides(int level, Xml&) const;
 #endif
 
-      PatchGroupList* groups()        { return &pg; }
+      // These hand out the lists for editing, so they invalidate the lookup tables.
+      PatchGroupList* groups()        { ensureLoaded(); _lookupValid = false; return &pg; }
       patch_drummap_mapping_list_t* get_patch_drummap_mapping(int channel, bool includeDefault);
-      ChannelDrumMappingList* getChannelDrumMapping() { return &_channelDrumMapping; }
+      const patch_drummap_mapping_list_t* get_patch_drummap_mapping(int channel, bool includeDefault) const;
+      ChannelDrumMappingList* getChannelDrumMapping() { ensureLoaded(); _lookupValid = false; return &_channelDrumMapping; }
       };
 
 //---------------------------------------------------------
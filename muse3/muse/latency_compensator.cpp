@@ -36,7 +36,7 @@ LatencyCompensator::LatencyCompensator(unsigned long channels, unsigned long buf
   _delays = new unsigned long[channels];
   _writePointers = new unsigned long[channels];
 
-  for(int i = 0; i < _channels; ++i)
+  for(unsigned long i = 0; i < _channels; ++i)
   {
     _buffer[i] = new float[_bufferSize];
     memset(_buffer[i],  0, sizeof(float) * _bufferSize);
@@ -47,7 +47,7 @@ LatencyCompensator::LatencyCompensator(unsigned long channels, unsigned long buf
 
 LatencyCompensator::~LatencyCompensator()
 {
-  for(int i = 0; i < _channels; ++i)
+  for(unsigned long i = 0; i < _channels; ++i)
     delete [] _buffer[i];
   delete [] _buffer;
   delete [] _delays;
@@ -56,14 +56,14 @@ LatencyCompensator::~LatencyCompensator()
 
 void LatencyCompensator::clear()
 {
-  for(int i = 0; i < _channels; ++i)
+  for(unsigned long i = 0; i < _channels; ++i)
     memset(_buffer[i],  0, sizeof(float) * _bufferSize);
 }
 
 void LatencyCompensator::setBufferSize(unsigned long size)
 {
   _bufferSize = size;
-  for(int i = 0; i < _channels; ++i)
+  for(unsigned long i = 0; i < _channels; ++i)
   {
     delete [] _buffer[i];
     _buffer[i] = new float[_bufferSize];
@@ -73,17 +73,18 @@ void LatencyCompensator::setBufferSize(unsigned long size)
 
 void LatencyCompensator::setChannels(unsigned long channels)
 {
-  for(int i = 0; i < _channels; ++i)
+  for(unsigned long i = 0; i < _channels; ++i)
     delete [] _buffer[i];
   delete [] _buffer;
   delete [] _delays;
   delete [] _writePointers;
 
-  _buffer = new float*[channels];
-  _delays = new unsigned long[channels];
-  _writePointers = new unsigned long[channels];
+  _channels = channels;
+  _buffer = new float*[_channels];
+  _delays = new unsigned long[_channels];
+  _writePointers = new unsigned long[_channels];
 
-  for(int i = 0; i < _channels; ++i)
+  for(unsigned long i = 0; i < _channels; ++i)
   {
     _buffer[i] = new float[_bufferSize];
     memset(_buffer[i],  0, sizeof(float) * _bufferSize);
@@ -92,9 +93,28 @@ void LatencyCompensator::setChannels(unsigned long channels)
   }
 }
 
+void LatencyCompensator::setDelay(unsigned long channel, unsigned long delay)
+{
+  if(channel >= _channels)
+    return;
+  if(delay >= _bufferSize)
+    delay = _bufferSize - 1;
+  _delays[channel] = delay;
+}
+
+void LatencyCompensator::setDelay(unsigned long delay)
+{
+  for(unsigned long i = 0; i < _channels; ++i)
+    setDelay(i, delay);
+}
+
 void LatencyCompensator::run(unsigned long SampleCount, float** data)
 {
-  float inputSample;
+  run(SampleCount, _channels, data);
+}
+
+void LatencyCompensator::run(unsigned long SampleCount, unsigned long channels, float** data)
+{
   unsigned long readOffset;
   unsigned long bufsz_mask;
   unsigned long writeOffset;
@@ -102,14 +122,15 @@ void LatencyCompensator::run(unsigned long SampleCount, float** data)
 
   bufsz_mask = _bufferSize - 1;
   
-  float* input;
-  float* output;
+  if(channels > _channels)
+    channels = _channels;
+
+  float* io;
   float* buf;
   
-  for(int ch = 0; ch < _channels; ++ch)
+  for(unsigned long ch = 0; ch < channels; ++ch)
   {
-    input = data[ch];
-    output = data[ch];
+    io = data[ch];
     buf = _buffer[ch];
 
     writeOffset = _writePointers[ch];
@@ -117,17 +138,12 @@ void LatencyCompensator::run(unsigned long SampleCount, float** data)
     
     for(i = 0; i < SampleCount; i++) 
     {
-      inputSample = *(input++);
-
-      *(output++) = (buf[((i + readOffset) & bufsz_mask)]);
-      //*(output++) = (buf[((i + readOffset) % _bufferSize)]);
-
-      buf[((i + writeOffset) & bufsz_mask)] = inputSample;
-      //buf[((i + writeOffset) % _bufferSize)] = inputSample;
+      // Write before reading, so that a zero delay passes the input straight through.
+      buf[((i + writeOffset) & bufsz_mask)] = io[i];
+      io[i] = buf[((i + readOffset) & bufsz_mask)];
     }
     
     _writePointers[ch] = (_writePointers[ch] + SampleCount) & bufsz_mask;
-    //_writePointers[ch] = (_writePointers[ch] + SampleCount) % _bufferSize;
   }
 }
   
@@ -42,9 +42,17 @@ class LatencyCompensator
     virtual ~LatencyCompensator();
     
     void clear();
+    unsigned long bufferSize() const { return _bufferSize; }
     void setBufferSize(unsigned long size);
+    unsigned long channels() const { return _channels; }
     void setChannels(unsigned long channels);
+    // Delay in samples. Limited to one less than the buffer size.
+    unsigned long delay(unsigned long channel) const { return _delays[channel]; }
+    void setDelay(unsigned long channel, unsigned long delay);
+    void setDelay(unsigned long delay);
     void run(unsigned long SampleCount, float** data);
+    // Runs only the first 'channels' channels.
+    void run(unsigned long SampleCount, unsigned long channels, float** data);
 };
 
 } // namespace MusECore
@@ -35,6 +35,8 @@
 #include <sys/stat.h>
 #include <iostream>
 #include <time.h>
+#include <unistd.h>
+#include <errno.h>
 #include <dlfcn.h>
 #include <QMessageBox>
 #include <QDirIterator>
@@ -66,6 +68,7 @@
 #include "app.h"
 #include "globals.h"
 #include "gconfig.h"
+#include "audiobuffers.h"
 #include "components/popupmenu.h"
 #include "widgets/menutitleitem.h"
 #include "icons.h"
@@ -230,6 +233,8 @@ LV2_Feature lv2Features [] =
 
 std::vector<LV2Synth *> synthsToFree;
 
+static LV2WorkerPool lv2WorkerPool;
+
 #define SIZEOF_ARRAY(x) sizeof(x)/sizeof(x[0])
 
 void initLV2()
@@ -438,6 +443,7 @@ void initLV2()
 
 void deinitLV2()
 {
+   lv2WorkerPool.stop();
 
    for(size_t i = 0; i < synthsToFree.size(); i++)
    {
@@ -588,7 +594,6 @@ void LV2Synth::lv2state_FillFeatures(LV2PluginWrapper_State *state)
    state->wrkSched.handle = (LV2_Worker_Schedule_Handle)state;
    state->wrkSched.schedule_work = LV2Synth::lv2wrk_scheduleWork;
    state->wrkIface = NULL;
-   state->wrkThread = new LV2PluginWrapper_Worker(state);
 
    state->extHost.plugin_human_id = state->human_id = NULL;
    state->extHost.ui_closed = LV2Synth::lv2ui_ExtUi_Closed;
@@ -809,7 +814,13 @@ void LV2Synth::lv2state_PostInstantiate(LV2PluginWrapper_State *state)
 
    LV2Synth::lv2prg_updatePrograms(state);
 
-   state->wrkThread->start(QThread::LowPriority);
+   if(state->wrkIface != NULL)
+   {
+      state->wrkRequests = new LV2WorkerRing(LV2_WORKER_RING_SIZE);
+      state->wrkResponses = new LV2WorkerRing(LV2_WORKER_RING_SIZE);
+      state->wrkBuffer = new char [LV2_WORKER_RING_SIZE];
+      lv2WorkerPool.start();
+   }
 
 }
 
@@ -839,9 +850,24 @@ void LV2Synth::lv2state_FreeState(LV2PluginWrapper_State *state)
 {
    assert(state != NULL);
 
-   state->wrkThread->setClosing();
-   state->wrkThread->wait();
-   delete state->wrkThread;
+   // Wait for the pool to be done with the instance, and keep it from being queued again.
+   while(state->wrkQueued.exchange(true) && lv2WorkerPool.threadCount() > 0)
+      usleep(1000);
+   if(state->wrkRequests)
+   {
+      delete state->wrkRequests;
+      state->wrkRequests = NULL;
+   }
+   if(state->wrkResponses)
+   {
+      delete state->wrkResponses;
+      state->wrkResponses = NULL;
+   }
+   if(state->wrkBuffer)
+   {
+      delete [] state->wrkBuffer;
+      state->wrkBuffer = NULL;
+   }
 
    if(state->human_id != NULL)
       free(state->human_id);
@@ -1563,16 +1589,24 @@ LV2_Worker_Status LV2Synth::lv2wrk_scheduleWork(LV2_Worker_Schedule_Handle handl
 #endif
    LV2PluginWrapper_State *state = (LV2PluginWrapper_State *)handle;
 
-   //assert(state->wrkEndWork != true);
-   if(state->wrkEndWork != false)
+   if(state->wrkRequests == NULL)
       return LV2_WORKER_ERR_UNKNOWN;
 
-   state->wrkDataSize = size;
-   state->wrkDataBuffer = data;
-   if(MusEGlobal::audio->freewheel()) //don't wait for a thread. Do it now
-      state->wrkThread->makeWork();
-   else
-      return state->wrkThread->scheduleWork();
+   // The data is only valid during this call.
+   if(!state->wrkRequests->write(size, data))
+      return LV2_WORKER_ERR_NO_SPACE;
+
+   //don't wait for a thread. Do it now, unless a pool thread is busy with this instance.
+   if(MusEGlobal::audio->freewheel() && !state->wrkQueued.exchange(true))
+   {
+      // Only called from run(), so the response buffer is free until end of run.
+      lv2wrk_process(state, state->wrkBuffer);
+      return LV2_WORKER_SUCCESS;
+   }
+
+   // The request is in the ring already and will be served, so this is not an error
+   //  even if the pool queue is full. lv2wrk_endRun() queues the instance again.
+   lv2WorkerPool.schedule(state);
 
    return LV2_WORKER_SUCCESS;
 }
@@ -1581,13 +1615,54 @@ LV2_Worker_Status LV2Synth::lv2wrk_respond(LV2_Worker_Respond_Handle handle, uin
 {
    LV2PluginWrapper_State *state = (LV2PluginWrapper_State *)handle;
 
-   state->wrkDataSize = size;
-   state->wrkDataBuffer = data;
-   state->wrkEndWork = true;
+   if(!state->wrkResponses->write(size, data))
+      return LV2_WORKER_ERR_NO_SPACE;
 
    return LV2_WORKER_SUCCESS;
 }
 
+void LV2Synth::lv2wrk_process(LV2PluginWrapper_State *state, char *buffer)
+{
+#ifdef DEBUG_LV2
+   std::cerr << "LV2Synth::lv2wrk_process" << std::endl;
+#endif
+   while(true)
+   {
+      uint32_t size;
+      while(state->wrkRequests->read(&size, buffer))
+      {
+         if(state->wrkIface->work)
+            state->wrkIface->work(lilv_instance_get_handle(state->handle), LV2Synth::lv2wrk_respond, state, size, buffer);
+      }
+
+      state->wrkQueued.store(false);
+      // A request may have arrived after the ring was drained but before the flag was cleared.
+      // Then the scheduler saw the flag set and did not queue the instance, so serve it now.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(state->wrkRequests->isEmpty() || state->wrkQueued.exchange(true))
+         break;
+   }
+}
+
+void LV2Synth::lv2wrk_endRun(LV2PluginWrapper_State *state)
+{
+   if(state->wrkIface == NULL)
+      return;
+   // Requests left over because the pool queue was full when they were scheduled.
+   if(state->wrkRequests && !state->wrkRequests->isEmpty() && !state->wrkQueued.load())
+      lv2WorkerPool.schedule(state);
+   //notify worker about processed data (if any)
+   if(state->wrkResponses && state->wrkIface->work_response)
+   {
+      uint32_t size;
+      while(state->wrkResponses->read(&size, state->wrkBuffer))
+         state->wrkIface->work_response(lilv_instance_get_handle(state->handle), size, state->wrkBuffer);
+   }
+   //notify worker that this run() finished
+   if(state->wrkIface->end_run)
+      state->wrkIface->end_run(lilv_instance_get_handle(state->handle));
+}
+
 void LV2Synth::lv2conf_write(LV2PluginWrapper_State *state, int level, Xml &xml)
 {
    state->iStateValues.clear();
@@ -2684,8 +2759,6 @@ LV2SynthIF::~LV2SynthIF()
       free((*_itA).buffer);
    }
 
-   if(_audioInSilenceBuf)
-     free(_audioInSilenceBuf);
   
    if(_audioInBuffers)
    {
@@ -2881,34 +2954,9 @@ bool LV2SynthIF::init(LV2Synth *s)
          lilv_instance_connect_port(_handle, idx, &_controlsOut[i].val);
    }
 
-#ifdef _WIN32
-   _audioInSilenceBuf = (float *) _aligned_malloc(16, sizeof(float) * MusEGlobal::segmentSize);
-   if(_audioInSilenceBuf == NULL)
-   {
-      fprintf(stderr, "ERROR: LV2SynthIF::init: _aligned_malloc returned error: NULL. Aborting!\n");
-      abort();
-   }
-#else
-   int rv = posix_memalign((void **)&_audioInSilenceBuf, 16, sizeof(float) * MusEGlobal::segmentSize);
-
-   if(rv != 0)
-   {
-      fprintf(stderr, "ERROR: LV2SynthIF::init: posix_memalign returned error:%d. Aborting!\n", rv);
-      abort();
-   }
-#endif
-
-   if(MusEGlobal::config.useDenormalBias)
-   {
-      for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-      {
-         _audioInSilenceBuf[q] = MusEGlobal::denormalBias;
-      }
-   }
-   else
-   {
-      memset(_audioInSilenceBuf, 0, sizeof(float) * MusEGlobal::segmentSize);
-   }
+   // Shared by all plugins.
+   MusEGlobal::audioBufferPool.prepare();
+   _audioInSilenceBuf = MusEGlobal::audioBufferPool.silence();
 
    //cache number of ports
    _inports = _audioInPorts.size();
@@ -4133,17 +4181,7 @@ bool LV2SynthIF::getData(MidiPort *, unsigned int pos, int ports, unsigned int n
 #endif
 
             lilv_instance_run(_handle, nsamp);
-            //notify worker that this run() finished
-            if(_state->wrkIface && _state->wrkIface->end_run)
-               _state->wrkIface->end_run(lilv_instance_get_handle(_handle));
-            //notify worker about processed data (if any)
-            if(_state->wrkIface && _state->wrkIface->work_response && _state->wrkEndWork)
-            {
-               _state->wrkIface->work_response(lilv_instance_get_handle(_handle), _state->wrkDataSize, _state->wrkDataBuffer);
-               _state->wrkDataSize = 0;
-               _state->wrkDataBuffer = NULL;
-               _state->wrkEndWork = false;
-            }
+            LV2Synth::lv2wrk_endRun(_state);
 
             LV2Synth::lv2audio_postProcessMidiPorts(_state, nsamp);
 
@@ -5067,17 +5105,7 @@ void LV2PluginWrapper::apply(LADSPA_Handle handle, unsigned long n)
 
 
    lilv_instance_run(state->handle, n);
-   //notify worker that this run() finished
-   if(state->wrkIface && state->wrkIface->end_run)
-      state->wrkIface->end_run(lilv_instance_get_handle(state->handle));
-   //notify worker about processes data (if any)
-   if(state->wrkIface && state->wrkIface->work_response && state->wrkEndWork)
-   {
-      state->wrkEndWork = false;
-      state->wrkIface->work_response(lilv_instance_get_handle(state->handle), state->wrkDataSize, state->wrkDataBuffer);
-      state->wrkDataSize = 0;
-      state->wrkDataBuffer = NULL;
-   }
+   LV2Synth::lv2wrk_endRun(state);
 
    LV2Synth::lv2audio_postProcessMidiPorts(state, n);
 }
@@ -5243,49 +5271,143 @@ void LV2PluginWrapper::applyPreset(PluginI *p, void *preset)
 
 void LV2PluginWrapper_Worker::run()
 {
+   char *buffer = new char [LV2_WORKER_RING_SIZE];
    while(true)
    {
-      _mSem.acquire(1);
-      if(_closing)
+      _pool->wait();
+      if(_pool->isClosing())
          break;
-      makeWork();
+      LV2PluginWrapper_State *state;
+      while(_pool->pop(&state))
+         LV2Synth::lv2wrk_process(state, buffer);
+   }
+   delete [] buffer;
+}
 
+LV2WorkerPool::LV2WorkerPool() : _queue(NULL), _enqueuePos(0), _dequeuePos(0), _closing(false)
+{
+}
+
+LV2WorkerPool::~LV2WorkerPool()
+{
+   stop();
+}
+
+void LV2WorkerPool::start()
+{
+   if(!_threads.empty())
+      return;
+
+   _queue = new Cell [LV2_WORKER_POOL_QUEUE_SIZE];
+   for(size_t i = 0; i < LV2_WORKER_POOL_QUEUE_SIZE; ++i)
+   {
+      _queue [i].sequence.store(i, std::memory_order_relaxed);
+      _queue [i].state = NULL;
    }
+   _enqueuePos.store(0);
+   _dequeuePos.store(0);
+   _closing.store(false);
+   sem_init(&_sem, 0, 0);
 
+   const int n = std::max(1, std::min(LV2_WORKER_POOL_MAX_THREADS, QThread::idealThreadCount()));
+   for(int i = 0; i < n; ++i)
+   {
+      LV2PluginWrapper_Worker *t = new LV2PluginWrapper_Worker(this);
+      _threads.push_back(t);
+      t->start(QThread::LowPriority);
+   }
 }
 
-LV2_Worker_Status LV2PluginWrapper_Worker::scheduleWork()
+void LV2WorkerPool::stop()
 {
-   if(_mSem.available() != 0)
-      return LV2_WORKER_ERR_NO_SPACE;
-   _mSem.release(1);
-   return LV2_WORKER_SUCCESS;
+   if(_threads.empty())
+      return;
 
+   _closing.store(true);
+   for(size_t i = 0; i < _threads.size(); ++i)
+      sem_post(&_sem);
+   for(size_t i = 0; i < _threads.size(); ++i)
+   {
+      _threads [i]->wait();
+      delete _threads [i];
+   }
+   _threads.clear();
+   sem_destroy(&_sem);
+   delete [] _queue;
+   _queue = NULL;
 }
 
-void LV2PluginWrapper_Worker::makeWork()
+bool LV2WorkerPool::push(LV2PluginWrapper_State *state)
 {
-#ifdef DEBUG_LV2
-   std::cerr << "LV2PluginWrapper_Worker::makeWork" << std::endl;
-#endif
-   if(_state->wrkIface && _state->wrkIface->work)
+   if(_queue == NULL)
+      return false;
+   Cell *cell;
+   size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+   while(true)
    {
-      const void *dataBuffer = _state->wrkDataBuffer;
-      uint32_t dataSize = _state->wrkDataSize;
-      _state->wrkDataBuffer = NULL;
-      _state->wrkDataSize = 0;
-      if(_state->wrkIface->work(lilv_instance_get_handle(_state->handle),
-                                LV2Synth::lv2wrk_respond,
-                                _state,
-                                dataSize,
-                                dataBuffer) != LV2_WORKER_SUCCESS)
+      cell = &_queue [pos & (LV2_WORKER_POOL_QUEUE_SIZE - 1)];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+      if(dif == 0)
       {
-         _state->wrkEndWork = false;
-         _state->wrkDataBuffer = NULL;
-         _state->wrkDataSize = 0;
+         if(_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
       }
+      else if(dif < 0)
+         return false;
+      else
+         pos = _enqueuePos.load(std::memory_order_relaxed);
    }
+   cell->state = state;
+   cell->sequence.store(pos + 1, std::memory_order_release);
+   return true;
+}
 
+bool LV2WorkerPool::pop(LV2PluginWrapper_State **state)
+{
+   Cell *cell;
+   size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+   while(true)
+   {
+      cell = &_queue [pos & (LV2_WORKER_POOL_QUEUE_SIZE - 1)];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+      if(dif == 0)
+      {
+         if(_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            break;
+      }
+      else if(dif < 0)
+         return false;
+      else
+         pos = _dequeuePos.load(std::memory_order_relaxed);
+   }
+   *state = cell->state;
+   cell->sequence.store(pos + LV2_WORKER_POOL_QUEUE_SIZE, std::memory_order_release);
+   return true;
+}
+
+bool LV2WorkerPool::schedule(LV2PluginWrapper_State *state)
+{
+   // Pairs with the fence in LV2Synth::lv2wrk_process(). Either we see the flag
+   //  cleared and queue the instance, or the pool thread sees our request.
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if(state->wrkQueued.exchange(true))
+      return true;
+   if(!push(state))
+   {
+      // The request stays in the ring and is served with the next one.
+      state->wrkQueued.store(false);
+      return false;
+   }
+   sem_post(&_sem);
+   return true;
+}
+
+void LV2WorkerPool::wait()
+{
+   while(sem_wait(&_sem) != 0 && errno == EINTR)
+      ;
 }
 
 LV2EvBuf::LV2EvBuf(bool isInput, bool oldApi, LV2_URID atomTypeSequence, LV2_URID atomTypeChunk)
@@ -5596,46 +5718,194 @@ bool LV2SimpleRTFifo::get(uint32_t *port_index, size_t *szOut, char *data_out)
    return true;
 }
 
-LV2UridBiMap::LV2UridBiMap() : nextId ( 1 ) {_map.clear(); _rmap.clear();}
+LV2WorkerRing::LV2WorkerRing(uint32_t size) : _size(size), _readIndex(0), _writeIndex(0)
+{
+   assert((size & (size - 1)) == 0);
+   _buffer = new char [_size];
+}
+
+LV2WorkerRing::~LV2WorkerRing()
+{
+   delete [] _buffer;
+}
+
+void LV2WorkerRing::copyIn(uint32_t pos, const void *data, uint32_t size)
+{
+   const uint32_t offs = pos & (_size - 1);
+   const uint32_t first = std::min(size, _size - offs);
+   memcpy(_buffer + offs, data, first);
+   if(first < size)
+      memcpy(_buffer, (const char *)data + first, size - first);
+}
+
+void LV2WorkerRing::copyOut(uint32_t pos, void *data, uint32_t size) const
+{
+   const uint32_t offs = pos & (_size - 1);
+   const uint32_t first = std::min(size, _size - offs);
+   memcpy(data, _buffer + offs, first);
+   if(first < size)
+      memcpy((char *)data + first, _buffer, size - first);
+}
+
+bool LV2WorkerRing::write(uint32_t size, const void *data)
+{
+   const uint32_t w = _writeIndex.load(std::memory_order_relaxed);
+   const uint32_t r = _readIndex.load(std::memory_order_acquire);
+   if(size > _size - sizeof(size) || _size - (w - r) < sizeof(size) + size)
+      return false;
+   copyIn(w, &size, sizeof(size));
+   copyIn(w + sizeof(size), data, size);
+   _writeIndex.store(w + sizeof(size) + size, std::memory_order_release);
+   return true;
+}
+
+bool LV2WorkerRing::read(uint32_t *size, void *data)
+{
+   const uint32_t r = _readIndex.load(std::memory_order_relaxed);
+   const uint32_t w = _writeIndex.load(std::memory_order_acquire);
+   if(r == w)
+      return false;
+   copyOut(r, size, sizeof(*size));
+   copyOut(r + sizeof(*size), data, *size);
+   _readIndex.store(r + sizeof(*size) + *size, std::memory_order_release);
+   return true;
+}
+
+// URIs registered with every map, so that plugins rarely have to add any from run().
+static const char *lv2PreregisteredUris [] =
+{
+   LV2_ATOM__Atom, LV2_ATOM__Blank, LV2_ATOM__Bool, LV2_ATOM__Chunk, LV2_ATOM__Double,
+   LV2_ATOM__Event, LV2_ATOM__Float, LV2_ATOM__Int, LV2_ATOM__Literal, LV2_ATOM__Long,
+   LV2_ATOM__Number, LV2_ATOM__Object, LV2_ATOM__Path, LV2_ATOM__Property, LV2_ATOM__Resource,
+   LV2_ATOM__Sequence, LV2_ATOM__Sound, LV2_ATOM__String, LV2_ATOM__Tuple, LV2_ATOM__URI,
+   LV2_ATOM__URID, LV2_ATOM__Vector, LV2_ATOM__atomTransfer, LV2_ATOM__beatTime,
+   LV2_ATOM__eventTransfer, LV2_ATOM__frameTime,
+   LV2_MIDI__MidiEvent,
+   LV2_TIME__Position, LV2_TIME__bar, LV2_TIME__barBeat, LV2_TIME__beat, LV2_TIME__beatUnit,
+   LV2_TIME__beatsPerBar, LV2_TIME__beatsPerMinute, LV2_TIME__frame, LV2_TIME__framesPerSecond,
+   LV2_TIME__speed,
+   LV2_PATCH__Get, LV2_PATCH__Put, LV2_PATCH__Set, LV2_PATCH__body, LV2_PATCH__property,
+   LV2_PATCH__subject, LV2_PATCH__value,
+   LV2_P_SAMPLE_RATE, LV2_P_MIN_BLKLEN, LV2_P_MAX_BLKLEN, LV2_P_SEQ_SIZE, LV2_CORE__sampleRate,
+   LV2_LOG__Error, LV2_LOG__Note, LV2_LOG__Trace, LV2_LOG__Warning,
+   LV2_F_STATE_CHANGED
+};
+
+LV2UridBiMap::LV2UridBiMap()
+{
+   _table.store(createTable(1024, 512));
+   for(size_t i = 0; i < SIZEOF_ARRAY(lv2PreregisteredUris); ++i)
+      map(lv2PreregisteredUris [i]);
+}
 
 LV2UridBiMap::~LV2UridBiMap()
 {
-   LV2_SYNTH_URID_MAP::iterator it = _map.begin();
-   for(;it != _map.end(); ++it)
+   for(size_t i = 0; i < _entries.size(); ++i)
    {
-      free((void*)(*it).first);
+      free((void*)_entries [i]->uri);
+      delete _entries [i];
    }
+   for(size_t i = 0; i < _oldTables.size(); ++i)
+      freeTable(_oldTables [i]);
+   freeTable(_table.load());
+}
+
+uint32_t LV2UridBiMap::hashUri(const char *uri)
+{
+   // FNV-1a
+   uint32_t h = 2166136261u;
+   for(const unsigned char *p = (const unsigned char *)uri; *p; ++p)
+   {
+      h ^= *p;
+      h *= 16777619u;
+   }
+   return h;
+}
+
+LV2UridBiMap::Table *LV2UridBiMap::createTable(uint32_t slots, uint32_t idCapacity)
+{
+   Table *t = new Table;
+   t->mask = slots - 1;
+   t->slots = new std::atomic<Entry *> [slots];
+   for(uint32_t i = 0; i < slots; ++i)
+      t->slots [i].store(NULL, std::memory_order_relaxed);
+   t->idCapacity = idCapacity;
+   t->uris = new std::atomic<const char *> [idCapacity];
+   for(uint32_t i = 0; i < idCapacity; ++i)
+      t->uris [i].store(NULL, std::memory_order_relaxed);
+   return t;
+}
+
+void LV2UridBiMap::freeTable(Table *t)
+{
+   delete [] t->slots;
+   delete [] t->uris;
+   delete t;
+}
+
+LV2UridBiMap::Entry *LV2UridBiMap::find(const Table *t, const char *uri, uint32_t hash)
+{
+   for(uint32_t i = hash & t->mask; ; i = (i + 1) & t->mask)
+   {
+      Entry *e = t->slots [i].load(std::memory_order_acquire);
+      if(e == NULL)
+         return NULL;
+      if(e->hash == hash && strcmp(e->uri, uri) == 0)
+         return e;
+   }
+}
+
+void LV2UridBiMap::insert(Table *t, Entry *e)
+{
+   uint32_t i = e->hash & t->mask;
+   while(t->slots [i].load(std::memory_order_relaxed) != NULL)
+      i = (i + 1) & t->mask;
+   t->uris [e->id - 1].store(e->uri, std::memory_order_release);
+   t->slots [i].store(e, std::memory_order_release);
 }
 
 LV2_URID LV2UridBiMap::map(const char *uri)
 {
-   std::pair<LV2_SYNTH_URID_MAP::iterator, bool> p;
-   uint32_t id;
+   if(uri == NULL)
+      return 0;
+   const uint32_t hash = hashUri(uri);
+   Entry *e = find(_table.load(std::memory_order_acquire), uri, hash);
+   if(e != NULL)
+      return e->id;
+
    idLock.lock();
-   LV2_SYNTH_URID_MAP::iterator it = _map.find(uri);
-   if(it == _map.end())
-   {
-      const char *mUri = strdup(uri);
-      p = _map.insert ( std::make_pair ( mUri, nextId ) );
-      _rmap.insert ( std::make_pair ( nextId, mUri ) );
-      nextId++;
-      id = p.first->second;
+   Table *t = _table.load(std::memory_order_relaxed);
+   e = find(t, uri, hash);
+   if(e == NULL)
+   {
+      e = new Entry;
+      e->uri = strdup(uri);
+      e->hash = hash;
+      e->id = _entries.size() + 1;
+      _entries.push_back(e);
+      // Keep the hash table at most half full.
+      if(e->id > t->idCapacity)
+      {
+         Table *nt = createTable((t->mask + 1) * 2, t->idCapacity * 2);
+         for(size_t i = 0; i < _entries.size(); ++i)
+            insert(nt, _entries [i]);
+         _oldTables.push_back(t);
+         _table.store(nt, std::memory_order_release);
+      }
+      else
+         insert(t, e);
    }
-   else
-      id = it->second;
+   const LV2_URID id = e->id;
    idLock.unlock();
    return id;
-
 }
 
 const char *LV2UridBiMap::unmap(uint32_t id)
 {
-   LV2_SYNTH_URID_RMAP::iterator it = _rmap.find ( id );
-   if ( it != _rmap.end() ) {
-      return it->second;
-   }
-
-   return NULL;
+   const Table *t = _table.load(std::memory_order_acquire);
+   if(id == 0 || id > t->idCapacity)
+      return NULL;
+   return t->uris [id - 1].load(std::memory_order_acquire);
 }
 
 }
@@ -79,8 +79,9 @@
 #include <set>
 #include <string>
 #include <utility>
+#include <atomic>
+#include <semaphore.h>
 #include <QMutex>
-#include <QSemaphore>
 #include <QThread>
 #include <QTimer>
 #include <QWindow>
@@ -111,6 +112,12 @@ class LV2Synth;
 #define LV2_RT_FIFO_SIZE 128
 #define LV2_RT_FIFO_ITEM_SIZE (std::max(size_t(4096 * 16), size_t(MusEGlobal::segmentSize * 16)))
 #define LV2_EVBUF_SIZE (2*LV2_RT_FIFO_ITEM_SIZE)
+// Size in bytes of each instance's worker request and response rings. Must be a power of two.
+#define LV2_WORKER_RING_SIZE 8192
+// Most worker threads shared by all instances.
+#define LV2_WORKER_POOL_MAX_THREADS 4
+// Most instances which can be waiting for a worker at once. Must be a power of two.
+#define LV2_WORKER_POOL_QUEUE_SIZE 4096
 
 struct LV2MidiEvent
 {
@@ -169,6 +176,33 @@ public:
    bool get(uint32_t *port_index, size_t *szOut, char *data_out);
 };
 
+//---------------------------------------------------------
+//   LV2WorkerRing
+//    Lock-free single reader, single writer ring of variable
+//     size messages, for worker requests and responses.
+//    The data is copied in, as the worker spec requires.
+//---------------------------------------------------------
+
+class LV2WorkerRing
+{
+private:
+   char *_buffer;
+   uint32_t _size;
+   std::atomic<uint32_t> _readIndex;
+   std::atomic<uint32_t> _writeIndex;
+   void copyIn(uint32_t pos, const void *data, uint32_t size);
+   void copyOut(uint32_t pos, void *data, uint32_t size) const;
+public:
+   LV2WorkerRing(uint32_t size);
+   ~LV2WorkerRing();
+   uint32_t size() const { return _size; }
+   bool isEmpty() const { return _readIndex.load() == _writeIndex.load(); }
+   // Returns false if there is no room for the message.
+   bool write(uint32_t size, const void *data);
+   // Copies the next message into data, which must hold size() bytes. Returns false if empty.
+   bool read(uint32_t *size, void *data);
+};
+
 
 
 struct LV2MidiPort
@@ -237,32 +271,52 @@ struct LV2AudioPort
     QString name;
 };
 
-struct cmp_str
-{
-    bool operator() ( char const *a, char const *b ) const
-    {
-        return std::strcmp ( a, b ) < 0;
-    }
-};
-
 typedef std::vector<LV2MidiPort> LV2_MIDI_PORTS;
 typedef std::vector<LV2ControlPort> LV2_CONTROL_PORTS;
 typedef std::vector<LV2AudioPort> LV2_AUDIO_PORTS;
-typedef std::map<const char *, uint32_t, cmp_str> LV2_SYNTH_URID_MAP;
-typedef std::map<uint32_t, const char *> LV2_SYNTH_URID_RMAP;
+
+//---------------------------------------------------------
+//   LV2UridBiMap
+//    Plugins map URIs from run(), so lookups never lock.
+//    The table is only added to under a lock. When it fills
+//     up, a larger copy is published and the old one is kept
+//     until destruction, since readers may still be in it.
+//    The URIs the host and most plugins use are registered
+//     up front, so mapping new ones in run() is rare.
+//---------------------------------------------------------
 
 class LV2UridBiMap
 {
 private:
-    LV2_SYNTH_URID_MAP _map;
-    LV2_SYNTH_URID_RMAP _rmap;
-    uint32_t nextId;
-    QMutex idLock;
+   struct Entry
+   {
+      const char *uri;
+      uint32_t hash;
+      LV2_URID id;
+   };
+   struct Table
+   {
+      // Open addressing hash table of entries, by URI.
+      uint32_t mask;
+      std::atomic<Entry *> *slots;
+      // URIs by id - 1.
+      uint32_t idCapacity;
+      std::atomic<const char *> *uris;
+   };
+   std::atomic<Table *> _table;
+   std::vector<Table *> _oldTables;
+   std::vector<Entry *> _entries;
+   QMutex idLock;
+   static uint32_t hashUri(const char *uri);
+   static Table *createTable(uint32_t slots, uint32_t idCapacity);
+   static void freeTable(Table *t);
+   static Entry *find(const Table *t, const char *uri, uint32_t hash);
+   static void insert(Table *t, Entry *e);
 public:
-    LV2UridBiMap();
-    ~LV2UridBiMap();
-    LV2_URID map ( const char *uri );
-    const char *unmap ( uint32_t id );
+   LV2UridBiMap();
+   ~LV2UridBiMap();
+   LV2_URID map ( const char *uri );
+   const char *unmap ( uint32_t id );
 };
 
 class LV2SynthIF;
@@ -373,7 +427,11 @@ public:
     static const void *lv2state_stateRetreive ( LV2_State_Handle handle, uint32_t key, size_t *size, uint32_t *type, uint32_t *flags );
     static LV2_State_Status lv2state_stateStore ( LV2_State_Handle handle, uint32_t key, const void *value, size_t size, uint32_t type, uint32_t flags );
     static LV2_Worker_Status lv2wrk_scheduleWork(LV2_Worker_Schedule_Handle handle, uint32_t size, const void *data);
-    static LV2_Worker_Status lv2wrk_respond(LV2_Worker_Respond_Handle handle, uint32_t size, const void* data);    
+    static LV2_Worker_Status lv2wrk_respond(LV2_Worker_Respond_Handle handle, uint32_t size, const void* data);
+    // Serves all of the instance's pending requests. Pool thread, or audio thread when freewheeling.
+    static void lv2wrk_process(LV2PluginWrapper_State *state, char *buffer);
+    // Hands the responses to the plugin and ends the run. Audio thread, after run().
+    static void lv2wrk_endRun(LV2PluginWrapper_State *state);    
     static void lv2conf_write(LV2PluginWrapper_State *state, int level, Xml &xml);
     static void lv2conf_set(LV2PluginWrapper_State *state, const std::vector<QString> & customParams);
     static unsigned lv2ui_IsSupported (const char *, const char *ui_type_uri);
@@ -549,10 +607,11 @@ struct LV2PluginWrapper_State {
       iState(NULL),
       tmpValues(NULL),
       numStateValues(0),
-      wrkDataSize(0),
-      wrkDataBuffer(0),
-      wrkThread(NULL),
-      wrkEndWork(false),
+      wrkIface(NULL),
+      wrkRequests(NULL),
+      wrkResponses(NULL),
+      wrkBuffer(NULL),
+      wrkQueued(false),
       controlTimers(NULL),
       deleteLater(false),
       hasGui(false),
@@ -621,11 +680,14 @@ struct LV2PluginWrapper_State {
     QMap<QString, QPair<QString, QVariant> > iStateValues;
     char **tmpValues;
     size_t numStateValues;
-    uint32_t wrkDataSize;
-    const void *wrkDataBuffer;
-    LV2PluginWrapper_Worker *wrkThread;
     LV2_Worker_Interface *wrkIface;
-    bool wrkEndWork;
+    // Requests from run() to the worker pool, and responses back. Only if the plugin has a worker.
+    LV2WorkerRing *wrkRequests;
+    LV2WorkerRing *wrkResponses;
+    // Audio thread scratch for reading the rings.
+    char *wrkBuffer;
+    // Set while the instance is waiting for, or being served by, a pool thread.
+    std::atomic<bool> wrkQueued;
     int *controlTimers;
     bool deleteLater;
     LV2_Atom_Forge atomForge;
@@ -668,24 +730,56 @@ struct LV2PluginWrapper_State {
 };
 
 
+//---------------------------------------------------------
+//   LV2WorkerPool
+//    A few worker threads shared by all LV2 instances.
+//    run() writes the request to the instance's ring and queues
+//     the instance, without locking. A pool thread then serves
+//     all of the instance's requests. An instance is only ever
+//     queued once, so its work() calls never overlap.
+//---------------------------------------------------------
+
+class LV2WorkerPool
+{
+private:
+   struct Cell
+   {
+      std::atomic<size_t> sequence;
+      LV2PluginWrapper_State *state;
+   };
+   // Bounded multi producer, multi consumer queue of instances.
+   Cell *_queue;
+   std::atomic<size_t> _enqueuePos;
+   std::atomic<size_t> _dequeuePos;
+   sem_t _sem;
+   std::vector<LV2PluginWrapper_Worker *> _threads;
+   std::atomic<bool> _closing;
+   bool push(LV2PluginWrapper_State *state);
+public:
+   LV2WorkerPool();
+   ~LV2WorkerPool();
+   // Gui thread.
+   void start();
+   void stop();
+   int threadCount() const { return _threads.size(); }
+   // Queues the instance if it is not queued already. Any thread.
+   bool schedule(LV2PluginWrapper_State *state);
+   // Pool threads.
+   bool pop(LV2PluginWrapper_State **state);
+   void wait();
+   bool isClosing() const { return _closing.load(); }
+};
+
 class LV2PluginWrapper_Worker :public QThread
 {
 private:
-    LV2PluginWrapper_State *_state;
-    QSemaphore _mSem;
-    bool _closing;
+    LV2WorkerPool *_pool;
 public:
-    explicit LV2PluginWrapper_Worker ( LV2PluginWrapper_State *s ) : QThread(),
-       _state ( s ),
-       _mSem(0),
-       _closing(false)
+    explicit LV2PluginWrapper_Worker ( LV2WorkerPool *pool ) : QThread(),
+       _pool ( pool )
     {}
 
     void run();
-    LV2_Worker_Status scheduleWork();
-    void makeWork();
-    void setClosing() {_closing = true; _mSem.release();}
-
 };
 
 
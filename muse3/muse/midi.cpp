@@ -48,6 +48,8 @@
 #include "gconfig.h"
 #include "ticksynth.h"
 #include "mpevent.h"
+#include "midiplayback.h"
+#include "syncout.h"
 
 // REMOVE Tim. Persistent routes. Added. Make this permanent later if it works OK and makes good sense.
 #define _USE_MIDI_ROUTE_PER_CHANNEL_
@@ -1129,22 +1131,12 @@ void Audio::seekMidi()
           }
         }
       }
-      
-      //---------------------------------------------------
-      //    Send STOP and "set song position pointer"
-      //---------------------------------------------------
-        
-      // Don't send if external sync is on. The master, and our sync routing system will take care of that.  
-      if(!MusEGlobal::extSyncFlag.value())
-      {
-        if(mp->syncInfo().MRTOut())
-        {
-          int beat = (pos * 4) / MusEGlobal::config.division;
-          mp->sendSongpos(beat);
-        }    
-      }
     }
   }
+
+  // Song position pointer now, ahead of any start or continue. The MTC full frame
+  //  goes out with the next cycle, sample accurately.
+  MusEGlobal::midiSyncOutput.locate(pos, _pos.frame());
 }
 
 //---------------------------------------------------------
@@ -1286,6 +1278,11 @@ void Audio::collectEvents(MusECore::MidiTrack* track, unsigned int cts, unsigned
 
       DEBUG_MIDI_TIMING(stderr, "Audio::collectEvents: pos_fr:%u next_pos_fr:%u\n", pos_fr, next_pos_fr);
       
+      // Normally just play the track's compiled stream. Walk the parts below only if the
+      //  stream is stale or not compiled yet, or with external sync where ticks drive the timing.
+      if(!extsync && track->playback()->play(track, pos_fr, next_pos_fr, syncFrame))
+        return;
+      
       MidiPort* mp = &MusEGlobal::midiPorts[port];
       MidiDevice* md = mp->device();
 
@@ -2424,6 +2421,12 @@ void Audio::processMidi(unsigned int frames)
         //}
       }
 
+      //---------------------------------------------------
+      //    midi clock and MTC out
+      //---------------------------------------------------
+
+      MusEGlobal::midiSyncOutput.process(playing, _pos.frame(), frames, syncFrame);
+
       //---------------------------------------------------
       //    insert metronome clicks
       //---------------------------------------------------
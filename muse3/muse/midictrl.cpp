@@ -724,6 +724,55 @@ MidiCtrlValList::MidiCtrlValList(int c)
 MidiCtrlValListList::MidiCtrlValListList()
 {
   _RPN_Ctrls_Reserved = false;
+  // Controllers may be added by the audio thread. Avoid rehashing there for typical ports.
+  _ctrlIndex.reserve(64);
+  rebuildIndex();
+}
+
+MidiCtrlValListList::MidiCtrlValListList(const MidiCtrlValListList& cl)
+  : MidiCtrlValListList_t(cl)
+{
+  _RPN_Ctrls_Reserved = cl._RPN_Ctrls_Reserved;
+  rebuildIndex();
+}
+
+//---------------------------------------------------------
+//   addIndex
+//---------------------------------------------------------
+
+void MidiCtrlValListList::addIndex(iterator i)
+{
+  const int idx = i->first;
+  if(isCtrl7Index(idx))
+    _ctrl7Index[idx >> 24][idx & 0x7f] = i;
+  else
+    _ctrlIndex[idx] = i;
+}
+
+//---------------------------------------------------------
+//   removeIndex
+//---------------------------------------------------------
+
+void MidiCtrlValListList::removeIndex(int idx)
+{
+  if(isCtrl7Index(idx))
+    _ctrl7Index[idx >> 24][idx & 0x7f] = end();
+  else
+    _ctrlIndex.erase(idx);
+}
+
+//---------------------------------------------------------
+//   rebuildIndex
+//---------------------------------------------------------
+
+void MidiCtrlValListList::rebuildIndex()
+{
+  for(int ch = 0; ch < MUSE_MIDI_CHANNELS; ++ch)
+    for(int ctl = 0; ctl < 128; ++ctl)
+      _ctrl7Index[ch][ctl] = end();
+  _ctrlIndex.clear();
+  for(iterator i = begin(); i != end(); ++i)
+    addIndex(i);
 }
 
 // TODO: Finish copy constructor, but first MidiCtrlValList might need one too ?
@@ -975,18 +1024,20 @@ MidiCtrlValListList& MidiCtrlValListList::operator=(const MidiCtrlValListList& c
   
   // Let map copy the items.
   std::map<int, MidiCtrlValList*, std::less<int> >::operator=(cl);
+  rebuildIndex();
   return *this;
 }
 
-//=========================================================
-#ifdef _MIDI_CTRL_METHODS_DEBUG_      
-
 void MidiCtrlValListList::swap(MidiCtrlValListList& cl)
 {
 #ifdef _MIDI_CTRL_DEBUG_
   printf("MidiCtrlValListList::swap\n");  
 #endif
   std::map<int, MidiCtrlValList*, std::less<int> >::swap(cl);
+  std::swap(_RPN_Ctrls_Reserved, cl._RPN_Ctrls_Reserved);
+  // The end iterators stay with their lists, so both indexes must be rebuilt.
+  rebuildIndex();
+  cl.rebuildIndex();
 }
 
 std::pair<iMidiCtrlValList, bool> MidiCtrlValListList::insert(const std::pair<int, MidiCtrlValList*>& p)
@@ -995,6 +1046,8 @@ std::pair<iMidiCtrlValList, bool> MidiCtrlValListList::insert(const std::pair<in
   printf("MidiCtrlValListList::insert num:%d\n", p.second->num());  
 #endif
   std::pair<iMidiCtrlValList, bool> res = std::map<int, MidiCtrlValList*, std::less<int> >::insert(p);
+  if(res.second)
+    addIndex(res.first);
   return res;
 }
 
@@ -1004,6 +1057,7 @@ iMidiCtrlValList MidiCtrlValListList::insert(iMidiCtrlValList ic, const std::pai
   printf("MidiCtrlValListList::insertAt num:%d\n", p.second->num()); 
 #endif
   iMidiCtrlValList res = std::map<int, MidiCtrlValList*, std::less<int> >::insert(ic, p);
+  addIndex(res);
   return res;
 }
 
@@ -1012,6 +1066,7 @@ void MidiCtrlValListList::erase(iMidiCtrlValList ictl)
 #ifdef _MIDI_CTRL_DEBUG_
   printf("MidiCtrlValListList::erase iMidiCtrlValList num:%d\n", ictl->second->num());  
 #endif
+  removeIndex(ictl->first);
   std::map<int, MidiCtrlValList*, std::less<int> >::erase(ictl);
 }
 
@@ -1021,6 +1076,8 @@ MidiCtrlValListList::size_type MidiCtrlValListList::erase(int num)
   printf("MidiCtrlValListList::erase num:%d\n", num);  
 #endif
   size_type res = std::map<int, MidiCtrlValList*, std::less<int> >::erase(num);
+  if(res)
+    removeIndex(num);
   return res;
 }
 
@@ -1030,6 +1087,8 @@ void MidiCtrlValListList::erase(iMidiCtrlValList first, iMidiCtrlValList last)
   printf("MidiCtrlValListList::erase range first num:%d second num:%d\n", 
          first->second->num(), last->second->num());  
 #endif
+  for(iMidiCtrlValList i = first; i != last; ++i)
+    removeIndex(i->first);
   std::map<int, MidiCtrlValList*, std::less<int> >::erase(first, last);
 }
 
@@ -1039,11 +1098,9 @@ void MidiCtrlValListList::clear()
   printf("MidiCtrlValListList::clear\n");  
 #endif
   std::map<int, MidiCtrlValList*, std::less<int> >::clear();
+  rebuildIndex();
 }
 
-#endif
-// =========================================================
-
 
 bool MidiCtrlValList::resetHwVal(bool doLastHwValue)
 {
@@ -27,9 +27,11 @@
 
 #include <list>
 #include <map>
+#include <unordered_map>
 
 #include <QString>
 
+#include "globaldefs.h"
 #include "midictrl_consts.h"
 
 //#define _MIDI_CTRL_DEBUG_
@@ -238,6 +240,10 @@ typedef std::pair <iMidiCtrlVal, iMidiCtrlVal> MidiCtrlValRange;
 //    This list represents the controller state of a
 //    midi port.
 //          index = (channelNumber << 24) + ctrlNumber
+//    find() does not search the map. The 128 plain
+//     controllers of each channel are looked up in a direct
+//     indexed table, and all others such as (N)RPNs, 14 bit
+//     controllers, pitch and program in a hash.
 //---------------------------------------------------------
 
 typedef std::map<int, MidiCtrlValList*, std::less<int> > MidiCtrlValListList_t;
@@ -246,16 +252,33 @@ typedef MidiCtrlValListList_t::const_iterator ciMidiCtrlValList;
 
 class MidiCtrlValListList : public MidiCtrlValListList_t {
       bool _RPN_Ctrls_Reserved; 
+
+      // Iterators of the plain controllers, or end(). Indexed by channel and controller number.
+      iterator _ctrl7Index[MUSE_MIDI_CHANNELS][128];
+      // Iterators of all other controllers, by index.
+      std::unordered_map<int, iterator> _ctrlIndex;
+
+      static bool isCtrl7Index(int idx) { return (unsigned)idx < ((unsigned)MUSE_MIDI_CHANNELS << 24) && (idx & 0xffffff) < 128; }
+      iterator findIndex(int idx) const {
+            if(isCtrl7Index(idx))
+                  return _ctrl7Index[idx >> 24][idx & 0x7f];
+            std::unordered_map<int, iterator>::const_iterator i = _ctrlIndex.find(idx);
+            return i == _ctrlIndex.end() ? ((MidiCtrlValListList*)this)->end() : i->second;
+            }
+      void addIndex(iterator i);
+      void removeIndex(int idx);
+      void rebuildIndex();
       
    public:
       MidiCtrlValListList();
-      //MidiCtrlValListList(const MidiCtrlValListList&); // TODO
+      // Shallow, like operator=. The value lists are shared.
+      MidiCtrlValListList(const MidiCtrlValListList&);
       
       iterator find(int channel, int ctrl) {
-            return std::map<int, MidiCtrlValList*, std::less<int> >::find((channel << 24) + ctrl);
+            return findIndex((channel << 24) + ctrl);
             }
       const_iterator find(int channel, int ctrl) const {
-            return ((const MidiCtrlValListList_t*)this)->find((channel << 24) + ctrl);
+            return findIndex((channel << 24) + ctrl);
             }
       void clearDelete(bool deleteLists);      
       // Like 'find', finds a controller given fully qualified type + number. 
@@ -286,8 +309,7 @@ class MidiCtrlValListList : public MidiCtrlValListList_t {
       // Returns true if either value was changed in any controller.
       bool resetAllHwVals(bool doLastHwValue);
       
-#ifdef _MIDI_CTRL_METHODS_DEBUG_      
-      // Need to catch all insert, erase, clear etc...
+      // Need to catch all insert, erase, clear etc, to keep the lookup index up to date.
       void swap(MidiCtrlValListList&);
       std::pair<iMidiCtrlValList, bool> insert(const std::pair<int, MidiCtrlValList*>& p);
       iMidiCtrlValList insert(iMidiCtrlValList ic, const std::pair<int, MidiCtrlValList*>& p);
@@ -295,7 +317,6 @@ class MidiCtrlValListList : public MidiCtrlValListList_t {
       size_type erase(int num);
       void erase(iMidiCtrlValList first, iMidiCtrlValList last);
       void clear();
-#endif       
       // Some IDEs won't "Find uses" of operators. So, no choice but to trust always catching it here.
       MidiCtrlValListList& operator=(const MidiCtrlValListList&);
       };
@@ -251,8 +251,8 @@ void MidiDevice::afterProcess()
 {
   for(unsigned int i = 0; i < MusECore::MUSE_MIDI_CHANNELS + 1; ++i)
   {
-    while (_tmpRecordCount[i]--)
-      _recordFifo[i].remove();
+    _recordFifo[i].remove(_tmpRecordCount[i]);
+    _tmpRecordCount[i] = 0;
   } 
 }
 
@@ -270,6 +270,55 @@ void MidiDevice::beforeProcess()
   _sysexFIFOProcessed = false;
 }
 
+//---------------------------------------------------------
+//   setRecordFifoCapacity
+//---------------------------------------------------------
+
+void MidiDevice::setRecordFifoCapacity(unsigned capacity)
+{
+  for(unsigned int i = 0; i < MusECore::MUSE_MIDI_CHANNELS + 1; ++i)
+  {
+    _recordFifo[i].setCapacity(capacity);
+    _tmpRecordCount[i] = 0;
+  }
+}
+
+//---------------------------------------------------------
+//   reserveRecordFifos
+//---------------------------------------------------------
+
+void MidiDevice::reserveRecordFifos()
+{
+  if(deviceType() == SYNTH_MIDI || !(_rwFlags & 2) || !(_openFlags & 2))
+    return;
+  // Only ever grown, so a device reopened for input keeps what it has.
+  if(_recordFifo[0].capacity() >= MIDI_REC_FIFO_DEVICE_SIZE)
+    return;
+  setRecordFifoCapacity(MIDI_REC_FIFO_DEVICE_SIZE);
+}
+
+//---------------------------------------------------------
+//   recordOverflows
+//---------------------------------------------------------
+
+unsigned MidiDevice::recordOverflows() const
+{
+  unsigned n = 0;
+  for(unsigned int i = 0; i < MusECore::MUSE_MIDI_CHANNELS + 1; ++i)
+    n += _recordFifo[i].overflows();
+  return n;
+}
+
+//---------------------------------------------------------
+//   resetRecordOverflows
+//---------------------------------------------------------
+
+void MidiDevice::resetRecordOverflows()
+{
+  for(unsigned int i = 0; i < MusECore::MUSE_MIDI_CHANNELS + 1; ++i)
+    _recordFifo[i].resetOverflows();
+}
+
 //---------------------------------------------------------
 //   midiClockInput
 //    Midi clock (24 ticks / quarter note)
@@ -369,9 +418,9 @@ void MidiDevice::recordEvent(MidiRecordEvent& event)
         return;
       
       // Split the events up into channel fifos. Special 'channel' number 17 for sysex events.
+      // An overflow is counted by the fifo and reported when recording stops.
       unsigned int ch = (typ == ME_SYSEX)? MusECore::MUSE_MIDI_CHANNELS : event.channel();
-      if(_recordFifo[ch].put(event))
-        fprintf(stderr, "MidiDevice::recordEvent: fifo channel %d overflow\n", ch);
+      _recordFifo[ch].put(event);
       }
 
 //---------------------------------------------------------
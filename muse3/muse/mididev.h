@@ -157,6 +157,7 @@ class MidiDevice {
       LockFreeMPSCRingBuffer<MidiPlayEvent> *_userEventBuffers;
       
       // Recording fifos. To speed up processing, one per channel plus one special system 'channel' for channel-less events like sysex.
+      // Events which do not fit are counted, see recordOverflows().
       MidiRecFifo _recordFifo[MusECore::MUSE_MIDI_CHANNELS + 1];   
 
       // To hold current output program, and RPN/NRPN parameter numbers and values.
@@ -282,11 +283,23 @@ class MidiDevice {
       //  require the frame since they 'compose' a buffer based on the 
       //  frame at cycle start.
       virtual void processMidi(unsigned int /*curFrame*/ = 0) {}
+      // Frame of the earliest event still waiting to be played by processMidi().
+      // Returns false if nothing is waiting. Lets the ALSA sequencer thread
+      //  schedule its next wakeup.
+      virtual bool nextProcessFrame(unsigned int* /*frame*/) { return false; }
 
       void beforeProcess();
       void afterProcess();
       int tmpRecordCount(const unsigned int ch)     { return _tmpRecordCount[ch]; }
       MidiRecFifo& recordEvents(const unsigned int ch) { return _recordFifo[ch]; }
+      // Not realtime safe. Sets the size of each recording fifo. Only while the device is not being read.
+      void setRecordFifoCapacity(unsigned capacity);
+      // Not realtime safe. Gives an ALSA or Jack device which is about to be opened for input
+      //  the large recording fifos. Others keep the small default. Only while the device is not being read.
+      void reserveRecordFifos();
+      // Total number of recorded events dropped because the fifos were full.
+      unsigned recordOverflows() const;
+      void resetRecordOverflows();
       bool sysexFIFOProcessed()                     { return _sysexFIFOProcessed; }
       void setSysexFIFOProcessed(bool v)            { _sysexFIFOProcessed = v; }
       
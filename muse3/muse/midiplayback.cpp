@@ -0,0 +1,468 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  midiplayback.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <algorithm>
+
+#include "midiplayback.h"
+#include "song.h"
+#include "track.h"
+#include "part.h"
+#include "event.h"
+#include "tempo.h"
+#include "midi.h"
+#include "midiport.h"
+#include "mididev.h"
+#include "midictrl.h"
+#include "drummap.h"
+#include "globaldefs.h"
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   MidiPlaybackParams
+//---------------------------------------------------------
+
+void MidiPlaybackParams::set(const MidiTrack* track)
+{
+  type          = track->type();
+  outPort       = track->outPort();
+  outChannel    = track->outChannel();
+  transposition = track->transposition;
+  velocity      = track->velocity;
+  delay         = track->delay;
+  len           = track->len;
+  compression   = track->compression;
+  pitchShift    = MusEGlobal::song->globalPitchShift();
+}
+
+bool MidiPlaybackParams::operator==(const MidiPlaybackParams& other) const
+{
+  return type == other.type &&
+         outPort == other.outPort &&
+         outChannel == other.outChannel &&
+         transposition == other.transposition &&
+         velocity == other.velocity &&
+         delay == other.delay &&
+         len == other.len &&
+         compression == other.compression &&
+         pitchShift == other.pitchShift;
+}
+
+//---------------------------------------------------------
+//   TickLess
+//---------------------------------------------------------
+
+struct MidiPlaybackTickLess
+{
+  bool operator()(const MidiPlaybackItem& a, const MidiPlaybackItem& b) const { return a.tick < b.tick; }
+};
+
+//---------------------------------------------------------
+//   compile
+//    Resolves the events exactly as Audio::collectEvents does.
+//---------------------------------------------------------
+
+void MidiPlaybackStream::compile(MidiTrack* track)
+{
+  _items.clear();
+
+  const int defaultPort = _params.outPort;
+  const int defaultChannel = _params.outChannel;
+  if(defaultPort < 0 || defaultPort >= MusECore::MIDI_PORTS)
+    return;
+  MidiPort* mp = &MusEGlobal::midiPorts[defaultPort];
+
+  DrumMap* dm = 0;
+  if(_params.type == Track::DRUM)
+    dm = MusEGlobal::drumMap;
+  else if(_params.type == Track::NEW_DRUM)
+    dm = track->drummap();
+
+  MidiPlaybackItem item;
+  const PartList* pl = track->cparts();
+  for(ciPart ip = pl->begin(); ip != pl->end(); ++ip)
+  {
+    const Part* part = ip->second;
+    // don't play muted parts
+    if(part->mute())
+      continue;
+    const unsigned offset = _params.delay + part->tick();
+    const unsigned partLen = part->lenTick();
+    const EventList& el = part->events();
+    for(ciEvent ie = el.begin(); ie != el.end(); ++ie)
+    {
+      const Event& ev = ie->second;
+      // Do not play events which are past the end of this part.
+      if(ev.tick() > partLen)
+        break;
+      //  don't play any meta events
+      if(ev.type() == Meta)
+        continue;
+      // ignore muted drums
+      if(dm && ev.isNote() && dm[ev.pitch()].mute)
+        continue;
+
+      item.tick = ev.tick() + offset;
+      item.frame = 0;
+      item.offTick = 0;
+      item.veloOff = 0;
+      item.flags = 0;
+
+      switch(ev.type())
+      {
+        case Note:
+        {
+          int port = defaultPort;
+          int channel = defaultChannel;
+          int len   = ev.lenTick();
+          int pitch = ev.pitch();
+          int velo  = ev.velo();
+          int veloOff = ev.veloOff();
+          if(dm)
+          {
+            // Map drum-notes to the drum-map values
+            const DrumMap& dme = dm[ev.pitch()];
+            pitch = dme.anote;
+            // Default to track port if -1 and track channel if -1.
+            if(dme.port != -1)
+              port = dme.port;
+            if(dme.channel != -1)
+              channel = dme.channel;
+            velo    = int(double(velo) * (double(dme.vol) / 100.0));
+            veloOff = int(double(veloOff) * (double(dme.vol) / 100.0));
+          }
+          else if(_params.type == Track::MIDI)
+            // transpose non drum notes
+            pitch += (_params.transposition + _params.pitchShift);
+
+          if(pitch > 127)
+            pitch = 127;
+          if(pitch < 0)
+            pitch = 0;
+
+          // Apply track velocity and compression to both note-on and note-off velocity...
+          velo += _params.velocity;
+          velo = (velo * _params.compression) / 100;
+          if(velo > 127)
+            velo = 127;
+          if(velo < 1)           // no off event
+            continue;
+          veloOff += _params.velocity;
+          veloOff = (veloOff * _params.compression) / 100;
+          if(veloOff > 127)
+            veloOff = 127;
+          if(veloOff < 1)
+            veloOff = 0;
+
+          len = (len * _params.len) / 100;
+          if(len <= 0)     // don't allow zero length
+            len = 1;
+
+          if(port < 0 || port >= MusECore::MIDI_PORTS)
+            continue;
+          item.event = MidiPlayEvent(0, port, channel, ME_NOTEON, pitch, velo);
+          item.offTick = item.tick + len;
+          item.veloOff = veloOff;
+          item.flags = MidiPlaybackItem::NoteOn;
+        }
+        break;
+
+        case Controller:
+        {
+          item.flags = MidiPlaybackItem::SetHwCtrlState;
+          // Is it a drum controller event, according to the track port's instrument?
+          if(dm && mp->drumController(ev.dataA()))
+          {
+            int ctl = ev.dataA();
+            const DrumMap& dme = dm[ctl & 0x7f];
+            ctl &= ~0xff;
+            const int pitch = dme.anote & 0x7f;
+            // Default to track port if -1 and track channel if -1.
+            const int port = (dme.port == -1) ? defaultPort : dme.port;
+            const int channel = (dme.channel == -1) ? defaultChannel : dme.channel;
+            if(port < 0 || port >= MusECore::MIDI_PORTS)
+              continue;
+            item.event = MidiPlayEvent(0, port, channel, ME_CONTROLLER, ctl | pitch, ev.dataB());
+          }
+          else
+            item.event = ev.asMidiPlayEvent(0, defaultPort, defaultChannel);
+        }
+        break;
+
+        case Sysex:
+          item.event = ev.asMidiPlayEvent(0, defaultPort, defaultChannel);
+          // Keep a private copy of the data. The audio thread shares it with the
+          //  events it queues, so the stream is only deleted once they let go of it.
+          item.event.setData(ev.data(), ev.dataLen());
+        break;
+
+        default:
+          item.event = ev.asMidiPlayEvent(0, defaultPort, defaultChannel);
+        break;
+      }
+
+      _items.push_back(item);
+    }
+  }
+
+  // Parts are walked one after the other. Keep their order for events on the same tick.
+  std::stable_sort(_items.begin(), _items.end(), MidiPlaybackTickLess());
+}
+
+//---------------------------------------------------------
+//   retime
+//---------------------------------------------------------
+
+void MidiPlaybackStream::retime()
+{
+  _tempoSN = MusEGlobal::tempomap.tempoSN();
+  for(std::vector<MidiPlaybackItem>::iterator i = _items.begin(); i != _items.end(); ++i)
+    i->frame = MusEGlobal::tempomap.tick2frame(i->tick);
+}
+
+//---------------------------------------------------------
+//   build
+//---------------------------------------------------------
+
+MidiPlaybackStream* MidiPlaybackStream::build(MidiTrack* track, unsigned serial)
+{
+  MidiPlaybackStream* s = new MidiPlaybackStream();
+  s->_serial = serial;
+  s->_params.set(track);
+  s->compile(track);
+  s->retime();
+  return s;
+}
+
+//---------------------------------------------------------
+//   retimed
+//---------------------------------------------------------
+
+MidiPlaybackStream* MidiPlaybackStream::retimed() const
+{
+  MidiPlaybackStream* s = new MidiPlaybackStream(*this);
+  // Each stream owns its sysex data, see dataInUse().
+  for(size_t i = 0; i < _items.size(); ++i)
+    if(_items[i].event.type() == ME_SYSEX)
+      s->_items[i].event.setData(_items[i].event.data(), _items[i].event.len());
+  s->retime();
+  return s;
+}
+
+//---------------------------------------------------------
+//   isCurrent
+//---------------------------------------------------------
+
+bool MidiPlaybackStream::isCurrent(const MidiTrack* track, unsigned serial) const
+{
+  if(_serial != serial || _tempoSN != MusEGlobal::tempomap.tempoSN())
+    return false;
+  MidiPlaybackParams p;
+  p.set(track);
+  return p == _params;
+}
+
+//---------------------------------------------------------
+//   lowerBound
+//---------------------------------------------------------
+
+size_t MidiPlaybackStream::lowerBound(unsigned frame) const
+{
+  size_t lo = 0;
+  size_t hi = _items.size();
+  while(lo < hi)
+  {
+    const size_t mid = lo + (hi - lo) / 2;
+    if(_items[mid].frame < frame)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+//---------------------------------------------------------
+//   dataInUse
+//---------------------------------------------------------
+
+bool MidiPlaybackStream::dataInUse() const
+{
+  for(std::vector<MidiPlaybackItem>::const_iterator i = _items.begin(); i != _items.end(); ++i)
+    if(i->event.type() == ME_SYSEX && i->event.eventData().useCount() > 1)
+      return true;
+  return false;
+}
+
+//---------------------------------------------------------
+//   MidiPlayback
+//---------------------------------------------------------
+
+MidiPlayback::MidiPlayback()
+  : _serial(0), _pending(0), _retired(0), _stream(0), _cursorStream(0), _cursor(0), _cursorFrame(0), _published(0)
+{
+}
+
+MidiPlayback::~MidiPlayback()
+{
+  // The track is no longer in the song, the audio thread has let go of everything.
+  // Any sysex still queued keeps its own reference to the data.
+  delete _pending.exchange(0);
+  delete _retired.exchange(0);
+  delete _stream;
+  for(std::list<MidiPlaybackStream*>::iterator i = _retiring.begin(); i != _retiring.end(); ++i)
+    delete *i;
+}
+
+//---------------------------------------------------------
+//   play
+//    Called from audio thread only.
+//---------------------------------------------------------
+
+bool MidiPlayback::play(MidiTrack* track, unsigned pos_fr, unsigned next_pos_fr, unsigned syncFrame)
+{
+  // Take a new stream from the gui, if the gui has collected the previous one.
+  if(_retired.load(std::memory_order_acquire) == 0)
+  {
+    MidiPlaybackStream* s = _pending.exchange(0, std::memory_order_acq_rel);
+    if(s)
+    {
+      _retired.store(_stream, std::memory_order_release);
+      _stream = s;
+    }
+  }
+
+  const MidiPlaybackStream* s = _stream;
+  if(!s || !s->isCurrent(track, _serial.load(std::memory_order_acquire)))
+    return false;
+
+  // Carry on from the last cycle if the transport moved on normally, otherwise search.
+  size_t i = (s == _cursorStream && pos_fr == _cursorFrame) ? _cursor : s->lowerBound(pos_fr);
+  const size_t sz = s->size();
+  for( ; i < sz; ++i)
+  {
+    const MidiPlaybackItem& it = s->item(i);
+    if(it.frame >= next_pos_fr)
+      break;
+    const unsigned frame = it.frame - pos_fr + syncFrame;
+    const MidiPlayEvent& src = it.event;
+    const int port = src.port();
+    MidiPort* mp = &MusEGlobal::midiPorts[port];
+    MidiDevice* md = mp->device();
+
+    if(it.flags & MidiPlaybackItem::NoteOn)
+    {
+      if(md)
+      {
+        md->putEvent(MidiPlayEvent(frame, port, src.channel(), ME_NOTEON, src.dataA(), src.dataB()),
+                     MidiDevice::NotLate, MidiDevice::PlaybackBuffer);
+        track->addStuckNote(MidiPlayEvent(it.offTick, port, src.channel(), ME_NOTEOFF, src.dataA(), it.veloOff));
+      }
+      if(src.dataB() > track->activity())
+        track->setActivity(src.dataB());
+      continue;
+    }
+
+    MidiPlayEvent ev;
+    if(src.type() == ME_SYSEX)
+      // Share the stream's data, nothing is allocated here. The reference count
+      //  is atomic, and the gui keeps a retired stream until the data is let go.
+      ev = MidiPlayEvent(frame, port, ME_SYSEX, src.eventData());
+    else
+    {
+      ev = MidiPlayEvent(frame, port, src.channel(), src.type(), src.dataA(), src.dataB());
+      // This is the audio thread. Just set directly.
+      if(it.flags & MidiPlaybackItem::SetHwCtrlState)
+        mp->setHwCtrlState(ev);
+    }
+    if(md)
+      md->putEvent(ev, MidiDevice::NotLate, MidiDevice::PlaybackBuffer);
+  }
+
+  _cursorStream = s;
+  _cursor = i;
+  _cursorFrame = next_pos_fr;
+  return true;
+}
+
+//---------------------------------------------------------
+//   update
+//    Called from gui thread only.
+//---------------------------------------------------------
+
+void MidiPlayback::update(MidiTrack* track)
+{
+  MidiPlaybackStream* r = _retired.exchange(0, std::memory_order_acq_rel);
+  if(r)
+    _retiring.push_back(r);
+  // Queued sysex events may still share a retired stream's data.
+  for(std::list<MidiPlaybackStream*>::iterator i = _retiring.begin(); i != _retiring.end(); )
+  {
+    if((*i)->dataInUse())
+      ++i;
+    else
+    {
+      delete *i;
+      i = _retiring.erase(i);
+    }
+  }
+
+  const unsigned serial = _serial.load(std::memory_order_acquire);
+  if(_published && _published->isCurrent(track, serial))
+    return;
+
+  MidiPlaybackParams p;
+  p.set(track);
+  MidiPlaybackStream* s;
+  // Only the tempo changed. Keep the resolved events and just recompute their frames.
+  if(_published && _published->serial() == serial && _published->params() == p)
+    s = _published->retimed();
+  else
+    s = MidiPlaybackStream::build(track, serial);
+
+  // If the audio thread has not taken the previous one yet, it never will.
+  delete _pending.exchange(s, std::memory_order_acq_rel);
+  _published = s;
+}
+
+//---------------------------------------------------------
+//   updateMidiPlayback
+//---------------------------------------------------------
+
+void updateMidiPlayback()
+{
+  MidiTrackList* mtl = MusEGlobal::song->midis();
+  for(iMidiTrack it = mtl->begin(); it != mtl->end(); ++it)
+    (*it)->playback()->update(*it);
+}
+
+//---------------------------------------------------------
+//   invalidateMidiPlayback
+//---------------------------------------------------------
+
+void invalidateMidiPlayback()
+{
+  MidiTrackList* mtl = MusEGlobal::song->midis();
+  for(iMidiTrack it = mtl->begin(); it != mtl->end(); ++it)
+    (*it)->playback()->invalidate();
+}
+
+} // namespace MusECore
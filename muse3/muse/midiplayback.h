@@ -0,0 +1,169 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  midiplayback.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __MIDIPLAYBACK_H__
+#define __MIDIPLAYBACK_H__
+
+#include <vector>
+#include <list>
+#include <atomic>
+#include <stddef.h>
+
+#include "mpevent.h"
+
+namespace MusECore {
+
+class MidiTrack;
+
+//---------------------------------------------------------
+//   MidiPlaybackItem
+//    One fully resolved playback event. Drum map, transpose,
+//     velocity, compression and length are already applied.
+//---------------------------------------------------------
+
+struct MidiPlaybackItem
+{
+      enum Flags { NoteOn = 0x1, SetHwCtrlState = 0x2 };
+
+      // Absolute tick, including the part position and the track delay.
+      unsigned tick;
+      unsigned frame;
+      // Final port, channel, type and data. The time is set when played.
+      MidiPlayEvent event;
+      // Notes only: the note-off tick and velocity.
+      unsigned offTick;
+      int veloOff;
+      int flags;
+};
+
+//---------------------------------------------------------
+//   MidiPlaybackParams
+//    The track settings a stream was compiled with.
+//---------------------------------------------------------
+
+struct MidiPlaybackParams
+{
+      int type;
+      int outPort;
+      int outChannel;
+      int transposition;
+      int velocity;
+      int delay;
+      int len;
+      int compression;
+      int pitchShift;
+
+      void set(const MidiTrack* track);
+      bool operator==(const MidiPlaybackParams& other) const;
+};
+
+//---------------------------------------------------------
+//   MidiPlaybackStream
+//    A midi track's events compiled into a flat array sorted
+//     by tick. Never changed once published to the audio thread.
+//---------------------------------------------------------
+
+class MidiPlaybackStream
+{
+      std::vector<MidiPlaybackItem> _items;
+      // Track serial and tempo map serial the stream is valid for.
+      unsigned _serial;
+      int _tempoSN;
+      MidiPlaybackParams _params;
+
+      void compile(MidiTrack* track);
+      void retime();
+
+   public:
+      // Compiles the track. Gui thread only.
+      static MidiPlaybackStream* build(MidiTrack* track, unsigned serial);
+      // Copy of the stream with the frames recomputed for the current tempo map. Gui thread only.
+      MidiPlaybackStream* retimed() const;
+
+      unsigned serial() const { return _serial; }
+      int tempoSN() const { return _tempoSN; }
+      const MidiPlaybackParams& params() const { return _params; }
+      // Whether the stream still matches the track, the track settings and the tempo map.
+      bool isCurrent(const MidiTrack* track, unsigned serial) const;
+
+      size_t size() const { return _items.size(); }
+      const MidiPlaybackItem& item(size_t idx) const { return _items[idx]; }
+      // Index of the first item at or after the given frame.
+      size_t lowerBound(unsigned frame) const;
+      // Whether events queued by the audio thread still share the stream's sysex data.
+      bool dataInUse() const;
+};
+
+//---------------------------------------------------------
+//   MidiPlayback
+//    Per track playback state.
+//    The gui compiles the stream and hands it over through
+//     the pending slot. The audio thread takes it at the start
+//     of its next cycle and gives the old one back through the
+//     retired slot, for the gui to delete once no queued event
+//     shares its sysex data any more.
+//    Anything which changes the track's events marks it stale
+//     with invalidate(). Until the gui has recompiled it, the
+//     audio thread falls back to walking the parts.
+//---------------------------------------------------------
+
+class MidiPlayback
+{
+      std::atomic<unsigned> _serial;
+      std::atomic<MidiPlaybackStream*> _pending;
+      std::atomic<MidiPlaybackStream*> _retired;
+
+      // Audio thread only.
+      MidiPlaybackStream* _stream;
+      const MidiPlaybackStream* _cursorStream;
+      size_t _cursor;
+      unsigned _cursorFrame;
+
+      // Gui thread only. The most recently published stream.
+      MidiPlaybackStream* _published;
+      // Gui thread only. Retired streams whose sysex data is still queued.
+      std::list<MidiPlaybackStream*> _retiring;
+
+   public:
+      MidiPlayback();
+      ~MidiPlayback();
+
+      // Can be called by the gui or audio thread.
+      void invalidate() { _serial.fetch_add(1, std::memory_order_acq_rel); }
+
+      // Audio thread. Plays the events between the two frames from the compiled stream.
+      // Returns false, without doing anything, if there is no current stream.
+      bool play(MidiTrack* track, unsigned pos_fr, unsigned next_pos_fr, unsigned syncFrame);
+
+      // Gui thread. Recompiles or retimes the stream if it is stale, and deletes retired streams.
+      void update(MidiTrack* track);
+};
+
+// Gui thread. Updates all midi tracks. Called once per heartbeat.
+extern void updateMidiPlayback();
+// Marks all midi tracks stale, for changes which affect every track
+//  such as the drum map or the port instruments.
+extern void invalidateMidiPlayback();
+
+} // namespace MusECore
+
+#endif
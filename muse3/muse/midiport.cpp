@@ -448,6 +448,8 @@ bool MidiPort::sendInitialControllers(unsigned start_time)
 //---------------------------------------------------------
 //   changeInstrument
 //   If audio is running (and not idle) this should only be called by the rt audio thread.
+//   The instrument must already be loaded, see MidiInstrument::load().
+//   Callers load it before idling the audio, so no file is read here.
 //---------------------------------------------------------
 
 void MidiPort::changeInstrument(MidiInstrument* i)
@@ -43,6 +43,7 @@
 #include "driver/qttimer.h"
 #else
 #include "driver/alsatimer.h"
+#include "driver/posixtimer.h"
 #include "driver/rtctimer.h"
 #endif
 #include "midi.h"
@@ -66,6 +67,56 @@ namespace MusECore {
 
 int MidiSeq::ticker = 0;
 
+const unsigned int MidiTimingHistogram::_binLimits[MidiTimingHistogram::NumBins - 1] =
+  { 50, 100, 200, 500, 1000, 2000, 5000, 10000 };
+
+//---------------------------------------------------------
+//   MidiTimingHistogram
+//---------------------------------------------------------
+
+void MidiTimingHistogram::clear()
+{
+  for(int i = 0; i < NumBins; ++i)
+    _bins[i] = 0;
+  _count = 0;
+  _sumFrames = 0;
+  _maxFrames = 0;
+}
+
+void MidiTimingHistogram::add(unsigned int lateFrames)
+{
+  const uint64_t us = muse_multiply_64_div_64_to_64(lateFrames, 1000000UL, MusEGlobal::sampleRate);
+  int bin = 0;
+  while(bin < NumBins - 1 && us >= _binLimits[bin])
+    ++bin;
+  ++_bins[bin];
+  ++_count;
+  _sumFrames += lateFrames;
+  if(lateFrames > _maxFrames)
+    _maxFrames = lateFrames;
+}
+
+void MidiTimingHistogram::dump(FILE* fp) const
+{
+  if(_count == 0 || MusEGlobal::sampleRate == 0)
+    return;
+  const double usPerFrame = 1000000.0 / (double)MusEGlobal::sampleRate;
+  fprintf(fp, "ALSA midi output timing: events:%u mean:%.1fus max:%.1fus\n",
+          _count, usPerFrame * (double)_sumFrames / (double)_count, usPerFrame * (double)_maxFrames);
+  for(int i = 0; i < NumBins; ++i)
+  {
+    if(i < NumBins - 1)
+      fprintf(fp, "  < %5uus", _binLimits[i]);
+    else
+      fprintf(fp, "  >=%5uus", _binLimits[NumBins - 2]);
+    const int bar = (int)((uint64_t)_bins[i] * 50 / _count);
+    fprintf(fp, " %10u %5.1f%% ", _bins[i], 100.0 * (double)_bins[i] / (double)_count);
+    for(int b = 0; b < bar; ++b)
+      fputc('#', fp);
+    fputc('\n', fp);
+  }
+}
+
 void initMidiSequencer()   
 {
   if(!MusEGlobal::midiSeq)
@@ -135,6 +186,12 @@ void MidiSeq::processMsg(const ThreadMsg* m)
 
 void MidiSeq::processStop()
 {
+  if(MusEGlobal::config.midiTimingReport && _timingHistogram.count() != 0)
+  {
+    _timingHistogram.dump(stderr);
+    _timingHistogram.clear();
+  }
+
   // Clear Alsa midi device notes and stop stuck notes.
   for(iMidiDevice id = MusEGlobal::midiDevices.begin(); id != MusEGlobal::midiDevices.end(); ++id)
   {
@@ -219,6 +276,19 @@ signed int MidiSeq::selectTimer()
     {
     int tmrFd;
 
+#ifndef _WIN32
+    if (MusEGlobal::config.midiHighResTimer) {
+        fprintf(stderr, "Trying high resolution timer...\n");
+        timer = new PosixTimer();
+        tmrFd = timer->initTimer(MusEGlobal::config.rtcTicks);
+        if (tmrFd != -1) { // ok!
+            fprintf(stderr, "got timer = %d\n", tmrFd);
+            return tmrFd;
+        }
+        delete timer;
+    }
+#endif
+
     printf("Trying RTC timer...\n");
 #ifdef _WIN32
     timer = new QtTimer();
@@ -543,47 +613,8 @@ void MidiSeq::processTimerTick()
       if (idle)
             return;
 
+      // Midi clock and MTC are generated by the audio thread, see syncout.cpp.
       unsigned curFrame = MusEGlobal::audio->curFrame();
-      
-      if (!MusEGlobal::extSyncFlag.value()) {
-            // Do not round up here since (audio) frame resolution is higher than tick resolution.
-            const unsigned int curTick = muse_multiply_64_div_64_to_64(
-              (uint64_t)MusEGlobal::config.division * (uint64_t)MusEGlobal::tempomap.globalTempo() * 10000UL, curFrame,
-              (uint64_t)MusEGlobal::sampleRate * (uint64_t)MusEGlobal::tempomap.tempo(MusEGlobal::song->cpos()));
-            
-            unsigned int mclock = MusEGlobal::midiSyncContainer.midiClock();
-            if(mclock > curTick)
-            {
-              mclock = curTick;
-              MusEGlobal::midiSyncContainer.setMidiClock(mclock);
-            }
-
-            const unsigned int div = MusEGlobal::config.division/24;
-            if(curTick >= mclock + div)  {
-                  const unsigned int perr = (curTick - mclock) / div;
-                  
-                  bool used = false;
-                  
-                    for(int port = 0; port < MusECore::MIDI_PORTS; ++port)
-                    {
-                      MidiPort* mp = &MusEGlobal::midiPorts[port];
-                      
-                      // No device? Clock out not turned on?
-                      if(!mp->device() || !mp->syncInfo().MCOut())
-                        continue;
-                        
-                      used = true;
-                      
-                      mp->sendClock();
-                    }
-                    
-                    if(MusEGlobal::debugMsg && used && perr > 1)
-                      printf("Dropped %u midi out clock(s). curTick:%u midiClock:%u div:%u\n", perr, curTick, MusEGlobal::midiSyncContainer.midiClock(), div);
-
-                  // Using equalization periods...
-                  MusEGlobal::midiSyncContainer.setMidiClock(mclock + (perr * div));
-               }
-            }
 
       // Play all events up to curFrame.
       for (iMidiDevice id = MusEGlobal::midiDevices.begin(); id != MusEGlobal::midiDevices.end(); ++id)
@@ -602,6 +633,47 @@ void MidiSeq::processTimerTick()
           break;
         }
       }
+
+      scheduleNextTick(curFrame);
+      }
+
+//---------------------------------------------------------
+//   scheduleNextTick
+//    Ask the timer to wake us exactly when the next event
+//     is due, instead of at the next periodic
+//     tick. Timers which only tick periodically ignore it.
+//---------------------------------------------------------
+
+void MidiSeq::scheduleNextTick(unsigned curFrame)
+      {
+      if (MusEGlobal::sampleRate == 0)
+            return;
+
+      bool found = false;
+      unsigned int nextFrame = 0;
+      for (iMidiDevice id = MusEGlobal::midiDevices.begin(); id != MusEGlobal::midiDevices.end(); ++id)
+      {
+        MidiDevice* md = *id;
+        if(md->deviceType() != MidiDevice::ALSA_MIDI)
+          continue;
+        unsigned int fr;
+        if(md->nextProcessFrame(&fr) && (!found || fr < nextFrame))
+        {
+          nextFrame = fr;
+          found = true;
+        }
+      }
+
+      // Nothing due, or already due: Leave it to the periodic tick.
+      if (!found || nextFrame <= curFrame)
+            return;
+
+      uint64_t nsecs = muse_multiply_64_div_64_to_64(
+        nextFrame - curFrame, 1000000000UL, MusEGlobal::sampleRate, LargeIntRoundUp);
+      // The timer caps it to its period anyway. Just keep it within an unsigned long.
+      if (nsecs > 1000000000UL)
+            nsecs = 1000000000UL;
+      timer->setNextWakeup(nsecs);
       }
 
 //---------------------------------------------------------
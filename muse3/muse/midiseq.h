@@ -25,6 +25,9 @@
 #ifndef __MIDISEQ_H__
 #define __MIDISEQ_H__
 
+#include <stdio.h>
+#include <stdint.h>
+
 #include "thread.h"
 
 namespace MusECore {
@@ -36,6 +39,32 @@ class MTC;
 class SynthI;
 class Timer;
 
+//---------------------------------------------------------
+//   MidiTimingHistogram
+//    How late ALSA midi events are dispatched, measured
+//     against the audio clock. Midi thread only.
+//---------------------------------------------------------
+
+class MidiTimingHistogram {
+   public:
+      enum { NumBins = 9 };
+
+   private:
+      // Upper bounds of the bins in microseconds. The last bin is open.
+      static const unsigned int _binLimits[NumBins - 1];
+      unsigned int _bins[NumBins];
+      unsigned int _count;
+      uint64_t _sumFrames;
+      unsigned int _maxFrames;
+
+   public:
+      MidiTimingHistogram() { clear(); }
+      void clear();
+      void add(unsigned int lateFrames);
+      unsigned int count() const { return _count; }
+      void dump(FILE* fp) const;
+      };
+
 //---------------------------------------------------------
 //   MidiSeq
 //---------------------------------------------------------
@@ -46,8 +75,10 @@ class MidiSeq : public Thread {
       int prio;   // realtime priority
       static int ticker;
       Timer *timer;
+      MidiTimingHistogram _timingHistogram;
 
       int setRtcTicks();
+      void scheduleNextTick(unsigned curFrame);
       static void midiTick(void* p, void*);
       void processTimerTick();
       void processSeek();
@@ -72,6 +103,7 @@ class MidiSeq : public Thread {
       bool isIdle() const { return idle; }
 
       void checkAndReportTimingResolution();
+      MidiTimingHistogram& timingHistogram() { return _timingHistogram; }
 
       void msgMsg(int id);
       void msgSeek();
@@ -22,7 +22,11 @@
 //=========================================================
 
 #include <stdio.h>
+#include <stdint.h>
 #include <list>
+#include <vector>
+#include <atomic>
+#include <thread>
 
 #include <QDialog>
 #include <QListWidgetItem>
@@ -31,8 +35,10 @@
 #include "spinboxFP.h"
 #include "event.h"
 #include "miditransform.h"
+#include "transformcompile.h"
 #include "track.h"
 #include "song.h"
+#include "undo.h"
 #include "xml.h"
 #include "globals.h"
 #include "comboQuant.h"
@@ -346,6 +352,373 @@ void clearMidiTransforms()
   mtlist.clear();
 }
 
+//---------------------------------------------------------
+//   TransformProgram
+//    The current preset compiled for one run over the song.
+//    Worker threads select and transform the events of whole
+//     parts into plain values. The Events themselves are only
+//     created afterwards on the gui thread, since their
+//     reference counts and ids are not thread safe.
+//---------------------------------------------------------
+
+struct TransformProgram {
+      unsigned selMask;             // bits of the MIDITRANSFORM_ classes to select
+      bool selInvert;
+      TransformRange val1, val2, len;
+      ValOp selRange;
+      int beat1, beat2;
+      unsigned tick1, tick2;
+      bool insideLoop;
+      unsigned lpos, rpos;
+
+      TransformFunction funcOp;
+      int quantVal;
+      bool setType;
+      EventType eventType;
+      TransformOp opA, opB, opLen, opPos;
+
+      TransformProgram(const MidiTransformation* t);
+      bool selected(const Event& e) const;
+      int run(const TransformOp& o, int val, unsigned tick, unsigned& seed) const;
+      };
+
+// The values of a transformed event.
+struct TransformedEvent {
+      int a, b, len, tick;
+      };
+
+// One part's share of the work. For Select events lists every
+//  event in range and selected whether it matched, otherwise
+//  events only lists the matching ones.
+struct PartTransform {
+      MidiPart* part;
+      unsigned seed;
+      std::vector<const Event*> events;
+      std::vector<char> selected;
+      std::vector<TransformedEvent> values;
+      };
+
+// Below this many events the parts are transformed on the calling thread.
+static const size_t PARALLEL_TRANSFORM_MIN_EVENTS = 16384;
+
+//---------------------------------------------------------
+//   compileMoveOp
+//    For length and position. Fix and the operators which
+//     make no sense for the position move it by a random
+//     amount instead.
+//---------------------------------------------------------
+
+static TransformOp compileMoveOp(TransformOperator op, int a, bool jitter)
+      {
+      TransformOp o;
+      o.kind   = TLinear;
+      o.k      = 0;
+      o.s      = 1;
+      o.factor = 1.0;
+      o.lo     = 0;
+      o.range  = 1;
+      switch (op) {
+            case Plus:
+                  o.k = a;
+                  break;
+            case Minus:
+                  o.k = -a;
+                  break;
+            case Multiply:
+                  o.kind   = TMultiply;
+                  o.factor = a / 100.0;
+                  break;
+            case Divide:
+                  o.kind   = TDivide;
+                  o.factor = a / 100.0;
+                  break;
+            case Fix:
+                  if (!jitter) {
+                        o.k = a;
+                        o.s = 0;
+                        }
+                  else {
+                        o.kind  = TJitter;
+                        o.range = a;
+                        }
+                  break;
+            case Invert:
+            case ScaleMap:
+            case Dynamic:
+            case Random:
+                  if (jitter) {
+                        o.kind  = TJitter;
+                        o.range = a;
+                        }
+                  break;
+            case Keep:
+            case Flip:
+            case Value:
+            case Toggle:
+            default:
+                  break;
+            }
+      return o;
+      }
+
+//---------------------------------------------------------
+//   TransformProgram
+//---------------------------------------------------------
+
+TransformProgram::TransformProgram(const MidiTransformation* t)
+      {
+      selMask    = t->selEventOp == All ? 0 : 1u << t->selType;
+      selInvert  = t->selEventOp != Equal;
+      val1       = compileRange(t->selVal1, t->selVal1a, t->selVal1b);
+      val2       = compileRange(t->selVal2, t->selVal2a, t->selVal2b);
+      len        = compileRange(t->selLen, t->selLenA, t->selLenB);
+      selRange   = t->selRange;
+      beat1      = t->selRangeA / 1000;
+      tick1      = t->selRangeA % 1000;
+      beat2      = t->selRangeB / 1000;
+      tick2      = t->selRangeB % 1000;
+      insideLoop = t->insideLoop;
+      lpos       = MusEGlobal::song->lpos();
+      rpos       = MusEGlobal::song->rpos();
+
+      funcOp    = t->funcOp;
+      quantVal  = t->quantVal;
+      setType   = t->procEvent != Keep;
+      eventType = t->eventType;
+
+      // Value A and B ramp between procVal2a and procVal2b for Dynamic.
+      opA = compileOp(t->procVal1, t->procVal1a, t->procVal1b, t->procVal2a, 128, true, t->procVal1a);
+      opB = compileOp(t->procVal2, t->procVal2a, t->procVal2b, t->procVal1a, 128, false, t->procVal1a);
+      if (t->procVal1 == Dynamic) {
+            opA.kind  = TDynamic;
+            opA.k     = t->procVal2a;
+            opA.range = t->procVal2b - t->procVal2a;
+            }
+      if (t->procVal2 == Dynamic) {
+            opB.kind  = TDynamic;
+            opB.k     = t->procVal2a;
+            opB.range = t->procVal2b - t->procVal2a;
+            }
+      opLen = compileMoveOp(t->procLen, t->procLenA, false);
+      opPos = compileMoveOp(t->procPos, t->procPosA, true);
+      if (t->procVal1 == ScaleMap)
+            printf("scale map not implemented\n");
+      }
+
+//---------------------------------------------------------
+//   eventClass
+//    The MIDITRANSFORM_ classes the event belongs to, as bits.
+//---------------------------------------------------------
+
+static inline unsigned eventClass(const Event& e)
+      {
+      if (e.type() == Note)
+            return 1u << MIDITRANSFORM_NOTE;
+      if (e.type() != Controller)
+            return 0;
+      unsigned cls = 1u << MIDITRANSFORM_CTRL;
+      switch (midiControllerType(e.dataA())) {
+            case MidiController::PolyAftertouch: cls |= 1u << MIDITRANSFORM_POLY;      break;
+            case MidiController::Aftertouch:     cls |= 1u << MIDITRANSFORM_ATOUCH;    break;
+            case MidiController::Pitch:          cls |= 1u << MIDITRANSFORM_PITCHBEND; break;
+            case MidiController::NRPN:           cls |= 1u << MIDITRANSFORM_NRPN;      break;
+            case MidiController::RPN:            cls |= 1u << MIDITRANSFORM_RPN;       break;
+            case MidiController::Program:       cls |= 1u << MIDITRANSFORM_PROGRAM;   break;
+            default:
+                  break;
+            }
+      return cls;
+      }
+
+//---------------------------------------------------------
+//   selected
+//    apply Select filter
+//    return true if event is selected
+//---------------------------------------------------------
+
+bool TransformProgram::selected(const Event& e) const
+      {
+      if (((eventClass(e) & selMask) != 0) == selInvert)
+            return false;
+      if (!(val1.pass(e.dataA()) & val2.pass(e.dataB()) & len.pass(e.lenTick())))
+            return false;
+      if (selRange == Ignore)
+            return true;
+
+      int bar, beat;
+      unsigned tick;
+      MusEGlobal::sigmap.tickValues(e.tick(), &bar, &beat, &tick);
+      switch (selRange) {
+            case Equal:
+                  return beat == beat1 && tick == tick1;
+            case Unequal:
+                  return beat != beat1 || tick != tick1;
+            case Higher:
+                  return beat > beat1;
+            case Lower:
+                  return beat < beat1;
+            case Inside:
+                  if ((beat < beat1) || (beat >= beat2))
+                        return false;
+                  if (beat == beat1 && tick < tick1)
+                        return false;
+                  if (beat == beat2 && tick >= tick2)
+                        return false;
+                  break;
+            case Outside:
+                  if ((beat >= beat1) || (beat < beat2))
+                        return false;
+                  if (beat == beat1 && tick >= tick1)
+                        return false;
+                  if (beat == beat2 && tick < tick2)
+                        return false;
+                  break;
+            default:
+                  break;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   run
+//---------------------------------------------------------
+
+int TransformProgram::run(const TransformOp& o, int val, unsigned tick, unsigned& seed) const
+      {
+      switch (o.kind) {
+            case TLinear:
+                  return o.k + o.s * val;
+            case TMultiply:
+                  return int(val * o.factor + .5);
+            case TDivide:
+                  return int(val / o.factor + .5);
+            case TDynamic:
+                  if (rpos == lpos)
+                        return o.k;
+                  // In 64 bit, range times the ticks into the loop overflows an int on long songs.
+                  return int((int64_t(o.range) * (int64_t(tick) - int64_t(lpos))) / (int64_t(rpos) - int64_t(lpos))) + o.k;
+            case TRandom:
+                  seed = seed * 1103515245u + 12345u;
+                  return o.lo + int((seed >> 16) & 0x7fff) % o.range;
+            case TJitter:
+                  if (o.range <= 0)
+                        return val;
+                  seed = seed * 1103515245u + 12345u;
+                  return val + int((seed >> 16) & 0x7fff) % (2 * o.range) - o.range;
+            case TToggle:
+                  break;
+            }
+      return val;
+      }
+
+//---------------------------------------------------------
+//   runTransformProgram
+//    Worker thread. Only reads the part's events.
+//---------------------------------------------------------
+
+static void runTransformProgram(const TransformProgram& p, PartTransform& pt)
+      {
+      const EventList& el = pt.part->events();
+      const bool select = p.funcOp == Select;
+      for (ciEvent i = el.begin(); i != el.end(); ++i) {
+            const Event& e = i->second;
+            const unsigned tick = e.tick();
+            if (p.insideLoop && (tick < p.lpos || tick >= p.rpos))
+                  continue;
+            const bool sel = p.selected(e);
+            if (select) {
+                  pt.events.push_back(&e);
+                  pt.selected.push_back(sel);
+                  continue;
+                  }
+            if (!sel)
+                  continue;
+            pt.events.push_back(&e);
+
+            TransformedEvent v;
+            v.a    = e.dataA();
+            v.b    = e.dataB();
+            v.len  = e.lenTick();
+            v.tick = tick;
+            switch (p.funcOp) {
+                  case Quantize:
+                        v.tick = MusEGlobal::sigmap.raster(tick, p.quantVal);
+                        break;
+                  case Transform:
+                  case Insert:
+                  case Copy:
+                  case Extract:
+                        v.a = p.run(p.opA, v.a, tick, pt.seed);
+                        v.a = v.a < 0 ? 0 : (v.a > 127 ? 127 : v.a);
+                        v.b = p.run(p.opB, v.b, tick, pt.seed);
+                        v.b = v.b < 0 ? 0 : (v.b > 127 ? 127 : v.b);
+                        v.len = p.run(p.opLen, v.len, tick, pt.seed);
+                        if (v.len < 0)
+                              v.len = 0;
+                        v.tick = p.run(p.opPos, int(tick), tick, pt.seed);
+                        if (v.tick < 0)
+                              v.tick = 0;
+                        break;
+                  default:
+                        break;
+                  }
+            pt.values.push_back(v);
+            }
+      }
+
+//---------------------------------------------------------
+//   TransformWorker
+//    Takes parts off the shared list until none are left.
+//---------------------------------------------------------
+
+struct TransformWorker {
+      const TransformProgram& program;
+      std::vector<PartTransform>& parts;
+      std::atomic<size_t>& next;
+
+      TransformWorker(const TransformProgram& p, std::vector<PartTransform>& pl, std::atomic<size_t>& n)
+         : program(p), parts(pl), next(n) {}
+
+      void operator()()
+            {
+            for (;;) {
+                  const size_t i = next.fetch_add(1);
+                  if (i >= parts.size())
+                        break;
+                  runTransformProgram(program, parts[i]);
+                  }
+            }
+      };
+
+//---------------------------------------------------------
+//   runTransformProgram
+//    Runs the program over all the parts, in parallel if
+//     there is enough work.
+//---------------------------------------------------------
+
+static void runTransformProgram(const TransformProgram& p, std::vector<PartTransform>& parts, size_t events)
+      {
+      std::atomic<size_t> next(0);
+      TransformWorker worker(p, parts, next);
+
+      unsigned threads = std::thread::hardware_concurrency();
+      if (threads > 16)
+            threads = 16;
+      if (threads > parts.size())
+            threads = parts.size();
+      if (events < PARALLEL_TRANSFORM_MIN_EVENTS || threads < 2) {
+            worker();
+            return;
+            }
+      std::vector<std::thread> workers;
+      workers.reserve(threads - 1);
+      for (unsigned i = 1; i < threads; ++i)
+            workers.push_back(std::thread(worker));
+      worker();
+      for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+      }
+
 } // namespace MusECore
 
 namespace MusEGui {
@@ -482,525 +855,139 @@ void MidiTransformerDialog::accept()
       }
 
 //---------------------------------------------------------
-//   transformEvent
-//    subfunction of processEvent()
+//   apply
+//    Collects the parts, transforms them in parallel and
+//     then turns the results into one batch of operations
+//     per part, applied as one operation group.
 //---------------------------------------------------------
 
-void MidiTransformerDialog::transformEvent(MusECore::Event& event, MusECore::MidiPart* part, MusECore::MidiPart* newPart, MusECore::Undo& operations)
+void MidiTransformerDialog::apply()
       {
       MusECore::MidiTransformation* cmt = data->cmt;
-      MusECore::Event newEvent = event.clone();
-
-      if (cmt->procEvent != MusECore::Keep)
-            newEvent.setType(cmt->eventType);
+      const MusECore::TransformProgram program(cmt);
+      const bool copyExtract = (cmt->funcOp == MusECore::Copy)
+                               || (cmt->funcOp == MusECore::Extract);
 
-      //---------------------------------------------------
-      //    transform value A
-      //---------------------------------------------------
-
-      int val = newEvent.dataA();
-      switch (cmt->procVal1) {
-            case MusECore::Keep:
-                  break;
-            case MusECore::Plus:
-                  val += cmt->procVal1a;
-                  break;
-            case MusECore::Minus:
-                  val -= cmt->procVal1a;
-                  break;
-            case MusECore::Multiply:
-                  val = int(val * (cmt->procVal1a/100.0) + .5);
-                  break;
-            case MusECore::Divide:
-                  val = int(val / (cmt->procVal1a/100.0) + .5);
-                  break;
-            case MusECore::Fix:
-                  val = cmt->procVal1a;
-                  break;
-            case MusECore::Value:
-                  val = cmt->procVal2a;
-                  break;
-            case MusECore::Invert:
-                  val = 128 - val;
-                  break;
-            case MusECore::ScaleMap:
-                  printf("scale map not implemented\n");
-                  break;
-            case MusECore::Flip:
-                  val = cmt->procVal1a - val;
-                  break;
-            case MusECore::Dynamic:           // "crescendo"
-                  val = (((cmt->procVal2b-cmt->procVal2a)
-                        * (newEvent.tick() - MusEGlobal::song->lpos()))
-                        / (MusEGlobal::song->rpos() - MusEGlobal::song->lpos())) + cmt->procVal2a;
-                  break;
-            case MusECore::Random:
-                  {
-                  int range = cmt->procVal1b - cmt->procVal1a;
-                  if (range > 0)
-                        val = (rand() % range) + cmt->procVal1a;
-                  else if (range < 0)
-                        val = (rand() % -range) + cmt->procVal1b;
-                  else
-                        val = cmt->procVal1a;
+      // Each clone chain is transformed once.
+      std::vector<MusECore::PartTransform> parts;
+      QSet< int > doneList;
+      size_t events = 0;
+      MusECore::MidiTrackList* tracks = MusEGlobal::song->midis();
+      for (MusECore::iMidiTrack t = tracks->begin(); t != tracks->end(); ++t) {
+            if (cmt->selectedTracks && !(*t)->selected())
+                  continue;
+            MusECore::PartList* pl = (*t)->parts();
+            for (MusECore::iPart p = pl->begin(); p != pl->end(); ++p) {
+                  MusECore::MidiPart* part = (MusECore::MidiPart *) p->second;
+                  if (doneList.contains(part->clonemaster_sn()))
+                        continue;
+                  doneList.insert(part->clonemaster_sn());
+                  MusECore::PartTransform pt;
+                  pt.part = part;
+                  pt.seed = rand();
+                  parts.push_back(pt);
+                  events += part->events().size();
                   }
-                  break;
-            default:
-                  break;
             }
-      if (val < 0)
-            val = 0;
-      if (val > 127)
-            val = 127;
-      newEvent.setA(val);
 
-      //---------------------------------------------------
-      //    transform value B
-      //---------------------------------------------------
+      MusECore::runTransformProgram(program, parts, events);
 
-      val = newEvent.dataB();
-      switch (cmt->procVal2) {
-            case MusECore::Plus:
-                  val += cmt->procVal2a;
-                  break;
-            case MusECore::Minus:
-                  val -= cmt->procVal2a;
-                  break;
-            case MusECore::Multiply:
-                  val = int(val * (cmt->procVal2a/100.0) + .5);
-                  break;
-            case MusECore::Divide:
-                  val = int(val / (cmt->procVal2a/100.0) + .5);
-                  break;
-            case MusECore::Fix:
-                  val = cmt->procVal2a;
-                  break;
-            case MusECore::Value:
-                  val = cmt->procVal1a;
-                  break;
-            case MusECore::Invert:
-                  val = 128 - val;
-                  break;
-            case MusECore::Dynamic:
-                  val = (((cmt->procVal2b-cmt->procVal2a)
-                        * (newEvent.tick() - MusEGlobal::song->lpos()))
-                        / (MusEGlobal::song->rpos() - MusEGlobal::song->lpos())) + cmt->procVal2a;
-                  break;
-            case MusECore::Random:
-                  {
-                  int range = cmt->procVal2b - cmt->procVal2a;
-                  if (range > 0)
-                        val = (rand() % range) + cmt->procVal2a;
-                  else if (range < 0)
-                        val = (rand() % -range) + cmt->procVal2b;
-                  else
-                        val = cmt->procVal1a;
+      Undo operations;
+      MusECore::MidiTrackList tl;
+      MusECore::Track* track = 0;
+      MusECore::MidiTrack* newTrack = 0;
+      for (size_t i = 0; i < parts.size(); ++i) {
+            const MusECore::PartTransform& pt = parts[i];
+            MusECore::MidiPart* part = pt.part;
+            if (part->track() != track) {
+                  track = part->track();
+                  newTrack = 0;
                   }
-                  break;
-            case MusECore::ScaleMap:
-            case MusECore::Keep:
-            case MusECore::Flip:
-            case MusECore::Toggle:
-                  break;
-            }
-      if (val < 0)
-            val = 0;
-      if (val > 127)
-            val = 127;
-      newEvent.setB(val);
-
-      //---------------------------------------------------
-      //    transform len
-      //---------------------------------------------------
-
-      int len = newEvent.lenTick();
-      switch (cmt->procLen) {
-            case MusECore::Plus:
-                  len += cmt->procLenA;
-                  break;
-            case MusECore::Minus:
-                  len -= cmt->procLenA;
-                  break;
-            case MusECore::Multiply:
-                  len = int(len * (cmt->procLenA/100.0) + .5);
-                  break;
-            case MusECore::Divide:
-                  len = int(len / (cmt->procLenA/100.0) + .5);
-                  break;
-            case MusECore::Fix:
-                  len = cmt->procLenA;
-                  break;
-            case MusECore::Invert:
-            case MusECore::ScaleMap:
-            case MusECore::Dynamic:
-            case MusECore::Random:
-            case MusECore::Keep:
-            case MusECore::Flip:
-            case MusECore::Value:
-            case MusECore::Toggle:
-                  break;
-            }
-      if (len < 0)
-            len = 0;
-      newEvent.setLenTick(len);
-
-      //---------------------------------------------------
-      //    transform pos
-      //---------------------------------------------------
-
-      int pos = newEvent.tick();
-      switch (cmt->procPos) {
-            case MusECore::Plus:
-                  pos += cmt->procPosA;
-                  break;
-            case MusECore::Minus:
-                  pos -= cmt->procPosA;
-                  break;
-            case MusECore::Multiply:
-                  pos = int(pos * (cmt->procPosA/100.0) + .5);
-                  break;
-            case MusECore::Divide:
-                  pos = int(pos / (cmt->procPosA/100.0) + .5);
-                  break;
-            case MusECore::Fix:
-            case MusECore::Invert:
-            case MusECore::ScaleMap:
-            case MusECore::Dynamic:
-            case MusECore::Random:
-                {
-                    int range = cmt->procPosA;
-                    int val = rand() % (2 * range) - range;
-                    pos = pos + val;
-                }
-            break;
-            case MusECore::Keep:
-            case MusECore::Flip:
-            case MusECore::Value:
-            case MusECore::Toggle:
-                  break;
-            }
-      if (pos < 0)
-            pos = 0;
-      newEvent.setTick(pos);
-
-      switch(data->cmt->funcOp) {
-            case MusECore::Transform:
-                  operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, event, part, true, true));
-                  break;
-            case MusECore::Insert:
-                  // Indicate do port controller values and clone parts. 
-                  operations.push_back(UndoOp(UndoOp::AddEvent, newEvent, part, true, true));
-                  break;
-            case MusECore::Extract:
-                  operations.push_back(UndoOp(UndoOp::DeleteEvent, event, part, true, true));
-            // NOTE: Error suppressor for new gcc 7 'fallthrough' level 3 and 4:
-            // FALLTHROUGH
-            case MusECore::Copy:
-                  newPart->addEvent(newEvent);
-                  break;
-            default:
-                  break;
-            }
-      }
-
-//---------------------------------------------------------
-//   processEvent
-//---------------------------------------------------------
-
-void MidiTransformerDialog::processEvent(MusECore::Event& event, MusECore::MidiPart* part, MusECore::MidiPart* newPart, MusECore::Undo& operations)
-      {
-      switch(data->cmt->funcOp) {
-            case MusECore::Select:
-                  break;
-            case MusECore::Quantize:
-                  {
-                  int tick = event.tick();
-                  int rt = MusEGlobal::sigmap.raster(tick, data->cmt->quantVal) - tick;
-                  if (tick != rt) {
-                        MusECore::Event newEvent = event.clone();
-                        newEvent.setTick(rt);
-						operations.push_back(UndoOp(UndoOp::ModifyEvent,newEvent,event,part,true,true));
+            const size_t n = pt.events.size();
+
+            if (program.funcOp == MusECore::Select) {
+                  // Here we have a choice of whether to allow undoing of selections.
+                  // Disabled for now, it's too tedious in use. Possibly make the choice user settable.
+                  for (size_t k = 0; k < n; ++k) {
+                        const MusECore::Event& event = *pt.events[k];
+                        const bool flag = pt.selected[k];
+                        if (flag != event.selected())
+                              operations.push_back(UndoOp(UndoOp::SelectEvent, event, part, flag, event.selected(), false));
                         }
+                  continue;
                   }
-                  break;
-            case MusECore::Delete:
-                  {
-                  operations.push_back(UndoOp(UndoOp::DeleteEvent, event, part, true, true));
-                  }
-                  break;
-            case MusECore::Transform:
-            case MusECore::Insert:
-            case MusECore::Copy:
-            case MusECore::Extract:
-                  transformEvent(event, part, newPart, operations);
-                  break;
-            }
-      }
-
-//---------------------------------------------------------
-//   isSelected
-//    apply Select filter
-//    return true if event is selected
-//---------------------------------------------------------
-
-bool MidiTransformerDialog::isSelected(const MusECore::Event& event)
-      {
-      MusECore::MidiTransformation* cmt = data->cmt;
-
-      switch (cmt->selEventOp) {
-            case MusECore::Equal:
-                  if (!typesMatch(event, cmt->selType)) {
-                        return false;
-                        }
-                  break;
-            case MusECore::Unequal:
-                  if (typesMatch(event, cmt->selType))
-                        return false;
-                  break;
-            default:
-                  break;
-            }
-      switch (cmt->selVal1) {
-            case MusECore::Ignore:
-                  break;
-            case MusECore::Equal:
-                  if (event.dataA() != cmt->selVal1a)
-                        return false;
-                  break;
-            case MusECore::Unequal:
-                  if (event.dataA() == cmt->selVal1a)
-                        return false;
-                  break;
-            case MusECore::Higher:
-                  if (event.dataA() <= cmt->selVal1a)
-                        return false;
-                  break;
-            case MusECore::Lower:
-                  if (event.dataA() >= cmt->selVal1a)
-                        return false;
-                  break;
-            case MusECore::Inside:
-                  if ((event.dataA() < cmt->selVal1a)
-                     || (event.dataA() >= cmt->selVal1b))
-                        return false;
-                  break;
-            case MusECore::Outside:
-                  if ((event.dataA() >= cmt->selVal1a)
-                     && (event.dataA() < cmt->selVal1b))
-                        return false;
-                  break;
-            }
-      switch (cmt->selVal2) {
-            case MusECore::Ignore:
-                  break;
-            case MusECore::Equal:
-                  if (event.dataB() != cmt->selVal2a)
-                        return false;
-                  break;
-            case MusECore::Unequal:
-                  if (event.dataB() == cmt->selVal2a)
-                        return false;
-                  break;
-            case MusECore::Higher:
-                  if (event.dataB() <= cmt->selVal2a)
-                        return false;
-                  break;
-            case MusECore::Lower:
-                  if (event.dataB() >= cmt->selVal2a)
-                        return false;
-                  break;
-            case MusECore::Inside:
-                  if ((event.dataB() < cmt->selVal2a)
-                     || (event.dataB() >= cmt->selVal2b))
-                        return false;
-                  break;
-            case MusECore::Outside:
-                  if ((event.dataB() >= cmt->selVal2a)
-                     && (event.dataB() < cmt->selVal2b))
-                        return false;
-                  break;
-            }
-      int len = event.lenTick();
-      switch (cmt->selLen) {
-            case MusECore::Ignore:
-                  break;
-            case MusECore::Equal:
-                  if (len != cmt->selLenA)
-                        return false;
-                  break;
-            case MusECore::Unequal:
-                  if (len == cmt->selLenA)
-                        return false;
-                  break;
-            case MusECore::Higher:
-                  if (len <= cmt->selLenA)
-                        return false;
-                  break;
-            case MusECore::Lower:
-                  if (len >= cmt->selLenA)
-                        return false;
-                  break;
-            case MusECore::Inside:
-                  if ((len < cmt->selLenA) || (len >= cmt->selLenB))
-                        return false;
-                  break;
-            case MusECore::Outside:
-                  if ((len >= cmt->selLenA) && (len < cmt->selLenB))
-                        return false;
-                  break;
-            }
-      int bar, beat;
-      unsigned tick;
-      MusEGlobal::sigmap.tickValues(event.tick(), &bar, &beat, &tick);
-      int beat1 = cmt->selRangeA / 1000;
-      unsigned tick1 = cmt->selRangeA % 1000;
-      int beat2 = cmt->selRangeB / 1000;
-      unsigned tick2 = cmt->selRangeB % 1000;
-      switch (cmt->selRange) {
-            case MusECore::Ignore:
-                  break;
-            case MusECore::Equal:
-                  if (beat != beat1 || tick != tick1)
-                        return false;
-                  break;
-            case MusECore::Unequal:
-                  if (beat == beat1 && tick == tick1)
-                        return false;
-                  break;
-            case MusECore::Higher:
-                  if (beat <= beat1)
-                        return false;
-                  if (beat == beat1 && tick <= tick1)
-                        return false;
-                  break;
-            case MusECore::Lower:
-                  if (beat >= beat1)
-                        return false;
-                  if (beat == beat1 && tick >= tick1)
-                        return false;
-                  break;
-            case MusECore::Inside:
-                  if ((beat < beat1) || (beat >= beat2))
-                        return false;
-                  if (beat == beat1 && tick < tick1)
-                        return false;
-                  if (beat == beat2 && tick >= tick2)
-                        return false;
-                  break;
-            case MusECore::Outside:
-                  if ((beat >= beat1) || (beat < beat2))
-                        return false;
-                  if (beat == beat1 && tick >= tick1)
-                        return false;
-                  if (beat == beat2 && tick < tick2)
-                        return false;
-                  break;
-            }
-      return true;
-      }
-
-//---------------------------------------------------------
-//   apply
-//---------------------------------------------------------
-
-void MidiTransformerDialog::apply()
-      {
-      MusECore::SongChangedStruct_t flags = 0;
-	  
-	  Undo operations;
-      bool copyExtract = (data->cmt->funcOp == MusECore::Copy)
-                         || (data->cmt->funcOp == MusECore::Extract);
-
-      QSet< int > doneList;
-      typedef std::set< int >::iterator iDoneList;
-      iDoneList idl;
-      
-      MusECore::MidiTrackList* tracks = MusEGlobal::song->midis();
-      MusECore::MidiTrackList tl;
-      for (MusECore::iMidiTrack t = tracks->begin(); t != tracks->end(); ++t) {
-            if (data->cmt->selectedTracks && !(*t)->selected())
+            if (n == 0)
                   continue;
-            MusECore::MidiTrack* newTrack = 0;
-            MusECore::PartList *pl = (*t)->parts();
+
+            MusECore::MidiPart* newPart = 0;
             if (copyExtract) {
-                  // check whether we must generate a new track
-                  for (MusECore::iPart p = pl->begin(); p != pl->end(); ++p) {
-                        MusECore::MidiPart* part = (MusECore::MidiPart *) p->second;
-                        const MusECore::EventList& el = part->events();
-                        // Check if the event list has already been done. Skip repeated clones.
-                        if (doneList.contains(part->clonemaster_sn()))
-                             continue;
-                        doneList.insert(part->clonemaster_sn());
-                        
-                        for (MusECore::ciEvent i = el.begin(); i != el.end(); ++i) {
-                              const MusECore::Event& event = i->second;
-                              unsigned tick = event.tick();
-                              if (data->cmt->insideLoop && (tick < MusEGlobal::song->lpos() || tick >= MusEGlobal::song->rpos()))
-                                    continue;
-                              if (isSelected(event)) {
-                                    newTrack = new MusECore::MidiTrack();
-                                    tl.push_back(newTrack);
-                                    break;
-                                    }
-                              }
-                        if (newTrack)
-                              break;
+                  if (!newTrack) {
+                        newTrack = new MusECore::MidiTrack();
+                        tl.push_back(newTrack);
                         }
+                  newPart = new MusECore::MidiPart(newTrack);
+                  newPart->setName(part->name());
+                  newPart->setColorIndex(part->colorIndex());
+                  newPart->setTick(part->tick());
+                  newPart->setLenTick(part->lenTick());
+                  operations.push_back(UndoOp(UndoOp::AddPart, newPart));
                   }
 
-            for (MusECore::iPart p = pl->begin(); p != pl->end(); ++p) {
-                  MusECore::MidiPart* part = (MusECore::MidiPart *) p->second;
-                  MusECore::MidiPart* newPart = 0;
-                  const MusECore::EventList& el = part->events();
-                  // Check if the event list has already been done. Skip repeated clones.
-                  if (doneList.contains(part->clonemaster_sn()))
-                      continue;
-                  doneList.insert(part->clonemaster_sn());
-                  
-                  if (copyExtract) {
-                        // check whether we must generate a new part
-                        for (MusECore::ciEvent i = el.begin(); i != el.end(); ++i) {
-                              const MusECore::Event& event = i->second;
-                              unsigned tick = event.tick();
-                              if (data->cmt->insideLoop && (tick < MusEGlobal::song->lpos() || tick >= MusEGlobal::song->rpos()))
-                                    continue;
-                              if (isSelected(event)) {
-                                    newPart = new MusECore::MidiPart(newTrack);
-                                    newPart->setName(part->name());
-                                    newPart->setColorIndex(part->colorIndex());
-                                    newPart->setTick(part->tick());
-                                    newPart->setLenTick(part->lenTick());
-                                    operations.push_back(UndoOp(UndoOp::AddPart,newPart));
-                                    flags |= SC_PART_INSERTED;
-                                    break;
-                                    }
-                              }
+            MusECore::UndoEventBatch* batch = new MusECore::UndoEventBatch();
+            batch->reserve(n);
+            for (size_t k = 0; k < n; ++k) {
+                  const MusECore::Event& event = *pt.events[k];
+                  const MusECore::TransformedEvent& v = pt.values[k];
+                  if (program.funcOp == MusECore::Delete) {
+                        batch->add(event, MusECore::Event());
+                        continue;
                         }
-                  MusECore::EventList pel;
-                  for (MusECore::ciEvent i = el.begin(); i != el.end(); ++i) {
-                        const MusECore::Event& event = i->second;
-                        unsigned tick = event.tick();
-                        if (data->cmt->insideLoop && (tick < MusEGlobal::song->lpos() || tick >= MusEGlobal::song->rpos()))
-                              continue;
-                        int flag = isSelected(event);
-                        if (data->cmt->funcOp == MusECore::Select)
-                              // Here we have a choice of whether to allow undoing of selections.
-                              // Disabled for now, it's too tedious in use. Possibly make the choice user settable.
-                              operations.push_back(UndoOp(UndoOp::SelectEvent, event, part, flag, event.selected(), false));
-                        else if (flag)
-                              pel.add(const_cast<MusECore::Event&>(event)); // ough, FIXME, what an ugly hack.
+                  if (program.funcOp == MusECore::Quantize) {
+                        if (unsigned(v.tick) != event.tick()) {
+                              MusECore::Event newEvent = event.clone();
+                              newEvent.setTick(v.tick);
+                              batch->add(event, newEvent);
+                              }
+                        continue;
                         }
-                  for (MusECore::iEvent i = pel.begin(); i != pel.end(); ++i) {
-                        MusECore::Event event = i->second;
-                        processEvent(event, part, newPart, operations);
+                  if (program.funcOp == MusECore::Transform && !program.setType
+                     && v.a == event.dataA() && v.b == event.dataB()
+                     && unsigned(v.len) == event.lenTick() && unsigned(v.tick) == event.tick())
+                        continue;
+
+                  MusECore::Event newEvent = event.clone();
+                  if (program.setType)
+                        newEvent.setType(program.eventType);
+                  newEvent.setA(v.a);
+                  newEvent.setB(v.b);
+                  newEvent.setLenTick(v.len);
+                  newEvent.setTick(v.tick);
+                  switch (program.funcOp) {
+                        case MusECore::Transform:
+                              batch->add(event, newEvent);
+                              break;
+                        case MusECore::Insert:
+                              batch->add(MusECore::Event(), newEvent);
+                              break;
+                        case MusECore::Extract:
+                              batch->add(event, MusECore::Event());
+                              newPart->addEvent(newEvent);
+                              break;
+                        case MusECore::Copy:
+                              newPart->addEvent(newEvent);
+                              break;
+                        default:
+                              break;
                         }
                   }
+            if (batch->empty())
+                  delete batch;
+            else
+                  // Indicate do port controller values and clone parts.
+                  operations.push_back(UndoOp(UndoOp::ModifyEventBatch, part, batch, true, true));
             }
-      if (!tl.empty()) {
-            flags |= SC_TRACK_INSERTED;
-            for (MusECore::iTrack t = tl.begin(); t != tl.end(); ++t)
-                  operations.push_back(UndoOp(UndoOp::AddTrack, -1, *t));
-      }
+      for (MusECore::iTrack t = tl.begin(); t != tl.end(); ++t)
+            operations.push_back(UndoOp(UndoOp::AddTrack, -1, *t));
 
       MusEGlobal::song->applyOperationGroup(operations);
       }
@@ -1685,76 +1672,4 @@ void MidiTransformerDialog::insideLoopChanged(bool val)
       processAll->setChecked(!data->cmt->selectedTracks && !val);
       }
 
-
-
-/*!
-    \fn MidiTransformerDialog::typesMatch(const MusECore::MidiEvent e, unsigned t)
- */
-bool MidiTransformerDialog::typesMatch(const MusECore::Event& e, unsigned selType)
-      {
-      bool matched = false;
-      switch (selType)
-         {
-         case MIDITRANSFORM_NOTE:
-            matched = (e.type() == MusECore::Note);
-            break;
-         case MIDITRANSFORM_POLY:
-            {
-            if (e.type() == MusECore::Controller) {
-                  MusECore::MidiController::ControllerType c = MusECore::midiControllerType(e.dataA());
-                  matched = (c == MusECore::MidiController::PolyAftertouch);
-                  }
-            break;
-            }
-         case MIDITRANSFORM_CTRL:
-            matched = (e.type() == MusECore::Controller);
-            break;
-         case MIDITRANSFORM_ATOUCH:
-            {
-            if (e.type() == MusECore::Controller) {
-                  MusECore::MidiController::ControllerType c = MusECore::midiControllerType(e.dataA());
-                  matched = (c == MusECore::MidiController::Aftertouch);
-                  }
-            break;
-            }
-         case MIDITRANSFORM_PITCHBEND:
-            {
-            if (e.type() == MusECore::Controller) {
-                  MusECore::MidiController::ControllerType c = MusECore::midiControllerType(e.dataA());
-                  matched = (c == MusECore::MidiController::Pitch);
-                  }
-            break;
-            }
-         case MIDITRANSFORM_NRPN:
-            {
-            if (e.type() == MusECore::Controller) {
-                  MusECore::MidiController::ControllerType c = MusECore::midiControllerType(e.dataA());
-                  matched = (c == MusECore::MidiController::NRPN);
-                  }
-            break;
-            }
-         case MIDITRANSFORM_RPN:
-            {
-            if (e.type() == MusECore::Controller) {
-                  MusECore::MidiController::ControllerType c = MusECore::midiControllerType(e.dataA());
-                  matched = (c == MusECore::MidiController::RPN);
-                  }
-            break;
-            }
-         case MIDITRANSFORM_PROGRAM:
-            {
-            if (e.type() == MusECore::Controller) {
-                  MusECore::MidiController::ControllerType c = MusECore::midiControllerType(e.dataA());
-                  matched = (c == MusECore::MidiController::Program);
-                  }
-            break;
-            }
-         default:
-            fprintf(stderr, "Error matching type in MidiTransformerDialog: unknown eventtype!\n");
-            break;
-         }
-      //printf("Event type=%d, selType =%d matched=%d\n", e.type(), selType, matched);
-      return matched;
-      }
-
 } // namespace MusEGui
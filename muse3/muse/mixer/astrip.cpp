@@ -54,6 +54,7 @@
 #include "meter.h"
 #include "astrip.h"
 #include "track.h"
+#include "telemetry.h"
 #include "synth.h"
 #include "doublelabel.h"
 #include "rack.h"
@@ -784,15 +785,22 @@ void AudioComponentRack::setComponentColors()
 
 void AudioStrip::heartBeat()
 {
-   const int tch = track->channels();
+   // Values published by the audio thread, or null until the first snapshot arrives.
+   const MusECore::TelemetryTrackValues* tv = MusEGlobal::telemetry.values(track);
+   int tch = track->channels();
+   if(tch > MusECore::MAX_CHANNELS)
+     tch = MusECore::MAX_CHANNELS;
    for (int ch = 0; ch < tch; ++ch) {
+      const double m = tv ? tv->meter[ch] : track->meter(ch);
+      const double p = tv ? tv->peak[ch] : track->peak(ch);
+      const bool clipped = tv ? tv->clipped[ch] : track->isClipped(ch);
       if (meter[ch]) {
-         meter[ch]->setVal(track->meter(ch), track->peak(ch), false);
+         meter[ch]->setVal(m, p, false);
       }
       if(_clipperLabel[ch])
       {
-        _clipperLabel[ch]->setVal(track->peak(ch));
-        _clipperLabel[ch]->setClipped(track->isClipped(ch));
+        _clipperLabel[ch]->setVal(p);
+        _clipperLabel[ch]->setClipped(clipped);
       }
    }
    updateVolume();
@@ -1018,7 +1026,15 @@ void AudioStrip::updateVolume()
 {
       if(_volPressed) // Inhibit the controller stream if control is currently pressed.
         return;
-      double vol = static_cast<MusECore::AudioTrack*>(track)->volume();
+      MusECore::AudioTrack* at = static_cast<MusECore::AudioTrack*>(track);
+      double vol;
+      // While automation is playing, take the value the audio thread last published.
+      // Otherwise the gui owns the value, and a snapshot could briefly undo a user change.
+      const MusECore::TelemetryTrackValues* tv = MusEGlobal::telemetry.values(track);
+      if(tv && MusEGlobal::automation && at->automationType() != MusECore::AUTO_OFF)
+        vol = tv->volume;
+      else
+        vol = at->volume();
       if (vol != volume)
       {
           double val;
@@ -46,6 +46,7 @@
 #include "combobox.h"
 #include "meter.h"
 #include "track.h"
+#include "telemetry.h"
 #include "doublelabel.h"
 #include "rack.h"
 #include "node.h"
@@ -866,6 +867,8 @@ void MidiComponentRack::instrPopup(QPoint p)
     {
       if((*i)->iname() == s) 
       {
+        // Read the instrument's file before the audio is stopped.
+        (*i)->load();
         MusEGlobal::audio->msgIdle(true); // Make it safe to edit structures
         MusEGlobal::midiPorts[port].changeInstrument(*i);
         MusEGlobal::audio->msgIdle(false);
@@ -1377,7 +1380,6 @@ MidiStrip::MidiStrip(QWidget* parent, MusECore::MidiTrack* t, bool hasHandle, bo
       setStyleSheet(MusECore::font2StyleSheet(MusEGlobal::config.fonts[1]));
       
       // Clear so the meters don't start off by showing stale values.
-      t->setActivity(0);
       t->setLastActivity(0);
 
       _inRoutesPos         = GridPosStruct(_curGridRow,     0, 1, 1);
@@ -2381,7 +2383,10 @@ void MidiStrip::heartBeat()
       
       if(track && track->isMidiTrack())
       {
-        int act = track->activity();
+        // Take the highest activity the audio thread saw since the last beat, if published.
+        // The activity itself is owned and decayed by the audio thread.
+        const MusECore::TelemetryTrackValues* tv = MusEGlobal::telemetry.values(track);
+        const int act = tv ? tv->activity : 0;
         double m_val = slider->value();
 
         if(_preferMidiVolumeDb)
@@ -2408,10 +2413,6 @@ void MidiStrip::heartBeat()
         
         if(meter[0]) 
           meter[0]->setVal(dact, track->lastActivity(), false);  
-        
-        // Gives reasonable decay with gui update set to 20/sec.
-        if(act)
-          track->setActivity((int)((double)act * 0.8));
       }
       
       updateControls();
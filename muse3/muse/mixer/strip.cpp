@@ -43,6 +43,7 @@
 #include "audio.h"
 #include "song.h"
 #include "track.h"
+#include "telemetry.h"
 #include "strip.h"
 #include "meter.h"
 #include "utils.h"
@@ -1064,6 +1065,7 @@ Strip::Strip(QWidget* parent, MusECore::Track* t, bool hasHandle, bool isEmbedde
       _broadcastChanges = false;
       _selected = false;
       _highlight = false;
+      _telemetrySubscribed = false;
 
       _curGridRow = 0;
       _userWidth = 0;
@@ -1138,6 +1140,38 @@ Strip::Strip(QWidget* parent, MusECore::Track* t, bool hasHandle, bool isEmbedde
 
 Strip::~Strip()
       {
+      if(_telemetrySubscribed)
+        MusEGlobal::telemetry.unsubscribe(track);
+      }
+
+//---------------------------------------------------------
+//   showEvent
+//    Only strips which are shown gather meters and values
+//     from the audio thread.
+//---------------------------------------------------------
+
+void Strip::showEvent(QShowEvent* e)
+      {
+      if(!_telemetrySubscribed && track)
+      {
+        MusEGlobal::telemetry.subscribe(track);
+        _telemetrySubscribed = true;
+      }
+      QFrame::showEvent(e);
+      }
+
+//---------------------------------------------------------
+//   hideEvent
+//---------------------------------------------------------
+
+void Strip::hideEvent(QHideEvent* e)
+      {
+      if(_telemetrySubscribed)
+      {
+        MusEGlobal::telemetry.unsubscribe(track);
+        _telemetrySubscribed = false;
+      }
+      QFrame::hideEvent(e);
       }
 
 void Strip::setFocusYieldWidget(QWidget* w)
@@ -38,6 +38,8 @@
 
 class QMouseEvent;
 class QResizeEvent;
+class QShowEvent;
+class QHideEvent;
 class QGridLayout;
 class QLayout;
 class QSize;
@@ -678,6 +680,8 @@ class Strip : public QFrame {
       bool _visible;
       bool _selected;
       bool _highlight;
+      // Whether the track is subscribed to the telemetry channel. Only while the strip is shown.
+      bool _telemetrySubscribed;
 
    protected:
       // Whether to propagate changes to other selected tracks.
@@ -711,6 +715,8 @@ class Strip : public QFrame {
       virtual void mouseMoveEvent(QMouseEvent *);
       virtual void keyPressEvent(QKeyEvent *);
       virtual void paintEvent(QPaintEvent *);
+      virtual void showEvent(QShowEvent *);
+      virtual void hideEvent(QHideEvent *);
 
       virtual void updateRouteButtons();
 
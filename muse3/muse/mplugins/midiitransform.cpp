@@ -23,6 +23,8 @@
 
 #include <stdio.h>
 #include <list>
+#include <atomic>
+#include <thread>
 #include <QCloseEvent>
 
 #include <QButtonGroup>
@@ -35,6 +37,7 @@
 #include "event.h"
 #include "mpevent.h"
 #include "midiitransform.h"
+#include "transformcompile.h"
 #include "track.h"
 #include "song.h"
 #include "xml.h"
@@ -55,6 +58,8 @@
 
 namespace MusECore {
 
+struct ITransformStep;
+
 static int selTypeTable[] = {
       MIDITRANSFORM_NOTE, MIDITRANSFORM_POLY, MIDITRANSFORM_CTRL, MIDITRANSFORM_ATOUCH,
          MIDITRANSFORM_PITCHBEND, MIDITRANSFORM_NRPN, MIDITRANSFORM_RPN, MIDITRANSFORM_PROGRAM
@@ -148,8 +153,7 @@ class MidiInputTransformation {
             procChannelb = 0;
             }
       void write(int level, Xml& xml) const;
-      int apply(MidiRecordEvent& ev);
-      bool typesMatch(MidiRecordEvent& e, int selType) const;
+      void compile(ITransformStep& step);
       };
 
 typedef std::list<MidiInputTransformation*> MidiInputTransformationList;
@@ -170,455 +174,241 @@ const int MIDI_INPUT_TRANSFORMATIONS = 4;
 static ITransModul modules[MIDI_INPUT_TRANSFORMATIONS];
 
 //---------------------------------------------------------
-//   applyMidiInputTransformation
-//    return false if event should be dropped
-//    (filter)
-//---------------------------------------------------------
+//   InputTransformProgram
+//    The enabled modules, compiled by the gui thread into
+//     flat steps. The midi input threads run the steps on
+//     each event and never look at the presets themselves,
+//     so selecting and transforming costs the same few
+//     compares and stores per event whatever the settings.
+//---------------------------------------------------------
+
+struct ITransformStep {
+      unsigned selMask;             // bits of the MIDITRANSFORM_ classes to select
+      bool selInvert;
+      TransformRange val1, val2, port, channel;
+      bool drop;
+      int newType;                  // 0 keeps the type
+      bool setsA;
+      int newA;
+      TransformOp opA, opB, opPort, opChannel;
+      int toggleOff, toggleOn;
+      TransformToggleState* toggleState;
+      };
 
-bool applyMidiInputTransformation(MidiRecordEvent& event)
-      {
-      for (int i = 0; i < 4; ++i) {
-            if (modules[i].valid && modules[i].transform) {
-                  int rv = modules[i].transform->apply(event);
-                  if (rv == 1)
-                  {
-                      if(MusEGlobal::debugMsg)
-                          printf("drop input event\n");
-                  }      
-                  if (rv)
-                        return rv != 1;
-                  }
-            }
-      return true;
-      }
+struct InputTransformProgram {
+      int steps;
+      bool needCtrlType;            // some step selects NRPN or RPN
+      ITransformStep step[MIDI_INPUT_TRANSFORMATIONS];
+      };
+
+static std::atomic<InputTransformProgram*> inputProgram(0);
+// Input threads running inputProgram. There can be several: jack, alsa and synths.
+static std::atomic<int> inputProgramUsers(0);
+
+// Classes of the channel messages by status >> 4.
+static const unsigned char statusClass[16] = {
+      0, 0, 0, 0, 0, 0, 0, 0,
+      1 << MIDITRANSFORM_NOTE, 1 << MIDITRANSFORM_NOTE, 1 << MIDITRANSFORM_POLY,
+      1 << MIDITRANSFORM_CTRL, 1 << MIDITRANSFORM_PROGRAM, 1 << MIDITRANSFORM_ATOUCH,
+      1 << MIDITRANSFORM_PITCHBEND, 0
+      };
 
 //---------------------------------------------------------
-//   filterValOp
+//   inputRandom
+//    Realtime safe, unlike rand(). Concurrent callers may
+//     draw the same number, which does no harm here.
 //---------------------------------------------------------
 
-static bool filterValOp(ValOp op, int val, int val1, int val2)
+static std::atomic<unsigned> inputRandomSeed(1);
+
+static inline int inputRandom()
       {
-      switch (op) {
-            case Ignore:
-                  break;
-            case Equal:
-                  if (val != val1)
-                        return true;
-                  break;
-            case Unequal:
-                  if (val == val1)
-                        return true;
-                  break;
-            case Higher:
-                  if (val <= val1)
-                        return true;
-                  break;
-            case Lower:
-                  if (val >= val1)
-                        return true;
-                  break;
-            case Inside:
-                  if ((val < val1) || (val >= val2))
-                        return true;
-                  break;
-            case Outside:
-                  if ((val >= val1) && (val < val2))
-                        return true;
-                  break;
-            }
-      return false;
+      unsigned s = inputRandomSeed.load(std::memory_order_relaxed) * 1103515245u + 12345u;
+      inputRandomSeed.store(s, std::memory_order_relaxed);
+      return (s >> 16) & 0x7fff;
       }
 
 //---------------------------------------------------------
-//   apply
-//    apply Select filter
-//    return  0 - not applied
-//            1 - drop event
-//            2 - event changed
+//   runOp
 //---------------------------------------------------------
 
-int MidiInputTransformation::apply(MidiRecordEvent& event)
+static inline int runOp(const TransformOp& o, int val)
       {
-      int t = event.type();
-      
-      switch (selEventOp) {
-            case Equal:
-                  switch(t) {
-                        case ME_NOTEON:
-                        case ME_NOTEOFF:
-                              if (selType != MIDITRANSFORM_NOTE)
-                                    return 0;
-                              break;
-                        default:
-                              if(!typesMatch(event, selType))
-                                    return 0;
-                              break;
-                        }
-                  break;
-            case Unequal:
-                  switch(event.type()) {
-                        case ME_NOTEON:
-                        case ME_NOTEOFF:
-                              if (selType == MIDITRANSFORM_NOTE)
-                                    return 0;
-                              break;
-                        default:
-                              if(typesMatch(event, selType))
-                                    return 0;
-                              break;
-                        }
-                  break;
-            default:
+      switch (o.kind) {
+            case TLinear:
+                  return o.k + o.s * val;
+            case TMultiply:
+                  return int(val * o.factor + .5);
+            case TDivide:
+                  return int(val / o.factor + .5);
+            case TRandom:
+                  return o.lo + inputRandom() % o.range;
+            case TToggle:
+            case TDynamic:
+            case TJitter:
                   break;
             }
-      if (filterValOp(selVal1, event.dataA(), selVal1a, selVal1b))
-            return 0;
-      if (filterValOp(selVal2, event.dataB(), selVal2a, selVal2b))
-            return 0;
-      if (filterValOp(selPort, event.port(), selPorta, selPortb))
-            return 0;
-      if (filterValOp(selChannel, event.channel(), selChannela, selChannelb))
-            return 0;
-
-      if (funcOp == Delete)
-            return 1;     // discard event
-
-      // transform event
-//printf("transform\n");
-      if (procEvent != KeepType)
-      {
-        switch(eventType)
-        {
-          case MIDITRANSFORM_POLY:
-            event.setType(ME_POLYAFTER);
-          break;
-          case MIDITRANSFORM_CTRL:
-            event.setType(ME_CONTROLLER);
-          break;
-          case MIDITRANSFORM_ATOUCH:
-            event.setType(ME_AFTERTOUCH);
-          break;
-          case MIDITRANSFORM_PITCHBEND:
-          {
-            event.setType(ME_PITCHBEND);
-          }  
-          break;
-          case MIDITRANSFORM_NRPN: 
-          {
-            event.setA(MidiController::NRPN);
-            event.setType(ME_CONTROLLER);
-          }  
-          break;
-          case MIDITRANSFORM_RPN:
-          {
-            event.setA(MidiController::RPN);
-            event.setType(ME_CONTROLLER);
-          }  
-          break;
-          case MIDITRANSFORM_PROGRAM:
-            event.setType(ME_PROGRAM);
-          break;
-          default:
-          break;
-        }
+      return val;
       }
 
-      //---------------------------------------------------
-      //    transform value A
-      //---------------------------------------------------
-
-      int val = event.dataA();
-      switch (procVal1) {
-            case Keep:
-                  break;
-            case Plus:
-                  val += procVal1a;
-                  break;
-            case Minus:
-                  val -= procVal1a;
-                  break;
-            case Multiply:
-                  val = int(val * (procVal1a/100.0) + .5);
-                  break;
-            case Divide:
-                  val = int(val / (procVal1a/100.0) + .5);
-                  break;
-            case Fix:
-                  val = procVal1a;
-                  break;
-            case Value:
-                  val = procVal2a;
-                  break;
-            case Invert:
-                  val = 127 - val;
-                  break;
-            case ScaleMap:
-                  printf("scale map not implemented\n");
-                  break;
-            case Flip:
-                  val = procVal1a - val;
-                  break;
-            case Dynamic:           // "crescendo"
-                  printf("transform not implemented\n");
-                  break;
-            case Random:
-                  {
-                  int range = procVal1b - procVal1a;
-                  if (range > 0)
-                        val = (rand() % range) + procVal1a;
-                  else if (range < 0)
-                        val = (rand() % -range) + procVal1b;
-                  else
-                        val = procVal1a;
-                  }
-                  break;
-            default:
-                  break;
-            }
-      if (val < 0)
-            val = 0;
-      if (val > 127)
-            val = 127;
-      event.setA(val);
+static inline int clampVal(int val, int hi)
+      {
+      return val < 0 ? 0 : (val > hi ? hi : val);
+      }
 
-      //---------------------------------------------------
-      //    transform value B
-      //---------------------------------------------------
+//---------------------------------------------------------
+//   compile
+//---------------------------------------------------------
 
-      val = event.dataB();
-      switch (procVal2) {
-            case Plus:
-                  val += procVal2a;
-                  break;
-            case Minus:
-                  val -= procVal2a;
-                  break;
-            case Multiply:
-                  val = int(val * (procVal2a/100.0) + .5);
-                  break;
-            case Divide:
-                  val = int(val / (procVal2a/100.0) + .5);
-                  break;
-            case Fix:
-                  val = procVal2a;
-                  break;
-            case Value:
-                  val = procVal1a;
-                  break;
-            case Invert:
-                  val = 127 - val;
-                  break;
-            case Dynamic:
-                  printf("transform not implemented\n");
-                  break;
-            case Random:
-                  {
-                  int range = procVal2b - procVal2a;
-                  if (range > 0)
-                        val = (rand() % range) + procVal2a;
-                  else if (range < 0)
-                        val = (rand() % -range) + procVal2b;
-                  else
-                        val = procVal2a;
-                  }
-                  break;
-            case Toggle:
-                  {
-                    if(event.type() == ME_CONTROLLER)
-                    {
-                      int num = event.dataA();
-                      bool state = toggleState.ctrlState(num);
-                      if(state)
-                      {
-                        state = false;
-                        val = procVal2a;
-                      }
-                      else
-                      {
-                        state = true;
-                        val = procVal2b;
-                      }
-                      toggleState.setCtrlState(num, state);
-                    }
-                    else
-                      printf("toggle implemented only for controllers\n");
+void MidiInputTransformation::compile(ITransformStep& s)
+      {
+      s.selMask   = selEventOp == All ? 0 : 1u << selType;
+      s.selInvert = selEventOp != Equal;
+      s.val1      = compileRange(selVal1, selVal1a, selVal1b);
+      s.val2      = compileRange(selVal2, selVal2a, selVal2b);
+      s.port      = compileRange(selPort, selPorta, selPortb);
+      s.channel   = compileRange(selChannel, selChannela, selChannelb);
+      s.drop      = funcOp == Delete;
+
+      s.newType = 0;
+      s.setsA   = false;
+      s.newA    = 0;
+      if (procEvent != KeepType) {
+            switch (eventType) {
+                  case MIDITRANSFORM_POLY:      s.newType = ME_POLYAFTER;  break;
+                  case MIDITRANSFORM_CTRL:      s.newType = ME_CONTROLLER; break;
+                  case MIDITRANSFORM_ATOUCH:    s.newType = ME_AFTERTOUCH; break;
+                  case MIDITRANSFORM_PITCHBEND: s.newType = ME_PITCHBEND;  break;
+                  case MIDITRANSFORM_PROGRAM:   s.newType = ME_PROGRAM;    break;
+                  case MIDITRANSFORM_NRPN:
+                        s.newType = ME_CONTROLLER;
+                        s.setsA   = true;
+                        s.newA    = MidiController::NRPN;
+                        break;
+                  case MIDITRANSFORM_RPN:
+                        s.newType = ME_CONTROLLER;
+                        s.setsA   = true;
+                        s.newA    = MidiController::RPN;
+                        break;
+                  default:
+                        break;
                   }
-                  break;
-            case ScaleMap:
-            case Keep:
-            case Flip:
-                  break;
             }
-      if (val < 0)
-            val = 0;
-      if (val > 127)
-            val = 127;
-      event.setB(val);
-
-      //---------------------------------------------------
-      //    transform port
-      //---------------------------------------------------
-
-      val = event.port();
-      switch (procPort) {
-            case Plus:
-                  val += procPorta;
-                  break;
-            case Minus:
-                  val -= procPorta;
-                  break;
-            case Multiply:
-                  val = int(val * (procPorta/100.0) + .5);
-                  break;
-            case Divide:
-                  val = int(val / (procPorta/100.0) + .5);
-                  break;
-            case Fix:
-                  val = procPorta;
-                  break;
-            case Value:
-                  val = procPorta;
-                  break;
-            case Invert:
-                  val = 15 - val;
-                  break;
-            case Dynamic:
+      s.opA       = compileOp(procVal1, procVal1a, procVal1b, procVal2a, 127, true, procVal1a);
+      s.opB       = compileOp(procVal2, procVal2a, procVal2b, procVal1a, 127, false, procVal2a);
+      s.opPort    = compileOp(procPort, procPorta, procPortb, procPorta, 15, false, procPorta);
+      s.opChannel = compileOp(procChannel, procChannela, procChannelb, procChannela, 16, false, procChannela);
+      const TransformOperator ops[4] = { procVal1, procVal2, procPort, procChannel };
+      for (int i = 0; i < 4; ++i)
+            if (ops[i] == ScaleMap || ops[i] == Dynamic)
                   printf("transform not implemented\n");
-                  break;
-            case Random:
-                  {
-                  int range = procPortb - procPorta;
-                  if (range > 0)
-                        val = (rand() % range) + procPorta;
-                  else if (range < 0)
-                        val = (rand() % -range) + procPortb;
-                  else
-                        val = procPorta;
-                  }
-                  break;
-            case ScaleMap:
-            case Keep:
-            case Flip:
-            case Toggle:
-                  break;
-            }
-      if (val < 0)
-            val = 0;
-      if (val > 15)
-            val = 15;
-      event.setPort(val);
+      if (procVal2 == Toggle)
+            s.opB.kind = TToggle;
+      s.toggleOff   = procVal2a;
+      s.toggleOn    = procVal2b;
+      s.toggleState = &toggleState;
+      }
 
-      //---------------------------------------------------
-      //    transform channel
-      //---------------------------------------------------
+//---------------------------------------------------------
+//   updateInputTransformProgram
+//    Gui thread. Recompiles the enabled modules, after any
+//     change to them or to their presets.
+//---------------------------------------------------------
 
-      val = event.channel();
-      switch (procChannel) {
-            case Plus:
-                  val += procChannela;
-                  break;
-            case Minus:
-                  val -= procChannela;
-                  break;
-            case Multiply:
-                  val = int(val * (procChannela/100.0) + .5);
-                  break;
-            case Divide:
-                  val = int(val / (procChannela/100.0) + .5);
-                  break;
-            case Fix:
-                  val = procChannela;
-                  break;
-            case Value:
-                  val = procChannela;
-                  break;
-            case Invert:
-                  val = 16 - val;
-                  break;
-            case Dynamic:
-                  printf("transform not implemented\n");
-                  break;
-            case Random:
-                  {
-                  int range = procChannelb - procChannela;
-                  if (range > 0)
-                        val = (rand() % range) + procChannela;
-                  else if (range < 0)
-                        val = (rand() % -range) + procChannelb;
-                  else
-                        val = procChannela;
+static void updateInputTransformProgram()
+      {
+      InputTransformProgram* p = 0;
+      for (int i = 0; i < MIDI_INPUT_TRANSFORMATIONS; ++i) {
+            if (!modules[i].valid || !modules[i].transform)
+                  continue;
+            if (!p) {
+                  p = new InputTransformProgram;
+                  p->steps = 0;
+                  p->needCtrlType = false;
                   }
-                  break;
-            case ScaleMap:
-            case Keep:
-            case Flip:
-            case Toggle:
-                  break;
+            MidiInputTransformation* t = modules[i].transform;
+            t->compile(p->step[p->steps++]);
+            if (t->selEventOp != All && (t->selType == MIDITRANSFORM_NRPN || t->selType == MIDITRANSFORM_RPN))
+                  p->needCtrlType = true;
             }
-      if (val < 0)
-            val = 0;
-      if (val > 15)
-            val = 15;
-      event.setChannel(val);
-
-      return 2;
+      InputTransformProgram* old = inputProgram.exchange(p);
+      if (!old)
+            return;
+      // An input thread may still be running the old program. It is only held for one event.
+      while (inputProgramUsers.load() != 0)
+            std::this_thread::yield();
+      delete old;
       }
 
 //---------------------------------------------------------
-//   typesMatch
+//   applyMidiInputTransformation
+//    return false if event should be dropped
+//    (filter)
+//    The first step which selects the event decides.
 //---------------------------------------------------------
 
-bool MidiInputTransformation::typesMatch(MidiRecordEvent& e, int selType) const
+bool applyMidiInputTransformation(MidiRecordEvent& event)
       {
-      bool matched = false;
-      int t = e.type();
-      switch (selType)
-         {
-         case MIDITRANSFORM_NOTE:
-            matched = ((t == ME_NOTEON) || (t == ME_NOTEOFF));
-            break;
-         case MIDITRANSFORM_POLY:
-            matched = (t == ME_POLYAFTER);
-            break;
-         case MIDITRANSFORM_CTRL:
-            matched = (t == ME_CONTROLLER);
-            break;
-         case MIDITRANSFORM_ATOUCH:
-            matched = (t == ME_AFTERTOUCH);
-            break;
-         case MIDITRANSFORM_PITCHBEND:
-            {
-            //if (t == ME_CONTROLLER) {
-            //      MidiController::ControllerType c = midiControllerType(e.dataA());
-            //      matched = (c == MidiController::Pitch);
-            matched = (t = ME_PITCHBEND);
-            }
-            break;
-         case MIDITRANSFORM_NRPN:
-            {
-            if (t == ME_CONTROLLER) {
-                  MidiController::ControllerType c = midiControllerType(e.dataA());
-                  matched = (c == MidiController::NRPN);
+      if (!inputProgram.load(std::memory_order_relaxed))
+            return true;
+
+      bool keep = true;
+      inputProgramUsers.fetch_add(1);
+      const InputTransformProgram* p = inputProgram.load();
+      if (p) {
+            const int t = event.type();
+            unsigned cls = statusClass[(t >> 4) & 0xf];
+            if (p->needCtrlType && t == ME_CONTROLLER) {
+                  MidiController::ControllerType c = midiControllerType(event.dataA());
+                  if (c == MidiController::NRPN)
+                        cls |= 1 << MIDITRANSFORM_NRPN;
+                  else if (c == MidiController::RPN)
+                        cls |= 1 << MIDITRANSFORM_RPN;
                   }
-            }
-            break;
-         case MIDITRANSFORM_RPN:
-            {
-            if (t == ME_CONTROLLER) {
-                  MidiController::ControllerType c = midiControllerType(e.dataA());
-                  matched = (c == MidiController::RPN);
+            const int a    = event.dataA();
+            const int b    = event.dataB();
+            const int port = event.port();
+            const int ch   = event.channel();
+
+            for (int i = 0; i < p->steps; ++i) {
+                  const ITransformStep& s = p->step[i];
+                  const bool selected = (((cls & s.selMask) != 0) != s.selInvert)
+                     & s.val1.pass(a) & s.val2.pass(b) & s.port.pass(port) & s.channel.pass(ch);
+                  if (!selected)
+                        continue;
+                  if (s.drop) {
+                        if (MusEGlobal::debugMsg)
+                              printf("drop input event\n");
+                        keep = false;
+                        break;
+                        }
+                  if (s.newType) {
+                        if (s.setsA)
+                              event.setA(s.newA);
+                        event.setType(s.newType);
+                        }
+                  event.setA(clampVal(runOp(s.opA, event.dataA()), 127));
+                  int val = event.dataB();
+                  if (s.opB.kind == TToggle) {
+                        if (event.type() == ME_CONTROLLER) {
+                              const int num = event.dataA();
+                              const bool state = s.toggleState->ctrlState(num);
+                              val = state ? s.toggleOff : s.toggleOn;
+                              s.toggleState->setCtrlState(num, !state);
+                              }
+                        else if (MusEGlobal::debugMsg)
+                              printf("toggle implemented only for controllers\n");
+                        }
+                  else
+                        val = runOp(s.opB, val);
+                  event.setB(clampVal(val, 127));
+                  event.setPort(clampVal(runOp(s.opPort, event.port()), 15));
+                  event.setChannel(clampVal(runOp(s.opChannel, event.channel()), 15));
+                  break;
                   }
             }
-            break;
-         case MIDITRANSFORM_PROGRAM:
-            matched = (t == ME_PROGRAM);
-            break;
-         default:
-            fprintf(stderr, "Error matching type in MidiTransformerDialog: unknown eventtype!\n");
-            break;
-         }
-      //printf("Event type=%d, selType =%d matched=%d\n", e.type(), selType, matched);
-      return matched;
+      inputProgramUsers.fetch_sub(1);
+      return keep;
       }
 
 //---------------------------------------------------------
@@ -822,6 +612,7 @@ void readMidiInputTransform(Xml& xml)
                                           }
                                     }
                               mtlist.push_back(t);
+                              updateInputTransformProgram();
                               return;
                               }
                   default:
@@ -841,6 +632,8 @@ void clearMidiInputTransforms()
     modules[i].transform = 0;
     modules[i].valid = false;
   }
+  // Take the program away from the input threads before deleting what it points to.
+  updateInputTransformProgram();
   for (iMidiInputTransformation i = mtlist.begin(); i != mtlist.end(); ++i) 
   {
     MidiInputTransformation* t = *i;
@@ -1062,6 +855,7 @@ void MidiInputTransformDialog::selEventOpSel(int val)
       cmt->selEventOp = MusECore::ValOp(val);
       selVal1aChanged(cmt->selVal1a);
       selVal1bChanged(cmt->selVal1b);
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1073,6 +867,7 @@ void MidiInputTransformDialog::selTypeSel(int val)
       cmt->selType = MusECore::selTypeTable[val];
       selVal1aChanged(cmt->selVal1a);
       selVal1bChanged(cmt->selVal1b);
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1083,6 +878,7 @@ void MidiInputTransformDialog::selVal1OpSel(int val)
       {
       setValOp(selVal1a, selVal1b, MusECore::ValOp(val));
       cmt->selVal1 = MusECore::ValOp(val);
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1093,6 +889,7 @@ void MidiInputTransformDialog::selVal2OpSel(int val)
       {
       setValOp(selVal2a, selVal2b, MusECore::ValOp(val));
       cmt->selVal2 = MusECore::ValOp(val);
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1107,6 +904,7 @@ void MidiInputTransformDialog::procEventOpSel(int val)
       
       procVal1aChanged(cmt->procVal1a);
       procVal1bChanged(cmt->procVal1b);
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1118,6 +916,7 @@ void MidiInputTransformDialog::procEventTypeSel(int val)
       cmt->eventType = MusECore::procTypeTable[val];
       procVal1aChanged(cmt->procVal1a);
       procVal1bChanged(cmt->procVal1b);
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1159,6 +958,7 @@ void MidiInputTransformDialog::procVal1OpSel(int val)
             }
       procVal1aChanged(cmt->procVal1a);
       procVal1bChanged(cmt->procVal1b);
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1170,6 +970,7 @@ void MidiInputTransformDialog::procVal2OpSel(int val)
       MusECore::TransformOperator op = MusECore::TransformOperator(MusECore::procVal2Map[val]);
       cmt->procVal2 = op;
       procVal2OpUpdate(op);
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1242,6 +1043,7 @@ void MidiInputTransformDialog::funcOpSel(int val)
             procChannelOpSel(cmt->procChannel);
             }
       cmt->funcOp = op;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1331,6 +1133,7 @@ void MidiInputTransformDialog::selVal1aChanged(int val)
             if(!selVal1a->suffix().isEmpty())
               selVal1a->setSuffix(QString(""));
       }      
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1349,6 +1152,7 @@ void MidiInputTransformDialog::selVal1bChanged(int val)
             if(!selVal1b->suffix().isEmpty())
               selVal1b->setSuffix(QString(""));
       }      
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1358,6 +1162,7 @@ void MidiInputTransformDialog::selVal1bChanged(int val)
 void MidiInputTransformDialog::selVal2aChanged(int val)
       {
       cmt->selVal2a = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1367,6 +1172,7 @@ void MidiInputTransformDialog::selVal2aChanged(int val)
 void MidiInputTransformDialog::selVal2bChanged(int val)
       {
       cmt->selVal2b = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1388,6 +1194,7 @@ void MidiInputTransformDialog::procVal1aChanged(int val)
             if(!procVal1a->suffix().isEmpty())
               procVal1a->setSuffix(QString(""));
       }      
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1409,6 +1216,7 @@ void MidiInputTransformDialog::procVal1bChanged(int val)
             if(!procVal1b->suffix().isEmpty())
               procVal1b->setSuffix(QString(""));
       }      
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1418,6 +1226,7 @@ void MidiInputTransformDialog::procVal1bChanged(int val)
 void MidiInputTransformDialog::procVal2aChanged(int val)
       {
       cmt->procVal2a = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1427,6 +1236,7 @@ void MidiInputTransformDialog::procVal2aChanged(int val)
 void MidiInputTransformDialog::procVal2bChanged(int val)
       {
       cmt->procVal2b = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1436,6 +1246,7 @@ void MidiInputTransformDialog::procVal2bChanged(int val)
 void MidiInputTransformDialog::modul1enableChanged(bool val)
       {
       MusECore::modules[0].valid = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1445,6 +1256,7 @@ void MidiInputTransformDialog::modul1enableChanged(bool val)
 void MidiInputTransformDialog::modul2enableChanged(bool val)
       {
       MusECore::modules[1].valid = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1454,6 +1266,7 @@ void MidiInputTransformDialog::modul2enableChanged(bool val)
 void MidiInputTransformDialog::modul3enableChanged(bool val)
       {
       MusECore::modules[2].valid = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1463,6 +1276,7 @@ void MidiInputTransformDialog::modul3enableChanged(bool val)
 void MidiInputTransformDialog::modul4enableChanged(bool val)
       {
       MusECore::modules[3].valid = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1473,6 +1287,7 @@ void MidiInputTransformDialog::selPortOpSel(int val)
       {
       setValOp(selPortVala, selPortValb, MusECore::ValOp(val));
       cmt->selPort = MusECore::ValOp(val);
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1482,6 +1297,7 @@ void MidiInputTransformDialog::selPortOpSel(int val)
 void MidiInputTransformDialog::selPortValaChanged(int val)
       {
       cmt->selPorta = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1491,6 +1307,7 @@ void MidiInputTransformDialog::selPortValaChanged(int val)
 void MidiInputTransformDialog::selPortValbChanged(int val)
       {
       cmt->selPortb = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1501,6 +1318,7 @@ void MidiInputTransformDialog::selChannelOpSel(int val)
       {
       setValOp(selChannelVala, selChannelValb, MusECore::ValOp(val));
       cmt->selChannel = MusECore::ValOp(val);
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1510,6 +1328,7 @@ void MidiInputTransformDialog::selChannelOpSel(int val)
 void MidiInputTransformDialog::selChannelValaChanged(int val)
       {
       cmt->selChannela = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1519,6 +1338,7 @@ void MidiInputTransformDialog::selChannelValaChanged(int val)
 void MidiInputTransformDialog::selChannelValbChanged(int val)
       {
       cmt->selChannelb = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1558,6 +1378,7 @@ void MidiInputTransformDialog::procPortOpSel(int val)
                   procPortValb->setEnabled(true);
                   break;
             }
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1567,6 +1388,7 @@ void MidiInputTransformDialog::procPortOpSel(int val)
 void MidiInputTransformDialog::procPortValaChanged(int val)
       {
       cmt->procPorta = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1576,6 +1398,7 @@ void MidiInputTransformDialog::procPortValaChanged(int val)
 void MidiInputTransformDialog::procPortValbChanged(int val)
       {
       cmt->procPortb = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1615,6 +1438,7 @@ void MidiInputTransformDialog::procChannelOpSel(int val)
                   procChannelValb->setEnabled(true);
                   break;
             }
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1624,6 +1448,7 @@ void MidiInputTransformDialog::procChannelOpSel(int val)
 void MidiInputTransformDialog::procChannelValaChanged(int val)
       {
       cmt->procChannela = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1633,6 +1458,7 @@ void MidiInputTransformDialog::procChannelValaChanged(int val)
 void MidiInputTransformDialog::procChannelValbChanged(int val)
       {
       cmt->procChannelb = val;
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1665,6 +1491,7 @@ void MidiInputTransformDialog::changeModul(int k)
             if (i == MusECore::mtlist.end())
                   printf("change to unknown transformation!\n");
             }
+      MusECore::updateInputTransformProgram();
       }
 
 //---------------------------------------------------------
@@ -1732,6 +1559,7 @@ void MidiInputTransformDialog::presetChanged(QListWidgetItem* item)
       if (i == sizeof(MusECore::oplist)/sizeof(*MusECore::oplist))
             printf("internal error: bad OpCode\n");
       funcOpSel(i);
+      MusECore::updateInputTransformProgram();
       }
 
       for (unsigned i = 0; i < sizeof(MusECore::procTypeTable)/sizeof(*MusECore::procTypeTable); ++i) {
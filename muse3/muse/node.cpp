@@ -39,6 +39,9 @@
 #include "audiodev.h"
 #include "audio.h"
 #include "wave.h"
+#include "latency_compensator.h"
+#include "audiobuffers.h"
+#include "trackfreeze.h"
 #include "utils.h"      //debug
 #include "ticksynth.h"  // metronome
 #include "wavepreview.h"
@@ -532,91 +535,6 @@ void AudioTrack::processTrackCtrls(unsigned pos, int trackChans, unsigned nframe
           dp2  = outBuffers[1] + sample;
         }
 
-        if(trackChans != 2)
-        {
-          const int start_ch = trackChans == 1 ? 0 : 2;
-
-          k = 0;
-          if(vol_interp.doInterp && MusEGlobal::audio->isPlaying())
-          {
-            for( ; k < nsamp; ++k)
-            {
-              _volume = vol_ctrl->interpolate(slice_frame + k, vol_interp);
-              v = _volume * _gain;
-              if(v > _curVolume)
-              {
-                if(_curVolume == 0.0)
-                  _curVolume = 0.001;  // Kick-start it from zero at -30dB.
-                _curVolume *= up_fact;
-                if(_curVolume >= v)
-                  _curVolume = v;
-              }
-              else
-              if(v < _curVolume)
-              {
-                _curVolume *= down_fact;
-                if(_curVolume <= v || _curVolume <= 0.001)  // Or if less than -30dB.
-                  _curVolume = v;
-              }
-              const unsigned long smp = sample + k;
-              for(int ch = start_ch; ch < trackChans; ++ch)
-                *(outBuffers[ch] + smp) = *(buffer[ch] + smp) * _curVolume;
-            }
-            _controls[AC_VOLUME].dval = _volume;    // Update the port.
-          }
-          else
-          {
-            if(vol_interp.doInterp) // And not playing...
-              _volume = vol_ctrl->interpolate(pos, vol_interp);
-            else
-              _volume = vol_interp.sVal;
-            _controls[AC_VOLUME].dval = _volume;    // Update the port.
-            v = _volume * _gain;
-            if(v > _curVolume)
-            {
-              //fprintf(stderr, "A %f %f\n", v, _curVolume);
-              if(_curVolume == 0.0)
-                _curVolume = 0.001;  // Kick-start it from zero at -30dB.
-              for( ; k < nsamp; ++k)
-              {
-                _curVolume *= up_fact;
-                if(_curVolume >= v)
-                {
-                  _curVolume = v;
-                  break;
-                }
-                const unsigned long smp = sample + k;
-                for(int ch = start_ch; ch < trackChans; ++ch)
-                  *(outBuffers[ch] + smp) = *(buffer[ch] + smp) * _curVolume;
-              }
-            }
-            else
-            if(v < _curVolume)
-            {
-              //fprintf(stderr, "B %f %f\n", v, _curVolume);
-              for( ; k < nsamp; ++k)
-              {
-                _curVolume *= down_fact;
-                if(_curVolume <= v || _curVolume <= 0.001)  // Or if less than -30dB.
-                {
-                  _curVolume = v;
-                  break;
-                }
-                const unsigned long smp = sample + k;
-                for(int ch = start_ch; ch < trackChans; ++ch)
-                  *(outBuffers[ch] + smp) = *(buffer[ch] + smp) * _curVolume;
-              }
-            }
-
-            const unsigned long next_smp = sample + nsamp;
-            for(unsigned long smp = sample + k; smp < next_smp; ++smp)
-            {
-              for(int ch = start_ch; ch < trackChans; ++ch)
-                *(outBuffers[ch] + smp) = *(buffer[ch] + smp) * _curVolume;
-            }
-          }
-        }
-
         k = 0;
         if((vol_interp.doInterp || pan_interp.doInterp) && MusEGlobal::audio->isPlaying())
         {
@@ -752,6 +670,93 @@ void AudioTrack::processTrackCtrls(unsigned pos, int trackChans, unsigned nframe
           for( ; k < nsamp; ++k)
             *dp2++ = *sp2++ * _curVol2;
         }
+
+        // Mono tracks may be processed in place, with buffer[0] being outBuffers[0].
+        // So the pan pass above must read buffer[0] before the volume pass overwrites it.
+        if(trackChans != 2)
+        {
+          const int start_ch = trackChans == 1 ? 0 : 2;
+
+          k = 0;
+          if(vol_interp.doInterp && MusEGlobal::audio->isPlaying())
+          {
+            for( ; k < nsamp; ++k)
+            {
+              _volume = vol_ctrl->interpolate(slice_frame + k, vol_interp);
+              v = _volume * _gain;
+              if(v > _curVolume)
+              {
+                if(_curVolume == 0.0)
+                  _curVolume = 0.001;  // Kick-start it from zero at -30dB.
+                _curVolume *= up_fact;
+                if(_curVolume >= v)
+                  _curVolume = v;
+              }
+              else
+              if(v < _curVolume)
+              {
+                _curVolume *= down_fact;
+                if(_curVolume <= v || _curVolume <= 0.001)  // Or if less than -30dB.
+                  _curVolume = v;
+              }
+              const unsigned long smp = sample + k;
+              for(int ch = start_ch; ch < trackChans; ++ch)
+                *(outBuffers[ch] + smp) = *(buffer[ch] + smp) * _curVolume;
+            }
+            _controls[AC_VOLUME].dval = _volume;    // Update the port.
+          }
+          else
+          {
+            if(vol_interp.doInterp) // And not playing...
+              _volume = vol_ctrl->interpolate(pos, vol_interp);
+            else
+              _volume = vol_interp.sVal;
+            _controls[AC_VOLUME].dval = _volume;    // Update the port.
+            v = _volume * _gain;
+            if(v > _curVolume)
+            {
+              //fprintf(stderr, "A %f %f\n", v, _curVolume);
+              if(_curVolume == 0.0)
+                _curVolume = 0.001;  // Kick-start it from zero at -30dB.
+              for( ; k < nsamp; ++k)
+              {
+                _curVolume *= up_fact;
+                if(_curVolume >= v)
+                {
+                  _curVolume = v;
+                  break;
+                }
+                const unsigned long smp = sample + k;
+                for(int ch = start_ch; ch < trackChans; ++ch)
+                  *(outBuffers[ch] + smp) = *(buffer[ch] + smp) * _curVolume;
+              }
+            }
+            else
+            if(v < _curVolume)
+            {
+              //fprintf(stderr, "B %f %f\n", v, _curVolume);
+              for( ; k < nsamp; ++k)
+              {
+                _curVolume *= down_fact;
+                if(_curVolume <= v || _curVolume <= 0.001)  // Or if less than -30dB.
+                {
+                  _curVolume = v;
+                  break;
+                }
+                const unsigned long smp = sample + k;
+                for(int ch = start_ch; ch < trackChans; ++ch)
+                  *(outBuffers[ch] + smp) = *(buffer[ch] + smp) * _curVolume;
+              }
+            }
+
+            const unsigned long next_smp = sample + nsamp;
+            for(unsigned long smp = sample + k; smp < next_smp; ++smp)
+            {
+              for(int ch = start_ch; ch < trackChans; ++ch)
+                *(outBuffers[ch] + smp) = *(buffer[ch] + smp) * _curVolume;
+            }
+          }
+        }
       }
 
 #ifdef NODE_DEBUG_PROCESS
@@ -812,7 +817,7 @@ void AudioTrack::copyData(unsigned pos,
 
   int i;
 
-  // Protection for pre-allocated _dataBuffers.
+  // Protection for pre-allocated outBuffers.
   if(nframes > MusEGlobal::segmentSize)
   {
     fprintf(stderr, "MusE: Error: AudioTrack::copyData: nframes:%u > segmentSize:%u\n", nframes, MusEGlobal::segmentSize);
@@ -997,9 +1002,14 @@ void AudioTrack::copyData(unsigned pos,
       return;
     }
 
-    // Point the input buffers at a temporary buffer.
+    // Process in place, in the cache buffers. Nothing reads them until _haveData is set below,
+    //  and getData only pulls from other tracks, so they are free until then.
     for(i = 0; i < srcTotalOutChans; ++i)
-        buffer[i] = _dataBuffers[i];
+        buffer[i] = outBuffers[i];
+
+    // A frozen track streams its cache instead of running its sources, and also its rack if frozen post-rack.
+    const int freezeState = _freeze->state();
+    const bool rackFrozen = freezeState == TrackFreeze::Frozen && _freeze->mode() == TrackFreeze::PostRack;
 
     // getData can use the supplied buffers, or change buffer to point to its own local buffers or Jack buffers etc.
     // For ex. if this is an audio input, Jack will set the pointers for us in AudioInput::getData!
@@ -1007,7 +1017,10 @@ void AudioTrack::copyData(unsigned pos,
     //  so still call getData before it. Off is NOT meant to be toggled rapidly, but mute is !
     // Since the meters are cleared above, getData can contribute (add) to them directly and return HaveMeterDataOnly
     //  if it does not want to pass the audio for listening.
-    if(!getData(pos, srcTotalOutChans, nframes, buffer))
+    const bool have_data = (freezeState == TrackFreeze::Frozen) ?
+                           _freeze->getData(pos, trackChans, srcTotalOutChans, nframes, buffer) :
+                           getData(pos, srcTotalOutChans, nframes, buffer);
+    if(!have_data)
     {
       #ifdef NODE_DEBUG_PROCESS
       fprintf(stderr, "MusE: AudioTrack::copyData name:%s srcTotalOutChans:%d zeroing buffers\n", name().toLatin1().constData(), srcTotalOutChans);
@@ -1031,8 +1044,25 @@ void AudioTrack::copyData(unsigned pos,
     // apply plugin chain
     //---------------------------------------------------
 
+    if(freezeState == TrackFreeze::Capturing && _freeze->mode() == TrackFreeze::PreRack)
+      _freeze->capture(pos, trackChans, nframes, buffer);
+
     // Allow it to process even if muted so that when mute is turned off, left-over buffers (reverb tails etc) can die away.
-    _efxPipe->apply(pos, trackChans, nframes, buffer);
+    if(rackFrozen)
+      _efxPipe->apply(pos, 0, nframes, 0);  // Just process controls only, the cache has the rack applied.
+    else
+      _efxPipe->apply(pos, trackChans, nframes, buffer,
+                      liveMonitorBypass() ? (float)MusEGlobal::config.liveMonitoringMaxLatency : -1.0);
+
+    if(freezeState == TrackFreeze::Capturing && _freeze->mode() == TrackFreeze::PostRack)
+      _freeze->capture(pos, trackChans, nframes, buffer);
+
+    //---------------------------------------------------
+    // line up with the other signals at our destinations
+    //---------------------------------------------------
+
+    if(_compDelay != 0)
+      _latencyComp->run(nframes, trackChans, buffer);
 
     //---------------------------------------------------
     // apply volume, pan
@@ -1088,8 +1118,10 @@ void AudioTrack::copyData(unsigned pos,
     }
 
     // Copy whole blocks that we can get away with here outside of the track control processing loop.
+    // Unless getData pointed them elsewhere, they are already there.
     for(i = valid_out_bufs; i < srcTotalOutChans; ++i)
-      AL::dsp->cpy(outBuffers[i], buffer[i], nframes);
+      if(outBuffers[i] != buffer[i])
+        AL::dsp->cpy(outBuffers[i], buffer[i], nframes);
 
     // We now have some data! Set to true.
     _haveData = true;
@@ -2016,20 +2048,6 @@ void AudioTrack::setTotalOutChannels(int num)
       int chans = _totalOutChannels;
       if(num != chans)
       {
-        if(_dataBuffers)
-        {
-          for(int i = 0; i < _totalOutChannels; ++i)
-          {
-            if(_dataBuffers[i])
-            {
-              free(_dataBuffers[i]);
-              _dataBuffers[i] = NULL;
-            }
-          }
-          delete[] _dataBuffers;
-          _dataBuffers = NULL;
-        }
-
         _totalOutChannels = num;
         int new_chans = num;
         // Number of allocated buffers is always MAX_CHANNELS or more, even if _totalOutChannels is less.
@@ -2043,11 +2061,8 @@ void AudioTrack::setTotalOutChannels(int num)
           {
             for(int i = 0; i < chans; ++i)
             {
-              if(outBuffers[i])
-              {
-                free(outBuffers[i]);
-                outBuffers[i] = NULL;
-              }
+              freeAudioBuffer(outBuffers[i]);
+              outBuffers[i] = NULL;
             }
             delete[] outBuffers;
             outBuffers = NULL;
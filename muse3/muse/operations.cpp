@@ -22,6 +22,8 @@
 
 #include "operations.h"
 #include "song.h"
+#include "audio.h"
+#include "midiplayback.h"
 
 // Enable for debugging:
 //#define _PENDING_OPS_DEBUG_
@@ -200,6 +202,17 @@ unsigned int PendingOperationItem::getIndex() const
   }
 }  
 
+//---------------------------------------------------------
+//   invalidatePlayback
+//    Marks a midi track's compiled playback stream stale.
+//---------------------------------------------------------
+
+static void invalidatePlayback(Track* track)
+{
+  if(track && track->isMidiTrack())
+    static_cast<MidiTrack*>(track)->playback()->invalidate();
+}
+
 SongChangedStruct_t PendingOperationItem::executeRTStage()
 {
     SongChangedStruct_t flags = 0;
@@ -957,6 +970,7 @@ SongChangedStruct_t PendingOperationItem::executeRTStage()
 #endif      
       _part_list->add(_part);
       _part->rechainClone();
+      invalidatePlayback(_part->track());
       // Be sure to mark the part as not deleted if it exists in the global copy/paste clone list.
       for(iClone i = MusEGlobal::cloneList.begin(); i != MusEGlobal::cloneList.end(); ++i) 
       {
@@ -979,6 +993,7 @@ SongChangedStruct_t PendingOperationItem::executeRTStage()
       Part* p = _iPart->second;
       _part_list->erase(_iPart);
       p->unchainClone();
+      invalidatePlayback(p->track());
       // Be sure to mark the part as deleted if it exists in the global copy/paste clone list.
       for(iClone i = MusEGlobal::cloneList.begin(); i != MusEGlobal::cloneList.end(); ++i) 
       {
@@ -1001,6 +1016,7 @@ SongChangedStruct_t PendingOperationItem::executeRTStage()
 #endif      
       //_part->type() == Pos::FRAMES ? _part->setLenFrame(_posLenVal) : _part->setLenTick(_posLenVal);
       _part->setLenValue(_posLenVal);
+      invalidatePlayback(_part->track());
       flags |= SC_PART_MODIFIED;
     break;
     
@@ -1008,6 +1024,8 @@ SongChangedStruct_t PendingOperationItem::executeRTStage()
 #ifdef _PENDING_OPS_DEBUG_
       fprintf(stderr, "PendingOperationItem::executeRTStage MovePart part:%p track:%p new_pos:%u\n", _part, _track, _posLenVal);
 #endif      
+      invalidatePlayback(_part->track());
+      invalidatePlayback(_track);
       if(_track)
       {
         if(_part->track() && _iPart != _part->track()->parts()->end())
@@ -1054,6 +1072,7 @@ SongChangedStruct_t PendingOperationItem::executeRTStage()
       _ev.dump();
 #endif      
       _part->addEvent(_ev);
+      invalidatePlayback(_part->track());
 #ifdef _PENDING_OPS_DEBUG_
       fprintf(stderr, "PendingOperationItem::executeRTStage AddEvent post:   ");
       _ev.dump();
@@ -1067,6 +1086,7 @@ SongChangedStruct_t PendingOperationItem::executeRTStage()
       _ev.dump();
 #endif      
       _part->nonconst_events().erase(_iev);
+      invalidatePlayback(_part->track());
 #ifdef _PENDING_OPS_DEBUG_
       fprintf(stderr, "PendingOperationItem::executeRTStage DeleteEvent post:   ");
       _ev.dump();
@@ -1463,7 +1483,12 @@ SongChangedStruct_t PendingOperationList::executeRTStage()
   {
     MusEGlobal::song->updateSoloStates();
     _sc_flags |= SC_SOLO;
+    // The route graph changed. Rebuild the plugin delay compensation.
+    MusEGlobal::audio->setLatencyDirty();
   } 
+  // Drum maps and instruments are shared by many tracks. Recompile them all.
+  if(_sc_flags._flags & (SC_DRUMMAP | SC_MIDI_INSTRUMENT | SC_CONFIG))
+    invalidateMidiPlayback();
   
   return _sc_flags;
 }
@@ -37,6 +37,7 @@
 #include "drummap.h"
 #include "midictrl.h"
 #include "operations.h"
+#include "midiplayback.h"
 
 namespace MusECore {
 
@@ -95,6 +96,18 @@ void Part::rechainClone()
     }
 }
 
+//---------------------------------------------------------
+//   setMute
+//---------------------------------------------------------
+
+void Part::setMute(bool b)
+{
+	_mute = b;
+	// Muted parts are left out of the compiled playback stream.
+	if(_track && _track->isMidiTrack())
+		static_cast<MidiTrack*>(_track)->playback()->invalidate();
+}
+
 bool Part::isCloneOf(const Part* other) const
 {
 	return this->_clonemaster_sn == other->_clonemaster_sn;
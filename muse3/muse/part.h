@@ -108,7 +108,7 @@ class Part : public PosLen {
       // Returns true if anything changed.
       bool selectEvents(bool select, unsigned long t0 = 0, unsigned long t1 = 0);
       bool mute() const                { return _mute; }
-      void setMute(bool b)             { _mute = b; }
+      void setMute(bool b);
       Track* track() const             { return _track; }
       void setTrack(Track*t)           { _track = t; }
       const EventList& events() const  { return _events; }
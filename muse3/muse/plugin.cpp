@@ -49,6 +49,7 @@
 #include "slider.h"
 #include "midictrl_consts.h"
 #include "plugin.h"
+#include "audiobuffers.h"
 #include "controlfifo.h"
 #include "xml.h"
 #include "icons.h"
@@ -1100,9 +1101,8 @@ Plugin* PluginList::find(const QString& file, const QString& label) const
 Pipeline::Pipeline()
    : std::vector<PluginI*>()
       {
-      for(int i = 0; i < MusECore::MAX_CHANNELS; ++i)
-        buffer[i] = NULL;
-      initBuffers();
+      // The scratch buffers are shared by all pipelines.
+      MusEGlobal::audioBufferPool.prepare();
 
       for (int i = 0; i < MusECore::PipelineDepth; ++i)
             push_back(0);
@@ -1115,9 +1115,8 @@ Pipeline::Pipeline()
 Pipeline::Pipeline(const Pipeline& p, AudioTrack* t)
    : std::vector<PluginI*>()
       {
-      for(int i = 0; i < MusECore::MAX_CHANNELS; ++i)
-        buffer[i] = NULL;
-      initBuffers();
+      // The scratch buffers are shared by all pipelines.
+      MusEGlobal::audioBufferPool.prepare();
 
       for(int i = 0; i < MusECore::PipelineDepth; ++i)
       {
@@ -1153,60 +1152,27 @@ Pipeline::Pipeline(const Pipeline& p, AudioTrack* t)
 Pipeline::~Pipeline()
       {
       removeAll();
-      for (int i = 0; i < MusECore::MAX_CHANNELS; ++i)
-          if(buffer[i])
-            ::free(buffer[i]);
       }
 
-void Pipeline::initBuffers()
-{
-  for(int i = 0; i < MusECore::MAX_CHANNELS; ++i)
-  {
-    if(!buffer[i])
-    {
-#ifdef _WIN32
-      buffer[i] = (float *) _aligned_malloc(16, sizeof(float *) * MusEGlobal::segmentSize);
-      if(buffer[i] == NULL)
-      {
-         fprintf(stderr, "ERROR: Pipeline ctor: _aligned_malloc returned error: NULL. Aborting!\n");
-         abort();
-      }
-#else
-      int rv = posix_memalign((void**)(buffer + i), 16, sizeof(float) * MusEGlobal::segmentSize);
-      if(rv != 0)
-      {
-        fprintf(stderr, "ERROR: Pipeline ctor: posix_memalign returned error:%d. Aborting!\n", rv);
-        abort();
-      }
-#endif
-    }
-  }
-
-  for(int i = 0; i < MusECore::MAX_CHANNELS; ++i)
-  {
-    if(MusEGlobal::config.useDenormalBias)
-    {
-      for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-        buffer[i][q] = MusEGlobal::denormalBias;
-    }
-    else
-      memset(buffer[i], 0, sizeof(float) * MusEGlobal::segmentSize);
-  }
-}
-
 //---------------------------------------------------------
 //  latency
 //---------------------------------------------------------
 
-float Pipeline::latency()
+float Pipeline::latency(float latencyLimit)
 {
   float l = 0.0;
+  float pl;
   PluginI* p;
   for(int i = 0; i < MusECore::PipelineDepth; ++i)
   {
     p = (*this)[i];
-    if(p)
-      l+= p->latency();
+    // Plugins which are off are not run, and add no latency.
+    if(!p || !p->on())
+      continue;
+    pl = p->latency();
+    if(latencyLimit >= 0.0 && pl > latencyLimit)
+      continue;
+    l += pl;
   }
   return l;
 }
@@ -1607,8 +1573,10 @@ bool Pipeline::nativeGuiVisible(int idx)
 //   If ports is 0, just process controllers only, not audio (do not 'run').
 //---------------------------------------------------------
 
-void Pipeline::apply(unsigned pos, unsigned long ports, unsigned long nframes, float** buffer1)
+void Pipeline::apply(unsigned pos, unsigned long ports, unsigned long nframes, float** buffer1, float latencyLimit)
 {
+      // Shared scratch buffers. Free, since no other pipeline is running.
+      float** buffer = MusEGlobal::audioBufferPool.pipelineBuffers();
       bool swap = false;
 
       for (iPluginI ip = begin(); ip != end(); ++ip) {
@@ -1616,7 +1584,7 @@ void Pipeline::apply(unsigned pos, unsigned long ports, unsigned long nframes, f
 
             if(p)
             {
-              if (p->on())
+              if (p->on() && (latencyLimit < 0.0 || p->latency() <= latencyLimit))
               {
                 if (!(p->requiredFeatures() & PluginNoInPlaceProcessing))
                 {
@@ -1977,11 +1945,6 @@ PluginI::~PluginI()
             _plugin->incReferences(-1);
             }
 
-      if(_audioInSilenceBuf)
-        free(_audioInSilenceBuf);
-      if(_audioOutDummyBuf)
-        free(_audioOutDummyBuf);
-
       if (controlsOutDummy)
             delete[] controlsOutDummy;
       if (controlsOut)
@@ -2331,47 +2294,10 @@ bool PluginI::initPluginInstance(Plugin* plug, int c)
         }
       }
 
-#ifdef _WIN32
-      _audioInSilenceBuf = (float *) _aligned_malloc(16, sizeof(float *) * MusEGlobal::segmentSize);
-      if(_audioInSilenceBuf == NULL)
-      {
-         fprintf(stderr, "ERROR: PluginI::initPluginInstance: _audioInSilenceBuf _aligned_malloc returned error: NULL. Aborting!\n");
-         abort();
-      }
-#else
-      int rv = posix_memalign((void **)&_audioInSilenceBuf, 16, sizeof(float) * MusEGlobal::segmentSize);
-      if(rv != 0)
-      {
-          fprintf(stderr, "ERROR: PluginI::initPluginInstance: _audioInSilenceBuf posix_memalign returned error:%d. Aborting!\n", rv);
-          abort();
-      }
-#endif
-      if(MusEGlobal::config.useDenormalBias)
-      {
-          for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-          {
-            _audioInSilenceBuf[q] = MusEGlobal::denormalBias;
-          }
-      }
-      else
-      {
-          memset(_audioInSilenceBuf, 0, sizeof(float) * MusEGlobal::segmentSize);
-      }
-#ifdef _WIN32
-      _audioOutDummyBuf = (float *) _aligned_malloc(16, sizeof(float *) * MusEGlobal::segmentSize);
-      if(_audioOutDummyBuf == NULL)
-      {
-         fprintf(stderr, "ERROR: PluginI::initPluginInstance: _audioOutDummyBuf _aligned_malloc returned error: NULL. Aborting!\n");
-         abort();
-      }
-#else
-      rv = posix_memalign((void **)&_audioOutDummyBuf, 16, sizeof(float) * MusEGlobal::segmentSize);
-      if(rv != 0)
-      {
-          fprintf(stderr, "ERROR: PluginI::initPluginInstance: _audioOutDummyBuf posix_memalign returned error:%d. Aborting!\n", rv);
-          abort();
-      }
-#endif
+      // Unused audio ports go to the buffers shared by all plugins.
+      MusEGlobal::audioBufferPool.prepare();
+      _audioInSilenceBuf = MusEGlobal::audioBufferPool.silence();
+      _audioOutDummyBuf = MusEGlobal::audioBufferPool.dummy();
       activate();
       return false;
       }
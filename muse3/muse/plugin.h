@@ -509,9 +509,6 @@ class PluginI : public PluginIBase {
 //---------------------------------------------------------
 
 class Pipeline : public std::vector<PluginI*> {
-   private:
-      float* buffer[MusECore::MAX_CHANNELS];
-      void initBuffers();
    public:
       Pipeline();
       Pipeline(const Pipeline&, AudioTrack*);
@@ -533,14 +530,16 @@ class Pipeline : public std::vector<PluginI*> {
       void deleteAllGuis();
       bool guiVisible(int);
       bool nativeGuiVisible(int);
-      void apply(unsigned pos, unsigned long ports, unsigned long nframes, float** buffer);
+      // If latencyLimit is not negative, plugins with more latency than that are bypassed.
+      void apply(unsigned pos, unsigned long ports, unsigned long nframes, float** buffer, float latencyLimit = -1.0);
       void move(int idx, bool up);
       bool empty(int idx) const;
       void setChannels(int);
       bool addScheduledControlEvent(int track_ctrl_id, double val, unsigned frame); // returns true if event cannot be delivered
       void enableController(int track_ctrl_id, bool en);
       bool controllerEnabled(int track_ctrl_id);
-      float latency();
+      // Total latency of the running plugins. Plugins over latencyLimit are not counted, as in apply().
+      float latency(float latencyLimit = -1.0);
       };
 
 typedef Pipeline::iterator iPluginI;
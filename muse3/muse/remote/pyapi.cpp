@@ -23,6 +23,7 @@
 #include <fstream>
 #include <string>
 #include <pthread.h>
+#include <algorithm>
 
 #include <QApplication>
 
@@ -38,6 +39,7 @@
 #include "plugin.h"
 #include "midi.h"
 #include "app.h"
+#include "undo.h"
 
 // Steals ref: PyList_SetItem, PyTuple_SetItem
 using namespace std;
@@ -50,7 +52,8 @@ QPybridgeEvent::QPybridgeEvent(QPybridgeEvent::EventType _type, int _p1, int _p2
       :QEvent(QEvent::User),
       type(_type),
       p1(_p1),
-      p2(_p2)
+      p2(_p2),
+      edits(NULL)
 {
 }
 //------------------------------------------------------------
@@ -449,6 +452,278 @@ PyObject* deletePart(PyObject*, PyObject* args)
       return Py_None;
 }
 
+//------------------------------------------------------------
+// Bulk event access
+//
+//  getPartEvents packs a part's notes and controllers into a
+//  bytearray of PyEventRecord, filled in place. It supports the
+//  buffer protocol, so numpy.frombuffer views it without copying:
+//    dt = numpy.dtype(muse.getEventRecordFormat())
+//    ev = numpy.frombuffer(muse.getPartEvents(id), dtype=dt)
+//  setPartEvents takes any such buffer back and replaces all
+//  notes and controllers of the part with it, as one operation.
+//  Between beginTransaction and commitTransaction, the edits are
+//  collected and then applied together in one audio sync.
+//------------------------------------------------------------
+
+// Pending transaction. Python thread only.
+static PyPartEventsEditList* pyTransaction = NULL;
+
+static bool isPyRecordType(int type)
+{
+      return type == Note || type == Controller;
+}
+
+static bool pyRecordLess(const PyEventRecord& r1, const PyEventRecord& r2)
+{
+      if (r1.tick != r2.tick) return r1.tick < r2.tick;
+      if (r1.type != r2.type) return r1.type < r2.type;
+      if (r1.a != r2.a) return r1.a < r2.a;
+      if (r1.b != r2.b) return r1.b < r2.b;
+      if (r1.c != r2.c) return r1.c < r2.c;
+      return r1.len < r2.len;
+}
+
+struct PyRecordPairLess
+{
+      bool operator()(const std::pair<PyEventRecord, const Event*>& p1,
+                      const std::pair<PyEventRecord, const Event*>& p2) const
+      {
+            return pyRecordLess(p1.first, p2.first);
+      }
+};
+
+static void eventToPyRecord(const Event& event, PyEventRecord* rec)
+{
+      rec->type = event.type();
+      rec->tick = event.tick();
+      rec->len  = event.type() == Note ? event.lenTick() : 0;
+      rec->a    = event.dataA();
+      rec->b    = event.dataB();
+      rec->c    = event.dataC();
+}
+
+//------------------------------------------------------------
+// getEventRecordFormat
+//  field names and types of PyEventRecord, as a numpy dtype list
+//------------------------------------------------------------
+PyObject* getEventRecordFormat(PyObject*, PyObject*)
+{
+      return Py_BuildValue("[(s,s),(s,s),(s,s),(s,s),(s,s),(s,s)]",
+                           "type", "i4", "tick", "u4", "len", "u4", "a", "i4", "b", "i4", "c", "i4");
+}
+
+//------------------------------------------------------------
+// getPartEvents
+//  notes and controllers of a part, by serial nr
+//------------------------------------------------------------
+PyObject* getPartEvents(PyObject*, PyObject* args)
+{
+      int id;
+      if (!PyArg_ParseTuple(args, "i", &id)) {
+            return NULL;
+            }
+
+      Part* part = findPartBySerial(id);
+      if (part == NULL || !part->track()->isMidiTrack()) {
+            PyErr_SetString(PyExc_ValueError, "No midi part with that id");
+            return NULL;
+            }
+
+      const EventList& events = part->events();
+      Py_ssize_t count = 0;
+      for (ciEvent e = events.begin(); e != events.end(); ++e)
+            if (isPyRecordType(e->second.type()))
+                  ++count;
+
+      PyObject* buf = PyByteArray_FromStringAndSize(NULL, count * sizeof(PyEventRecord));
+      if (buf == NULL)
+            return NULL;
+      PyEventRecord* rec = (PyEventRecord*)PyByteArray_AsString(buf);
+      for (ciEvent e = events.begin(); e != events.end(); ++e) {
+            if (isPyRecordType(e->second.type()))
+                  eventToPyRecord(e->second, rec++);
+            }
+      return buf;
+}
+
+//------------------------------------------------------------
+// setPartEvents
+//  args: part serial nr, buffer of PyEventRecord
+//------------------------------------------------------------
+PyObject* setPartEvents(PyObject*, PyObject* args)
+{
+      int id;
+      PyObject* obj;
+      if (!PyArg_ParseTuple(args, "iO", &id, &obj)) {
+            return NULL;
+            }
+
+      Part* part = findPartBySerial(id);
+      if (part == NULL || !part->track()->isMidiTrack()) {
+            PyErr_SetString(PyExc_ValueError, "No midi part with that id");
+            return NULL;
+            }
+
+      Py_buffer view;
+      if (PyObject_GetBuffer(obj, &view, PyBUF_C_CONTIGUOUS) == -1)
+            return NULL;
+      if (view.len % sizeof(PyEventRecord) != 0) {
+            PyBuffer_Release(&view);
+            PyErr_SetString(PyExc_ValueError, "Buffer size is not a multiple of the event record size");
+            return NULL;
+            }
+
+      PyPartEventsEdit edit;
+      edit.partSn = id;
+      const PyEventRecord* recs = (const PyEventRecord*)view.buf;
+      edit.events.assign(recs, recs + view.len / sizeof(PyEventRecord));
+      PyBuffer_Release(&view);
+
+      for (std::vector<PyEventRecord>::const_iterator r = edit.events.begin(); r != edit.events.end(); ++r) {
+            if (!isPyRecordType(r->type)) {
+                  PyErr_SetString(PyExc_ValueError, "Only note and controller events are supported");
+                  return NULL;
+                  }
+            }
+
+      if (pyTransaction) {
+            // Each edit replaces all of the part's events, so a later edit of the same part supersedes the earlier one.
+            PyPartEventsEditList::iterator ie = pyTransaction->begin();
+            for ( ; ie != pyTransaction->end(); ++ie)
+                  if (ie->partSn == id)
+                        break;
+            if (ie != pyTransaction->end())
+                  ie->events.swap(edit.events);
+            else
+                  pyTransaction->push_back(edit);
+            }
+      else {
+            PyPartEventsEditList* edits = new PyPartEventsEditList();
+            edits->push_back(edit);
+            QPybridgeEvent* pyevent = new QPybridgeEvent(QPybridgeEvent::SONG_SET_PART_EVENTS);
+            pyevent->setEdits(edits);
+            QApplication::postEvent(MusEGlobal::song, pyevent);
+            }
+
+      Py_INCREF(Py_None);
+      return Py_None;
+}
+
+//------------------------------------------------------------
+// beginTransaction
+//------------------------------------------------------------
+PyObject* beginTransaction(PyObject*, PyObject*)
+{
+      if (pyTransaction) {
+            PyErr_SetString(PyExc_RuntimeError, "A transaction is already open");
+            return NULL;
+            }
+      pyTransaction = new PyPartEventsEditList();
+      Py_INCREF(Py_None);
+      return Py_None;
+}
+
+//------------------------------------------------------------
+// commitTransaction
+//------------------------------------------------------------
+PyObject* commitTransaction(PyObject*, PyObject*)
+{
+      if (!pyTransaction) {
+            PyErr_SetString(PyExc_RuntimeError, "No transaction is open");
+            return NULL;
+            }
+      if (pyTransaction->empty())
+            delete pyTransaction;
+      else {
+            QPybridgeEvent* pyevent = new QPybridgeEvent(QPybridgeEvent::SONG_SET_PART_EVENTS);
+            pyevent->setEdits(pyTransaction);
+            QApplication::postEvent(MusEGlobal::song, pyevent);
+            }
+      pyTransaction = NULL;
+      Py_INCREF(Py_None);
+      return Py_None;
+}
+
+//------------------------------------------------------------
+// abortTransaction
+//------------------------------------------------------------
+PyObject* abortTransaction(PyObject*, PyObject*)
+{
+      if (pyTransaction) {
+            delete pyTransaction;
+            pyTransaction = NULL;
+            }
+      Py_INCREF(Py_None);
+      return Py_None;
+}
+
+//------------------------------------------------------------
+// applyPartEventsEdits
+//  Gui thread. Turns the edits into one ModifyEventBatch per
+//  part, holding only the events which actually changed, and
+//  applies them all as one operation group.
+//------------------------------------------------------------
+static void applyPartEventsEdits(const PyPartEventsEditList& edits)
+{
+      Undo operations;
+      for (PyPartEventsEditList::const_iterator ie = edits.begin(); ie != edits.end(); ++ie) {
+            Part* part = findPartBySerial(ie->partSn);
+            if (part == NULL || !part->track()->isMidiTrack()) {
+                  printf("applyPartEventsEdits: part %d no longer exists\n", ie->partSn);
+                  continue;
+                  }
+
+            // Current notes and controllers, and the new ones, both sorted the same way.
+            std::vector< std::pair<PyEventRecord, const Event*> > olds;
+            const EventList& events = part->events();
+            for (ciEvent e = events.begin(); e != events.end(); ++e) {
+                  if (!isPyRecordType(e->second.type()))
+                        continue;
+                  PyEventRecord rec;
+                  eventToPyRecord(e->second, &rec);
+                  olds.push_back(std::make_pair(rec, &e->second));
+                  }
+            std::vector<PyEventRecord> news(ie->events);
+            std::stable_sort(news.begin(), news.end(), pyRecordLess);
+            std::stable_sort(olds.begin(), olds.end(), PyRecordPairLess());
+
+            UndoEventBatch* batch = new UndoEventBatch();
+            size_t io = 0, in = 0;
+            while (io < olds.size() || in < news.size()) {
+                  if (in == news.size() || (io < olds.size() && pyRecordLess(olds[io].first, news[in]))) {
+                        batch->add(*olds[io].second, Event());
+                        ++io;
+                        }
+                  else if (io == olds.size() || pyRecordLess(news[in], olds[io].first)) {
+                        const PyEventRecord& r = news[in];
+                        Event event((EventType)r.type);
+                        event.setTick(r.tick);
+                        if (r.type == Note)
+                              event.setLenTick(r.len);
+                        event.setA(r.a);
+                        event.setB(r.b);
+                        event.setC(r.c);
+                        batch->add(Event(), event);
+                        ++in;
+                        }
+                  else {
+                        // Unchanged.
+                        ++io;
+                        ++in;
+                        }
+                  }
+
+            if (batch->empty())
+                  delete batch;
+            else
+                  operations.push_back(UndoOp(UndoOp::ModifyEventBatch, part, batch, true, true));
+            }
+
+      if (!operations.empty())
+            MusEGlobal::song->applyOperationGroup(operations);
+}
+
 //------------------------------------------------------------
 // setPos
 //------------------------------------------------------------
@@ -954,6 +1229,12 @@ PyMethodDef g_methodDefinitions[] =
       { "createPart", createPart, METH_VARARGS, "Create a part" },
       { "modifyPart", modifyPart, METH_O, "Modify a particular part" },
       { "deletePart", deletePart, METH_VARARGS, "Remove part with a particular serial nr" },
+      { "getEventRecordFormat", getEventRecordFormat, METH_NOARGS, "Get field names and types of the records used by getPartEvents/setPartEvents" },
+      { "getPartEvents", getPartEvents, METH_VARARGS, "Get notes and controllers of a part as a packed record buffer" },
+      { "setPartEvents", setPartEvents, METH_VARARGS, "Replace notes and controllers of a part with a packed record buffer" },
+      { "beginTransaction", beginTransaction, METH_NOARGS, "Collect setPartEvents edits until commitTransaction" },
+      { "commitTransaction", commitTransaction, METH_NOARGS, "Apply all collected edits as one operation" },
+      { "abortTransaction", abortTransaction, METH_NOARGS, "Discard all collected edits" },
       { "getSelectedTrack", getSelectedTrack, METH_NOARGS, "Get first selected track" },
       { "importPart", importPart, METH_VARARGS, "Import part file to a track at a particular position" },
       { "changeTrackName", changeTrackName, METH_VARARGS, "Change track name" },
@@ -1144,6 +1425,14 @@ bool Song::event(QEvent* _e)
                   t->setName(e->getS2());
                   break;
                   }
+            case QPybridgeEvent::SONG_SET_PART_EVENTS: {
+                  PyPartEventsEditList* edits = e->getEdits();
+                  if (edits == NULL)
+                        return false;
+                  applyPartEventsEdits(*edits);
+                  delete edits;
+                  break;
+                  }
             case QPybridgeEvent::SONG_DELETE_TRACK: {
                   Track* t = this->findTrack(e->getS1());
                   if (t == NULL)
@@ -23,14 +23,43 @@
 
 #include <QEvent>
 
+#include <vector>
+#include <stdint.h>
+
 namespace MusECore {
 
+//------------------------------------------------------------
+// PyEventRecord
+//  One midi event as exposed to Python by getPartEvents and
+//  taken back by setPartEvents. Fixed layout, so that scripts
+//  can view a whole part as an array, e.g. with numpy.
+//------------------------------------------------------------
+struct PyEventRecord
+{
+      int32_t type;     // Note or Controller
+      uint32_t tick;    // Relative to the part
+      uint32_t len;     // Notes only
+      int32_t a, b, c;
+};
+
+//------------------------------------------------------------
+// PyPartEventsEdit
+//  A part's new events, to replace all its notes and controllers.
+//------------------------------------------------------------
+struct PyPartEventsEdit
+{
+      int partSn;
+      std::vector<PyEventRecord> events;
+};
+
+typedef std::vector<PyPartEventsEdit> PyPartEventsEditList;
+
 class QPybridgeEvent : public QEvent
 {
 public:
       enum EventType { SONG_UPDATE=0, SONGLEN_CHANGE, SONG_POSCHANGE, SONG_SETPLAY, SONG_SETSTOP, SONG_REWIND, SONG_SETMUTE,
              SONG_SETCTRL, SONG_SETAUDIOVOL, SONG_IMPORT_PART, SONG_TOGGLE_EFFECT, SONG_ADD_TRACK, SONG_CHANGE_TRACKNAME,
-             SONG_DELETE_TRACK };
+             SONG_DELETE_TRACK, SONG_SET_PART_EVENTS };
       QPybridgeEvent( QPybridgeEvent::EventType _type, int _p1=0, int _p2=0);
       EventType getType() { return type; }
       int getP1() { return p1; }
@@ -41,6 +70,9 @@ public:
       const QString& getS2() { return s2; }
       double getD1() { return d1; }
       void setD1(double _d1) { d1 = _d1; }
+      // The receiver takes ownership.
+      void setEdits(PyPartEventsEditList* _edits) { edits = _edits; }
+      PyPartEventsEditList* getEdits() { return edits; }
 
 private:
       EventType type;
@@ -48,6 +80,7 @@ private:
       double d1;
       QString s1;
       QString s2;
+      PyPartEventsEditList* edits;
 
 };
 
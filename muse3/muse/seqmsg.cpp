@@ -820,9 +820,15 @@ void Audio::msgStartMidiLearn()
 
 void Audio::msgBounce()
       {
+      msgBounce(MusEGlobal::song->lPos(), MusEGlobal::song->rPos());
+      }
+
+void Audio::msgBounce(const Pos& start, const Pos& end)
+      {
+      _bounceEnd = end;
       _bounce = true;
       if (!MusEGlobal::checkAudioDevice()) return;
-      MusEGlobal::audioDevice->seekTransport(MusEGlobal::song->lPos());
+      MusEGlobal::audioDevice->seekTransport(start);
       }
 
 //---------------------------------------------------------
@@ -863,6 +869,9 @@ void Audio::msgSetMidiDevice(MidiPort* port, MidiDevice* device)
   //MusEGlobal::midiSeq->sendMsg(&msg);
   sendMsg(&msg); // Idle both audio and midi.
 
+  // Nothing reads the device while idle, a good time to size its recording fifos.
+  if(device)
+    device->reserveRecordFifos();
   port->setMidiDevice(device);
 
   msg.id = MusECore::SEQM_IDLE;
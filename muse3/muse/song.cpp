@@ -45,6 +45,7 @@
 #include "song.h"
 #include "track.h"
 #include "undo.h"
+#include "undostore.h"
 #include "key.h"
 #include "globals.h"
 #include "event.h"
@@ -52,6 +53,9 @@
 #include "marker/marker.h"
 #include "synth.h"
 #include "audio.h"
+#include "telemetry.h"
+#include "midiplayback.h"
+#include "trackfreeze.h"
 #include "mididev.h"
 #include "amixer.h"
 #include "midiseq.h"
@@ -71,6 +75,7 @@
 #include "tempo.h"
 #include "route.h"
 #include "strntcpy.h"
+#include "utils.h"
 
 // Undefine if and when multiple output routes are added to midi tracks.
 #define _USE_MIDI_TRACK_SINGLE_OUT_PORT_CHAN_
@@ -980,22 +985,26 @@ void Song::cmdAddRecordedEvents(MidiTrack* mt, const EventList& events, unsigned
       }
             
 
+      // Replace and add everything in one batch, rather than one operation per event.
+      UndoEventBatch* batch = new UndoEventBatch();
       if (_recMode == REC_REPLACE) {
             ciEvent si = part->events().lower_bound(startTick - part->tick());
             ciEvent ei = part->events().lower_bound(endTick   - part->tick());
 
-            for (ciEvent i = si; i != ei; ++i) {
-                  const Event& event = i->second;
-                  // Indicate that controller values and clone parts were handled.
-                  operations.push_back(UndoOp(UndoOp::DeleteEvent, event, part, true, true));
-            }
+            for (ciEvent i = si; i != ei; ++i)
+                  batch->add(i->second, Event());
       }
       for (ciEvent i = s; i != e; ++i) {
             Event event = i->second.clone();
             event.setTick(event.tick() - partTick);
-            // Indicate that controller values and clone parts were handled.
-            operations.push_back(UndoOp(UndoOp::AddEvent, event, part, true, true));
+            batch->add(Event(), event);
       }
+      if (batch->empty()) {
+            delete batch;
+            return;
+            }
+      // Indicate that controller values and clone parts were handled.
+      operations.push_back(UndoOp(UndoOp::ModifyEventBatch, part, batch, true, true));
 }
 
 //---------------------------------------------------------
@@ -1421,6 +1430,11 @@ void Song::update(MusECore::SongChangedStruct_t flags, bool allowRecursion)
                    "                          probably cause windows being not up-to-date.\n", (unsigned long)flags._flags, level);
             return;
             }
+      // Drum maps and instruments are shared by many tracks, and may have been edited directly.
+      if(flags._flags & (SC_DRUMMAP | SC_MIDI_INSTRUMENT | SC_CONFIG))
+            MusECore::invalidateMidiPlayback();
+      // Frozen tracks recheck their content at the next beat.
+      MusECore::invalidateTrackFreezes(flags._flags);
       ++level;
       emit songChanged(flags);
       --level;
@@ -1732,6 +1746,16 @@ void Song::beat()
       _heartbeatRateTimer = t;
       #endif
       
+      // Collect everything the audio thread has published since the last beat,
+      //  before any strips read from it. Song::beat is connected to the heartbeat first.
+      MusEGlobal::telemetry.consume();
+
+      // Recompile the playback streams of tracks which changed since the last beat.
+      MusECore::updateMidiPlayback();
+
+      // Drop the caches of frozen tracks which changed, and freeze those which finished capturing.
+      MusECore::updateTrackFreezes();
+
       //First: update cpu load toolbar
 
       _fCpuLoad = MusEGlobal::muse->getCPULoad();
@@ -1746,7 +1770,10 @@ void Song::beat()
       
       
       if (MusEGlobal::audio->isPlaying())
-        setPos(0, MusEGlobal::audio->tickPos(), true, false, true);
+      {
+        const MusECore::TelemetryTransport* tt = MusEGlobal::telemetry.transport();
+        setPos(0, (tt && tt->playing) ? tt->tick : MusEGlobal::audio->tickPos(), true, false, true);
+      }
 
       // Process external tempo changes:
       while(!_tempoFifo.isEmpty())
@@ -1930,8 +1957,33 @@ void Song::undo()
       if (opGroup.empty())
             return;
       
+      const uint64_t startTime = curTimeUS();
+      // Bring back any events the group had handed to the undo store.
+      // Reverting without them would corrupt the song, so if they cannot
+      //  be read back, give up and drop the whole history instead.
+      if(!MusEGlobal::undoStore.restore(opGroup))
+      {
+        undoList->clearDelete();
+        redoList->clearDelete();
+        if(MusEGlobal::undoAction)
+          MusEGlobal::undoAction->setEnabled(false);
+        if(MusEGlobal::redoAction)
+          MusEGlobal::redoAction->setEnabled(false);
+        setUndoRedoText();
+        QMessageBox::critical(MusEGlobal::muse, tr("MusE: Undo"),
+          tr("The undo history could not be read back from the undo store.\n"
+             "Nothing was undone, and the undo and redo history has been cleared."));
+        return;
+      }
+      const uint64_t restoreTime = curTimeUS();
+      
       MusEGlobal::audio->msgRevertOperationGroup(opGroup);
       
+      const size_t ops = MusECore::UndoStore::operationCount(opGroup);
+      if(MusEGlobal::debugMsg && ops >= UNDO_LATENCY_REPORT_OPS)
+        fprintf(stderr, "Song::undo: %u operations took %u us, of which restoring took %u us\n",
+                (unsigned)ops, (unsigned)(curTimeUS() - startTime), (unsigned)(restoreTime - startTime));
+      
       redoList->push_back(opGroup);
       undoList->pop_back();
 
@@ -1962,10 +2014,17 @@ void Song::redo()
       if (opGroup.empty())
             return;
       
+      const uint64_t startTime = curTimeUS();
+      
       MusEGlobal::audio->msgExecuteOperationGroup(opGroup);
       
+      const size_t ops = MusECore::UndoStore::operationCount(opGroup);
+      if(MusEGlobal::debugMsg && ops >= UNDO_LATENCY_REPORT_OPS)
+        fprintf(stderr, "Song::redo: %u operations took %u us\n", (unsigned)ops, (unsigned)(curTimeUS() - startTime));
+      
       undoList->push_back(opGroup);
       redoList->pop_back();
+      MusEGlobal::undoStore.enforce(undoList);
       
       if(MusEGlobal::undoAction)
         MusEGlobal::undoAction->setEnabled(true);
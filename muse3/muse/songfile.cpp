@@ -26,6 +26,11 @@
 #include <QMessageBox>
 #include <QCheckBox>
 #include <QString>
+#include <QByteArray>
+
+#include <vector>
+#include <atomic>
+#include <thread>
 
 #include "app.h"
 #include "song.h"
@@ -393,7 +398,8 @@ void Part::write(int level, Xml& xml, bool isCopy, bool forceWavePaths) const
             if (i->cp->isCloneOf(this))
             {
               id = i->id;
-              dumpEvents = false;
+              // The part which was given the id writes the events. See registerWriteClones().
+              dumpEvents = (i->cp == this);
               break;
             }
           }
@@ -443,6 +449,129 @@ void Part::write(int level, Xml& xml, bool isCopy, bool forceWavePaths) const
       }
 
 
+//---------------------------------------------------------
+//   registerWriteClones
+//    Gives clone ids to the parts in the same order as
+//     writing the tracks one by one would, so that the
+//     tracks can then be written in any order.
+//---------------------------------------------------------
+
+static void registerWriteClones(const TrackList& tracks)
+      {
+      for (ciTrack t = tracks.begin(); t != tracks.end(); ++t) {
+            const PartList* pl = (*t)->cparts();
+            for (ciPart ip = pl->begin(); ip != pl->end(); ++ip) {
+                  const Part* part = ip->second;
+                  if (!part->hasClones())
+                        continue;
+                  iClone i = MusEGlobal::cloneList.begin();
+                  for ( ; i != MusEGlobal::cloneList.end(); ++i)
+                        if (i->cp->isCloneOf(part))
+                              break;
+                  if (i == MusEGlobal::cloneList.end())
+                        MusEGlobal::cloneList.push_back(ClonePart(part, MusEGlobal::cloneList.size()));
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   TrackWriteJob
+//    Writes the midi tracks into their own buffers. Run by
+//     several threads at once, each taking the next track.
+//---------------------------------------------------------
+
+struct TrackWriteJob
+      {
+      const std::vector<const Track*>* tracks;
+      std::vector<QByteArray>* chunks;
+      std::atomic<size_t>* next;
+      int level;
+
+      void operator()() const
+            {
+            for (;;) {
+                  const size_t i = next->fetch_add(1);
+                  if (i >= tracks->size())
+                        return;
+                  const Track* t = (*tracks)[i];
+                  if (!t->isMidiTrack())
+                        continue;
+                  Xml xml(&(*chunks)[i]);
+                  t->write(level, xml);
+                  }
+            }
+      };
+
+// Below this many midi events the tracks are written on the calling thread.
+static const size_t PARALLEL_WRITE_MIN_EVENTS = 16384;
+
+//---------------------------------------------------------
+//   writeTracks
+//    Midi tracks hold the bulk of a song. If the destination
+//     takes raw bytes, they are written in parallel into
+//     separate buffers, which are then put out in track order.
+//     The result is the same as writing them one by one.
+//    Other tracks may call into plugins, so they are always
+//     written by the calling thread.
+//---------------------------------------------------------
+
+static void writeTracks(const TrackList& tracks, int level, Xml& xml)
+      {
+      size_t events = 0;
+      unsigned midiTracks = 0;
+      for (ciTrack t = tracks.begin(); t != tracks.end(); ++t) {
+            if (!(*t)->isMidiTrack())
+                  continue;
+            ++midiTracks;
+            const PartList* pl = (*t)->cparts();
+            for (ciPart ip = pl->begin(); ip != pl->end(); ++ip)
+                  events += ip->second->events().size();
+            }
+
+      unsigned threads = std::thread::hardware_concurrency();
+      if (threads > 16)
+            threads = 16;
+      if (threads > midiTracks)
+            threads = midiTracks;
+      if (!xml.writesBytes() || threads < 2 || events < PARALLEL_WRITE_MIN_EVENTS) {
+            for (ciTrack t = tracks.begin(); t != tracks.end(); ++t)
+                  (*t)->write(level, xml);
+            return;
+            }
+
+      registerWriteClones(tracks);
+
+      std::vector<const Track*> tl;
+      tl.reserve(tracks.size());
+      for (ciTrack t = tracks.begin(); t != tracks.end(); ++t)
+            tl.push_back(*t);
+      std::vector<QByteArray> chunks(tl.size());
+      std::atomic<size_t> next(0);
+      TrackWriteJob job;
+      job.tracks = &tl;
+      job.chunks = &chunks;
+      job.next   = &next;
+      job.level  = level;
+
+      std::vector<std::thread> workers;
+      workers.reserve(threads - 1);
+      for (unsigned i = 1; i < threads; ++i)
+            workers.push_back(std::thread(job));
+
+      for (size_t i = 0; i < tl.size(); ++i) {
+            if (tl[i]->isMidiTrack())
+                  continue;
+            Xml cxml(&chunks[i]);
+            tl[i]->write(level, cxml);
+            }
+      job();
+      for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+
+      for (size_t i = 0; i < chunks.size(); ++i)
+            xml.putBytes(chunks[i]);
+      }
+
 //---------------------------------------------------------
 //   writeFont
 //---------------------------------------------------------
@@ -725,8 +854,7 @@ void Song::write(int level, Xml& xml) const
       MusEGlobal::cloneList.clear();
 
       // write tracks
-      for (ciTrack i = _tracks.begin(); i != _tracks.end(); ++i)
-            (*i)->write(level, xml);
+      writeTracks(_tracks, level, xml);
 
       // write routing
       for (ciTrack i = _tracks.begin(); i != _tracks.end(); ++i)
@@ -0,0 +1,359 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  syncout.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include "syncout.h"
+#include "globals.h"
+#include "gconfig.h"
+#include "song.h"
+#include "tempo.h"
+#include "sync.h"
+#include "mtc.h"
+#include "midi_consts.h"
+#include "midiport.h"
+#include "mididev.h"
+#include "mpevent.h"
+#include "large_int.h"
+
+namespace MusEGlobal {
+MusECore::MidiSyncOutput midiSyncOutput;
+}
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   MtcRate
+//    Frame rate of an MTC type as a fraction, and its
+//     rate code in the quarter frame and full frame messages.
+//---------------------------------------------------------
+
+struct MtcRate
+{
+      uint64_t num;
+      uint64_t den;
+      int code;
+      bool drop;
+};
+
+static MtcRate mtcRate(int type)
+      {
+      MtcRate r;
+      r.den = 1;
+      r.drop = false;
+      switch (type) {
+            case 0:
+                  r.num = 24;
+                  r.code = 0;
+                  break;
+            case 1:
+                  r.num = 25;
+                  r.code = 1;
+                  break;
+            case 2:
+                  r.num = 30000;
+                  r.den = 1001;
+                  r.code = 2;
+                  r.drop = true;
+                  break;
+            case 3:
+            default:
+                  r.num = 30;
+                  r.code = 3;
+                  break;
+            }
+      return r;
+      }
+
+//---------------------------------------------------------
+//   mtcTime
+//    Convert a frame count to hours, minutes, seconds and frames.
+//---------------------------------------------------------
+
+static void mtcTime(uint64_t frameNo, const MtcRate& r, int* h, int* m, int* s, int* f)
+      {
+      int fps = r.num / r.den;
+      if (r.drop) {
+            // Frame numbers 0 and 1 are skipped each minute, except every tenth minute.
+            fps = 30;
+            const uint64_t d = frameNo / 17982;
+            const uint64_t rem = frameNo % 17982;
+            frameNo += 18 * d;
+            if (rem > 1)
+                  frameNo += 2 * ((rem - 2) / 1798);
+            }
+      *f = frameNo % fps;
+      const uint64_t secs = frameNo / fps;
+      *s = secs % 60;
+      *m = (secs / 60) % 60;
+      *h = (secs / 3600) % 24;
+      }
+
+//---------------------------------------------------------
+//   quarterFrame
+//    Transport frame of an MTC quarter frame, rounded up.
+//---------------------------------------------------------
+
+static unsigned quarterFrame(uint64_t quarter, const MtcRate& r)
+      {
+      return muse_multiply_64_div_64_to_64(quarter * r.den, MusEGlobal::sampleRate, r.num * 4, LargeIntRoundUp);
+      }
+
+//---------------------------------------------------------
+//   offsetQuarters
+//    The MTC offset in quarter frames.
+//---------------------------------------------------------
+
+static uint64_t offsetQuarters(const MtcRate& r)
+      {
+      return muse_multiply_64_div_64_to_64(MusEGlobal::mtcOffset.timeUS(), r.num * 4, 1000000UL * r.den, LargeIntRoundNearest);
+      }
+
+//---------------------------------------------------------
+//   MidiSyncOutput
+//---------------------------------------------------------
+
+MidiSyncOutput::MidiSyncOutput()
+   : _fullFrameData(MTC_FULL_FRAME_BUFFERS, MTC_FULL_FRAME_LEN)
+      {
+      _nextClockTick = 0;
+      _nextIdleClockFrame = 0.0;
+      _idleClockValid = false;
+      _nextQuarter = 0;
+      _mtcType = -1;
+      _wasPlaying = false;
+      _locatePending = false;
+      _locateFrame = 0;
+      }
+
+//---------------------------------------------------------
+//   locate
+//---------------------------------------------------------
+
+void MidiSyncOutput::locate(unsigned tick, unsigned frame)
+      {
+      // The master, and our sync routing system, take care of it.
+      if (MusEGlobal::extSyncFlag.value())
+            return;
+      // Sent straight away through the same path as start and continue, so that
+      //  slaves always get the position before a continue sent in this cycle.
+      if (MusEGlobal::config.division >= 24) {
+            const int beat = (tick * 4) / MusEGlobal::config.division;
+            for (int port = 0; port < MIDI_PORTS; ++port) {
+                  MidiPort* mp = &MusEGlobal::midiPorts[port];
+                  if (mp->device() && mp->syncInfo().MRTOut())
+                        mp->sendSongpos(beat);
+                  }
+            }
+      _locateFrame = frame;
+      _locatePending = true;
+      }
+
+//---------------------------------------------------------
+//   resync
+//    Start counting clocks and quarter frames from the
+//     transport position.
+//---------------------------------------------------------
+
+void MidiSyncOutput::resync(unsigned pos_fr)
+      {
+      const unsigned div = MusEGlobal::config.division / 24;
+      const unsigned tick = MusEGlobal::tempomap.frame2tick(pos_fr, 0, LargeIntRoundUp);
+      _nextClockTick = ((tick + div - 1) / div) * div;
+
+      _mtcType = MusEGlobal::mtcType;
+      const MtcRate r = mtcRate(_mtcType);
+      _nextQuarter = muse_multiply_64_div_64_to_64(pos_fr, r.num * 4, (uint64_t)MusEGlobal::sampleRate * r.den, LargeIntRoundUp);
+      }
+
+//---------------------------------------------------------
+//   sendFullFrame
+//---------------------------------------------------------
+
+void MidiSyncOutput::sendFullFrame(uint64_t quarter, unsigned frame)
+      {
+      const MtcRate r = mtcRate(MusEGlobal::mtcType);
+      int h, m, s, f;
+      mtcTime(quarter / 4, r, &h, &m, &s, &f);
+      unsigned char data[MTC_FULL_FRAME_LEN];
+      data[0] = 0x7f;
+      data[1] = 0x7f;
+      data[2] = 0x01;
+      data[3] = 0x01;
+      data[4] = (r.code << 5) | h;
+      data[5] = m;
+      data[6] = s;
+      data[7] = f;
+      EvData d;
+      // Every buffer is still queued. Rare, allocate one.
+      if (!_fullFrameData.get(&d, data, MTC_FULL_FRAME_LEN))
+            d.setData(data, MTC_FULL_FRAME_LEN);
+
+      for (int port = 0; port < MIDI_PORTS; ++port) {
+            MidiPort* mp = &MusEGlobal::midiPorts[port];
+            MidiDevice* md = mp->device();
+            if (!md || !mp->syncInfo().MTCOut())
+                  continue;
+            const MidiPlayEvent ev(frame, port, ME_SYSEX, d);
+            md->putEvent(ev, MidiDevice::NotLate, MidiDevice::PlaybackBuffer);
+            }
+      }
+
+//---------------------------------------------------------
+//   sendQuarterFrame
+//    The eight pieces of a sequence carry the time of the
+//     frame at which piece zero was sent.
+//---------------------------------------------------------
+
+void MidiSyncOutput::sendQuarterFrame(uint64_t quarter, unsigned frame)
+      {
+      const MtcRate r = mtcRate(_mtcType);
+      const int piece = quarter & 7;
+      int h, m, s, f;
+      mtcTime((quarter - piece) / 4, r, &h, &m, &s, &f);
+      int nibble = 0;
+      switch (piece) {
+            case 0: nibble = f & 0xf; break;
+            case 1: nibble = (f >> 4) & 0x1; break;
+            case 2: nibble = s & 0xf; break;
+            case 3: nibble = (s >> 4) & 0x3; break;
+            case 4: nibble = m & 0xf; break;
+            case 5: nibble = (m >> 4) & 0x3; break;
+            case 6: nibble = h & 0xf; break;
+            case 7: nibble = ((h >> 4) & 0x1) | (r.code << 1); break;
+            }
+
+      for (int port = 0; port < MIDI_PORTS; ++port) {
+            MidiPort* mp = &MusEGlobal::midiPorts[port];
+            MidiDevice* md = mp->device();
+            if (!md || !mp->syncInfo().MTCOut())
+                  continue;
+            const MidiPlayEvent ev(frame, port, 0, ME_MTC_QUARTER, (piece << 4) | nibble, 0);
+            md->putEvent(ev, MidiDevice::NotLate, MidiDevice::PlaybackBuffer);
+            }
+      }
+
+//---------------------------------------------------------
+//   sendClocks
+//---------------------------------------------------------
+
+void MidiSyncOutput::sendClocks(unsigned frame)
+      {
+      for (int port = 0; port < MIDI_PORTS; ++port) {
+            MidiPort* mp = &MusEGlobal::midiPorts[port];
+            MidiDevice* md = mp->device();
+            if (!md || !mp->syncInfo().MCOut())
+                  continue;
+            const MidiPlayEvent ev(frame, port, 0, ME_CLOCK, 0, 0);
+            md->putEvent(ev, MidiDevice::NotLate, MidiDevice::PlaybackBuffer);
+            }
+      }
+
+//---------------------------------------------------------
+//   process
+//---------------------------------------------------------
+
+void MidiSyncOutput::process(bool playing, unsigned pos_fr, unsigned frames, unsigned syncFrame)
+      {
+      // The master, and our sync routing system, take care of it.
+      if (MusEGlobal::extSyncFlag.value()) {
+            _locatePending = false;
+            _idleClockValid = false;
+            _wasPlaying = playing;
+            return;
+            }
+
+      if (MusEGlobal::sampleRate == 0 || MusEGlobal::config.division < 24)
+            return;
+
+      if (_locatePending) {
+            _locatePending = false;
+            const MtcRate r = mtcRate(MusEGlobal::mtcType);
+            sendFullFrame(muse_multiply_64_div_64_to_64(_locateFrame, r.num * 4,
+                            (uint64_t)MusEGlobal::sampleRate * r.den) + offsetQuarters(r), syncFrame);
+            resync(pos_fr);
+            }
+      if (playing != _wasPlaying || MusEGlobal::mtcType != _mtcType) {
+            _wasPlaying = playing;
+            resync(pos_fr);
+            }
+
+      const unsigned end_fr = syncFrame + frames;
+
+      if (!playing) {
+            //---------------------------------------------------
+            //    Free running clock at the current tempo
+            //---------------------------------------------------
+
+            const double period = double(MusEGlobal::sampleRate) * double(MusEGlobal::tempomap.tempo(MusEGlobal::song->cpos())) /
+                                  (24.0 * double(MusEGlobal::tempomap.globalTempo()) * 10000.0);
+            // Start over if we fell behind, or the frame counter wrapped around.
+            if (!_idleClockValid || _nextIdleClockFrame < double(syncFrame) || _nextIdleClockFrame >= double(end_fr) + period) {
+                  _nextIdleClockFrame = syncFrame;
+                  _idleClockValid = true;
+                  }
+            while (_nextIdleClockFrame < double(end_fr)) {
+                  sendClocks((unsigned)_nextIdleClockFrame);
+                  _nextIdleClockFrame += period;
+                  }
+            return;
+            }
+
+      _idleClockValid = false;
+      const unsigned next_pos_fr = pos_fr + frames;
+
+      //---------------------------------------------------
+      //    Midi clock, from the tempo map
+      //---------------------------------------------------
+
+      const unsigned div = MusEGlobal::config.division / 24;
+      unsigned fr = MusEGlobal::tempomap.tick2frame(_nextClockTick);
+      // Behind, after a tempo change for example.
+      if (fr < pos_fr) {
+            resync(pos_fr);
+            fr = MusEGlobal::tempomap.tick2frame(_nextClockTick);
+            }
+      while (fr < next_pos_fr) {
+            if (fr >= pos_fr)
+                  sendClocks(fr - pos_fr + syncFrame);
+            _nextClockTick += div;
+            fr = MusEGlobal::tempomap.tick2frame(_nextClockTick);
+            }
+
+      //---------------------------------------------------
+      //    MTC quarter frames, from the transport frame
+      //---------------------------------------------------
+
+      const MtcRate r = mtcRate(_mtcType);
+      const uint64_t offset = offsetQuarters(r);
+      fr = quarterFrame(_nextQuarter, r);
+      if (fr < pos_fr) {
+            resync(pos_fr);
+            fr = quarterFrame(_nextQuarter, r);
+            }
+      while (fr < next_pos_fr) {
+            if (fr >= pos_fr)
+                  sendQuarterFrame(_nextQuarter + offset, fr - pos_fr + syncFrame);
+            ++_nextQuarter;
+            fr = quarterFrame(_nextQuarter, r);
+            }
+      }
+
+} // namespace MusECore
@@ -0,0 +1,93 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  syncout.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __SYNCOUT_H__
+#define __SYNCOUT_H__
+
+#include <stdint.h>
+
+#include "evdata.h"
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   MidiSyncOutput
+//    Generates midi clock, MTC quarter frames and full frames
+//     in the audio thread. Every message is timestamped with
+//     the exact frame it is due at, computed from the tempo
+//     map, and handed to the port's device like any other
+//     playback event. The song position pointer goes out
+//     right away on locate, like start and continue.
+//    While stopped, midi clock keeps running at the tempo
+//     of the current position so that slaves stay locked.
+//    Nothing is generated while synced to an external master.
+//---------------------------------------------------------
+
+// Number of preallocated MTC full frame buffers.
+const int MTC_FULL_FRAME_BUFFERS = 8;
+// Length of an MTC full frame sysex, without the start and end bytes.
+const int MTC_FULL_FRAME_LEN = 8;
+
+class MidiSyncOutput
+{
+      // Next clock tick while playing. A multiple of division / 24.
+      unsigned _nextClockTick;
+      // Next clock frame while stopped, in free running frames.
+      double _nextIdleClockFrame;
+      bool _idleClockValid;
+      // Next MTC quarter frame, counted from transport zero,
+      //  and the MTC type it was counted with.
+      uint64_t _nextQuarter;
+      int _mtcType;
+      bool _wasPlaying;
+      // Set by locate(), handled by the next process().
+      bool _locatePending;
+      unsigned _locateFrame;
+      // Sysex data of the MTC full frames, so that none is allocated in
+      //  the audio thread. A buffer is only written again once every
+      //  event sharing it has been sent.
+      EvDataPool _fullFrameData;
+
+      void resync(unsigned pos_fr);
+      void sendClocks(unsigned frame);
+      void sendQuarterFrame(uint64_t quarter, unsigned frame);
+      void sendFullFrame(uint64_t quarter, unsigned frame);
+
+   public:
+      MidiSyncOutput();
+
+      // Audio thread. The transport was moved. The song position is sent
+      //  now, before any start or continue, and an MTC full frame with the
+      //  next cycle.
+      void locate(unsigned tick, unsigned frame);
+      // Audio thread. Called once per cycle. pos_fr is the transport frame
+      //  and syncFrame the free running frame at the start of the cycle.
+      void process(bool playing, unsigned pos_fr, unsigned frames, unsigned syncFrame);
+};
+
+} // namespace MusECore
+
+namespace MusEGlobal {
+extern MusECore::MidiSyncOutput midiSyncOutput;
+}
+
+#endif
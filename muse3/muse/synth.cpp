@@ -116,7 +116,8 @@ void SynthIF::getMapItem(int channel, int patch, int index, DrumMap& dest_map, i
 ) const
 {
   // Not found? Search the global mapping list.
-  const patch_drummap_mapping_list_t* def_pdml = genericMidiInstrument->get_patch_drummap_mapping(channel, true); // Include default.
+  const patch_drummap_mapping_list_t* def_pdml =
+    static_cast<const MidiInstrument*>(genericMidiInstrument)->get_patch_drummap_mapping(channel, true); // Include default.
   if(def_pdml)
   {
     ciPatchDrummapMapping_t ipdm = def_pdml->find(patch, true); // Include default.
@@ -573,9 +574,9 @@ void SynthI::recordEvent(MidiRecordEvent& event)
         return;
 
       // Split the events up into channel fifos. Special 'channel' number 17 for sysex events.
+      // An overflow is counted by the fifo and reported when recording stops.
       unsigned int ch = (typ == ME_SYSEX)? MusECore::MUSE_MIDI_CHANNELS : event.channel();
-      if(_recordFifo[ch].put(event))
-        fprintf(stderr, "SynthI::recordEvent: fifo channel %d overflow\n", ch);
+      _recordFifo[ch].put(event);
       }
 
 
@@ -774,7 +775,8 @@ void MessSynthIF::getMapItem(int channel, int patch, int index, DrumMap& dest_ma
 
   DrumMap* dm = NULL;
   // Not found? Search the global mapping list.
-  patch_drummap_mapping_list_t* def_pdml = genericMidiInstrument->get_patch_drummap_mapping(channel, true); // Include default.
+  const patch_drummap_mapping_list_t* def_pdml =
+    static_cast<const MidiInstrument*>(genericMidiInstrument)->get_patch_drummap_mapping(channel, true); // Include default.
   if(def_pdml)
   {
     ciPatchDrummapMapping_t ipdm = def_pdml->find(patch, true); // Include default.
@@ -1249,6 +1251,19 @@ bool SynthI::getData(unsigned pos, int ports, unsigned n, float** buffer)
       return true;
       }
 
+//---------------------------------------------------------
+//   discardOutEvents
+//    Like an off track, user events are kept for when the
+//     synth runs again.
+//---------------------------------------------------------
+
+void SynthI::discardOutEvents()
+      {
+      _playbackEventBuffers->clearRead();
+      _outPlaybackEvents.clear();
+      setStopFlag(false);
+      }
+
 bool MessSynthIF::getData(MidiPort* /*mp*/, unsigned pos, int /*ports*/, unsigned n, float** buffer)
 {
       const unsigned int syncFrame = MusEGlobal::audio->curSyncFrame();
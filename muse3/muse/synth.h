@@ -235,6 +235,8 @@ class SynthI : public AudioTrack, public MidiDevice,
 
       void preProcessAlways();
       bool getData(unsigned a, int b, unsigned c, float** data);
+      // Audio thread. Drops the queued playback events instead of rendering them, while the track is frozen.
+      void discardOutEvents();
       // Returns the number of frames to shift forward output event scheduling times when putting events
       //  into the eventFifos.
       virtual unsigned int pbForwardShiftFrames() const;
@@ -264,6 +266,7 @@ class SynthI : public AudioTrack, public MidiDevice,
       SynthIF* sif() const { return _sif; }
       bool initInstance(Synth* s, const QString& instanceName);
       virtual float latency(int channel) { return _sif->latency() + AudioTrack::latency(channel); }
+      virtual float ownLatency() { return _sif->latency() + AudioTrack::ownLatency(); }
 
       void read(Xml&);
       virtual void write(int, Xml&) const;
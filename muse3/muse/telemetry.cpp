@@ -0,0 +1,394 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  telemetry.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <stdio.h>
+#include <math.h>
+
+#include "telemetry.h"
+#include "track.h"
+#include "song.h"
+#include "audio.h"
+#include "globals.h"
+#include "gconfig.h"
+
+namespace MusEGlobal {
+MusECore::TelemetryChannel telemetry;
+}
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   TelemetryTrackValues::clear
+//---------------------------------------------------------
+
+void TelemetryTrackValues::clear()
+{
+  track = 0;
+  for(int ch = 0; ch < MAX_CHANNELS; ++ch)
+  {
+    meter[ch] = 0.0f;
+    peak[ch] = 0.0f;
+    clipped[ch] = false;
+  }
+  volume = 0.0;
+  pan = 0.0;
+  activity = 0;
+}
+
+//---------------------------------------------------------
+//   TelemetryChannel
+//---------------------------------------------------------
+
+TelemetryChannel::TelemetryChannel()
+  : _writeIndex(0), _readIndex(0), _accumFrames(0), _slotCount(0), _overruns(0), _haveTransport(false)
+{
+  for(int i = 0; i < MAX_TELEMETRY_SLOTS; ++i)
+  {
+    _accum[i].clear();
+    _values[i].clear();
+    _slotOwner[i].store(0, std::memory_order_relaxed);
+  }
+  for(int i = 0; i < TELEMETRY_RING_SIZE; ++i)
+    _ring[i].slots = 0;
+  _transport.playing = false;
+  _transport.frame = 0;
+  _transport.tick = 0;
+}
+
+//---------------------------------------------------------
+//   gather
+//    Fold the current cycle's meters into the accumulators.
+//    Called from the audio thread.
+//---------------------------------------------------------
+
+void TelemetryChannel::gather(unsigned frames)
+{
+  _accumFrames += frames;
+  if(_slotCount.load(std::memory_order_acquire) == 0)
+    return;
+  const TrackList* tl = MusEGlobal::song->tracks();
+  for(ciTrack it = tl->begin(); it != tl->end(); ++it)
+  {
+    Track* t = *it;
+    const int slot = t->telemetrySlot();
+    if(slot < 0 || slot >= MAX_TELEMETRY_SLOTS || _slotOwner[slot].load(std::memory_order_acquire) != t)
+      continue;
+
+    TelemetryTrackValues& a = _accum[slot];
+    if(a.track != t)
+    {
+      a.clear();
+      a.track = t;
+    }
+
+    if(t->isMidiTrack())
+    {
+      const int act = t->activity();
+      if(act > a.activity)
+        a.activity = act;
+      continue;
+    }
+
+    int chans = t->channels();
+    if(chans > MAX_CHANNELS)
+      chans = MAX_CHANNELS;
+    for(int ch = 0; ch < chans; ++ch)
+    {
+      const float m = t->meter(ch);
+      if(m > a.meter[ch])
+        a.meter[ch] = m;
+    }
+  }
+}
+
+//---------------------------------------------------------
+//   publish
+//    Called from the audio thread.
+//---------------------------------------------------------
+
+void TelemetryChannel::publish()
+{
+  const unsigned w = _writeIndex.load(std::memory_order_relaxed);
+  if(w - _readIndex.load(std::memory_order_acquire) >= (unsigned)TELEMETRY_RING_SIZE)
+  {
+    // The gui has not kept up. Keep accumulating so that no peaks are lost.
+    _overruns.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  TelemetryFrame& f = _ring[w & (TELEMETRY_RING_SIZE - 1)];
+  f.transport.playing = MusEGlobal::audio->isPlaying();
+  f.transport.frame = MusEGlobal::audio->pos().frame();
+  f.transport.tick = MusEGlobal::audio->tickPos();
+  f.cycleFrames = _accumFrames;
+
+  int slots = _slotCount.load(std::memory_order_acquire);
+  if(slots > MAX_TELEMETRY_SLOTS)
+    slots = MAX_TELEMETRY_SLOTS;
+  f.slots = slots;
+  for(int i = 0; i < slots; ++i)
+    f.values[i].track = 0;
+
+  const TrackList* tl = MusEGlobal::song->tracks();
+  for(ciTrack it = tl->begin(); it != tl->end(); ++it)
+  {
+    Track* t = *it;
+    const int slot = t->telemetrySlot();
+    if(slot < 0 || slot >= slots || _slotOwner[slot].load(std::memory_order_acquire) != t)
+      continue;
+
+    TelemetryTrackValues& a = _accum[slot];
+    if(a.track != t)
+      continue;
+
+    TelemetryTrackValues& v = f.values[slot];
+    v = a;
+    if(!t->isMidiTrack())
+    {
+      for(int ch = 0; ch < MAX_CHANNELS; ++ch)
+      {
+        v.peak[ch] = t->peak(ch);
+        v.clipped[ch] = t->isClipped(ch);
+      }
+      const AudioTrack* at = static_cast<const AudioTrack*>(t);
+      v.volume = at->volume();
+      v.pan = at->pan();
+    }
+
+    for(int ch = 0; ch < MAX_CHANNELS; ++ch)
+      a.meter[ch] = 0.0f;
+    a.activity = 0;
+  }
+
+  _accumFrames = 0;
+  _writeIndex.store(w + 1, std::memory_order_release);
+}
+
+//---------------------------------------------------------
+//   decayActivity
+//    Let the midi activity of all midi tracks fall off.
+//    The activity is raised by the audio thread when events
+//     are played or recorded, so it is decayed here as well
+//     rather than by the gui. Decays by 0.8 every 50 ms.
+//    Called from the audio thread.
+//---------------------------------------------------------
+
+void TelemetryChannel::decayActivity(unsigned frames)
+{
+  if(MusEGlobal::sampleRate == 0)
+    return;
+  const double factor = pow(0.8, (20.0 * double(frames)) / double(MusEGlobal::sampleRate));
+  const MidiTrackList* mtl = MusEGlobal::song->midis();
+  for(ciMidiTrack it = mtl->begin(); it != mtl->end(); ++it)
+  {
+    MidiTrack* t = *it;
+    const int act = t->activity();
+    if(act)
+      t->setActivity((int)((double)act * factor));
+  }
+}
+
+//---------------------------------------------------------
+//   process
+//    Called from the audio thread at the end of each cycle.
+//---------------------------------------------------------
+
+void TelemetryChannel::process(unsigned frames)
+{
+  gather(frames);
+
+  // Publish about twice per gui heartbeat, so that a snapshot
+  //  is always waiting and the meters do not beat against the timer.
+  unsigned interval = MusEGlobal::sampleRate;
+  if(MusEGlobal::config.guiRefresh > 0)
+    interval /= (2 * MusEGlobal::config.guiRefresh);
+  if(_accumFrames >= interval)
+  {
+    const unsigned decayFrames = _accumFrames;
+    publish();
+    decayActivity(decayFrames);
+  }
+}
+
+//---------------------------------------------------------
+//   subscribe
+//    Called from the gui thread.
+//---------------------------------------------------------
+
+void TelemetryChannel::subscribe(Track* t)
+{
+  if(!t)
+    return;
+  std::map<const Track*, Subscription>::iterator is = _subscriptions.find(t);
+  if(is != _subscriptions.end())
+  {
+    ++is->second.refs;
+    return;
+  }
+
+  int slot;
+  if(!_freeSlots.empty())
+  {
+    slot = _freeSlots.back();
+    _freeSlots.pop_back();
+  }
+  else if(_slotCount < MAX_TELEMETRY_SLOTS)
+    slot = _slotCount;
+  else
+  {
+    fprintf(stderr, "TelemetryChannel::subscribe: No free slots for track:%s\n", t->name().toLatin1().constData());
+    return;
+  }
+
+  _values[slot].clear();
+  // Set the owner before the track's slot, so the audio thread never sees a slot with a stale owner.
+  _slotOwner[slot].store(t, std::memory_order_release);
+  if(slot >= _slotCount.load(std::memory_order_relaxed))
+    _slotCount.store(slot + 1, std::memory_order_release);
+  t->setTelemetrySlot(slot);
+
+  Subscription sub;
+  sub.slot = slot;
+  sub.refs = 1;
+  _subscriptions.insert(std::pair<const Track*, Subscription>(t, sub));
+}
+
+//---------------------------------------------------------
+//   unsubscribe
+//    Called from the gui thread.
+//---------------------------------------------------------
+
+void TelemetryChannel::unsubscribe(Track* t)
+{
+  std::map<const Track*, Subscription>::iterator is = _subscriptions.find(t);
+  if(is == _subscriptions.end())
+    return;
+  if(--is->second.refs > 0)
+    return;
+
+  const int slot = is->second.slot;
+  _subscriptions.erase(is);
+  _slotOwner[slot].store(0, std::memory_order_release);
+  _values[slot].clear();
+  // The track may already have been removed from the song and even deleted.
+  // Only touch it if it is still live. A stale slot on a removed track is
+  //  ignored by the audio thread, since the slot owner no longer matches.
+  if(MusEGlobal::song->tracks()->contains(t))
+    t->setTelemetrySlot(-1);
+
+  if(slot == _slotCount.load(std::memory_order_relaxed) - 1)
+  {
+    int count = slot;
+    while(count > 0 && _slotOwner[count - 1].load(std::memory_order_relaxed) == 0)
+      --count;
+    _slotCount.store(count, std::memory_order_release);
+    // Drop free slots which are now beyond the end.
+    for(std::vector<int>::iterator i = _freeSlots.begin(); i != _freeSlots.end(); )
+    {
+      if(*i >= count)
+        i = _freeSlots.erase(i);
+      else
+        ++i;
+    }
+  }
+  else
+    _freeSlots.push_back(slot);
+}
+
+//---------------------------------------------------------
+//   isSubscribed
+//---------------------------------------------------------
+
+bool TelemetryChannel::isSubscribed(const Track* t) const
+{
+  return _subscriptions.find(t) != _subscriptions.end();
+}
+
+//---------------------------------------------------------
+//   consume
+//    Called from the gui thread, once per heartbeat.
+//---------------------------------------------------------
+
+bool TelemetryChannel::consume()
+{
+  unsigned r = _readIndex.load(std::memory_order_relaxed);
+  const unsigned w = _writeIndex.load(std::memory_order_acquire);
+  if(r == w)
+    return false;
+
+  // Whether each slot has been refreshed by this pass yet.
+  bool folded[MAX_TELEMETRY_SLOTS];
+  for(int slot = 0; slot < MAX_TELEMETRY_SLOTS; ++slot)
+    folded[slot] = false;
+
+  for( ; r != w; ++r)
+  {
+    const TelemetryFrame& f = _ring[r & (TELEMETRY_RING_SIZE - 1)];
+    for(int slot = 0; slot < f.slots; ++slot)
+    {
+      const TelemetryTrackValues& v = f.values[slot];
+      // Skip slots not published in this snapshot, or since given to another track.
+      if(!v.track || v.track != _slotOwner[slot].load(std::memory_order_relaxed))
+        continue;
+      TelemetryTrackValues& d = _values[slot];
+      if(!folded[slot] || d.track != v.track)
+      {
+        d = v;
+        folded[slot] = true;
+        continue;
+      }
+      for(int ch = 0; ch < MAX_CHANNELS; ++ch)
+      {
+        if(v.meter[ch] > d.meter[ch])
+          d.meter[ch] = v.meter[ch];
+        d.peak[ch] = v.peak[ch];
+        d.clipped[ch] = v.clipped[ch];
+      }
+      if(v.activity > d.activity)
+        d.activity = v.activity;
+      d.volume = v.volume;
+      d.pan = v.pan;
+    }
+    _transport = f.transport;
+  }
+  _haveTransport = true;
+
+  _readIndex.store(r, std::memory_order_release);
+  return true;
+}
+
+//---------------------------------------------------------
+//   values
+//---------------------------------------------------------
+
+const TelemetryTrackValues* TelemetryChannel::values(const Track* t) const
+{
+  std::map<const Track*, Subscription>::const_iterator is = _subscriptions.find(t);
+  if(is == _subscriptions.end())
+    return 0;
+  const TelemetryTrackValues& v = _values[is->second.slot];
+  if(v.track != t)
+    return 0;
+  return &v;
+}
+
+} // namespace MusECore
@@ -0,0 +1,167 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  telemetry.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <map>
+#include <vector>
+#include <atomic>
+
+#include "globaldefs.h"
+
+namespace MusECore {
+
+class Track;
+
+// Maximum number of tracks which can be subscribed at once.
+const int MAX_TELEMETRY_SLOTS = 256;
+// Number of snapshots the ring can hold. Must be a power of two.
+const int TELEMETRY_RING_SIZE = 4;
+
+//---------------------------------------------------------
+//   TelemetryTrackValues
+//    Snapshot of one track's realtime state.
+//---------------------------------------------------------
+
+struct TelemetryTrackValues
+{
+      // Identifies the track the values belong to. Only compared, never dereferenced by the gui.
+      const Track* track;
+      // Highest meter level since the previous snapshot.
+      float meter[MAX_CHANNELS];
+      float peak[MAX_CHANNELS];
+      bool clipped[MAX_CHANNELS];
+      // Current volume and pan, including automation. Audio tracks only.
+      double volume;
+      double pan;
+      // Highest midi activity since the previous snapshot. Midi tracks only.
+      int activity;
+
+      void clear();
+};
+
+//---------------------------------------------------------
+//   TelemetryTransport
+//---------------------------------------------------------
+
+struct TelemetryTransport
+{
+      bool playing;
+      unsigned frame;
+      unsigned tick;
+};
+
+//---------------------------------------------------------
+//   TelemetryFrame
+//    One snapshot published by the audio thread.
+//---------------------------------------------------------
+
+struct TelemetryFrame
+{
+      TelemetryTransport transport;
+      // Number of audio frames covered by this snapshot.
+      unsigned cycleFrames;
+      // Number of valid slots in values.
+      int slots;
+      TelemetryTrackValues values[MAX_TELEMETRY_SLOTS];
+};
+
+//---------------------------------------------------------
+//   TelemetryChannel
+//    Single producer, single consumer channel carrying meters,
+//     peaks, automation values and transport from the audio
+//     thread to the gui.
+//    The audio thread folds every cycle into accumulators and
+//     publishes a snapshot once per decimation interval, which
+//     follows the gui refresh rate. The gui drains all pending
+//     snapshots once per heartbeat.
+//    Only tracks subscribed by the gui (visible strips) are
+//     gathered.
+//---------------------------------------------------------
+
+class TelemetryChannel
+{
+      struct Subscription
+      {
+            int slot;
+            int refs;
+      };
+
+      // Snapshot ring. Written by the audio thread, read by the gui.
+      TelemetryFrame _ring[TELEMETRY_RING_SIZE];
+      std::atomic<unsigned> _writeIndex;
+      std::atomic<unsigned> _readIndex;
+
+      // Audio thread only.
+      TelemetryTrackValues _accum[MAX_TELEMETRY_SLOTS];
+      unsigned _accumFrames;
+
+      // Written by the gui, read by the audio thread.
+      // Owner of each slot, used to reject slots held by removed tracks.
+      std::atomic<const Track*> _slotOwner[MAX_TELEMETRY_SLOTS];
+      std::atomic<int> _slotCount;
+      // Number of snapshots dropped because the gui did not keep up.
+      std::atomic<unsigned> _overruns;
+
+      // Gui thread only.
+      std::map<const Track*, Subscription> _subscriptions;
+      std::vector<int> _freeSlots;
+      TelemetryTrackValues _values[MAX_TELEMETRY_SLOTS];
+      TelemetryTransport _transport;
+      bool _haveTransport;
+
+      void gather(unsigned frames);
+      void publish();
+      void decayActivity(unsigned frames);
+
+   public:
+      TelemetryChannel();
+
+      // Called by the audio thread at the end of each process cycle.
+      void process(unsigned frames);
+
+      // Gui thread. Subscriptions are reference counted, one per visible strip.
+      void subscribe(Track* t);
+      void unsubscribe(Track* t);
+      bool isSubscribed(const Track* t) const;
+
+      // Gui thread. Drains all pending snapshots. Meters are combined so
+      //  that short peaks between heartbeats are not lost. Returns true if
+      //  any snapshot was consumed.
+      bool consume();
+      // Latest values for the track, or null if not subscribed or nothing
+      //  has been published for it yet.
+      const TelemetryTrackValues* values(const Track* t) const;
+      // Latest transport state, or null if nothing has been published yet.
+      const TelemetryTransport* transport() const { return _haveTransport ? &_transport : 0; }
+
+      unsigned overruns() const { return _overruns.load(std::memory_order_relaxed); }
+};
+
+} // namespace MusECore
+
+namespace MusEGlobal {
+extern MusECore::TelemetryChannel telemetry;
+}
+
+#endif
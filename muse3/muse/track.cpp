@@ -43,6 +43,7 @@
 #include "gconfig.h"
 #include "operations.h"
 #include "icons.h"
+#include "midiplayback.h"
 #include <QMessageBox>
 
 // Undefine if and when multiple output routes are added to midi tracks.
@@ -256,6 +257,7 @@ void Track::init()
       _height        = MusEGlobal::config.trackHeight;
       _locked        = false;
       _recMonitor    = false;
+      _telemetrySlot = -1;
       for (int i = 0; i < MusECore::MAX_CHANNELS; ++i) {
             _meter[i] = 0.0;
             _peak[i]  = 0.0;
@@ -276,6 +278,7 @@ Track::Track(const Track& t, int flags)
   // we'll see if there is any draw back to that.
   _name = t.name();
   internal_assign(t, flags | ASSIGN_PROPERTIES);
+  _telemetrySlot = -1;
   for (int i = 0; i < MusECore::MAX_CHANNELS; ++i) {
         _meter[i] = 0.0;
         _peak[i]  = 0.0;
@@ -610,6 +613,7 @@ RouteCapabilitiesStruct Track::routeCapabilities() const
 MidiTrack::MidiTrack()
    : Track(MIDI)
       {
+      _playback = new MidiPlayback();
       init();
       clefType=trebleClef;
       
@@ -622,6 +626,7 @@ MidiTrack::MidiTrack()
 MidiTrack::MidiTrack(const MidiTrack& mt, int flags)
   : Track(mt, flags)
 {
+      _playback = new MidiPlayback();
       _drummap=new DrumMap[128];
       _workingDrumMapPatchList = new WorkingDrumMapPatchList();
 
@@ -784,6 +789,7 @@ MidiTrack::~MidiTrack()
         delete _workingDrumMapPatchList;
       delete [] _drummap;
       remove_ourselves_from_drum_ordering();
+      delete _playback;
       }
 
 
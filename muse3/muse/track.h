@@ -28,6 +28,7 @@
 #include <QString>
 
 #include <vector>
+#include <atomic>
 #include <algorithm>
 
 #include "wave.h" // for SndFileR
@@ -45,9 +46,12 @@ class QPixmap;
 class QColor;
 
 namespace MusECore {
+class LatencyCompensator;
+class MidiPlayback;
 class Pipeline;
 class PluginI;
 class SynthI;
+class TrackFreeze;
 class Xml;
 struct DrumMap;
 struct ControlEvent;
@@ -120,6 +124,8 @@ class Track {
       double _meter[MusECore::MAX_CHANNELS];
       double _peak[MusECore::MAX_CHANNELS];
       bool _isClipped[MusECore::MAX_CHANNELS]; //used in audio mixer strip. Persistent.
+      // Slot in the telemetry channel, or -1 if no strip is showing this track. Set by the gui.
+      std::atomic<int> _telemetrySlot;
 
       int _y;
       int _height;            // visual height in arranger
@@ -295,6 +301,8 @@ class Track {
       bool isVisible();
       inline bool isClipped(int ch) const { if(ch >= MusECore::MAX_CHANNELS) return false; return _isClipped[ch]; }
       void resetClipper() { for(int ch = 0; ch < MusECore::MAX_CHANNELS; ++ch) _isClipped[ch] = false; }
+      int telemetrySlot() const { return _telemetrySlot.load(std::memory_order_acquire); }
+      void setTelemetrySlot(int slot) { _telemetrySlot.store(slot, std::memory_order_release); }
       };
 
 //---------------------------------------------------------
@@ -318,6 +326,9 @@ class MidiTrack : public Track {
       int drum_in_map[128];
       int _curDrumPatchNumber; // Can be CTRL_VAL_UNKNOWN.
       
+      // Compiled playback stream. See midiplayback.h.
+      MidiPlayback* _playback;
+      
       void init();
       void internal_assign(const Track&, int flags);
       void init_drummap(bool write_ordering); // function without argument in public
@@ -400,6 +411,8 @@ class MidiTrack : public Track {
       virtual void updateSoloStates(bool noDec);
       virtual void updateInternalSoloStates();
 
+      MidiPlayback* playback() const { return _playback; }
+
       virtual bool addStuckNote(const MidiPlayEvent& ev);
       // These are only for 'live' (rec) notes for which we don't have a note-off time yet. Even times = 0.
       virtual bool addStuckLiveNote(int port, int chan, int note, int vel = 64);
@@ -503,15 +516,14 @@ class AudioTrack : public Track {
       // Cached audio data for all channels. If prefader is not on, the first two channels
       //  have volume and pan applied if track is stereo, or the first channel has just
       //  volume applied if track is mono.
+      // Also the working buffers getData() and the effect rack process in, before the cache is valid.
       float** outBuffers;
       // Extra cached audio data.
       float** outBuffersExtraMix;
-      // Just all zeros all the time, so we don't have to clear for silence.
+      // Just all zeros all the time, so we don't have to clear for silence. Shared, see AudioBufferPool.
       float*  audioInSilenceBuf;
-      // Just a place to connect all unused audio outputs.
+      // Just a place to connect all unused audio outputs. Shared, see AudioBufferPool.
       float*  audioOutDummyBuf;
-      // Internal temporary buffers for getData().
-      float** _dataBuffers;
 
       // These two are not the same as the number of track channels which is always either 1 (mono) or 2 (stereo):
       // Total number of output channels.
@@ -521,6 +533,22 @@ class AudioTrack : public Track {
       
       Pipeline* _efxPipe;
 
+      // Plugin delay compensation. Only touched by the audio thread, see Audio::updateLatencyCompensation().
+      LatencyCompensator* _latencyComp;
+      // Own latency and live monitoring state the current delays were computed with.
+      float _ownLatency;
+      bool _liveBypass;
+      // Latency of the track's sources, and from the sources through to the track's output.
+      float _inputLatency;
+      float _pathLatency;
+      // Graph walk marker. Equal to the current walk once _pathLatency is valid.
+      int _latencyVisit;
+      // Delay applied after the plugins, in samples.
+      unsigned long _compDelay;
+
+      // Render-and-stream freezing. Only wave and synth tracks use it.
+      TrackFreeze* _freeze;
+
       virtual bool getData(unsigned, int, unsigned, float**);
 
       SndFileR _recFile;
@@ -612,6 +640,7 @@ class AudioTrack : public Track {
 
       void setPrefader(bool val);
       Pipeline* efxPipe()                { return _efxPipe;  }
+      TrackFreeze* freeze() const        { return _freeze; }
       void deleteAllEfxGuis();
       void clearEfxList();
       // Removes any existing plugin and inserts plugin into effects rack, and calls setupPlugin.
@@ -647,6 +676,19 @@ class AudioTrack : public Track {
       virtual bool hasAuxSend() const { return false; }
 
       virtual float latency(int channel); 
+      // Latency added by this track's own processing, not counting its sources.
+      // Plugins which live monitoring bypasses are left out.
+      virtual float ownLatency();
+      // Whether live monitoring bypasses the high latency plugins on this track.
+      bool liveMonitorBypass() const;
+      // Latency graph support for Audio::updateLatencyCompensation(). Audio thread only.
+      // Returns true if the own latency or live monitoring state changed since the last call.
+      bool updateLatencyState();
+      // Latency from the track's sources through to its output, computed once per walk.
+      float pathLatency(int visit);
+      float inputLatency() const { return _inputLatency; }
+      unsigned long compensationDelay() const { return _compDelay; }
+      void setCompensationDelay(unsigned long delay);
       
       // automation
       virtual AutomationType automationType() const    { return _automationType; }
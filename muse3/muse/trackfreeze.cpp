@@ -0,0 +1,953 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  trackfreeze.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <QFile>
+
+#include "trackfreeze.h"
+#include "track.h"
+#include "song.h"
+#include "audio.h"
+#include "synth.h"
+#include "plugin.h"
+#include "tempo.h"
+#include "midiplayback.h"
+#include "midiedit/drummap.h"
+#include "xml.h"
+#include "globals.h"
+#include "gconfig.h"
+#include "al/dsp.h"
+
+namespace MusECore {
+
+// Bumped by any song change which can affect a frozen track's content.
+static unsigned freezeGeneration = 1;
+
+//---------------------------------------------------------
+//   FreezeHash
+//    64 bit FNV-1a.
+//---------------------------------------------------------
+
+class FreezeHash
+{
+      uint64_t _h;
+
+   public:
+      FreezeHash() : _h(14695981039346656037ULL) { }
+
+      void add(const void* data, size_t len)
+            {
+            const unsigned char* p = (const unsigned char*)data;
+            for(size_t i = 0; i < len; ++i) {
+                  _h ^= p[i];
+                  _h *= 1099511628211ULL;
+                  }
+            }
+      void add(int v)      { add(&v, sizeof(v)); }
+      void add(unsigned v) { add(&v, sizeof(v)); }
+      void add(int64_t v)  { add(&v, sizeof(v)); }
+      void add(uint64_t v) { add(&v, sizeof(v)); }
+      void add(const QString& s)
+            {
+            add(s.size());
+            add(s.constData(), s.size() * sizeof(QChar));
+            }
+      // Values are rounded, so that the small differences left
+      //  by saving and loading the song do not change the signature.
+      void addValue(double v)
+            {
+            int e;
+            const double m = frexp(v, &e);
+            add(int(lrint(m * 65536.0)));
+            add(e);
+            }
+      uint64_t value() const { return _h; }
+};
+
+//---------------------------------------------------------
+//   addWaveTrack
+//---------------------------------------------------------
+
+static void addWaveTrack(FreezeHash& h, const Track* t)
+{
+  const PartList* pl = t->cparts();
+  for(ciPart ip = pl->begin(); ip != pl->end(); ++ip)
+  {
+    const Part* part = ip->second;
+    h.add(part->frame());
+    h.add(part->lenFrame());
+    h.add(int(part->mute()));
+    const EventList& el = part->events();
+    for(ciEvent ie = el.begin(); ie != el.end(); ++ie)
+    {
+      const Event& e = ie->second;
+      h.add(e.frame());
+      h.add(e.lenFrame());
+      h.add(e.spos());
+      h.add(e.sndFile().canonicalPath());
+      const WaveEditList* wel = e.waveEdits();
+      if(!wel)
+        continue;
+      for(ciWaveEdit iw = wel->begin(); iw != wel->end(); ++iw)
+      {
+        h.add(iw->type);
+        h.add(int64_t(iw->start));
+        h.add(int64_t(iw->end));
+        h.addValue(iw->gain);
+        h.add(iw->source.canonicalPath());
+        h.add(int64_t(iw->sourceOffset));
+      }
+    }
+  }
+}
+
+//---------------------------------------------------------
+//   addDrumMap
+//---------------------------------------------------------
+
+static void addDrumMap(FreezeHash& h, const DrumMap* dm)
+{
+  for(int i = 0; i < 128; ++i)
+  {
+    h.add(int(dm[i].anote));
+    h.add(dm[i].port);
+    h.add(dm[i].channel);
+    h.add(int(dm[i].vol));
+    h.add(dm[i].len);
+    h.add(int(dm[i].mute));
+  }
+}
+
+//---------------------------------------------------------
+//   addMidiTrack
+//    Everything which shapes what the track plays.
+//---------------------------------------------------------
+
+static void addMidiTrack(FreezeHash& h, MidiTrack* mt)
+{
+  h.add(int(mt->isMute()));
+  h.add(int(mt->off()));
+  MidiPlaybackParams pp;
+  pp.set(mt);
+  h.add(pp.type);
+  h.add(pp.outPort);
+  h.add(pp.outChannel);
+  h.add(pp.transposition);
+  h.add(pp.velocity);
+  h.add(pp.delay);
+  h.add(pp.len);
+  h.add(pp.compression);
+  h.add(pp.pitchShift);
+  if(mt->type() == Track::NEW_DRUM)
+    addDrumMap(h, mt->drummap());
+  else if(mt->type() == Track::DRUM)
+    addDrumMap(h, MusEGlobal::drumMap);
+
+  const PartList* pl = mt->cparts();
+  for(ciPart ip = pl->begin(); ip != pl->end(); ++ip)
+  {
+    const Part* part = ip->second;
+    h.add(part->tick());
+    h.add(part->lenTick());
+    h.add(int(part->mute()));
+    const EventList& el = part->events();
+    for(ciEvent ie = el.begin(); ie != el.end(); ++ie)
+    {
+      const Event& e = ie->second;
+      h.add(int(e.type()));
+      h.add(e.tick());
+      h.add(e.lenTick());
+      h.add(e.dataA());
+      h.add(e.dataB());
+      h.add(e.dataC());
+      if(e.dataLen() > 0)
+        h.add(e.data(), e.dataLen());
+    }
+  }
+}
+
+//---------------------------------------------------------
+//   addParameters
+//    Current values of a plugin's or synth's parameters,
+//     except those following automation.
+//---------------------------------------------------------
+
+static void addParameters(FreezeHash& h, const PluginIBase* p, int baseId, const CtrlListList* cll, bool automated)
+{
+  const unsigned long n = p->parameters();
+  for(unsigned long k = 0; k < n; ++k)
+  {
+    if(automated)
+    {
+      ciCtrlList icl = cll->find(baseId + int(k));
+      if(icl != cll->end() && !icl->second->empty())
+        continue;
+    }
+    h.addValue(p->param(k));
+  }
+}
+
+//---------------------------------------------------------
+//   combine
+//---------------------------------------------------------
+
+static uint64_t combine(uint64_t content, uint64_t control)
+{
+  FreezeHash h;
+  h.add(content);
+  h.add(control);
+  return h.value();
+}
+
+//---------------------------------------------------------
+//   TrackFreeze
+//---------------------------------------------------------
+
+TrackFreeze::TrackFreeze(AudioTrack* track)
+   : _track(track), _mode(Off), _state(Live), _sf(0), _channels(0), _length(0),
+     _captureNext(~0U), _captureComplete(false),
+     _signature(0), _restored(false), _contentSig(0), _contentGeneration(0)
+{
+}
+
+TrackFreeze::~TrackFreeze()
+{
+  // Keep the file. The track may come back through undo.
+  closeCache(false);
+}
+
+//---------------------------------------------------------
+//   canFreeze
+//---------------------------------------------------------
+
+bool TrackFreeze::canFreeze() const
+{
+  if(_track->type() == Track::WAVE)
+    return true;
+  // The cache holds the track's own channels only. A synth with more
+  //  outputs than that would lose the extra ones while frozen.
+  return _track->type() == Track::AUDIO_SOFTSYNTH &&
+         _track->totalProcessBuffers() <= _track->channels();
+}
+
+//---------------------------------------------------------
+//   openCache
+//    Gui thread. Creates a new cache file, or opens the
+//     one named in the song file.
+//---------------------------------------------------------
+
+bool TrackFreeze::openCache(bool create)
+{
+  if(create && _fileName.isEmpty())
+  {
+    const QString fbase = QString("FREEZE_%1_").arg(_track->name().simplified().replace(" ", "_"));
+    for(int n = 1; ; ++n)
+    {
+      const QString name = fbase + QString("%1.wav").arg(n);
+      if(!QFile::exists(MusEGlobal::museProject + "/" + name))
+      {
+        _fileName = name;
+        break;
+      }
+    }
+  }
+  if(_fileName.isEmpty())
+    return false;
+  const QString path = MusEGlobal::museProject + "/" + _fileName;
+
+  SF_INFO info;
+  memset(&info, 0, sizeof(info));
+  if(create)
+  {
+    info.samplerate = MusEGlobal::sampleRate;
+    info.channels = _track->channels();
+    info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+  }
+  SNDFILE* sf = sf_open(path.toLocal8Bit().constData(), create ? SFM_RDWR : SFM_READ, &info);
+  if(!sf)
+  {
+    if(create || MusEGlobal::debugMsg)
+      fprintf(stderr, "TrackFreeze: cannot open %s: %s\n", path.toLocal8Bit().constData(), sf_strerror(0));
+    return false;
+  }
+  if(!create && (info.channels != _track->channels() || info.samplerate != (int)MusEGlobal::sampleRate))
+  {
+    sf_close(sf);
+    return false;
+  }
+
+  _fileMutex.lock();
+  _sf = sf;
+  _channels = info.channels;
+  if(!create)
+    _length = info.frames;
+  _fileMutex.unlock();
+  return true;
+}
+
+//---------------------------------------------------------
+//   closeCache
+//    Gui thread.
+//---------------------------------------------------------
+
+void TrackFreeze::closeCache(bool remove)
+{
+  _fileMutex.lock();
+  if(_sf)
+    sf_close(_sf);
+  _sf = 0;
+  _fileMutex.unlock();
+  if(remove && !_fileName.isEmpty())
+    QFile::remove(MusEGlobal::museProject + "/" + _fileName);
+}
+
+//---------------------------------------------------------
+//   goLive
+//    Gui thread. Returns once the audio thread has stopped
+//     using the cache.
+//---------------------------------------------------------
+
+void TrackFreeze::goLive()
+{
+  const State old = state();
+  if(old == Live)
+    return;
+  _state.store(Live, std::memory_order_release);
+  MusEGlobal::audio->msgAudioWait();
+  // The prefetch thread skipped the track's own parts while it was frozen.
+  if(old == Frozen && _track->type() == Track::WAVE && MusEGlobal::audio->isPlaying())
+    MusEGlobal::audio->msgSeek(MusEGlobal::audio->pos());
+}
+
+//---------------------------------------------------------
+//   startCapture
+//    Gui thread, the track is live. The next run from the
+//     start of the song captures the track.
+//---------------------------------------------------------
+
+void TrackFreeze::startCapture()
+{
+  _signature = combine(_contentSig, controlSignature());
+  if(!_sf && !openCache(true))
+    return;
+  _length = trackFreezeLength();
+  _captureNext = ~0U;
+  _captureComplete.store(false);
+  _state.store(Capturing, std::memory_order_release);
+}
+
+//---------------------------------------------------------
+//   finishCapture
+//    Gui thread. The transport is stopped and the last
+//     captured block has been handed to the prefetch thread.
+//---------------------------------------------------------
+
+void TrackFreeze::finishCapture()
+{
+  goLive();
+  // Wait for the prefetch thread to write the last block.
+  _fileMutex.lock();
+  if(_sf)
+    sf_write_sync(_sf);
+  _fileMutex.unlock();
+  _state.store(Frozen, std::memory_order_release);
+  // Fill the play fifo.
+  MusEGlobal::audio->msgSeek(MusEGlobal::audio->pos());
+  MusEGlobal::song->update(SC_TRACK_MODIFIED);
+}
+
+//---------------------------------------------------------
+//   setMode
+//    Gui thread.
+//---------------------------------------------------------
+
+void TrackFreeze::setMode(Mode mode)
+{
+  if(!canFreeze())
+    mode = Off;
+  if(mode == _mode)
+    return;
+  const bool wasFrozen = state() != Live;
+  goLive();
+  closeCache(true);
+  _fileName = QString();
+  _restored = false;
+  _mode = mode;
+  if(_mode != Off)
+  {
+    _contentSig = contentSignature();
+    _contentGeneration = freezeGeneration;
+    startCapture();
+  }
+  if(wasFrozen || _mode != Off)
+    MusEGlobal::song->update(SC_TRACK_MODIFIED);
+}
+
+//---------------------------------------------------------
+//   update
+//    Gui thread, once per heartbeat.
+//---------------------------------------------------------
+
+void TrackFreeze::update()
+{
+  if(_mode == Off)
+    return;
+
+  // The track was switched to stereo, or a song restored the freeze
+  //  before its synth's outputs were known.
+  if(!canFreeze())
+  {
+    setMode(Off);
+    return;
+  }
+
+  if(_contentGeneration != freezeGeneration)
+  {
+    _contentSig = contentSignature();
+    _contentGeneration = freezeGeneration;
+  }
+  const uint64_t sig = combine(_contentSig, controlSignature());
+
+  if(_restored)
+  {
+    // First check after loading the song. Use the cache if it still matches.
+    _restored = false;
+    if(sig == _signature && openCache(false))
+    {
+      _state.store(Frozen, std::memory_order_release);
+      MusEGlobal::audio->msgSeek(MusEGlobal::audio->pos());
+      return;
+    }
+    closeCache(true);
+    startCapture();
+    return;
+  }
+
+  switch(state())
+  {
+    case Live:
+      // The cache file could not be created. Try again once something changes.
+      if(sig != _signature)
+        startCapture();
+      break;
+
+    case Capturing:
+      if(sig != _signature)
+      {
+        // Part of the run was captured with the old content. Start over.
+        goLive();
+        startCapture();
+      }
+      else if(_captureComplete.load() && !MusEGlobal::audio->isPlaying() &&
+              !MusEGlobal::audio->bounce() && _captureFifo.isEmpty())
+        finishCapture();
+      break;
+
+    case Frozen:
+      if(sig != _signature)
+      {
+        if(MusEGlobal::debugMsg)
+          fprintf(stderr, "TrackFreeze: %s changed, recapturing\n", _track->name().toLatin1().constData());
+        goLive();
+        closeCache(true);
+        startCapture();
+        MusEGlobal::song->update(SC_TRACK_MODIFIED);
+      }
+      break;
+  }
+}
+
+//---------------------------------------------------------
+//   contentSignature
+//    Gui thread. Everything which only changes through
+//     song operations, recomputed after those.
+//---------------------------------------------------------
+
+uint64_t TrackFreeze::contentSignature()
+{
+  FreezeHash h;
+  h.add(int(_mode));
+  h.add(_track->channels());
+  h.add(unsigned(MusEGlobal::sampleRate));
+  h.add(trackFreezeLength());
+
+  const TempoList& tl = MusEGlobal::tempomap;
+  h.add(int(tl.masterFlag()));
+  h.add(tl.staticTempo());
+  h.add(tl.globalTempo());
+  for(ciTEvent it = tl.begin(); it != tl.end(); ++it)
+  {
+    h.add(it->second->tick);
+    h.add(it->second->tempo);
+  }
+
+  if(_track->type() == Track::WAVE)
+    addWaveTrack(h, _track);
+  else
+  {
+    // The midi tracks playing the synth.
+    const int port = static_cast<SynthI*>(_track)->midiPort();
+    MidiTrackList* ml = MusEGlobal::song->midis();
+    for(iMidiTrack it = ml->begin(); it != ml->end(); ++it)
+    {
+      MidiTrack* mt = *it;
+      if(mt->isDrumTrack() || (port >= 0 && mt->outPort() == port))
+        addMidiTrack(h, mt);
+    }
+  }
+
+  // Volume, pan and mute stay live. The rack's automation only matters if it is frozen too.
+  const int rackEnd = genACnum(MAX_PLUGINS, 0);
+  const CtrlListList* cll = _track->controller();
+  for(ciCtrlList icl = cll->lower_bound(AC_PLUGIN_CTL_BASE); icl != cll->end(); ++icl)
+  {
+    if(_mode == PreRack && icl->first < rackEnd)
+      continue;
+    const CtrlList* cl = icl->second;
+    h.add(icl->first);
+    h.add(int(cl->mode()));
+    for(ciCtrl ic = cl->begin(); ic != cl->end(); ++ic)
+    {
+      h.add(ic->second.frame);
+      h.addValue(ic->second.val);
+    }
+  }
+  return h.value();
+}
+
+//---------------------------------------------------------
+//   controlSignature
+//    Gui thread. Rack and parameter values, which can be
+//     changed directly from plugin guis. Checked every heartbeat.
+//---------------------------------------------------------
+
+uint64_t TrackFreeze::controlSignature()
+{
+  FreezeHash h;
+  const bool automated = _track->automationType() != AUTO_OFF;
+  const CtrlListList* cll = _track->controller();
+  if(_mode == PostRack)
+  {
+    const Pipeline* pl = _track->efxPipe();
+    for(int i = 0; i < PipelineDepth; ++i)
+    {
+      const PluginI* p = (*pl)[i];
+      if(!p)
+      {
+        h.add(0);
+        continue;
+      }
+      h.add(1);
+      h.add(p->lib());
+      h.add(p->pluginLabel());
+      h.add(int(p->on()));
+      addParameters(h, p, genACnum(i, 0), cll, automated);
+    }
+  }
+  if(_track->type() == Track::AUDIO_SOFTSYNTH)
+  {
+    const SynthIF* sif = static_cast<SynthI*>(_track)->sif();
+    if(sif)
+    {
+      h.add(sif->lib());
+      h.add(sif->pluginLabel());
+      addParameters(h, sif, genACnum(MAX_PLUGINS, 0), cll, automated);
+    }
+  }
+  return h.value();
+}
+
+//---------------------------------------------------------
+//   write
+//---------------------------------------------------------
+
+void TrackFreeze::write(int level, Xml& xml) const
+{
+  if(_mode == Off)
+    return;
+  xml.tag(level++, "freeze");
+  xml.intTag(level, "mode", int(_mode));
+  // Only a completed cache is worth keeping.
+  if(state() == Frozen)
+  {
+    xml.strTag(level, "file", _fileName);
+    xml.strTag(level, "signature", QString::number((qulonglong)_signature, 16));
+  }
+  xml.etag(level, "freeze");
+}
+
+//---------------------------------------------------------
+//   read
+//---------------------------------------------------------
+
+void TrackFreeze::read(Xml& xml)
+{
+  for(;;)
+  {
+    Xml::Token token = xml.parse();
+    const QString& tag = xml.s1();
+    switch(token)
+    {
+      case Xml::Error:
+      case Xml::End:
+        return;
+      case Xml::TagStart:
+        if(tag == "mode")
+        {
+          const int m = xml.parseInt();
+          _mode = (m == PreRack || m == PostRack) ? Mode(m) : Off;
+        }
+        else if(tag == "file")
+          _fileName = xml.parse1();
+        else if(tag == "signature")
+          _signature = xml.parse1().toULongLong(0, 16);
+        else
+          xml.unknown("freeze");
+        break;
+      case Xml::TagEnd:
+        if(tag == "freeze")
+        {
+          if(!canFreeze())
+            _mode = Off;
+          // Checked against the song at the first update.
+          _restored = _mode != Off;
+          return;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+//---------------------------------------------------------
+//   readCache
+//    The caller holds the file mutex.
+//---------------------------------------------------------
+
+void TrackFreeze::readCache(unsigned pos, int chans, unsigned n, float** buffer)
+{
+  const float fill = MusEGlobal::config.useDenormalBias ? MusEGlobal::denormalBias : 0.0f;
+  unsigned done = 0;
+  while(done < n)
+  {
+    unsigned cnt = n - done;
+    if(cnt > CHUNK_FRAMES)
+      cnt = CHUNK_FRAMES;
+    const unsigned fr = pos + done;
+    unsigned got = 0;
+    if(_sf && _channels > 0 && fr < _length)
+    {
+      unsigned want = _length - fr;
+      if(want > cnt)
+        want = cnt;
+      if(sf_seek(_sf, fr, SEEK_SET | SFM_READ) >= 0)
+      {
+        const sf_count_t rd = sf_readf_float(_sf, _interleaved, want);
+        if(rd > 0)
+          got = rd;
+      }
+    }
+    for(int ch = 0; ch < chans; ++ch)
+    {
+      float* dp = buffer[ch] + done;
+      const int sch = ch < _channels ? ch : _channels - 1;
+      const float* sp = _interleaved + sch;
+      unsigned k = 0;
+      for( ; k < got; ++k, sp += _channels)
+        dp[k] = *sp;
+      for( ; k < cnt; ++k)
+        dp[k] = fill;
+    }
+    done += cnt;
+  }
+}
+
+//---------------------------------------------------------
+//   writeCache
+//    The caller holds the file mutex.
+//---------------------------------------------------------
+
+void TrackFreeze::writeCache(unsigned pos, int chans, unsigned n, float** buffer)
+{
+  if(!_sf || _channels <= 0 || pos >= _length)
+    return;
+  if(n > _length - pos)
+    n = _length - pos;
+  if(sf_seek(_sf, pos, SEEK_SET | SFM_WRITE) < 0)
+  {
+    fprintf(stderr, "TrackFreeze: %s: cannot seek the cache to %u\n", _track->name().toLatin1().constData(), pos);
+    return;
+  }
+  unsigned done = 0;
+  while(done < n)
+  {
+    unsigned cnt = n - done;
+    if(cnt > CHUNK_FRAMES)
+      cnt = CHUNK_FRAMES;
+    for(int ch = 0; ch < _channels; ++ch)
+    {
+      float* dp = _interleaved + ch;
+      if(ch < chans)
+      {
+        const float* sp = buffer[ch] + done;
+        for(unsigned k = 0; k < cnt; ++k, dp += _channels)
+          *dp = sp[k];
+      }
+      else
+      {
+        for(unsigned k = 0; k < cnt; ++k, dp += _channels)
+          *dp = 0.0f;
+      }
+    }
+    if(sf_writef_float(_sf, _interleaved, cnt) != (sf_count_t)cnt)
+    {
+      fprintf(stderr, "TrackFreeze: %s: write error: %s\n", _track->name().toLatin1().constData(), sf_strerror(_sf));
+      return;
+    }
+    done += cnt;
+  }
+}
+
+//---------------------------------------------------------
+//   getData
+//    Audio thread.
+//---------------------------------------------------------
+
+bool TrackFreeze::getData(unsigned pos, int trackChans, int totalChans, unsigned n, float** buffer)
+{
+  // Nothing is rendered, but the synth's queued events must not pile up.
+  if(_track->type() == Track::AUDIO_SOFTSYNTH)
+    static_cast<SynthI*>(_track)->discardOutEvents();
+
+  if(!MusEGlobal::audio->isPlaying())
+    return false;
+
+  if(MusEGlobal::audio->freewheel())
+  {
+    // When freewheeling, read directly from the file, like wave tracks do.
+    _fileMutex.lock();
+    readCache(pos, trackChans, n, buffer);
+    _fileMutex.unlock();
+  }
+  else
+  {
+    float* pf_buf[trackChans];
+    unsigned fpos;
+    if(_playFifo.get(trackChans, n, pf_buf, &fpos))
+    {
+      fprintf(stderr, "TrackFreeze::getData(%s) fifo underrun\n", _track->name().toLocal8Bit().constData());
+      return false;
+    }
+    while(fpos < pos)
+    {
+      if(_playFifo.get(trackChans, n, pf_buf, &fpos))
+      {
+        fprintf(stderr, "TrackFreeze::getData(%s) fifo underrun\n", _track->name().toLocal8Bit().constData());
+        return false;
+      }
+    }
+    // Still filling after a seek.
+    if(fpos != pos)
+      return false;
+    for(int i = 0; i < trackChans; ++i)
+      AL::dsp->cpy(buffer[i], pf_buf[i], n, MusEGlobal::config.useDenormalBias);
+  }
+
+  // Only the main channels are frozen. canFreeze() keeps synths
+  //  with extra outputs live, so these are the unused buffers.
+  for(int i = trackChans; i < totalChans; ++i)
+  {
+    if(MusEGlobal::config.useDenormalBias)
+    {
+      for(unsigned int q = 0; q < n; ++q)
+        buffer[i][q] = MusEGlobal::denormalBias;
+    }
+    else
+      memset(buffer[i], 0, sizeof(float) * n);
+  }
+  return true;
+}
+
+//---------------------------------------------------------
+//   capture
+//    Audio thread. A run only counts if it starts at the
+//     beginning of the song and is never interrupted.
+//---------------------------------------------------------
+
+void TrackFreeze::capture(unsigned pos, int chans, unsigned n, float** buffer)
+{
+  if(!MusEGlobal::audio->isPlaying())
+    return;
+  // A muted or monitoring wave track does not play its parts.
+  if(_track->isMute() || _track->isRecMonitored())
+  {
+    _captureNext = ~0U;
+    return;
+  }
+  if(pos == 0)
+  {
+    _captureNext = 0;
+    _captureComplete.store(false);
+  }
+  else if(pos != _captureNext)
+  {
+    _captureNext = ~0U;
+    return;
+  }
+
+  if(pos < _length)
+  {
+    if(MusEGlobal::audio->freewheel())
+    {
+      _fileMutex.lock();
+      writeCache(pos, chans, n, buffer);
+      _fileMutex.unlock();
+    }
+    // The fifo only holds whole segments.
+    else if(n != MusEGlobal::segmentSize || _captureFifo.put(chans, n, buffer, pos))
+    {
+      _captureNext = ~0U;
+      return;
+    }
+  }
+
+  _captureNext = pos + n;
+  if(_captureNext >= _length)
+    _captureComplete.store(true);
+}
+
+//---------------------------------------------------------
+//   fetch
+//    Prefetch thread.
+//---------------------------------------------------------
+
+void TrackFreeze::fetch(unsigned pos, unsigned n)
+{
+  if(state() != Frozen || _track->off())
+    return;
+  const int chans = _track->channels();
+  float* bp[chans];
+  if(_playFifo.getWriteBuffer(chans, n, bp, pos))
+    return;
+  _fileMutex.lock();
+  readCache(pos, chans, n, bp);
+  _fileMutex.unlock();
+  _playFifo.add();
+}
+
+//---------------------------------------------------------
+//   writeCaptured
+//    Prefetch thread. Writes what the audio thread captured.
+//---------------------------------------------------------
+
+void TrackFreeze::writeCaptured()
+{
+  if(_captureFifo.isEmpty())
+    return;
+  // Held until the blocks are written, see finishCapture().
+  _fileMutex.lock();
+  while(!_captureFifo.isEmpty())
+  {
+    const int chans = _track->channels();
+    float* bp[chans];
+    unsigned pos;
+    if(_captureFifo.get(chans, MusEGlobal::segmentSize, bp, &pos))
+      break;
+    // Blocks left over from an abandoned run are overwritten by the next one.
+    writeCache(pos, chans, MusEGlobal::segmentSize, bp);
+  }
+  _fileMutex.unlock();
+}
+
+//---------------------------------------------------------
+//   updateTrackFreezes
+//---------------------------------------------------------
+
+void updateTrackFreezes()
+{
+  TrackList* tl = MusEGlobal::song->tracks();
+  for(iTrack it = tl->begin(); it != tl->end(); ++it)
+  {
+    if((*it)->isMidiTrack())
+      continue;
+    static_cast<AudioTrack*>(*it)->freeze()->update();
+  }
+}
+
+//---------------------------------------------------------
+//   invalidateTrackFreezes
+//---------------------------------------------------------
+
+void invalidateTrackFreezes(SongChangedFlags_t flags)
+{
+  const SongChangedFlags_t mask =
+    SC_TRACK_INSERTED | SC_TRACK_REMOVED | SC_TRACK_MODIFIED |
+    SC_PART_INSERTED | SC_PART_REMOVED | SC_PART_MODIFIED |
+    SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED |
+    SC_SIG | SC_TEMPO | SC_MASTER | SC_MUTE | SC_SOLO | SC_ROUTE | SC_CHANNELS |
+    SC_CONFIG | SC_DRUMMAP | SC_MIDI_INSTRUMENT | SC_AUDIO_CONTROLLER | SC_AUTOMATION |
+    SC_RACK | SC_CLIP_MODIFIED | SC_MIDI_TRACK_PROP | SC_AUDIO_CONTROLLER_LIST;
+  if(flags & mask)
+    ++freezeGeneration;
+}
+
+//---------------------------------------------------------
+//   trackFreezeLength
+//---------------------------------------------------------
+
+unsigned trackFreezeLength()
+{
+  return MusEGlobal::tempomap.tick2frame(MusEGlobal::song->len());
+}
+
+//---------------------------------------------------------
+//   renderFrozenTracks
+//---------------------------------------------------------
+
+void renderFrozenTracks()
+{
+  if(MusEGlobal::audio->bounce() || MusEGlobal::audio->isPlaying())
+    return;
+  bool waiting = false;
+  TrackList* tl = MusEGlobal::song->tracks();
+  for(iTrack it = tl->begin(); it != tl->end(); ++it)
+  {
+    if(!(*it)->isMidiTrack() && static_cast<AudioTrack*>(*it)->freeze()->state() == TrackFreeze::Capturing)
+    {
+      waiting = true;
+      break;
+    }
+  }
+  if(!waiting)
+    return;
+
+  const Pos start(0, false);
+  MusEGlobal::song->setPos(Song::CPOS, start, true, true, true);
+  MusEGlobal::audio->msgBounce(start, Pos(trackFreezeLength(), false));
+  MusEGlobal::song->setPlay(true);
+}
+
+} // namespace MusECore
@@ -0,0 +1,156 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  trackfreeze.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __TRACKFREEZE_H__
+#define __TRACKFREEZE_H__
+
+#include <atomic>
+#include <stdint.h>
+#include <sndfile.h>
+
+#include <QString>
+#include <QMutex>
+
+#include "globaldefs.h"
+#include "type_defs.h"
+#include "node.h"
+
+namespace MusECore {
+
+class AudioTrack;
+class Xml;
+
+//---------------------------------------------------------
+//   TrackFreeze
+//    Renders a wave or synth track into a cache file and
+//     streams it back instead of running the track.
+//    Pre-rack freezing replaces only the track's sources,
+//     post-rack freezing also replaces the effect rack.
+//     Volume, pan and the aux sends always stay live.
+//    The cache is captured while the track plays from the
+//     start to the end of the song in one run, either during
+//     normal playback or during a freewheel render pass.
+//     Seeking or looping part way breaks the run, since the
+//     synth and plugin states would no longer match.
+//    A signature of everything which affects the rendered
+//     audio (parts, events, tempo, automation, rack and
+//     plugin parameters) is checked once per heartbeat.
+//     When it changes the cache is dropped, the track plays
+//     live again and the next run recaptures it.
+//---------------------------------------------------------
+
+class TrackFreeze
+{
+   public:
+      enum Mode { Off = 0, PreRack, PostRack };
+      enum State { Live = 0, Capturing, Frozen };
+
+   private:
+      // Frames converted per libsndfile call.
+      enum { CHUNK_FRAMES = 1024 };
+
+      AudioTrack* _track;
+      // Only changed by the gui while the state is Live, after the audio thread has let go.
+      Mode _mode;
+      // Written by the gui, read by the audio and prefetch threads.
+      std::atomic<int> _state;
+
+      // The cache file. Written by the prefetch thread, or by the audio thread when freewheeling.
+      QMutex _fileMutex;
+      SNDFILE* _sf;
+      int _channels;
+      // Length of the render, in frames. Reads beyond it are silent.
+      unsigned _length;
+      float _interleaved[CHUNK_FRAMES * MAX_CHANNELS];
+
+      // Audio thread -> prefetch thread while capturing.
+      Fifo _captureFifo;
+      // Prefetch thread -> audio thread while frozen.
+      Fifo _playFifo;
+
+      // Audio thread only. Next frame of the current capture run, or ~0 if there is no run.
+      unsigned _captureNext;
+      // Set by the audio thread once a run reached the end, cleared when a new run starts.
+      std::atomic<bool> _captureComplete;
+
+      // Gui thread only.
+      QString _fileName;
+      // Signature the cache was, or is being, captured with.
+      uint64_t _signature;
+      // Signature read from the song file, until the first check.
+      bool _restored;
+      uint64_t _contentSig;
+      unsigned _contentGeneration;
+
+      bool openCache(bool create);
+      void closeCache(bool remove);
+      void startCapture();
+      void finishCapture();
+      void goLive();
+      uint64_t contentSignature();
+      uint64_t controlSignature();
+
+      void readCache(unsigned pos, int chans, unsigned n, float** buffer);
+      void writeCache(unsigned pos, int chans, unsigned n, float** buffer);
+
+   public:
+      TrackFreeze(AudioTrack* track);
+      ~TrackFreeze();
+
+      Mode mode() const { return _mode; }
+      State state() const { return State(_state.load(std::memory_order_acquire)); }
+      // Only wave and synth tracks can be frozen, and synths only
+      //  if all their outputs go through the track's own channels.
+      bool canFreeze() const;
+
+      // Gui thread.
+      void setMode(Mode mode);
+      // Gui thread. Checks the signature, and freezes the track once a capture run has completed.
+      void update();
+      void write(int level, Xml& xml) const;
+      void read(Xml& xml);
+
+      // Audio thread. Fills the track's main channels from the cache.
+      // Returns false if there is nothing to play.
+      bool getData(unsigned pos, int trackChans, int totalChans, unsigned n, float** buffer);
+      // Audio thread. Records the track's output into the current capture run.
+      void capture(unsigned pos, int chans, unsigned n, float** buffer);
+
+      // Prefetch thread.
+      void fetch(unsigned pos, unsigned n);
+      void clearPlayFifo() { _playFifo.clear(); }
+      void writeCaptured();
+};
+
+// Gui thread. Updates all frozen tracks. Called once per heartbeat.
+extern void updateTrackFreezes();
+// Gui thread. Marks the content signatures of all frozen tracks stale,
+//  if the song change can affect them.
+extern void invalidateTrackFreezes(SongChangedFlags_t flags);
+// Gui thread. Length of a render covering the whole song, in frames.
+extern unsigned trackFreezeLength();
+// Gui thread. Captures all tracks waiting for it in one freewheel pass from the start of the song.
+extern void renderFrozenTracks();
+
+} // namespace MusECore
+
+#endif
@@ -0,0 +1,180 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  transformcompile.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __TRANSFORMCOMPILE_H__
+#define __TRANSFORMCOMPILE_H__
+
+#include <limits.h>
+
+#include "miditransform.h"
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   Compiled transforms
+//    The select ranges and value operators of the midi
+//     transformer and the input transformer, compiled
+//     into a few plain values which are cheap to run.
+//---------------------------------------------------------
+
+// Passes if (lo <= val <= hi) differs from invert. Every ValOp maps to one.
+struct TransformRange {
+      int lo, hi;
+      bool invert;
+      bool pass(int val) const { return ((val >= lo) & (val <= hi)) != invert; }
+      };
+
+// Dynamic and Jitter are only used by the midi transformer,
+//  Toggle only by the input transformer.
+enum TransformOpKind { TLinear, TMultiply, TDivide, TDynamic, TRandom, TJitter, TToggle };
+
+// Linear: val = k + s * val, which covers Keep, Plus, Minus, Fix,
+//  Value, Invert and Flip. Dynamic ramps from k to k + range
+//  over the loop, Jitter adds up to +-range.
+struct TransformOp {
+      TransformOpKind kind;
+      int k, s;
+      double factor;
+      int lo, range;
+      };
+
+//---------------------------------------------------------
+//   compileRange
+//---------------------------------------------------------
+
+inline TransformRange compileRange(ValOp op, int a, int b)
+      {
+      TransformRange r;
+      r.invert = false;
+      switch (op) {
+            case Equal:
+                  r.lo = a;
+                  r.hi = a;
+                  break;
+            case Unequal:
+                  r.lo = a;
+                  r.hi = a;
+                  r.invert = true;
+                  break;
+            case Higher:
+                  r.lo = INT_MIN;
+                  r.hi = a;
+                  r.invert = true;
+                  break;
+            case Lower:
+                  r.lo = a;
+                  r.hi = INT_MAX;
+                  r.invert = true;
+                  break;
+            case Inside:
+                  r.lo = a;
+                  r.hi = b - 1;
+                  break;
+            case Outside:
+                  r.lo = a;
+                  r.hi = b - 1;
+                  r.invert = true;
+                  break;
+            case Ignore:
+            default:
+                  r.lo = INT_MIN;
+                  r.hi = INT_MAX;
+                  break;
+            }
+      return r;
+      }
+
+//---------------------------------------------------------
+//   compileOp
+//    value is the operand of Value, invertBase the value
+//     Invert subtracts from, randomEqual the result of a
+//     Random whose bounds are equal. Operators a field does
+//     not support keep it; the callers set up Dynamic and
+//     Toggle themselves.
+//---------------------------------------------------------
+
+inline TransformOp compileOp(TransformOperator op, int a, int b, int value, int invertBase, bool flip, int randomEqual)
+      {
+      TransformOp o;
+      o.kind   = TLinear;
+      o.k      = 0;
+      o.s      = 1;
+      o.factor = 1.0;
+      o.lo     = 0;
+      o.range  = 1;
+      switch (op) {
+            case Plus:
+                  o.k = a;
+                  break;
+            case Minus:
+                  o.k = -a;
+                  break;
+            case Multiply:
+                  o.kind   = TMultiply;
+                  o.factor = a / 100.0;
+                  break;
+            case Divide:
+                  o.kind   = TDivide;
+                  o.factor = a / 100.0;
+                  break;
+            case Fix:
+                  o.k = a;
+                  o.s = 0;
+                  break;
+            case Value:
+                  o.k = value;
+                  o.s = 0;
+                  break;
+            case Invert:
+                  o.k = invertBase;
+                  o.s = -1;
+                  break;
+            case Flip:
+                  if (flip) {
+                        o.k = a;
+                        o.s = -1;
+                        }
+                  break;
+            case Random:
+                  if (b == a) {
+                        o.k = randomEqual;
+                        o.s = 0;
+                        }
+                  else {
+                        o.kind  = TRandom;
+                        o.lo    = b > a ? a : b;
+                        o.range = b > a ? b - a : a - b;
+                        }
+                  break;
+            case ScaleMap:
+            case Dynamic:
+            case Keep:
+            case Toggle:
+            default:
+                  break;
+            }
+      return o;
+      }
+
+} // namespace MusECore
+
+#endif
@@ -35,6 +35,7 @@
 #include "part.h"
 #include "audiodev.h"
 #include "track.h"
+#include "undostore.h"
 
 #include <string.h>
 #include <QAction>
@@ -62,7 +63,7 @@ const char* UndoOp::typeName()
             "AddRoute", "DeleteRoute", 
             "AddTrack", "DeleteTrack", 
             "AddPart",  "DeletePart", "MovePart", "ModifyPartLength", "ModifyPartName", "SelectPart",
-            "AddEvent", "DeleteEvent", "ModifyEvent", "SelectEvent",
+            "AddEvent", "DeleteEvent", "ModifyEvent", "SelectEvent", "ModifyEventBatch",
             "AddAudioCtrlVal", "DeleteAudioCtrlVal", "ModifyAudioCtrlVal", "ModifyAudioCtrlValList",
             "AddTempo", "DeleteTempo", "ModifyTempo", "SetTempo", "SetStaticTempo", "SetGlobalTempo",
             "AddSig",   "DeleteSig",   "ModifySig",
@@ -100,6 +101,11 @@ void UndoOp::dump()
                   if (part)
                         part->dump(5);
                   break;
+            case ModifyEventBatch:
+                  printf("%d events\n   Part:\n", _eventBatch ? int(_eventBatch->size()) : 0);
+                  if (part)
+                        part->dump(5);
+                  break;
             case ModifyTrackName:
                   printf("<%s>-<%s>\n", _oldName->toLocal8Bit().data(), _newName->toLocal8Bit().data());
                   break;
@@ -139,6 +145,7 @@ void UndoList::clearDelete()
       for(iUndo iu = begin(); iu != end(); ++iu)
       {
         Undo& u = *iu;
+        MusEGlobal::undoStore.discard(u);
         for(iUndoOp i = u.begin(); i != u.end(); ++i)
         {
           switch(i->type)
@@ -171,6 +178,11 @@ void UndoList::clearDelete()
                   if (i->_addCtrlList)
                     delete i->_addCtrlList;
                   break;
+
+            case UndoOp::ModifyEventBatch:
+                  if (i->_eventBatch)
+                    delete i->_eventBatch;
+                  break;
                   
             default:
                   break;
@@ -184,6 +196,7 @@ void UndoList::clearDelete()
       for(riUndo iu = rbegin(); iu != rend(); ++iu)
       {
         Undo& u = *iu;
+        MusEGlobal::undoStore.discard(u);
         for(riUndoOp i = u.rbegin(); i != u.rend(); ++i)
         {
           switch(i->type)
@@ -215,6 +228,11 @@ void UndoList::clearDelete()
                   if (i->_addCtrlList)
                     delete i->_addCtrlList;
                   break;
+
+            case UndoOp::ModifyEventBatch:
+                  if (i->_eventBatch)
+                    delete i->_eventBatch;
+                  break;
                   
             default:
                   break;
@@ -264,6 +282,7 @@ void Song::endUndo(SongChangedStruct_t flags)
               if (prev_undo->merge_combo(undoList->back()))
                     undoList->pop_back();
         }
+        MusEGlobal::undoStore.enforce(undoList);
       }
       
       // Even if the current list was empty, or emptied during appending of given operations to the current list, 
@@ -418,6 +437,9 @@ void Undo::insert(Undo::iterator position, const UndoOp& op)
     case UndoOp::SelectEvent:
       fprintf(stderr, "Undo::insert: SelectEvent\n");
     break;
+    case UndoOp::ModifyEventBatch:
+      fprintf(stderr, "Undo::insert: ModifyEventBatch\n");
+    break;
     
     
     case UndoOp::AddAudioCtrlVal:
@@ -509,7 +531,9 @@ void Undo::insert(Undo::iterator position, const UndoOp& op)
 #endif
 
   // (NOTE: Use this handy speed-up 'if' line to exclude unhandled operation types)
-  if(n_op.type != UndoOp::ModifyTrackChannel && n_op.type != UndoOp::ModifyClip && n_op.type != UndoOp::ModifyMarker && n_op.type != UndoOp::DoNothing) 
+  // Batches are not merged. Skipping them avoids scanning the whole list for each one.
+  if(n_op.type != UndoOp::ModifyTrackChannel && n_op.type != UndoOp::ModifyClip && n_op.type != UndoOp::ModifyMarker && n_op.type != UndoOp::DoNothing &&
+     n_op.type != UndoOp::ModifyEventBatch) 
   {
     // TODO FIXME: Must look beyond position and optimize in that direction too !
     //for(Undo::iterator iuo = begin(); iuo != position; ++iuo)
@@ -1343,6 +1367,9 @@ bool Undo::merge_combo(const Undo& other)
 {
   if (other.combobreaker)
           return false;
+  // Groups whose events were moved to the undo store are settled.
+  if (storeId >= 0 || other.storeId >= 0)
+          return false;
   
   int has_other=0x01;
   int has_select_event=0x02;
@@ -1814,6 +1841,20 @@ UndoOp::UndoOp(UndoType type_, const Event& nev, const Part* part_, bool a_, boo
       }
       }
       
+UndoOp::UndoOp(UndoType type_, const Part* part_, UndoEventBatch* batch, bool doCtrls_, bool doClones_, bool noUndo)
+      {
+      assert(type_==ModifyEventBatch);
+      assert(part_);
+      assert(batch);
+      
+      type   = type_;
+      part   = part_;
+      _eventBatch = batch;
+      doCtrls = doCtrls_;
+      doClones = doClones_;
+      _noUndo = noUndo;
+      }
+      
 UndoOp::UndoOp(UndoType type_, Marker* copyMarker_, Marker* realMarker_, bool noUndo)
       {
       assert(type_==ModifyMarker);
@@ -2336,6 +2377,35 @@ void Song::revertOperationGroup1(Undo& operations)
                         updateFlags |= SC_EVENT_MODIFIED;
                         break;
 
+                  case UndoOp::ModifyEventBatch:
+                  {
+#ifdef _UNDO_DEBUG_
+                        fprintf(stderr, "Song::revertOperationGroup1:ModifyEventBatch\n");
+#endif                        
+                        const UndoEventBatch* batch = i->_eventBatch;
+                        for(size_t k = batch->size(); k > 0; --k)
+                        {
+                          const Event& oe = batch->oldEvents[k - 1];
+                          const Event& ne = batch->newEvents[k - 1];
+                          if(oe.empty())
+                          {
+                            deleteEventOperation(ne, editable_part, i->doCtrls, i->doClones);
+                            updateFlags |= SC_EVENT_REMOVED;
+                          }
+                          else if(ne.empty())
+                          {
+                            addEventOperation(oe, editable_part, i->doCtrls, i->doClones);
+                            updateFlags |= SC_EVENT_INSERTED;
+                          }
+                          else
+                          {
+                            changeEventOperation(ne, oe, editable_part, i->doCtrls, i->doClones);
+                            updateFlags |= SC_EVENT_MODIFIED;
+                          }
+                        }
+                  }
+                  break;
+
                         
                   case UndoOp::AddAudioCtrlVal:
                   {
@@ -3123,6 +3193,37 @@ void Song::executeOperationGroup1(Undo& operations)
                         updateFlags |= SC_EVENT_MODIFIED;
                         break;
 
+                  case UndoOp::ModifyEventBatch:
+                  {
+#ifdef _UNDO_DEBUG_
+                        fprintf(stderr, "Song::executeOperationGroup1:ModifyEventBatch\n");
+#endif                        
+                        UndoEventBatch* batch = i->_eventBatch;
+                        const size_t sz = batch->size();
+                        for(size_t k = 0; k < sz; ++k)
+                        {
+                          const Event& oe = batch->oldEvents[k];
+                          const Event& ne = batch->newEvents[k];
+                          if(oe.empty())
+                          {
+                            addEventOperation(ne, editable_part, i->doCtrls, i->doClones);
+                            updateFlags |= SC_EVENT_INSERTED;
+                          }
+                          else if(ne.empty())
+                          {
+                            // Same as DeleteEvent: keep the real event found in the lists, so it can be restored.
+                            batch->oldEvents[k] = deleteEventOperation(oe, editable_part, i->doCtrls, i->doClones);
+                            updateFlags |= SC_EVENT_REMOVED;
+                          }
+                          else
+                          {
+                            changeEventOperation(oe, ne, editable_part, i->doCtrls, i->doClones);
+                            updateFlags |= SC_EVENT_MODIFIED;
+                          }
+                        }
+                  }
+                  break;
+
                         
                   case UndoOp::AddAudioCtrlVal:
                   {
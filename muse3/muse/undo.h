@@ -25,6 +25,7 @@
 #define __UNDO_H__
 
 #include <list>
+#include <vector>
 
 #include "event.h"
 #include "marker/marker.h"
@@ -42,6 +43,26 @@ class CtrlList;
 struct CtrlVal;
 
 extern std::list<QString> temporaryWavFiles; //!< Used for storing all tmp-files, for cleanup on shutdown
+
+//---------------------------------------------------------
+//   UndoEventBatch
+//    Compact record of many event changes in one part,
+//     used by ModifyEventBatch instead of one UndoOp per event.
+//    An empty old event means the new event is added,
+//     an empty new event means the old event is deleted.
+//    Midi events only.
+//---------------------------------------------------------
+
+struct UndoEventBatch {
+      std::vector<Event> oldEvents;
+      std::vector<Event> newEvents;
+
+      void reserve(size_t n) { oldEvents.reserve(n); newEvents.reserve(n); }
+      void add(const Event& oldEvent, const Event& newEvent) { oldEvents.push_back(oldEvent); newEvents.push_back(newEvent); }
+      size_t size() const { return oldEvents.size(); }
+      bool empty() const { return oldEvents.empty(); }
+};
+
 //---------------------------------------------------------
 //   UndoOp
 //---------------------------------------------------------
@@ -51,7 +72,7 @@ struct UndoOp {
             AddRoute, DeleteRoute,
             AddTrack, DeleteTrack,
             AddPart,  DeletePart,  MovePart, ModifyPartLength, ModifyPartName, SelectPart,
-            AddEvent, DeleteEvent, ModifyEvent, SelectEvent,
+            AddEvent, DeleteEvent, ModifyEvent, SelectEvent, ModifyEventBatch,
             AddAudioCtrlVal, DeleteAudioCtrlVal, ModifyAudioCtrlVal, ModifyAudioCtrlValList,
             // Add, delete and modify operate directly on the list.
             // setTempo does only if master is set, otherwise it operates on the static tempo value.
@@ -122,6 +143,8 @@ struct UndoOp {
 
       QString* _oldName;
       QString* _newName;
+      // For ModifyEventBatch. Owned by the operation, deleted with the undo list.
+      UndoEventBatch* _eventBatch;
       Event oEvent;
       Event nEvent;
       bool selected;
@@ -153,6 +176,8 @@ struct UndoOp {
              const Track* oTrack = 0, const Track* nTrack = 0, bool noUndo = false);
       UndoOp(UndoType type, const Event& nev, const Event& oev, const Part* part, bool doCtrls, bool doClones, bool noUndo = false);
       UndoOp(UndoType type, const Event& nev, const Part* part, bool, bool, bool noUndo = false);
+      // Takes ownership of the batch.
+      UndoOp(UndoType type, const Part* part, UndoEventBatch* batch, bool doCtrls, bool doClones, bool noUndo = false);
       UndoOp(UndoType type, const Event& changedEvent, const QString& changeData, int startframe, int endframe, bool noUndo = false);
       UndoOp(UndoType type, Marker* copyMarker, Marker* realMarker, bool noUndo = false);
       UndoOp(UndoType type, const Track* track, const QString& old_name, const QString& new_name, bool noUndo = false);
@@ -169,9 +194,9 @@ struct UndoOp {
 
 class Undo : public std::list<UndoOp> {
    public:
-      Undo() : std::list<UndoOp>() { combobreaker=false; }
-      Undo(const Undo& other) : std::list<UndoOp>(other) { this->combobreaker=other.combobreaker; }
-      Undo& operator=(const Undo& other) { std::list<UndoOp>::operator=(other); this->combobreaker=other.combobreaker; return *this;}
+      Undo() : std::list<UndoOp>() { combobreaker=false; storeId=-1; }
+      Undo(const Undo& other) : std::list<UndoOp>(other) { this->combobreaker=other.combobreaker; this->storeId=other.storeId; }
+      Undo& operator=(const Undo& other) { std::list<UndoOp>::operator=(other); this->combobreaker=other.combobreaker; this->storeId=other.storeId; return *this;}
 
       bool empty() const;
       
@@ -179,6 +204,10 @@ class Undo : public std::list<UndoOp> {
       /** if set, forbid merging (below).
        *  Defaults to false */
       bool combobreaker; 
+
+      /** id of the group's compacted events in the undo store,
+       *  or -1 if the events are held by the operations. */
+      int storeId;
       
       /** is possible, merges itself and other by appending
        *  all contents of other at this->end().
@@ -0,0 +1,544 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  undostore.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <stdio.h>
+#include <vector>
+
+#include <QDir>
+#include <QTemporaryFile>
+
+#include "undostore.h"
+#include "undo.h"
+#include "event.h"
+#include "midievent.h"
+#include "part.h"
+#include "globals.h"
+#include "gconfig.h"
+
+namespace MusEGlobal {
+MusECore::UndoStore undoStore;
+}
+
+namespace MusECore {
+
+// Rough bytes per event besides the event base: reference, list node and allocator overhead.
+static const size_t EVENT_OVERHEAD = 64;
+
+//---------------------------------------------------------
+//   Delta stream encoding
+//---------------------------------------------------------
+
+static void putVarint(QByteArray& out, uint64_t v)
+{
+  while(v >= 0x80)
+  {
+    out.append((char)(v | 0x80));
+    v >>= 7;
+  }
+  out.append((char)v);
+}
+
+static void putSVarint(QByteArray& out, int64_t v)
+{
+  putVarint(out, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+//---------------------------------------------------------
+//   StreamReader
+//---------------------------------------------------------
+
+class StreamReader
+{
+      const unsigned char* _p;
+      const unsigned char* _end;
+      bool _ok;
+
+   public:
+      StreamReader(const QByteArray& in)
+        : _p((const unsigned char*)in.constData()), _end(_p + in.size()), _ok(true) { }
+
+      bool ok() const { return _ok; }
+      void fail() { _ok = false; }
+
+      uint64_t varint()
+      {
+        uint64_t v = 0;
+        int shift = 0;
+        while(_p < _end && shift < 64)
+        {
+          const unsigned char c = *_p++;
+          v |= (uint64_t)(c & 0x7f) << shift;
+          if(!(c & 0x80))
+            return v;
+          shift += 7;
+        }
+        _ok = false;
+        return 0;
+      }
+
+      int64_t svarint()
+      {
+        const uint64_t v = varint();
+        return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+      }
+
+      int byte()
+      {
+        if(_p >= _end)
+        {
+          _ok = false;
+          return 0;
+        }
+        return *_p++;
+      }
+
+      const unsigned char* bytes(size_t n)
+      {
+        if((size_t)(_end - _p) < n)
+        {
+          _ok = false;
+          return 0;
+        }
+        const unsigned char* p = _p;
+        _p += n;
+        return p;
+      }
+};
+
+//---------------------------------------------------------
+//   EventCoder
+//    Events are written one after the other, with ticks and
+//     ids as differences from the previous event.
+//---------------------------------------------------------
+
+struct EventCoder
+{
+      int64_t prevTick;
+      int64_t prevUniqueId;
+
+      EventCoder() : prevTick(0), prevUniqueId(0) { }
+
+      void write(QByteArray& out, const Event& e)
+      {
+        putVarint(out, (unsigned)e.type() | (e.selected() ? 0x80 : 0));
+        const int64_t uid = e.uniqueId();
+        putSVarint(out, uid - prevUniqueId);
+        putSVarint(out, e.id() - uid);
+        prevUniqueId = uid;
+        const int64_t tick = e.tick();
+        putSVarint(out, tick - prevTick);
+        prevTick = tick;
+        putVarint(out, e.lenTick());
+        putSVarint(out, e.dataA());
+        putSVarint(out, e.dataB());
+        putSVarint(out, e.dataC());
+        const int len = e.dataLen();
+        putVarint(out, len);
+        if(len > 0)
+          out.append((const char*)e.data(), len);
+      }
+
+      Event read(StreamReader& in)
+      {
+        const unsigned tf = in.varint();
+        Event e((EventType)(tf & 0x7f));
+        e.setSelected(tf & 0x80);
+        const int64_t uid = prevUniqueId + in.svarint();
+        const int64_t id = uid + in.svarint();
+        prevUniqueId = uid;
+        e.restoreIds(uid, id);
+        const int64_t tick = prevTick + in.svarint();
+        prevTick = tick;
+        e.setTick(tick);
+        e.setLenTick(in.varint());
+        e.setA(in.svarint());
+        e.setB(in.svarint());
+        e.setC(in.svarint());
+        const size_t len = in.varint();
+        if(len > 0)
+        {
+          const unsigned char* data = in.bytes(len);
+          if(data)
+            e.setData(data, len);
+        }
+        return e;
+      }
+};
+
+//---------------------------------------------------------
+//   Event slots
+//    The events of an operation, numbered. For single event
+//     operations 0 is the new and 1 the old event, for batches
+//     2k is the old and 2k+1 the new event of entry k.
+//---------------------------------------------------------
+
+static size_t slotCount(const UndoOp& op)
+{
+  switch(op.type)
+  {
+    case UndoOp::AddEvent:
+    case UndoOp::DeleteEvent:
+    case UndoOp::ModifyEvent:
+      return 2;
+    case UndoOp::ModifyEventBatch:
+      return op._eventBatch ? 2 * op._eventBatch->size() : 0;
+    default:
+      return 0;
+  }
+}
+
+static Event& slotEvent(UndoOp& op, size_t slot)
+{
+  if(op.type == UndoOp::ModifyEventBatch)
+    return (slot & 1) ? op._eventBatch->newEvents[slot >> 1] : op._eventBatch->oldEvents[slot >> 1];
+  return slot ? op.oEvent : op.nEvent;
+}
+
+static const Event& slotEvent(const UndoOp& op, size_t slot)
+{
+  return slotEvent(const_cast<UndoOp&>(op), slot);
+}
+
+// Whether only the history refers to the event, so that dropping it frees memory.
+static bool isCompactable(const Event& e)
+{
+  return !e.empty() && e.type() != Wave && e.getRefCount() == 1;
+}
+
+// Whether all events of a deleted part can be taken.
+static bool isCompactablePart(const UndoOp& op)
+{
+  if(op.type != UndoOp::DeletePart || !op.part || op.part->events().empty())
+    return false;
+  const EventList& el = op.part->events();
+  for(ciEvent ie = el.begin(); ie != el.end(); ++ie)
+    if(!isCompactable(ie->second))
+      return false;
+  return true;
+}
+
+static size_t eventSize(const Event& e)
+{
+  return sizeof(MidiEventBase) + EVENT_OVERHEAD + e.dataLen();
+}
+
+//---------------------------------------------------------
+//   UndoStore
+//---------------------------------------------------------
+
+UndoStore::UndoStore() : _nextId(0), _memBytes(0), _log(0)
+{
+}
+
+UndoStore::~UndoStore()
+{
+  // Removes the file.
+  delete _log;
+}
+
+//---------------------------------------------------------
+//   estimate
+//---------------------------------------------------------
+
+size_t UndoStore::estimate(const Undo& group)
+{
+  if(group.storeId >= 0)
+    return 0;
+  size_t sz = 0;
+  for(ciUndoOp i = group.begin(); i != group.end(); ++i)
+  {
+    if(isCompactablePart(*i))
+    {
+      const EventList& el = i->part->events();
+      for(ciEvent ie = el.begin(); ie != el.end(); ++ie)
+        sz += eventSize(ie->second);
+      continue;
+    }
+    const size_t slots = slotCount(*i);
+    for(size_t s = 0; s < slots; ++s)
+    {
+      const Event& e = slotEvent(*i, s);
+      if(isCompactable(e))
+        sz += eventSize(e);
+    }
+  }
+  return sz;
+}
+
+//---------------------------------------------------------
+//   operationCount
+//---------------------------------------------------------
+
+size_t UndoStore::operationCount(const Undo& group)
+{
+  size_t n = 0;
+  for(ciUndoOp i = group.begin(); i != group.end(); ++i)
+  {
+    if(i->type == UndoOp::ModifyEventBatch && i->_eventBatch)
+      n += i->_eventBatch->size();
+    else
+      ++n;
+  }
+  return n;
+}
+
+//---------------------------------------------------------
+//   compact
+//    For each operation the stream holds the number of
+//     events taken, then each event, preceded by the
+//     difference of its slot from the previous one.
+//    A deleted part's events are taken all or not at all,
+//     and have no slots.
+//---------------------------------------------------------
+
+bool UndoStore::compact(Undo& group)
+{
+  if(group.storeId >= 0)
+    return false;
+
+  QByteArray raw;
+  EventCoder coder;
+  std::vector<size_t> taken;
+  int events = 0;
+
+  for(iUndoOp i = group.begin(); i != group.end(); ++i)
+  {
+    if(isCompactablePart(*i))
+    {
+      EventList& el = const_cast<Part*>(i->part)->nonconst_events();
+      putVarint(raw, el.size());
+      for(ciEvent ie = el.begin(); ie != el.end(); ++ie)
+        coder.write(raw, ie->second);
+      events += el.size();
+      continue;
+    }
+
+    taken.clear();
+    const size_t slots = slotCount(*i);
+    for(size_t s = 0; s < slots; ++s)
+      if(isCompactable(slotEvent(*i, s)))
+        taken.push_back(s);
+
+    putVarint(raw, taken.size());
+    size_t prev = 0;
+    for(std::vector<size_t>::const_iterator it = taken.begin(); it != taken.end(); ++it)
+    {
+      putVarint(raw, *it - prev);
+      prev = *it;
+      coder.write(raw, slotEvent(*i, *it));
+    }
+    events += taken.size();
+  }
+
+  if(events == 0)
+    return false;
+
+  Blob blob;
+  blob.data = qCompress(raw, 1);
+  blob.offset = -1;
+  blob.size = blob.data.size();
+
+  // Only now drop the events, which frees them.
+  for(iUndoOp i = group.begin(); i != group.end(); ++i)
+  {
+    if(isCompactablePart(*i))
+    {
+      const_cast<Part*>(i->part)->nonconst_events().clear();
+      continue;
+    }
+    const size_t slots = slotCount(*i);
+    for(size_t s = 0; s < slots; ++s)
+    {
+      Event& e = slotEvent(*i, s);
+      if(isCompactable(e))
+        e = Event();
+    }
+  }
+
+  const int id = _nextId++;
+  _blobs.insert(std::pair<int, Blob>(id, blob));
+  _memBytes += blob.size;
+  group.storeId = id;
+
+  if(MusEGlobal::debugMsg)
+    fprintf(stderr, "UndoStore::compact: group %d: %d events, %d bytes raw, %d compressed\n",
+            id, events, raw.size(), blob.size);
+  return true;
+}
+
+//---------------------------------------------------------
+//   restore
+//---------------------------------------------------------
+
+bool UndoStore::restore(Undo& group)
+{
+  if(group.storeId < 0)
+    return true;
+
+  std::map<int, Blob>::iterator ib = _blobs.find(group.storeId);
+  if(ib == _blobs.end())
+  {
+    fprintf(stderr, "UndoStore::restore: group %d not found\n", group.storeId);
+    group.storeId = -1;
+    return false;
+  }
+  Blob& blob = ib->second;
+
+  QByteArray packed;
+  if(blob.offset < 0)
+    packed = blob.data;
+  else if(!_log || !_log->seek(blob.offset) || (packed = _log->read(blob.size)).size() != blob.size)
+  {
+    fprintf(stderr, "UndoStore::restore: cannot read group %d from the undo log\n", group.storeId);
+    discard(group);
+    return false;
+  }
+
+  const QByteArray raw = qUncompress(packed);
+  StreamReader in(raw);
+  EventCoder coder;
+
+  for(iUndoOp i = group.begin(); i != group.end() && in.ok(); ++i)
+  {
+    const size_t n = in.varint();
+    if(i->type == UndoOp::DeletePart && i->part && i->part->events().empty() && n > 0)
+    {
+      EventList& el = const_cast<Part*>(i->part)->nonconst_events();
+      for(size_t k = 0; k < n && in.ok(); ++k)
+        el.add(coder.read(in));
+      continue;
+    }
+    const size_t slots = slotCount(*i);
+    size_t slot = 0;
+    for(size_t k = 0; k < n && in.ok(); ++k)
+    {
+      slot += in.varint();
+      Event e = coder.read(in);
+      if(slot < slots)
+        slotEvent(*i, slot) = e;
+      else
+        in.fail();
+    }
+  }
+
+  const bool ok = in.ok();
+  if(!ok)
+    fprintf(stderr, "UndoStore::restore: group %d is corrupt\n", group.storeId);
+  discard(group);
+  return ok;
+}
+
+//---------------------------------------------------------
+//   discard
+//---------------------------------------------------------
+
+void UndoStore::discard(Undo& group)
+{
+  if(group.storeId < 0)
+    return;
+  std::map<int, Blob>::iterator ib = _blobs.find(group.storeId);
+  group.storeId = -1;
+  if(ib == _blobs.end())
+    return;
+  if(ib->second.offset < 0)
+    _memBytes -= ib->second.size;
+  _blobs.erase(ib);
+
+  // Once nothing refers to the log any more, start it over.
+  if(_log && _log->size() != 0)
+  {
+    std::map<int, Blob>::const_iterator ic = _blobs.begin();
+    for( ; ic != _blobs.end(); ++ic)
+      if(ic->second.offset >= 0)
+        break;
+    if(ic == _blobs.end())
+      _log->resize(0);
+  }
+}
+
+//---------------------------------------------------------
+//   spill
+//---------------------------------------------------------
+
+bool UndoStore::spill(Blob& blob)
+{
+  if(blob.offset >= 0)
+    return false;
+  if(!_log)
+  {
+    _log = new QTemporaryFile(QDir::tempPath() + "/muse_undo_XXXXXX.log");
+    if(!_log->open())
+    {
+      fprintf(stderr, "UndoStore::spill: cannot open undo log file\n");
+      delete _log;
+      _log = 0;
+      return false;
+    }
+  }
+  const qint64 offset = _log->size();
+  if(!_log->seek(offset) || _log->write(blob.data) != blob.size || !_log->flush())
+  {
+    fprintf(stderr, "UndoStore::spill: cannot write undo log file\n");
+    return false;
+  }
+  blob.offset = offset;
+  blob.data = QByteArray();
+  _memBytes -= blob.size;
+  return true;
+}
+
+//---------------------------------------------------------
+//   enforce
+//---------------------------------------------------------
+
+void UndoStore::enforce(UndoList* list)
+{
+  if(MusEGlobal::config.undoMemoryBudget <= 0 || list->empty())
+    return;
+  const size_t budget = (size_t)MusEGlobal::config.undoMemoryBudget * 1024 * 1024;
+
+  std::vector<std::pair<Undo*, size_t> > groups;
+  size_t total = _memBytes;
+  for(iUndo iu = list->begin(); iu != list->end(); ++iu)
+  {
+    const size_t sz = estimate(*iu);
+    total += sz;
+    groups.push_back(std::pair<Undo*, size_t>(&(*iu), sz));
+  }
+
+  // Oldest first. Leave the newest group alone, it is the one most likely undone next.
+  for(size_t k = 0; total > budget && k + 1 < groups.size(); ++k)
+  {
+    if(groups[k].second == 0)
+      continue;
+    const size_t mem = _memBytes;
+    if(compact(*groups[k].first))
+      total = total - groups[k].second + (_memBytes - mem);
+  }
+
+  // Keep only a quarter of the budget in compressed form, move the rest to disk.
+  for(std::map<int, Blob>::iterator ib = _blobs.begin(); ib != _blobs.end() && _memBytes > budget / 4; ++ib)
+    if(!spill(ib->second) && ib->second.offset < 0)
+      break;
+}
+
+} // namespace MusECore
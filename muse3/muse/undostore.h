@@ -0,0 +1,102 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  undostore.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __UNDOSTORE_H__
+#define __UNDOSTORE_H__
+
+#include <map>
+#include <stddef.h>
+
+#include <QByteArray>
+
+class QTemporaryFile;
+
+namespace MusECore {
+
+class Undo;
+class UndoList;
+
+// Undo and redo of groups with at least this many operations print how long they took, in debug mode.
+const size_t UNDO_LATENCY_REPORT_OPS = 1000;
+
+//---------------------------------------------------------
+//   UndoStore
+//    Keeps the midi events held by the undo history within
+//     the configured memory budget.
+//    When the history grows past the budget, the events of
+//     the oldest groups which nothing but the history refers
+//     to are encoded as a compact delta stream, compressed,
+//     and dropped from the operations. Past a quarter of the
+//     budget, the oldest compressed groups are moved on to a
+//     log file on disk. A group is restored before it is
+//     undone, with the same event ids, so the operations
+//     find their events again.
+//    Gui thread only.
+//---------------------------------------------------------
+
+class UndoStore
+{
+      struct Blob
+      {
+            // The compressed stream. Emptied once spilled.
+            QByteArray data;
+            // Position in the log file, or -1 while in memory.
+            qint64 offset;
+            int size;
+      };
+
+      // Ids grow with age, so the map is oldest first.
+      std::map<int, Blob> _blobs;
+      int _nextId;
+      // Compressed bytes still held in memory.
+      size_t _memBytes;
+      QTemporaryFile* _log;
+
+      bool spill(Blob& blob);
+
+   public:
+      UndoStore();
+      ~UndoStore();
+
+      // Estimated bytes of the group's events which only the history refers to.
+      static size_t estimate(const Undo& group);
+      // Number of operations in the group, counting each event of a batch.
+      static size_t operationCount(const Undo& group);
+
+      // Encodes the group's events into the store. Returns false if there was nothing to take.
+      bool compact(Undo& group);
+      // Puts the group's events back. Returns false if they could not be read.
+      bool restore(Undo& group);
+      // Forgets the group's events, when the group itself is deleted.
+      void discard(Undo& group);
+      // Compacts and spills the oldest groups of the list until it is within the budget.
+      // The newest group is never compacted.
+      void enforce(UndoList* list);
+};
+
+} // namespace MusECore
+
+namespace MusEGlobal {
+extern MusECore::UndoStore undoStore;
+}
+
+#endif
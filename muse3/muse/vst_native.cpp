@@ -40,6 +40,7 @@
 
 #include "globals.h"
 #include "gconfig.h"
+#include "audiobuffers.h"
 #include "audio.h"
 #include "synth.h"
 #include "jackaudio.h"
@@ -704,8 +705,6 @@ VstNativeSynthIF::~VstNativeSynthIF()
     delete[] _audioInBuffers;
   }
 
-  if(_audioInSilenceBuf)
-    free(_audioInSilenceBuf);
     
   if(_controls)
     delete[] _controls;
@@ -788,28 +787,9 @@ bool VstNativeSynthIF::init(Synth* s)
             memset(_audioInBuffers[k], 0, sizeof(float) * MusEGlobal::segmentSize);
         }
         
-#ifdef _WIN32
-        _audioInSilenceBuf = (float *) _aligned_malloc(16, sizeof(float *) * MusEGlobal::segmentSize);
-        if(_audioInSilenceBuf == NULL)
-        {
-           fprintf(stderr, "ERROR: VstNativeSynthIF::init: _aligned_malloc returned error: NULL. Aborting!\n");
-           abort();
-        }
-#else
-        int rv = posix_memalign((void**)&_audioInSilenceBuf, 16, sizeof(float) * MusEGlobal::segmentSize);
-        if(rv != 0)
-        {
-          fprintf(stderr, "ERROR: VstNativeSynthIF::init: posix_memalign returned error:%d. Aborting!\n", rv);
-          abort();
-        }
-#endif
-        if(MusEGlobal::config.useDenormalBias)
-        {
-          for(unsigned q = 0; q < MusEGlobal::segmentSize; ++q)
-            _audioInSilenceBuf[q] = MusEGlobal::denormalBias;
-        }
-        else
-          memset(_audioInSilenceBuf, 0, sizeof(float) * MusEGlobal::segmentSize);
+        // Shared by all plugins.
+        MusEGlobal::audioBufferPool.prepare();
+        _audioInSilenceBuf = MusEGlobal::audioBufferPool.silence();
       }
 
       _controls = NULL;
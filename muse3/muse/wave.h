@@ -178,7 +178,7 @@ class SndFileR {
       size_t readWithHeap(int channel, float** f, size_t n, bool overwrite = true) {
             return sf ? sf->readWithHeap(channel, f, n, overwrite) : 0;
             }
-      size_t read(int channel, float** f, size_t n, bool overwrite = true) {
+      size_t read(int channel, float** f, size_t n, bool overwrite = true) const {
             return sf ? sf->read(channel, f, n, overwrite) : 0;
             }
       size_t readDirect(float* f, size_t n) { return sf ? sf->readDirect(f, n) : 0; }  
@@ -186,10 +186,10 @@ class SndFileR {
       size_t write(int channel, float** f, size_t n) {
             return sf ? sf->write(channel, f, n) : 0;
             }
-      off_t seek(off_t frames, int whence) {
+      off_t seek(off_t frames, int whence) const {
             return sf ? sf->seek(frames, whence) : 0;
             }
-      void read(SampleV* s, int mag, unsigned pos, bool overwrite = true, bool allowSeek = true) {
+      void read(SampleV* s, int mag, unsigned pos, bool overwrite = true, bool allowSeek = true) const {
             if(sf) sf->read(s, mag, pos, overwrite, allowSeek);
             }
       QString strerror() const { return sf ? sf->strerror() : QString(); }
@@ -34,6 +34,7 @@
 #include <QDragMoveEvent>
 #include <QDropEvent>
 #include <QFile>
+#include <QFileInfo>
 #include <QInputDialog>
 #include <QMouseEvent>
 #include <QList>
@@ -69,7 +70,6 @@
 #include "fastlog.h"
 #include "utils.h"
 #include "tools.h"
-#include "copy_on_write.h"
 #include "helper.h"
 #include "sig.h"
 
@@ -141,6 +141,10 @@ WaveCanvas::WaveCanvas(MidiEditor* pr, QWidget* parent, int sx, int sy)
 WaveCanvas::~WaveCanvas()
 {
   //delete steprec;
+  // Consolidations still running are children, they must finish before they are deleted.
+  QList<WaveConsolidator*> cl = findChildren<WaveConsolidator*>();
+  for(QList<WaveConsolidator*>::iterator i = cl.begin(); i != cl.end(); ++i)
+    (*i)->wait();
 }
 
 //---------------------------------------------------------
@@ -968,7 +972,7 @@ void WaveCanvas::drawItem(QPainter& p, const CItem* item, const QRect& mr, const
         for (int i = sx; i < ex; i++) {
               int y = h;
               MusECore::SampleV sa[f.channels()];
-              f.read(sa, xScale, pos);
+              event.readPeaks(sa, xScale, pos);
               pos += xScale;
               if (pos < event.spos())
                     continue;
@@ -1721,6 +1725,10 @@ void WaveCanvas::cmd(int cmd)
                   adjustWaveOffset();
                   break;
 
+            case CMD_CONSOLIDATE:
+                  consolidateEdits();
+                  break;
+
             case CMD_EDIT_EXTERNAL:
                   modifyoperation = EDIT_EXTERNAL;
                   break;
@@ -1917,8 +1925,10 @@ MusECore::WaveSelectionList WaveCanvas::getSelection(unsigned startpos, unsigned
                         //printf("Event data affected: %d->%d filename:%s\n", sx, ex, file.name().toLatin1().constData());
                         MusECore::WaveEventSelection s;
                         s.event = event;  
+                        s.part = wp;
                         s.startframe = sx;
                         s.endframe   = ex+1;
+                        s.startoffset = sx - tmp_sx;
                         //printf("sx=%d ex=%d\n",sx,ex);
                         selection.push_back(s);
                         }
@@ -1946,146 +1956,15 @@ void WaveCanvas::modifySelection(int operation, unsigned startpos, unsigned stop
         }
 
         //
-        // Copy on Write: Check if some files need to be copied, either because they are not 
-        //  writable, or more than one independent (non-clone) wave event shares a wave file.
+        // The edits are non-destructive. Each one is added to a copy of
+        //  the event, which replaces it through undo. Sound files are
+        //  never written, only new ones created for pasted and externally
+        //  edited material.
         //
-        
         MusECore::WaveSelectionList selection = getSelection(startpos, stoppos);
-        std::vector<MusECore::SndFileR> copy_files_proj_dir;
-        for(MusECore::iWaveSelection i = selection.begin(); i != selection.end(); i++) 
-        {
-          MusECore::WaveEventSelection w = *i;
-          if(w.event.empty())
-            continue;
-          MusECore::SndFileR file = w.event.sndFile();
-          if(file.isNull())
-            continue;
-          if(file.checkCopyOnWrite())
-          {
-            std::vector<MusECore::SndFileR>::iterator i = copy_files_proj_dir.begin();
-            for( ; i != copy_files_proj_dir.end(); ++i)
-            {
-              if(i->canonicalPath() == file.canonicalPath())
-                break; 
-            }  
-            if(i == copy_files_proj_dir.end())
-              copy_files_proj_dir.push_back(file);
-          }
-        }
-        if(!copy_files_proj_dir.empty())
-        {
-          CopyOnWriteDialog* dlg = new CopyOnWriteDialog();
-          for(std::vector<MusECore::SndFileR>::iterator i = copy_files_proj_dir.begin(); i != copy_files_proj_dir.end(); ++i)
-          {
-            qint64 sz = QFile(i->canonicalPath()).size();
-            QString s;
-            if(sz > 1048576)
-              s += QString::number(sz / 1048576) + "MB ";
-            else
-            if(sz > 1024)
-              s += QString::number(sz / 1024) + "KB ";
-            else
-              s += QString::number(sz) + "B ";
-            s += i->canonicalPath();
-            dlg->addProjDirFile(s);
-          }
-          int rv = dlg->exec();
-          delete dlg;
-          if(rv != QDialog::Accepted)
-            return;
-          // Has a project been created yet?
-          if(MusEGlobal::museProject == MusEGlobal::museProjectInitPath) // && MusEGlobal::config.useProjectSaveDialog
-          { 
-            // No project, we need to create one.
-            if(!MusEGlobal::muse->saveAs())
-              return; // No project, don't want to copy without one.
-            //setFocus(); // For some reason focus is given away to Arranger
-          }
-          for(MusECore::iWaveSelection i = selection.begin(); i != selection.end(); i++)
-          {
-            MusECore::WaveEventSelection w = *i;
-            if(w.event.empty())
-              continue;
-            MusECore::SndFileR file = w.event.sndFile();
-            if(file.isNull() || !file.checkCopyOnWrite()) // Make sure to re-check
-              continue;
-            QString filePath = MusEGlobal::museProject + QString("/") + file.name();
-            QString newFilePath;
-            if(MusECore::getUniqueFileName(filePath, newFilePath))
-            {
-              {
-                QFile qf(file.canonicalPath());
-                if(!qf.copy(newFilePath)) // Copy the file
-                {
-                  printf("MusE Error: Could not copy to new sound file (file exists?): %s\n", newFilePath.toLatin1().constData());
-                  continue;  // Let's not overwrite an existing file
-                }
-              }  
-              QFile nqf(newFilePath);
-              // Need to make sure some permissions are set...
-              QFile::Permissions pm = nqf.permissions();
-              if(!(pm & QFile::ReadOwner))
-              {
-                pm |= QFile::ReadOwner;
-                if(!nqf.setPermissions(pm))
-                {
-                  printf("MusE Error: Could not set read owner permissions on new sound file: %s\n", newFilePath.toLatin1().constData());
-                  continue; 
-                }
-              }
-              if(!(pm & QFile::WriteOwner))
-              {
-                pm |= QFile::WriteOwner;
-                if(!nqf.setPermissions(pm))
-                {
-                  printf("MusE Error: Could not set write owner permissions on new sound file: %s\n", newFilePath.toLatin1().constData());
-                  continue; 
-                }
-              }
-              if(!(pm & QFile::ReadUser))
-              {
-                pm |= QFile::ReadUser;
-                if(!nqf.setPermissions(pm))
-                {
-                  printf("MusE Error: Could not set read user permissions on new sound file: %s\n", newFilePath.toLatin1().constData());
-                  continue; 
-                }
-              }
-              if(!(pm & QFile::WriteUser))
-              {
-                pm |= QFile::WriteUser;
-                if(!nqf.setPermissions(pm))
-                {
-                  printf("MusE Error: Could not set write user permissions on new sound file: %s\n", newFilePath.toLatin1().constData());
-                  continue; 
-                }
-              }
-              MusECore::SndFile* newSF = new MusECore::SndFile(newFilePath);
-              MusECore::SndFileR newSFR(newSF);  // Create a sndFileR for the new file
-              if(newSFR.openRead())  
-              {
-                printf("MusE Error: Could not open new sound file: %s\n", newSFR.canonicalPath().toLatin1().constData());
-                continue; // newSF will be deleted when newSFR goes out of scope and is deleted
-              }
-              MusEGlobal::audio->msgIdle(true); 
-              w.event.sndFile().close();             // Close the old file.
-              // NOTE: For now, don't bother providing undo for this. Reason: If the user undoes
-              //  and then modifies again, it will prompt to create new copies each time. There is
-              //  no mechanism ("touched"?) to tell if an existing copy would be suitable to just 'drop in'.
-              // It would help if we deleted the wave file copies upon undo, but not too crazy about that. 
-              // So since the copy has already been created and "there it is", we might as well use it.
-              // It means that events and even undo items BEFORE this operation will point to this 
-              //  NEW wave file (as if they always did). It also means the user CANNOT change back 
-              //  to the old file...    Oh well, this IS Copy On Write.
-              // FIXME: Find a conceptual way to make undo work with or without deleting the copies. 
-              w.event.setSndFile(newSFR);            // Set the new file.
-              MusEGlobal::audio->msgIdle(false); 
-            }
-          }
-        }
-         
-         MusEGlobal::song->startUndo();
-         for (MusECore::iWaveSelection i = selection.begin(); i != selection.end(); i++) {
+        MusECore::Undo operations;
+        MusECore::SndFileR pasteSource;
+        for (MusECore::iWaveSelection i = selection.begin(); i != selection.end(); i++) {
                MusECore::WaveEventSelection w = *i;
                if(w.event.empty())
                  continue;
@@ -2094,224 +1973,336 @@ void WaveCanvas::modifySelection(int operation, unsigned startpos, unsigned stop
                  continue;
                unsigned sx            = w.startframe;
                unsigned ex            = w.endframe;
+               if(ex <= sx)
+                 continue;
                unsigned file_channels = file.channels();
+               unsigned tmpdatalen    = ex - sx;
 
-               QString tmpWavFile = QString::null;
-               if (!MusEGlobal::getUniqueTmpfileName("tmp_musewav",".wav", tmpWavFile)) {
-                     break;
-                     }
-
-               MusEGlobal::audio->msgIdle(true); // Not good with playback during operations
-               MusECore::SndFile tmpFile(tmpWavFile);
-               tmpFile.setFormat(file.format(), file_channels, file.samplerate());
-               if (tmpFile.openWrite()) {
-                     MusEGlobal::audio->msgIdle(false);
-                     printf("Could not open temporary file...\n");
-                     break;
-                     }
-
-               //
-               // Write out data that will be changed to temp file
-               //
-               unsigned tmpdatalen = ex - sx;
-               off_t    tmpdataoffset = sx;
-               float*   tmpdata[file_channels];
-
-               for (unsigned i=0; i<file_channels; i++) {
-                     tmpdata[i] = new float[tmpdatalen];
-                     }
-               file.seek(tmpdataoffset, 0);
-               file.readWithHeap(file_channels, tmpdata, tmpdatalen);
-               file.close();
-               tmpFile.write(file_channels, tmpdata, tmpdatalen);
-               tmpFile.close();
-
+               MusECore::WaveEdit edit(MusECore::WaveEdit::Gain, sx, ex);
                switch(operation)
                {
                      case MUTE:
-                           muteSelection(file_channels, tmpdata, tmpdatalen);
+                           edit.type = MusECore::WaveEdit::Mute;
                            break;
 
                      case NORMALIZE:
-                           normalizeSelection(file_channels, tmpdata, tmpdatalen);
+                           {
+                           float* tmpdata[file_channels];
+                           for (unsigned i=0; i<file_channels; i++)
+                                 tmpdata[i] = new float[tmpdatalen];
+                           readSelection(w.event, sx, file_channels, tmpdata, tmpdatalen);
+                           float loudest = 0.0;
+                           for (unsigned i=0; i<file_channels; i++) {
+                                 for (unsigned j=0; j<tmpdatalen; j++) {
+                                       if (fabs(tmpdata[i][j]) > loudest)
+                                             loudest = fabs(tmpdata[i][j]);
+                                       }
+                                 delete[] tmpdata[i];
+                                 }
+                           if (loudest == 0.0)
+                                 continue;
+                           edit.gain = 0.99 / (double)loudest;
+                           }
                            break;
 
                      case FADE_IN:
-                           fadeInSelection(file_channels, tmpdata, tmpdatalen);
+                           edit.type = MusECore::WaveEdit::FadeIn;
                            break;
 
                      case FADE_OUT:
-                           fadeOutSelection(file_channels, tmpdata, tmpdatalen);
+                           edit.type = MusECore::WaveEdit::FadeOut;
                            break;
 
                      case REVERSE:
-                           reverseSelection(file_channels, tmpdata, tmpdatalen);
+                           edit.type = MusECore::WaveEdit::Reverse;
                            break;
 
                      case GAIN:
-                           applyGain(file_channels, tmpdata, tmpdatalen, paramA);
+                           edit.gain = paramA;
                            break;
+
                      case CUT:
-                           copySelection(file_channels, tmpdata, tmpdatalen, true, file.format(), file.samplerate());
-                           break;
                      case COPY:
+                           {
+                           float* tmpdata[file_channels];
+                           for (unsigned i=0; i<file_channels; i++)
+                                 tmpdata[i] = new float[tmpdatalen];
+                           readSelection(w.event, sx, file_channels, tmpdata, tmpdatalen);
                            copySelection(file_channels, tmpdata, tmpdatalen, false, file.format(), file.samplerate());
+                           for (unsigned i=0; i<file_channels; i++)
+                                 delete[] tmpdata[i];
+                           if (operation == COPY)
+                                 continue;
+                           edit.type = MusECore::WaveEdit::Mute;
+                           }
                            break;
+
                      case PASTE:
                            {
-                           MusECore::SndFile pasteFile(copiedPart);
-                           pasteFile.openRead();
-                           pasteFile.seek(tmpdataoffset, 0);
-                           pasteFile.readWithHeap(file_channels, tmpdata, tmpdatalen);
+                           // The copy buffer is a temporary file, keep what is pasted in the project.
+                           if (pasteSource.isNull()) {
+                                 QString path = newProjectWaveFile(QFileInfo(copiedPart).fileName());
+                                 if (path.isEmpty())
+                                       break;
+                                 if (!QFile::copy(copiedPart, path)) {
+                                       printf("MusE Error: Could not copy to new sound file (file exists?): %s\n", path.toLatin1().constData());
+                                       break;
+                                       }
+                                 pasteSource = MusECore::getWave(path, true);
+                                 if (pasteSource.isNull())
+                                       break;
+                                 }
+                           edit.type = MusECore::WaveEdit::Splice;
+                           edit.source = pasteSource;
+                           edit.sourceOffset = w.startoffset;
                            }
                            break;
 
                      case EDIT_EXTERNAL:
+                           {
+                           float* tmpdata[file_channels];
+                           for (unsigned i=0; i<file_channels; i++)
+                                 tmpdata[i] = new float[tmpdatalen];
+                           readSelection(w.event, sx, file_channels, tmpdata, tmpdatalen);
                            editExternal(file.format(), file.samplerate(), file_channels, tmpdata, tmpdatalen);
+
+                           QString path = newProjectWaveFile(file.name());
+                           if (!path.isEmpty()) {
+                                 MusECore::SndFile extFile(path);
+                                 extFile.setFormat(file.format(), file_channels, file.samplerate());
+                                 if (extFile.openWrite()) {
+                                       printf("Could not open new sound file: %s\n", path.toLatin1().constData());
+                                       path = QString();
+                                       }
+                                 else {
+                                       extFile.write(file_channels, tmpdata, tmpdatalen);
+                                       extFile.close();
+                                       }
+                                 }
+                           for (unsigned i=0; i<file_channels; i++)
+                                 delete[] tmpdata[i];
+                           if (path.isEmpty())
+                                 continue;
+                           edit.type = MusECore::WaveEdit::Splice;
+                           edit.source = MusECore::getWave(path, true);
+                           if (edit.source.isNull())
+                                 continue;
+                           }
                            break;
 
                      default:
                            printf("Error: Default state reached in modifySelection\n");
-                           break;
+                           continue;
 
                }
+               if (operation == PASTE && pasteSource.isNull())
+                     break;
 
-               file.openWrite();
-               file.seek(tmpdataoffset, 0);
-               file.write(file_channels, tmpdata, tmpdatalen);
-               file.update();
-               file.close();
-               file.openRead();
-
-               for (unsigned i=0; i<file_channels; i++) {
-                     delete[] tmpdata[i];
-                     }
-
-               // Undo handling
-               MusEGlobal::song->cmdChangeWave(w.event, tmpWavFile, sx, ex);
-               MusEGlobal::audio->msgIdle(false); // Not good with playback during operations
+               MusECore::Event newEvent = w.event.clone();
+               newEvent.addWaveEdit(edit);
+               operations.push_back(MusECore::UndoOp(MusECore::UndoOp::ModifyEvent, newEvent, w.event, w.part, false, false));
                }
-         MusEGlobal::song->endUndo(SC_CLIP_MODIFIED);
+         MusEGlobal::song->applyOperationGroup(operations);
          redraw();
       }
 
 //---------------------------------------------------------
-//   copySelection
+//   readSelection
+//    Reads the sound of an event as it is with its edits
+//     applied, from the given file frame on.
 //---------------------------------------------------------
-void WaveCanvas::copySelection(unsigned file_channels, float** tmpdata, unsigned length, bool blankData, unsigned format, unsigned sampleRate)
-{
-      if (copiedPart!="") {
-        QFile::remove(copiedPart);
-      }
-      if (!MusEGlobal::getUniqueTmpfileName("tmp_musewav",".wav", copiedPart)) {
-            return;
+
+void WaveCanvas::readSelection(const MusECore::Event& event, unsigned startframe, unsigned channels, float** data, unsigned length)
+      {
+      // A private copy, so the file handles are not shared with the audio prefetch.
+      // Its offset is cleared so that it reads plain file frames.
+      MusECore::Event ev = event.clone();
+      ev.setSpos(0);
+      const unsigned blockSize = 65536;
+      float* bp[channels];
+      for (unsigned pos = 0; pos < length; pos += blockSize) {
+            unsigned n = length - pos;
+            if (n > blockSize)
+                  n = blockSize;
+            for (unsigned i = 0; i < channels; ++i) {
+                  bp[i] = data[i] + pos;
+                  for (unsigned j = 0; j < n; ++j)
+                        bp[i][j] = 0.0f;
+                  }
+            ev.readAudio(0, startframe + pos, bp, channels, n, true, true);
             }
+      }
 
-      MusECore::SndFile tmpFile(copiedPart);
-      tmpFile.setFormat(format, file_channels, sampleRate);
-      tmpFile.openWrite();
-      tmpFile.write(file_channels, tmpdata, length);
-      tmpFile.close();
+//---------------------------------------------------------
+//   newProjectWaveFile
+//---------------------------------------------------------
 
-      if (blankData) {
-        // Set everything to 0!
-        for (unsigned i=0; i<file_channels; i++) {
-              for (unsigned j=0; j<length; j++) {
-                    tmpdata[i][j] = 0;
-                    }
-              }
-        }
-}
+QString WaveCanvas::newProjectWaveFile(const QString& name)
+      {
+      // Has a project been created yet?
+      if(MusEGlobal::museProject == MusEGlobal::museProjectInitPath)
+      {
+        // No project, we need to create one.
+        if(!MusEGlobal::muse->saveAs())
+          return QString();
+      }
+      QString path;
+      if(!MusECore::getUniqueFileName(MusEGlobal::museProject + QString("/") + name, path))
+        return QString();
+      return path;
+      }
 
 //---------------------------------------------------------
-//   muteSelection
+//   consolidateEdits
+//    Renders every edited event of the editor's parts into
+//     a new file in the background. The events are replaced
+//     when done, unless they were changed in the meantime.
 //---------------------------------------------------------
-void WaveCanvas::muteSelection(unsigned channels, float** data, unsigned length)
+
+void WaveCanvas::consolidateEdits()
       {
-      // Set everything to 0!
-      for (unsigned i=0; i<channels; i++) {
-            for (unsigned j=0; j<length; j++) {
-                  data[i][j] = 0;
+      for (MusECore::iPart ip = editor->parts()->begin(); ip != editor->parts()->end(); ++ip) {
+            const MusECore::Part* part = ip->second;
+            const MusECore::EventList& el = part->events();
+            for (MusECore::ciEvent e = el.begin(); e != el.end(); ++e) {
+                  const MusECore::Event& event = e->second;
+                  const MusECore::WaveEditList* edits = event.waveEdits();
+                  if (!edits || edits->empty() || event.sndFile().isNull())
+                        continue;
+                  QString path = newProjectWaveFile(event.sndFile().name());
+                  if (path.isEmpty())
+                        return;
+                  // Reserve the name, so the next event does not pick it too.
+                  QFile(path).open(QIODevice::WriteOnly);
+                  WaveConsolidator* c = new WaveConsolidator(event, part, path, this);
+                  connect(c, SIGNAL(finished()), SLOT(consolidateFinished()));
+                  c->start();
                   }
             }
       }
 
 //---------------------------------------------------------
-//   normalizeSelection
+//   consolidateFinished
 //---------------------------------------------------------
-void WaveCanvas::normalizeSelection(unsigned channels, float** data, unsigned length)
+
+void WaveCanvas::consolidateFinished()
       {
-      float loudest = 0.0;
+      WaveConsolidator* c = dynamic_cast<WaveConsolidator*>(sender());
+      if (!c)
+            return;
+      c->wait();
 
-      for (unsigned i=0; i<channels; i++) {
-            for (unsigned j=0; j<length; j++) {
-                  if (data[i][j]  > loudest)
-                        loudest = data[i][j];
+      // Find the event again. It may have been changed or deleted since.
+      bool found = false;
+      MusECore::Event event;
+      for (MusECore::iPart ip = editor->parts()->begin(); ip != editor->parts()->end() && !found; ++ip) {
+            if (ip->second != c->part())
+                  continue;
+            const MusECore::EventList& el = ip->second->events();
+            for (MusECore::ciEvent e = el.begin(); e != el.end(); ++e) {
+                  if (e->second.id() == c->event().id() && e->second.isSimilarTo(c->event())) {
+                        event = e->second;
+                        found = true;
+                        break;
+                        }
                   }
             }
 
-      double scale = 0.99 / (double)loudest;
-
-      for (unsigned i=0; i<channels; i++) {
-            for (unsigned j=0; j<length; j++) {
-                  data[i][j] = (float) ((double)data[i][j] * scale);
-                  }
+      MusECore::SndFileR f;
+      if (c->ok() && found)
+            f = MusECore::getWave(c->path(), true);
+      if (f.isNull()) {
+            QFile::remove(c->path());
             }
+      else {
+            MusECore::Event newEvent = event.clone();
+            newEvent.setSndFile(f);
+            newEvent.clearWaveEdits();
+            MusEGlobal::song->applyOperation(MusECore::UndoOp(MusECore::UndoOp::ModifyEvent, newEvent, event, c->part(), false, false));
+            }
+      delete c;
       }
 
 //---------------------------------------------------------
-//   fadeInSelection
+//   WaveConsolidator
 //---------------------------------------------------------
-void WaveCanvas::fadeInSelection(unsigned channels, float** data, unsigned length)
+
+WaveConsolidator::WaveConsolidator(const MusECore::Event& event, const MusECore::Part* part,
+                                   const QString& path, QObject* parent)
+   : QThread(parent), _event(event), _render(event.clone()), _part(part), _path(path), _ok(false)
       {
-      for (unsigned i=0; i<channels; i++) {
-            for (unsigned j=0; j<length; j++) {
-                  double scale = (double) j / (double)length ;
-                  data[i][j] = (float) ((double)data[i][j] * scale);
-                  }
-            }
+      // Read plain file frames.
+      _render.setSpos(0);
       }
 
 //---------------------------------------------------------
-//   fadeOutSelection
+//   run
+//    Renders the whole file, so the event can still be
+//     resized or moved within it afterwards.
 //---------------------------------------------------------
-void WaveCanvas::fadeOutSelection(unsigned channels, float** data, unsigned length)
+
+void WaveConsolidator::run()
       {
-      for (unsigned i=0; i<channels; i++) {
-            for (unsigned j=0; j<length; j++) {
-                  double scale = (double) (length - j) / (double)length ;
-                  data[i][j] = (float) ((double)data[i][j] * scale);
-                  }
+      MusECore::SndFileR file = _render.sndFile();
+      const unsigned channels = file.channels();
+      const unsigned length = file.samples();
+      if (channels == 0)
+            return;
+
+      MusECore::SndFile out(_path);
+      out.setFormat(file.format(), channels, file.samplerate());
+      if (out.openWrite()) {
+            printf("Could not open new sound file: %s\n", _path.toLatin1().constData());
+            return;
             }
-      }
 
-//---------------------------------------------------------
-//   reverseSelection
-//---------------------------------------------------------
-void WaveCanvas::reverseSelection(unsigned channels, float** data, unsigned length)
-      {
-      if(length <= 1)    
-        return;
-      for (unsigned i=0; i<channels; i++) {
-            for (unsigned j=0; j<length/2; j++) {
-                  float tmpl = data[i][j];
-                  float tmpr = data[i][length - j - 1];
-                  data[i][j] = tmpr;
-                  data[i][length - j - 1] = tmpl;
-                  }
+      const unsigned blockSize = 65536;
+      float* bp[channels];
+      for (unsigned i = 0; i < channels; ++i)
+            bp[i] = new float[blockSize];
+      for (unsigned pos = 0; pos < length; pos += blockSize) {
+            unsigned n = length - pos;
+            if (n > blockSize)
+                  n = blockSize;
+            for (unsigned i = 0; i < channels; ++i)
+                  for (unsigned j = 0; j < n; ++j)
+                        bp[i][j] = 0.0f;
+            _render.readAudio(0, pos, bp, channels, n, true, true);
+            out.write(channels, bp, n);
             }
+      for (unsigned i = 0; i < channels; ++i)
+            delete[] bp[i];
+      out.close();
+      _ok = true;
       }
+
 //---------------------------------------------------------
-//   applyGain
+//   copySelection
 //---------------------------------------------------------
-void WaveCanvas::applyGain(unsigned channels, float** data, unsigned length, double gain)
-      {
-      for (unsigned i=0; i<channels; i++) {
-            for (unsigned j=0; j<length; j++) {
-                  data[i][j] = (float) ((double)data[i][j] * gain);
-                  }
-            }
+void WaveCanvas::copySelection(unsigned file_channels, float** tmpdata, unsigned length, bool blankData, unsigned format, unsigned sampleRate)
+{
+      if (copiedPart!="") {
+        QFile::remove(copiedPart);
       }
+      if (!MusEGlobal::getUniqueTmpfileName("tmp_musewav",".wav", copiedPart)) {
+            return;
+            }
+
+      MusECore::SndFile tmpFile(copiedPart);
+      tmpFile.setFormat(format, file_channels, sampleRate);
+      tmpFile.openWrite();
+      tmpFile.write(file_channels, tmpdata, length);
+      tmpFile.close();
+
+      if (blankData) {
+        // Set everything to 0!
+        for (unsigned i=0; i<file_channels; i++) {
+              for (unsigned j=0; j<length; j++) {
+                    tmpdata[i][j] = 0;
+                    }
+              }
+        }
+}
 
 //---------------------------------------------------------
 //   editExternal
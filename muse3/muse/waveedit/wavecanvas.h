@@ -37,18 +37,22 @@
 #include <QWheelEvent>
 #include <QResizeEvent>
 #include <QTimer>
+#include <QThread>
 
 class QRect;
 
 namespace MusECore {
 class SndFileR;
+class Part;
 class WavePart;
 class WaveTrack;
 
 struct WaveEventSelection {
       Event event;         
+      const Part* part;
       unsigned startframe;
       unsigned endframe;
+      unsigned startoffset;   // frames from the start of the selection to startframe
       };
 
 typedef std::list<WaveEventSelection> WaveSelectionList;
@@ -67,6 +71,31 @@ class WEvent : public EItem {
       WEvent(const MusECore::Event& e, MusECore::Part* p, int height);
       };
 
+//---------------------------------------------------------
+//   WaveConsolidator
+//    Renders a wave event with all its edits applied into
+//     a new file, in the background.
+//---------------------------------------------------------
+
+class WaveConsolidator : public QThread {
+      MusECore::Event _event;     // The event as it was when started.
+      MusECore::Event _render;    // Private copy to read from.
+      const MusECore::Part* _part;
+      QString _path;
+      bool _ok;
+
+   protected:
+      virtual void run();
+
+   public:
+      WaveConsolidator(const MusECore::Event& event, const MusECore::Part* part,
+                       const QString& path, QObject* parent);
+      const MusECore::Event& event() const { return _event; }
+      const MusECore::Part* part() const   { return _part; }
+      const QString& path() const          { return _path; }
+      bool ok() const                      { return _ok; }
+      };
+
 //---------------------------------------------------------
 //   WaveCanvas
 //---------------------------------------------------------
@@ -89,12 +118,9 @@ class WaveCanvas : public EventCanvas {
       //bool getUniqueTmpfileName(QString& newFilename); //!< Generates unique filename for temporary SndFile
       MusECore::WaveSelectionList getSelection(unsigned startpos, unsigned stoppos);
       void modifySelection(int operation, unsigned startpos, unsigned stoppos, double paramA); //!< Modifies selection
-      void muteSelection(unsigned channels, float** data, unsigned length); //!< Mutes selection
-      void normalizeSelection(unsigned channels, float** data, unsigned length); //!< Normalizes selection
-      void fadeInSelection(unsigned channels, float** data, unsigned length); //!< Linear fade in of selection
-      void fadeOutSelection(unsigned channels, float** data, unsigned length); //!< Linear fade out of selection
-      void reverseSelection(unsigned channels, float** data, unsigned length); //!< Reverse selection
-      void applyGain(unsigned channels, float** data, unsigned length, double gain); //!< Apply gain to selection
+      void readSelection(const MusECore::Event& event, unsigned startframe, unsigned channels, float** data, unsigned length); //!< Reads the edited sound of an event
+      QString newProjectWaveFile(const QString& name); //!< Unique path for a new file in the project directory
+      void consolidateEdits(); //!< Renders the edits of all events into new files
       void copySelection(unsigned file_channels, float** tmpdata, unsigned tmpdatalen, bool blankData, unsigned format, unsigned sampleRate);
       void editExternal(unsigned file_format, unsigned file_samplerate, unsigned channels, float** data, unsigned length);
       //void applyLadspa(unsigned channels, float** data, unsigned length); //!< Apply LADSPA plugin on selection
@@ -140,6 +166,7 @@ class WaveCanvas : public EventCanvas {
       
    private slots:
       void setPos(int idx, unsigned val, bool adjustScrollbar);
+      void consolidateFinished();
 
    signals:
       void quantChanged(int);
@@ -162,7 +189,8 @@ class WaveCanvas : public EventCanvas {
              CMD_SELECT_ALL, CMD_SELECT_NONE, CMD_SELECT_INVERT, 
              CMD_SELECT_ILOOP, CMD_SELECT_OLOOP, CMD_SELECT_PREV_PART, CMD_SELECT_NEXT_PART, 
              CMD_ERASE_MEASURE, CMD_DELETE_MEASURE, CMD_CREATE_MEASURE,
-             CMD_ADJUST_WAVE_OFFSET
+             CMD_ADJUST_WAVE_OFFSET,
+             CMD_CONSOLIDATE
            };
              
       WaveCanvas(MidiEditor*, QWidget*, int, int);
@@ -198,6 +198,10 @@ WaveEdit::WaveEdit(MusECore::PartList* pl, QWidget* parent, const char* name)
       mapper->setMapping(act, WaveCanvas::CMD_REVERSE);
       connect(act, SIGNAL(triggered()), mapper, SLOT(map()));
       
+      act = menuFunctions->addAction(tr("Consolidate Edits"));
+      mapper->setMapping(act, WaveCanvas::CMD_CONSOLIDATE);
+      connect(act, SIGNAL(triggered()), mapper, SLOT(map()));
+      
       select = menuEdit->addMenu(QIcon(*selectIcon), tr("Select"));
       
       selectAllAction = select->addAction(QIcon(*select_allIcon), tr("Select &All"));
@@ -0,0 +1,139 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  waveedits.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include "waveedits.h"
+#include "xml.h"
+#include "globals.h"
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   WaveEdit
+//---------------------------------------------------------
+
+WaveEdit::WaveEdit()
+   : type(Gain), start(0), end(0), gain(1.0), sourceOffset(0)
+      {
+      }
+
+WaveEdit::WaveEdit(int t, off_t s, off_t e, double g)
+   : type(t), start(s), end(e), gain(g), sourceOffset(0)
+      {
+      }
+
+//---------------------------------------------------------
+//   operator==
+//---------------------------------------------------------
+
+bool WaveEdit::operator==(const WaveEdit& other) const
+      {
+      return type == other.type && start == other.start && end == other.end &&
+             gain == other.gain && sourceOffset == other.sourceOffset &&
+             source.canonicalPath() == other.source.canonicalPath();
+      }
+
+//---------------------------------------------------------
+//   gainAt
+//---------------------------------------------------------
+
+double WaveEdit::gainAt(off_t frame) const
+      {
+      const off_t len = end - start;
+      if (len <= 0)
+            return gain;
+      switch (type) {
+            case FadeIn:
+                  return gain * double(frame - start) / double(len);
+            case FadeOut:
+                  return gain * double(end - frame) / double(len);
+            case Mute:
+                  return 0.0;
+            default:
+                  return gain;
+            }
+      }
+
+//---------------------------------------------------------
+//   read
+//---------------------------------------------------------
+
+void WaveEdit::read(Xml& xml)
+      {
+      for (;;) {
+            Xml::Token token = xml.parse();
+            const QString& tag = xml.s1();
+            switch (token) {
+                  case Xml::Error:
+                  case Xml::End:
+                        return;
+                  case Xml::TagStart:
+                        if (tag == "type")
+                              type = xml.parseInt();
+                        else if (tag == "start")
+                              start = xml.parseLongLong();
+                        else if (tag == "end")
+                              end = xml.parseLongLong();
+                        else if (tag == "gain")
+                              gain = xml.parseDouble();
+                        else if (tag == "file") {
+                              SndFileR wf = getWave(xml.parse1(), true);
+                              if (wf)
+                                    source = wf;
+                              }
+                        else if (tag == "offset")
+                              sourceOffset = xml.parseLongLong();
+                        else
+                              xml.unknown("WaveEdit");
+                        break;
+                  case Xml::TagEnd:
+                        if (tag == "edit")
+                              return;
+                  default:
+                        break;
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   write
+//---------------------------------------------------------
+
+void WaveEdit::write(int level, Xml& xml, bool forcePath) const
+      {
+      xml.tag(level++, "edit");
+      xml.intTag(level, "type", type);
+      xml.longLongTag(level, "start", start);
+      xml.longLongTag(level, "end", end);
+      if (type == Gain || type == FadeIn || type == FadeOut)
+            xml.doubleTag(level, "gain", gain);
+      if (type == Splice && !source.isNull()) {
+            // Files in the project directory are stored with a relative path.
+            if (!forcePath && source.dirPath().contains(MusEGlobal::museProject))
+                  xml.strTag(level, "file", source.path().remove(MusEGlobal::museProject + "/"));
+            else
+                  xml.strTag(level, "file", source.path());
+            xml.longLongTag(level, "offset", sourceOffset);
+            }
+      xml.etag(--level, "edit");
+      }
+
+} // namespace MusECore
@@ -0,0 +1,80 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  waveedits.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __WAVEEDITS_H__
+#define __WAVEEDITS_H__
+
+#include <vector>
+#include <sys/types.h>
+
+#include "wave.h"
+
+namespace MusECore {
+
+class Xml;
+
+//---------------------------------------------------------
+//   WaveEdit
+//    One non-destructive edit of a wave event. It is applied
+//     when the event is played or its peaks are drawn, the
+//     sound file itself is never written.
+//    The range is in frames of the event's sound file.
+//---------------------------------------------------------
+
+struct WaveEdit
+{
+      enum Type { Gain = 0, FadeIn, FadeOut, Mute, Reverse, Splice };
+
+      int type;
+      off_t start;
+      off_t end;
+      // Gain, and the peak level of the fades.
+      double gain;
+      // Splice only. The range is replaced by this file, from the offset on.
+      SndFileR source;
+      off_t sourceOffset;
+
+      WaveEdit();
+      WaveEdit(int type, off_t start, off_t end, double gain = 1.0);
+
+      bool operator==(const WaveEdit& other) const;
+      bool operator!=(const WaveEdit& other) const { return !(*this == other); }
+      // Gain of the gain and fade types at a frame within the range.
+      double gainAt(off_t frame) const;
+
+      void read(Xml&);
+      void write(int level, Xml&, bool forcePath = false) const;
+};
+
+//---------------------------------------------------------
+//   WaveEditList
+//    Applied in order, each edit works on the result of
+//     the ones before it.
+//---------------------------------------------------------
+
+typedef std::vector<WaveEdit> WaveEditList;
+typedef WaveEditList::iterator iWaveEdit;
+typedef WaveEditList::const_iterator ciWaveEdit;
+
+} // namespace MusECore
+
+#endif
@@ -23,6 +23,7 @@
 
 #include "audioconvert.h"
 #include "globals.h"
+#include "globaldefs.h"
 #include "event.h"
 #include "waveevent.h"
 #include "xml.h"
@@ -38,6 +39,9 @@
 
 namespace MusECore {
 
+// Frames mixed per pass when adding edited audio to a buffer.
+static const int EDIT_MIX_CHUNK = 1024;
+
 //---------------------------------------------------------
 //   WaveEvent
 //---------------------------------------------------------
@@ -53,12 +57,19 @@ WaveEventBase::WaveEventBase(const WaveEventBase& ev, bool duplicate_not_clone)
 {
       _name = ev._name;
       _spos = ev._spos;
+      _edits = ev._edits;
       
       // NOTE: It is necessary to create copies always. Unlike midi events, no shared data is allowed for 
       //        wave events because sndfile handles and audio stretchers etc. ABSOLUTELY need separate instances always. 
       //       So duplicate_not_clone is not used here. 
       if(!ev.f.isNull() && !ev.f.canonicalPath().isEmpty())
         f = getWave(ev.f.canonicalPath(), !ev.f.isWritable(), ev.f.isOpen(), false); // Don't show error box.
+      // Same for the files spliced in by edits.
+      for(iWaveEdit i = _edits.begin(); i != _edits.end(); ++i)
+      {
+        if(!i->source.isNull() && !i->source.canonicalPath().isEmpty())
+          i->source = getWave(i->source.canonicalPath(), true, i->source.isOpen(), false);
+      }
 }
 
 //---------------------------------------------------------
@@ -73,6 +84,9 @@ void WaveEventBase::assign(const EventBase& ev)
 
   _name = ev.name();
   _spos = ev.spos();
+  const WaveEditList* edits = ev.waveEdits();
+  if(edits)
+    _edits = *edits;
 
   SndFileR sf = ev.sndFile();
   setSndFile(sf);
@@ -84,7 +98,7 @@ bool WaveEventBase::isSimilarTo(const EventBase& other_) const
 	if (other==NULL) // dynamic cast hsa failed: "other_" is not of type WaveEventBase.
 		return false;
 	
-	return f.dirPath()==other->f.dirPath() && _spos==other->_spos && this->PosLen::operator==(*other);
+	return f.dirPath()==other->f.dirPath() && _spos==other->_spos && _edits==other->_edits && this->PosLen::operator==(*other);
 }
 
 //---------------------------------------------------------
@@ -143,6 +157,11 @@ void WaveEventBase::read(Xml& xml)
                               SndFileR wf = getWave(xml.parse1(), true);
                               if (wf) f = wf;
                               }
+                        else if (tag == "edit") {
+                              WaveEdit edit;
+                              edit.read(xml);
+                              _edits.push_back(edit);
+                              }
                         else
                               xml.unknown("Event");
                         break;
@@ -184,6 +203,8 @@ void WaveEventBase::write(int level, Xml& xml, const Pos& offset, bool forcePath
             }
       else
             xml.strTag(level, "file", f.path());
+      for (ciWaveEdit i = _edits.begin(); i != _edits.end(); ++i)
+            i->write(level, xml, forcePath);
       xml.etag(level, "event");
       }
 
@@ -479,12 +500,265 @@ void WaveEventBase::readAudio(WavePart* /*part*/, unsigned offset, float** buffe
   off_t e_off = offset + _spos;
   if(e_off < 0)
     e_off = 0;
-  f.seek(e_off, 0);
-  f.read(channel, buffer, n, overwrite);
+  if(_edits.empty())
+  {
+    f.seek(e_off, 0);
+    f.read(channel, buffer, n, overwrite);
+    return;
+  }
+
+  if(overwrite)
+  {
+    readEdited(_edits.size(), e_off, buffer, channel, n, 0);
+    return;
+  }
+  // Mix through a fixed size buffer, chunk by chunk, so nothing is sized
+  //  on the prefetch stack. Only wave tracks mix, and they have at most
+  //  MAX_CHANNELS channels.
+  if(channel > MAX_CHANNELS)
+    channel = MAX_CHANNELS;
+  float data[MAX_CHANNELS][EDIT_MIX_CHUNK];
+  float* dp[MAX_CHANNELS];
+  for(int ch = 0; ch < channel; ++ch)
+    dp[ch] = data[ch];
+  for(int done = 0; done < n; done += EDIT_MIX_CHUNK)
+  {
+    const int len = n - done < EDIT_MIX_CHUNK ? n - done : EDIT_MIX_CHUNK;
+    readEdited(_edits.size(), e_off + done, dp, channel, len, 0);
+    for(int ch = 0; ch < channel; ++ch)
+      for(int i = 0; i < len; ++i)
+        buffer[ch][done + i] += data[ch][i];
+  }
       
   return;
   #endif
   
 }
 
+//---------------------------------------------------------
+//   readFile
+//    Reads n frames from pos on into the buffers at frame
+//     offset off, zeroing anything beyond the end of the file.
+//---------------------------------------------------------
+
+static void readFile(const SndFileR& sf, off_t pos, float** buffer, int channels, int n, int off)
+{
+  size_t rn = 0;
+  if(!sf.isNull() && pos >= 0 && pos < (off_t)sf.samples())
+  {
+    // The file reads to the start of the buffers, so point them
+    //  at the offset for the read and put them back afterwards.
+    for(int ch = 0; ch < channels; ++ch)
+      buffer[ch] += off;
+    sf.seek(pos, 0);
+    rn = sf.read(channels, buffer, n, true);
+    for(int ch = 0; ch < channels; ++ch)
+      buffer[ch] -= off;
+  }
+  for(int ch = 0; ch < channels; ++ch)
+    for(int i = rn; i < n; ++i)
+      buffer[ch][off + i] = 0.0f;
+}
+
+//---------------------------------------------------------
+//   readEdited
+//    Reads n frames from file position pos on, as they are
+//     after the first 'level' edits, into the buffers at
+//     frame offset off. Always overwrites.
+//---------------------------------------------------------
+
+void WaveEventBase::readEdited(int level, off_t pos, float** buffer, int channels, int n, int off)
+{
+  if(n <= 0)
+    return;
+  if(level == 0)
+  {
+    readFile(f, pos, buffer, channels, n, off);
+    return;
+  }
+
+  const WaveEdit& edit = _edits[level - 1];
+  const off_t end = pos + n;
+  if(edit.end <= pos || edit.start >= end)
+  {
+    readEdited(level - 1, pos, buffer, channels, n, off);
+    return;
+  }
+
+  // The parts outside of the edit's range pass through.
+  const off_t s = edit.start > pos ? edit.start : pos;
+  const off_t e = edit.end < end ? edit.end : end;
+  if(s > pos)
+    readEdited(level - 1, pos, buffer, channels, s - pos, off);
+  if(e < end)
+    readEdited(level - 1, e, buffer, channels, end - e, off + (e - pos));
+
+  const int bo = off + (s - pos);
+  const int len = e - s;
+  switch(edit.type)
+  {
+    case WaveEdit::Mute:
+      for(int ch = 0; ch < channels; ++ch)
+        for(int i = 0; i < len; ++i)
+          buffer[ch][bo + i] = 0.0f;
+      break;
+
+    case WaveEdit::Gain:
+      readEdited(level - 1, s, buffer, channels, len, bo);
+      for(int ch = 0; ch < channels; ++ch)
+        for(int i = 0; i < len; ++i)
+          buffer[ch][bo + i] *= edit.gain;
+      break;
+
+    case WaveEdit::FadeIn:
+    case WaveEdit::FadeOut:
+      readEdited(level - 1, s, buffer, channels, len, bo);
+      for(int i = 0; i < len; ++i)
+      {
+        const float g = edit.gainAt(s + i);
+        for(int ch = 0; ch < channels; ++ch)
+          buffer[ch][bo + i] *= g;
+      }
+      break;
+
+    case WaveEdit::Reverse:
+      // Read the mirrored range, then turn it around.
+      readEdited(level - 1, edit.start + edit.end - e, buffer, channels, len, bo);
+      for(int ch = 0; ch < channels; ++ch)
+      {
+        float* bp = buffer[ch] + bo;
+        for(int i = 0, k = len - 1; i < k; ++i, --k)
+        {
+          const float tmp = bp[i];
+          bp[i] = bp[k];
+          bp[k] = tmp;
+        }
+      }
+      break;
+
+    case WaveEdit::Splice:
+    {
+      // Reference, not copy: a copy would touch the source's
+      //  non-atomic reference count from the prefetch thread.
+      const SndFileR& src = edit.source;
+      readFile(src, edit.sourceOffset + (s - edit.start), buffer, channels, len, bo);
+    }
+    break;
+
+    default:
+      readEdited(level - 1, s, buffer, channels, len, bo);
+      break;
+  }
+}
+
+//---------------------------------------------------------
+//   readPeaks
+//---------------------------------------------------------
+
+void WaveEventBase::readPeaks(SampleV* s, int mag, unsigned pos, bool overwrite, bool allowSeek)
+{
+  if(f.isNull())
+    return;
+  if(_edits.empty())
+  {
+    f.read(s, mag, pos, overwrite, allowSeek);
+    return;
+  }
+
+  const unsigned channels = f.channels();
+  SampleV sa[channels];
+  readEditedPeaks(_edits.size(), sa, mag, pos, allowSeek);
+  for(unsigned ch = 0; ch < channels; ++ch)
+  {
+    if(overwrite)
+      s[ch] = sa[ch];
+    else
+    {
+      if(s[ch].peak < sa[ch].peak)
+        s[ch].peak = sa[ch].peak;
+      s[ch].rms += sa[ch].rms;
+    }
+  }
+}
+
+//---------------------------------------------------------
+//   readEditedPeaks
+//    Peaks are only for drawing, so an edit counts for a whole
+//     window if it covers the middle of it. Always overwrites.
+//---------------------------------------------------------
+
+void WaveEventBase::readEditedPeaks(int level, SampleV* s, int mag, off_t pos, bool allowSeek)
+{
+  const unsigned channels = f.channels();
+  if(level == 0)
+  {
+    if(pos < 0)
+    {
+      for(unsigned ch = 0; ch < channels; ++ch)
+        s[ch].peak = s[ch].rms = 0;
+      return;
+    }
+    f.read(s, mag, pos, true, allowSeek);
+    return;
+  }
+
+  const WaveEdit& edit = _edits[level - 1];
+  const off_t mid = pos + mag / 2;
+  if(mid < edit.start || mid >= edit.end)
+  {
+    readEditedPeaks(level - 1, s, mag, pos, allowSeek);
+    return;
+  }
+
+  switch(edit.type)
+  {
+    case WaveEdit::Mute:
+      for(unsigned ch = 0; ch < channels; ++ch)
+        s[ch].peak = s[ch].rms = 0;
+      break;
+
+    case WaveEdit::Gain:
+    case WaveEdit::FadeIn:
+    case WaveEdit::FadeOut:
+    {
+      readEditedPeaks(level - 1, s, mag, pos, allowSeek);
+      const double g = fabs(edit.gainAt(mid));
+      for(unsigned ch = 0; ch < channels; ++ch)
+      {
+        const int peak = lrint(s[ch].peak * g);
+        const int rms = lrint(s[ch].rms * g);
+        s[ch].peak = peak > 255 ? 255 : peak;
+        s[ch].rms = rms > 255 ? 255 : rms;
+      }
+    }
+    break;
+
+    case WaveEdit::Reverse:
+      readEditedPeaks(level - 1, s, mag, edit.start + edit.end - pos - mag, allowSeek);
+      break;
+
+    case WaveEdit::Splice:
+    {
+      const SndFileR& src = edit.source;
+      const unsigned srcChannels = src.channels();
+      const off_t srcPos = edit.sourceOffset + (pos - edit.start);
+      if(srcChannels == 0 || srcPos < 0)
+      {
+        for(unsigned ch = 0; ch < channels; ++ch)
+          s[ch].peak = s[ch].rms = 0;
+        break;
+      }
+      SampleV sa[srcChannels];
+      src.read(sa, mag, srcPos, true, allowSeek);
+      for(unsigned ch = 0; ch < channels; ++ch)
+        s[ch] = sa[ch % srcChannels];
+    }
+    break;
+
+    default:
+      readEditedPeaks(level - 1, s, mag, pos, allowSeek);
+      break;
+  }
+}
+
 } // namespace MusECore
@@ -42,12 +42,16 @@ class WaveEventBase : public EventBase {
       QString _name;
       SndFileR f;
       int _spos;            // start sample position in WaveFile
+      WaveEditList _edits;  // non-destructive edits, applied in order
 
       // Creates a non-shared clone (copies event base), including the same 'group' id.
       virtual EventBase* clone() const { return new WaveEventBase(*this); }
       // Creates a copy of the event base, excluding the 'group' _id. 
       virtual EventBase* duplicate() const { return new WaveEventBase(*this, true); } 
 
+      void readEdited(int level, off_t pos, float** buffer, int channels, int n, int off);
+      void readEditedPeaks(int level, SampleV* s, int mag, off_t pos, bool allowSeek);
+
    public:
       WaveEventBase(EventType t);
       // Creates a non-shared clone with same id, or duplicate with unique id, and 0 ref count and invalid Pos sn. 
@@ -70,9 +74,13 @@ class WaveEventBase : public EventBase {
       virtual void setSpos(int s)              { _spos = s;     }
       virtual SndFileR sndFile() const         { return f;      }
       virtual void setSndFile(SndFileR& sf)    { f = sf;        }
+      virtual const WaveEditList* waveEdits() const { return &_edits; }
+      virtual void addWaveEdit(const WaveEdit& edit) { _edits.push_back(edit); }
+      virtual void clearWaveEdits()            { _edits.clear(); }
       
       virtual void readAudio(WavePart* part, unsigned offset, 
                              float** bpp, int channels, int nn, bool doSeek, bool overwrite);
+      virtual void readPeaks(SampleV* s, int mag, unsigned pos, bool overwrite, bool allowSeek);
       };
       
 } // namespace MusECore
@@ -66,15 +66,10 @@ void DoubleChorusModel::activate() {
 }
 
 //---------------------------------------------------------
-//   processReplace
+//   updateParameters
 //---------------------------------------------------------
 
-void DoubleChorusModel::processReplace(long n) {
-  float tmpLeftOutput1;
-  float tmpRightOutput1;
-  float tmpLeftOutput2;
-  float tmpRightOutput2;
-  //update parameters
+void DoubleChorusModel::updateParameters() {
   if (param[0] != *port[4]) {
     param[0] = *port[4];
     setPan1(param[0]);
@@ -103,64 +98,63 @@ void DoubleChorusModel::processReplace(long n) {
     param[6] = *port[10];
     setDryWet(param[6]);
   }
-  //process the effect
-  for (int i = 0; i < n; ++i) {
-    _simpleChorus1->process_chorus(port[0][i], port[1][i],
-				   &tmpLeftOutput1, &tmpRightOutput1);  
-    _simpleChorus2->process_chorus(port[0][i], port[1][i],
-				   &tmpLeftOutput2, &tmpRightOutput2);
-    port[2][i] = _dryWet * (tmpLeftOutput1 + tmpLeftOutput2)
-      + (1.0 - _dryWet) * port[0][i];
-    port[3][i] = _dryWet * (tmpRightOutput1 + tmpRightOutput2)
-      + (1.0 - _dryWet) * port[1][i];
+}
+
+//---------------------------------------------------------
+//   process
+//    Runs both choruses over blocks of up to BLOCKSIZE
+//    samples, then mixes the block in one pass.
+//---------------------------------------------------------
+
+void DoubleChorusModel::process(long n, bool mix) {
+  float left1[BLOCKSIZE];
+  float right1[BLOCKSIZE];
+  float left2[BLOCKSIZE];
+  float right2[BLOCKSIZE];
+
+  updateParameters();
+  const float wet = _dryWet;
+  const float dry = 1.0 - _dryWet;
+
+  for (long pos = 0; pos < n; pos += BLOCKSIZE) {
+    const int len = (n - pos < BLOCKSIZE) ? (n - pos) : BLOCKSIZE;
+    const float* inL = port[0] + pos;
+    const float* inR = port[1] + pos;
+    float* outL = port[2] + pos;
+    float* outR = port[3] + pos;
+
+    _simpleChorus1->process_chorus(inL, inR, left1, right1, len);
+    _simpleChorus2->process_chorus(inL, inR, left2, right2, len);
+
+    if (mix) {
+      for (int i = 0; i < len; ++i) {
+	const float l = wet * (left1[i] + left2[i]) + dry * inL[i];
+	const float r = wet * (right1[i] + right2[i]) + dry * inR[i];
+	outL[i] += l;
+	outR[i] += r;
+      }
+    }
+    else {
+      for (int i = 0; i < len; ++i) {
+	const float l = wet * (left1[i] + left2[i]) + dry * inL[i];
+	const float r = wet * (right1[i] + right2[i]) + dry * inR[i];
+	outL[i] = l;
+	outR[i] = r;
+      }
+    }
   }
 }
 
+//---------------------------------------------------------
+//   processReplace
+//---------------------------------------------------------
+
+void DoubleChorusModel::processReplace(long n) {
+  process(n, false);
+}
+
 void DoubleChorusModel::processMix(long n) {
-  float tmpLeftOutput1;
-  float tmpRightOutput1;
-  float tmpLeftOutput2;
-  float tmpRightOutput2;
-  //update parameters
-  if (param[0] != *port[4]) {
-    param[0] = *port[4];
-    setPan1(param[0]);
-  }
-  if (param[1] != *port[5]) {
-    param[1] = *port[5];
-    setLFOFreq1(param[1]);
-  }
-  if (param[2] != *port[6]) {
-    param[2] = *port[6];
-    setDepth1(param[2]);
-  }
-  if (param[3] != *port[7]) {
-    param[3] = *port[7];
-    setPan2(param[3]);
-  }
-  if (param[4] != *port[8]) {
-    param[4] = *port[8];
-    setLFOFreq2(param[4]);
-  }
-  if (param[5] != *port[9]) {
-    param[5] = *port[9];
-    setDepth2(param[5]);
-  }
-  if (param[6] != *port[10]) {
-    param[6] = *port[10];
-    setDryWet(param[6]);
-  }
-  //process the effect
-  for (int i = 0; i < n; ++i) {
-    _simpleChorus1->process_chorus(port[0][i], port[1][i],
-				   &tmpLeftOutput1, &tmpRightOutput1);  
-    _simpleChorus2->process_chorus(port[0][i], port[1][i],
-				   &tmpLeftOutput2, &tmpRightOutput2);
-    port[2][i] += _dryWet * (tmpLeftOutput1 + tmpLeftOutput2)
-      + (1.0 - _dryWet) * port[0][i];
-    port[3][i] += _dryWet * (tmpRightOutput1 + tmpRightOutput2)
-      + (1.0 - _dryWet) * port[1][i];
-  }
+  process(n, true);
 }
 
 //------------------------------------------------------------------
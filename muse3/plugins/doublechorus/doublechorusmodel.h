@@ -34,6 +34,7 @@
 #include <ladspa.h>
 
 #define NBRPARAM 7
+#define BLOCKSIZE 64 //longest block the choruses are run on
 
 class SimpleChorusModel;
 
@@ -42,6 +43,9 @@ class DoubleChorusModel {
   SimpleChorusModel* _simpleChorus2;
 
   float _dryWet; //0.0 : dry, 1.0 : wet
+
+  void updateParameters();
+  void process(long numsamples, bool mix);
   
  public:
   LADSPA_Data* port[NBRPARAM + 4];
@@ -76,34 +76,50 @@ SimpleChorusModel::SimpleChorusModel(float samplerate) {
 SimpleChorusModel::~SimpleChorusModel() {
 }
 
-void SimpleChorusModel::process_chorus(float leftInput, float rightInput,
-				       float* leftOutput, float* rightOutput) {
-  float ocsDiff;
-
-  _ocsDistance = _depthAmp * sinus[(int)_index];
-  
-  ocsDiff = _ocsDistance - floorf(_ocsDistance);
-
-  _past_position_left = MAXBUFFERLENGTH //to be sure that _past_position_left>0
-    + _position - _leftMidDistance + (int)_ocsDistance;
-  _past_position_right = MAXBUFFERLENGTH
-    + _position - _rightMidDistance + (int)_ocsDistance;
-
-  *leftOutput = _leftAmp *
-    lin_interp(ocsDiff, _leftBuffer[_past_position_left%MAXBUFFERLENGTH],
-	       _leftBuffer[(_past_position_left+1)%MAXBUFFERLENGTH]);
-  *rightOutput = _rightAmp *
-    lin_interp(ocsDiff, _rightBuffer[_past_position_right%MAXBUFFERLENGTH],
-	       _rightBuffer[(_past_position_right+1)%MAXBUFFERLENGTH]);
-
-  _leftBuffer[_position] = leftInput;
-  _rightBuffer[_position] = rightInput;
-  
-  _position++;
-  _position %= MAXBUFFERLENGTH;
-  
-  _index += _inct;
-  _index = (_index<MAXSINUSRESOLUTION?_index:_index-MAXSINUSRESOLUTION);
+void SimpleChorusModel::process_chorus(const float* leftInput,
+				       const float* rightInput,
+				       float* leftOutput, float* rightOutput,
+				       int n) {
+  //keep the state in locals, the buffers could alias it otherwise
+  float index = _index;
+  int position = _position;
+  const float leftAmp = _leftAmp;
+  const float rightAmp = _rightAmp;
+  const int leftOffset = MAXBUFFERLENGTH - _leftMidDistance;
+  const int rightOffset = MAXBUFFERLENGTH - _rightMidDistance;
+
+  for(int i = 0; i < n; i++) {
+    float ocsDistance = _depthAmp * sinus[(int)index];
+    float ocsDiff = ocsDistance - floorf(ocsDistance);
+    int ocs = (int)ocsDistance;
+
+    //the read positions are less than a buffer length behind the
+    //write position, so a single comparison wraps them
+    int pl = position + leftOffset + ocs;
+    if(pl >= MAXBUFFERLENGTH) pl -= MAXBUFFERLENGTH;
+    int pl1 = pl + 1;
+    if(pl1 >= MAXBUFFERLENGTH) pl1 -= MAXBUFFERLENGTH;
+    int pr = position + rightOffset + ocs;
+    if(pr >= MAXBUFFERLENGTH) pr -= MAXBUFFERLENGTH;
+    int pr1 = pr + 1;
+    if(pr1 >= MAXBUFFERLENGTH) pr1 -= MAXBUFFERLENGTH;
+
+    leftOutput[i] = leftAmp * lin_interp(ocsDiff, _leftBuffer[pl],
+					 _leftBuffer[pl1]);
+    rightOutput[i] = rightAmp * lin_interp(ocsDiff, _rightBuffer[pr],
+					   _rightBuffer[pr1]);
+
+    _leftBuffer[position] = leftInput[i];
+    _rightBuffer[position] = rightInput[i];
+
+    if(++position >= MAXBUFFERLENGTH) position = 0;
+
+    index += _inct;
+    index = (index<MAXSINUSRESOLUTION?index:index-MAXSINUSRESOLUTION);
+  }
+
+  _index = index;
+  _position = position;
 }
 
 void SimpleChorusModel::setPan(float p) {
@@ -66,17 +66,15 @@ class SimpleChorusModel {
   float _index; //time at the scale of sampleRate
   float _leftBuffer[MAXBUFFERLENGTH];
   float _rightBuffer[MAXBUFFERLENGTH];
-  float _ocsDistance; //in sample, distance of the micro with initial position 
-  int _past_position_left;
-  int _past_position_right;
   int _position;
  public :
   static int useCount;
   static float sinus[MAXSINUSRESOLUTION];
 
 
-  void process_chorus(float leftInput, float rightInput,
-		      float* leftOutput, float* rightOutput);
+  //process n samples, writes the wet signal only
+  void process_chorus(const float* leftInput, const float* rightInput,
+		      float* leftOutput, float* rightOutput, int n);
 
   void setPan(float);
   void setLFOFreq(float);
@@ -13,11 +13,6 @@
 
 #ifndef _allpass_
 #define _allpass_
-#include "denormals.h"
-
-//---------------------------------------------------------
-//   allpass
-//---------------------------------------------------------
 
 class allpass
       {
@@ -32,15 +27,33 @@ class allpass
       	buffer = buf;
 	      bufsize = size;
             }
-      float process(float input) {
-	      float bufout = buffer[bufidx];
-      	undenormalise(bufout);
-	      float output = -input + bufout;
-      	buffer[bufidx] = input + (bufout*feedback);
-            if (++bufidx >= bufsize)
-                  bufidx = 0;
-//            bufidx = ++bufidx % bufsize;
-      	return output;
+
+      //---------------------------------------------------------
+      //   process
+      //    Filters n samples in place, in straight runs up to
+      //    the wrap point. Within a run no sample depends on
+      //    another one of the run, so the loop vectorizes.
+      //---------------------------------------------------------
+
+      void process(float* io, int n) {
+            int i = 0;
+            while (i < n) {
+                  int len = bufsize - bufidx;
+                  if (len > n - i)
+                        len = n - i;
+                  float* buf = buffer + bufidx;
+                  float* p = io + i;
+                  for (int j = 0; j < len; j++) {
+	                  const float bufout = buf[j];
+                        const float input = p[j];
+                        p[j] = -input + bufout;
+      	            buf[j] = input + (bufout*feedback);
+                        }
+                  i += len;
+                  bufidx += len;
+                  if (bufidx >= bufsize)
+                        bufidx = 0;
+                  }
             }
 	void	mute() {
       	for (int i=0; i<bufsize; i++)
@@ -50,8 +63,5 @@ class allpass
 	float	getfeedback()           { return feedback; }
       };
 
-
-// Big to inline - but crucial for speed
-
-
 #endif//_allpass
+
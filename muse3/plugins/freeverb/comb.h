@@ -14,46 +14,96 @@
 #ifndef _comb_
 #define _comb_
 
-#include "denormals.h"
-
+#include "tuning.h"
 
 //---------------------------------------------------------
-//   comb
+//   combbank
+//    The parallel comb filters of both channels, run as
+//    lanes. Lanes 0 to numcombs-1 are the left channel,
+//    the others the right one. All lanes share feedback
+//    and damping, so a block is filtered one time step at
+//    a time across all lanes, which the compiler turns
+//    into vector code.
 //---------------------------------------------------------
 
-class comb
+class combbank
       {
 	float	feedback;
-	float	filterstore;
 	float	damp1;
 	float	damp2;
-	float	*buffer;
-	int bufsize;
-	int bufidx;
+	float	filterstore[numcomblanes];
+	float	*buffer[numcomblanes];
+	int bufsize[numcomblanes];
+	int bufidx[numcomblanes];
 
 public:
-      comb() {
-	      filterstore = 0;
-	      bufidx = 0;
+      combbank() {
+            for (int k = 0; k < numcomblanes; k++) {
+	            filterstore[k] = 0;
+	            buffer[k] = 0;
+	            bufsize[k] = 0;
+	            bufidx[k] = 0;
+                  }
             }
-	void	setbuffer(float *buf, int size) {
-	      buffer = buf;
-	      bufsize = size;
+	void	setbuffer(int lane, float *buf, int size) {
+	      buffer[lane] = buf;
+	      bufsize[lane] = size;
             }
-      float process(float input) {
-      	float output = buffer[bufidx];
-	      undenormalise(output);
-      	filterstore = (output*damp2) + (filterstore*damp1);
-	      undenormalise(filterstore);
-      	buffer[bufidx] = input + (filterstore*feedback);
-            if (++bufidx >= bufsize)
-                  bufidx = 0;
-//            bufidx = ++bufidx % bufsize;
-      	return output;
+
+      //---------------------------------------------------------
+      //   process
+      //    Feeds n samples of input through all lanes and sums
+      //    the lanes of each channel into outL and outR. The
+      //    block is cut where any lane wraps around, so the
+      //    inner loop runs without index checks.
+      //---------------------------------------------------------
+
+      void process(const float* input, float* outL, float* outR, int n) {
+            float fs[numcomblanes];
+            for (int k = 0; k < numcomblanes; k++)
+                  fs[k] = filterstore[k];
+
+            int i = 0;
+            while (i < n) {
+                  int len = n - i;
+                  float* buf[numcomblanes];
+                  for (int k = 0; k < numcomblanes; k++) {
+                        if (bufsize[k] - bufidx[k] < len)
+                              len = bufsize[k] - bufidx[k];
+                        buf[k] = buffer[k] + bufidx[k];
+                        }
+                  const float* in = input + i;
+                  float* l = outL + i;
+                  float* r = outR + i;
+                  for (int j = 0; j < len; j++) {
+                        const float x = in[j];
+                        float sum[2] = { 0, 0 };
+                        for (int k = 0; k < numcomblanes; k++) {
+                              const float output = buf[k][j];
+                              fs[k] = (output*damp2) + (fs[k]*damp1);
+                              buf[k][j] = x + (fs[k]*feedback);
+                              sum[k / numcombs] += output;
+                              }
+                        l[j] = sum[0];
+                        r[j] = sum[1];
+                        }
+                  for (int k = 0; k < numcomblanes; k++) {
+                        bufidx[k] += len;
+                        if (bufidx[k] >= bufsize[k])
+                              bufidx[k] = 0;
+                        }
+                  i += len;
+                  }
+
+            for (int k = 0; k < numcomblanes; k++)
+                  filterstore[k] = fs[k];
             }
 	void	mute() {
-      	for (int i=0; i<bufsize; i++)
-	      	buffer[i]=0;
+            for (int k = 0; k < numcomblanes; k++) {
+	            filterstore[k] = 0;
+      	      for (int i=0; i<bufsize[k]; i++)
+	      	      buffer[k][i]=0;
+                  }
             }
 	void	setdamp(float val) {
 	      damp1 = val;
@@ -64,10 +114,5 @@ public:
 	float	getfeedback()          { return feedback; }
       };
 
-
-// Big to inline - but crucial for speed
-
-
 #endif //_comb_
 
-//ends
@@ -21,22 +21,22 @@
 Revmodel::Revmodel()
       {
 	// Tie the components to their buffers
-	combL[0].setbuffer(bufcombL1,combtuningL1);
-	combR[0].setbuffer(bufcombR1,combtuningR1);
-	combL[1].setbuffer(bufcombL2,combtuningL2);
-	combR[1].setbuffer(bufcombR2,combtuningR2);
-	combL[2].setbuffer(bufcombL3,combtuningL3);
-	combR[2].setbuffer(bufcombR3,combtuningR3);
-	combL[3].setbuffer(bufcombL4,combtuningL4);
-	combR[3].setbuffer(bufcombR4,combtuningR4);
-	combL[4].setbuffer(bufcombL5,combtuningL5);
-	combR[4].setbuffer(bufcombR5,combtuningR5);
-	combL[5].setbuffer(bufcombL6,combtuningL6);
-	combR[5].setbuffer(bufcombR6,combtuningR6);
-	combL[6].setbuffer(bufcombL7,combtuningL7);
-	combR[6].setbuffer(bufcombR7,combtuningR7);
-	combL[7].setbuffer(bufcombL8,combtuningL8);
-	combR[7].setbuffer(bufcombR8,combtuningR8);
+	combs.setbuffer(0,bufcombL1,combtuningL1);
+	combs.setbuffer(numcombs+0,bufcombR1,combtuningR1);
+	combs.setbuffer(1,bufcombL2,combtuningL2);
+	combs.setbuffer(numcombs+1,bufcombR2,combtuningR2);
+	combs.setbuffer(2,bufcombL3,combtuningL3);
+	combs.setbuffer(numcombs+2,bufcombR3,combtuningR3);
+	combs.setbuffer(3,bufcombL4,combtuningL4);
+	combs.setbuffer(numcombs+3,bufcombR4,combtuningR4);
+	combs.setbuffer(4,bufcombL5,combtuningL5);
+	combs.setbuffer(numcombs+4,bufcombR5,combtuningR5);
+	combs.setbuffer(5,bufcombL6,combtuningL6);
+	combs.setbuffer(numcombs+5,bufcombR6,combtuningR6);
+	combs.setbuffer(6,bufcombL7,combtuningL7);
+	combs.setbuffer(numcombs+6,bufcombR7,combtuningR7);
+	combs.setbuffer(7,bufcombL8,combtuningL8);
+	combs.setbuffer(numcombs+7,bufcombR8,combtuningR8);
 	allpassL[0].setbuffer(bufallpassL1,allpasstuningL1);
 	allpassR[0].setbuffer(bufallpassR1,allpasstuningR1);
 	allpassL[1].setbuffer(bufallpassL2,allpasstuningL2);
@@ -67,10 +67,7 @@ Revmodel::Revmodel()
 
 	// Buffer will be full of rubbish - so we MUST mute them
 
-	for (int i = 0; i < numcombs; i++) {
-		combL[i].mute();
-		combR[i].mute();
-            }
+	combs.mute();
 	for (int i=0;i<numallpasses;i++) {
 		allpassL[i].mute();
 		allpassR[i].mute();
@@ -89,10 +86,13 @@ void Revmodel::activate()
       }
 
 //---------------------------------------------------------
-//   processreplace
+//   process
+//    Runs the filters on blocks of up to maxblock samples.
+//    The combs of both channels run side by side, the
+//    allpasses one stage at a time over the whole block.
 //---------------------------------------------------------
 
-void Revmodel::processreplace(long n)
+void Revmodel::process(long n, bool mix)
       {
       if (param[0] != *port[4]) {
             param[0] = *port[4];
@@ -108,66 +108,64 @@ void Revmodel::processreplace(long n)
 	float wet1 = wet * (width/2 + 0.5f);
 	float wet2 = wet * ((1-width)/2);
 
-	for (int i = 0; i < n; ++i) {
-		float outL  = 0;
-		float outR  = 0;
-		float input = (port[0][i] + port[1][i]) * gain;
+      float input[maxblock];
+      float outL[maxblock];
+      float outR[maxblock];
+
+      for (long pos = 0; pos < n; pos += maxblock) {
+            const int len = (n - pos < maxblock) ? (n - pos) : maxblock;
+            const float* inL  = port[0] + pos;
+            const float* inR  = port[1] + pos;
+            float* dstL = port[2] + pos;
+            float* dstR = port[3] + pos;
+
+            for (int i = 0; i < len; ++i)
+                  input[i] = (inL[i] + inR[i]) * gain + antidenormal;
 
 		// Accumulate comb filters in parallel
-		for (int k = 0; k < numcombs; k++) {
-			outL += combL[k].process(input);
-			outR += combR[k].process(input);
-		      }
+            combs.process(input, outL, outR, len);
 
 		// Feed through allpasses in series
-		for (int k=0; k < numallpasses; k++) {
-			outL = allpassL[k].process(outL);
-			outR = allpassR[k].process(outR);
+		for (int k = 0; k < numallpasses; k++) {
+			allpassL[k].process(outL, len);
+			allpassR[k].process(outR, len);
 		      }
 
-		// Calculate output REPLACING anything already there
-		port[2][i] = outL*wet1 + outR*wet2 + port[0][i]*dry;
-		port[3][i] = outR*wet1 + outL*wet2 + port[1][i]*dry;
-	      }
-      }
-
-void Revmodel::processmix(long n)
-      {
-      if (param[0] != *port[4]) {
-            param[0] = *port[4];
-            setroomsize(param[0]);
-            }
-      if (param[1] != *port[5]) {
-            param[1] = *port[5];
-            setdamp(param[1]);
+            if (mix) {
+                  for (int i = 0; i < len; ++i) {
+                        const float l = outL[i]*wet1 + outR[i]*wet2 + inL[i]*dry;
+                        const float r = outR[i]*wet1 + outL[i]*wet2 + inR[i]*dry;
+                        dstL[i] += l;
+                        dstR[i] += r;
+                        }
+                  }
+            else {
+                  for (int i = 0; i < len; ++i) {
+                        const float l = outL[i]*wet1 + outR[i]*wet2 + inL[i]*dry;
+                        const float r = outR[i]*wet1 + outL[i]*wet2 + inR[i]*dry;
+                        dstL[i] = l;
+                        dstR[i] = r;
+                        }
+                  }
             }
+      }
 
-      float wet  = (1.0f - *port[6]) * scalewet;
-      float dry  = *port[6] * scaledry;
-	float wet1 = wet * (width/2 + 0.5f);
-	float wet2 = wet * ((1-width)/2);
-
-	for (int i = 0; i < n; ++i) {
-		float outL  = 0;
-		float outR  = 0;
-		float input = (port[0][i] + port[1][i]) * gain;
+//---------------------------------------------------------
+//   processreplace
+//---------------------------------------------------------
 
-		// Accumulate comb filters in parallel
-		for (int k = 0; k < numcombs; k++) {
-			outL += combL[k].process(input);
-			outR += combR[k].process(input);
-		      }
+void Revmodel::processreplace(long n)
+      {
+      process(n, false);
+      }
 
-		// Feed through allpasses in series
-		for (int k=0; k < numallpasses; k++) {
-			outL = allpassL[k].process(outL);
-			outR = allpassR[k].process(outR);
-		      }
+//---------------------------------------------------------
+//   processmix
+//---------------------------------------------------------
 
-		// Calculate output REPLACING anything already there
-		port[2][i] += outL*wet1 + outR*wet2 + port[0][i]*dry;
-		port[3][i] += outR*wet1 + outL*wet2 + port[1][i]*dry;
-	      }
+void Revmodel::processmix(long n)
+      {
+      process(n, true);
       }
 
 //---------------------------------------------------------
@@ -188,15 +186,8 @@ void Revmodel::update()
 		gain      = fixedgain;
             }
 
-	for (int i = 0; i < numcombs; i++) {
-		combL[i].setfeedback(roomsize1);
-		combR[i].setfeedback(roomsize1);
-            }
-
-	for (int i = 0; i < numcombs; i++) {
-		combL[i].setdamp(damp1);
-		combR[i].setdamp(damp1);
-            }
+	combs.setfeedback(roomsize1);
+	combs.setdamp(damp1);
       }
 
 // The following get/set functions are not inlined, because
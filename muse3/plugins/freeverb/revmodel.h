@@ -30,9 +30,8 @@ class Revmodel {
       float	width;
       float	mode;
 
-      // Comb filters
-      comb combL[numcombs];
-      comb combR[numcombs];
+      // Comb filters, both channels
+      combbank combs;
 
       // Allpass filters
       allpass allpassL[numallpasses];
@@ -66,6 +65,7 @@ class Revmodel {
       float	bufallpassL4[allpasstuningL4];
       float	bufallpassR4[allpasstuningR4];
       void update();
+      void process(long numsamples, bool mix);
 
    public:
       LADSPA_Data* port[7];
@@ -16,6 +16,13 @@
 
 const int	numcombs		= 8;
 const int	numallpasses	= 4;
+const int	numcomblanes	= 2*numcombs;
+// Longest block the filters are run on at once.
+const int	maxblock		= 64;
+// Added to the comb input to keep the filter states out of the
+// denormal range once the input has gone silent. It settles at a
+// tiny dc offset far below anything audible.
+const float	antidenormal	= 1e-18f;
 const float	muted			= 0;
 const float	fixedgain		= 0.015f;
 const float scalewet		= 3;
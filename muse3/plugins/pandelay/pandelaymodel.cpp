@@ -100,58 +100,92 @@ void PanDelayModel::setPanDelay() {
   _rBound = 1.0 + _panLFODepth;
 }
 
+//------------------------------------------------------------------
+// process
+//  The pan LFO is stepped first for a whole run, then the delay
+//  line is processed in one straight loop up to its wrap point.
+//------------------------------------------------------------------
+void PanDelayModel::process(const float* leftSamplesIn,
+			    const float* rightSamplesIn,
+			    float* leftSamplesOut, float* rightSamplesOut,
+			    unsigned n, bool mix) {
+  float lg[BLOCKSIZE];
+  float rg[BLOCKSIZE];
+  const float p = 1.0 - _dryWet;
+  const float feedback = _feedback;
+  const float bias = ANTIDENORMAL;
+  unsigned i = 0;
+  while(i < n) {
+    //run up to the end of the delay, at least one sample in case
+    //the delay has just been shortened below the buffer pointer
+    int len = _delaySampleSize - _bufferPointer;
+    if(len < 1) len = 1;
+    if(len > BLOCKSIZE) len = BLOCKSIZE;
+    if((unsigned)len > n - i) len = n - i;
+
+    //gains, wet level included
+    float l = _l;
+    float r = _r;
+    float inc = _inc;
+    for(int j = 0; j < len; j++) {
+      lg[j] = l * _dryWet;
+      rg[j] = r * _dryWet;
+      r += inc;
+      l -= inc;
+      if(r > _rBound || r < _lBound) inc = -inc;
+    }
+    _l = l;
+    _r = r;
+    _inc = inc;
+
+    float* lb = _leftBuffer + _bufferPointer;
+    float* rb = _rightBuffer + _bufferPointer;
+    const float* li = leftSamplesIn + i;
+    const float* ri = rightSamplesIn + i;
+    float* lo = leftSamplesOut + i;
+    float* ro = rightSamplesOut + i;
+    if(mix) {
+      for(int j = 0; j < len; j++) {
+	const float ls = lb[j];
+	const float rs = rb[j];
+	const float lin = li[j];
+	const float rin = ri[j];
+	lb[j] = ls * feedback + lin + bias;
+	rb[j] = rs * feedback + rin + bias;
+	lo[j] += lg[j] * ls + p * lin;
+	ro[j] += rg[j] * rs + p * rin;
+      }
+    }
+    else {
+      for(int j = 0; j < len; j++) {
+	const float ls = lb[j];
+	const float rs = rb[j];
+	const float lin = li[j];
+	const float rin = ri[j];
+	lb[j] = ls * feedback + lin + bias;
+	rb[j] = rs * feedback + rin + bias;
+	lo[j] = lg[j] * ls + p * lin;
+	ro[j] = rg[j] * rs + p * rin;
+      }
+    }
+
+    _bufferPointer += len;
+    if(_bufferPointer >= _delaySampleSize)
+      _bufferPointer %= _delaySampleSize;
+    i += len;
+  }
+}
+
 void PanDelayModel::processMix(float* leftSamplesIn, float* rightSamplesIn,
 			       float* leftSamplesOut, float* rightSamplesOut,
 			       unsigned n) {
-  float ls, rs, p;
-  p = 1.0 - _dryWet;
-  for(unsigned i = 0; i < n; i++) {
-    //read buffer
-    ls = _leftBuffer[_bufferPointer];
-    rs = _rightBuffer[_bufferPointer];
-    //write buffer
-    _leftBuffer[_bufferPointer] *= _feedback;
-    _leftBuffer[_bufferPointer] += leftSamplesIn[i];
-    _rightBuffer[_bufferPointer] *= _feedback;
-    _rightBuffer[_bufferPointer] += rightSamplesIn[i];
-    //write out
-    leftSamplesOut[i] += _l * _dryWet * ls + p * leftSamplesIn[i];
-    rightSamplesOut[i] += _r * _dryWet * rs + p * rightSamplesIn[i];
-    //update _bufferPointer
-    _bufferPointer++;
-    _bufferPointer%=_delaySampleSize;
-    //update _l _r
-    _r += _inc;
-    _l -= _inc;
-    //update _inc
-    if(_r > _rBound || _r < _lBound) _inc = -_inc;
-  }
+  process(leftSamplesIn, rightSamplesIn, leftSamplesOut, rightSamplesOut,
+	  n, true);
 }
 
 void PanDelayModel::processReplace(float* leftSamplesIn, float* rightSamplesIn,
 				   float* leftSamplesOut,
 				   float* rightSamplesOut, unsigned n) {
-  float ls, rs, p;
-  p = 1.0 - _dryWet;
-  for(unsigned i = 0; i < n; i++) {
-    //read buffer
-    ls = _leftBuffer[_bufferPointer];
-    rs = _rightBuffer[_bufferPointer];
-    //write buffer
-    _leftBuffer[_bufferPointer] *= _feedback;
-    _leftBuffer[_bufferPointer] += leftSamplesIn[i];
-    _rightBuffer[_bufferPointer] *= _feedback;
-    _rightBuffer[_bufferPointer] += rightSamplesIn[i];
-    //write out
-    leftSamplesOut[i] = _l * _dryWet * ls + p * leftSamplesIn[i];
-    rightSamplesOut[i] = _r * _dryWet * rs + p * rightSamplesIn[i];
-    //update _bufferPointer
-    _bufferPointer++;
-    _bufferPointer%=_delaySampleSize;
-    //update _l _r
-    _r += _inc;
-    _l -= _inc;
-    //update _inc
-    if(_r > _rBound || _r < _lBound) _inc = -_inc;
-  }
+  process(leftSamplesIn, rightSamplesIn, leftSamplesOut, rightSamplesOut,
+	  n, false);
 }
@@ -41,6 +41,9 @@
 #define MAXBEATRATIO 2.0
 #define MINDELAYTIME 0.01 //in second
 #define MAXDELAYTIME 2.0 //in second
+#define BLOCKSIZE 64 //longest block the pan gains are computed for
+#define ANTIDENORMAL 1e-18f //added to the feedback, keeps it out of the
+                            //denormal range once the input is silent
 
 #ifdef NBRPARAM
 #undef NBRPARAM
@@ -71,6 +74,10 @@ class PanDelayModel {
   float _rightBuffer[MAXBUFFERLENGTH];
   int _bufferPointer;
 
+  void process(const float* leftInSamples, const float* rightInSamples,
+	       float* leftOutSamples, float* rightOutSamples,
+	       unsigned n, bool mix);
+
  public:
   PanDelayModel(int samplerate);
   ~PanDelayModel();
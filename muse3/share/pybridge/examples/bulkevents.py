@@ -0,0 +1,41 @@
+"""
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//  (C) Copyright 2009 Mathias Gyllengahm (lunar_shuttle@users.sf.net)
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the
+#  Free Software Foundation, Inc.,
+#  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//=========================================================
+"""
+
+#
+# Transposes all notes in all parts of "Track 1" up an octave,
+# using the packed event records and a single transaction.
+#
+
+import Pyro.core
+import numpy
+
+muse=Pyro.core.getProxyForURI('PYRONAME://:Default.muse')
+dt = numpy.dtype([(str(name), str(fmt)) for name, fmt in muse.getEventRecordFormat()])
+
+muse.beginTransaction()
+for part in muse.getParts("Track 1"):
+      events = numpy.frombuffer(muse.getPartEvents(part['id']), dtype=dt)
+      notes = events['type'] == 0
+      events['a'][notes] = numpy.minimum(events['a'][notes] + 12, 127)
+      muse.setPartEvents(part['id'], events.tobytes())
+muse.commitTransaction()
@@ -80,6 +80,24 @@ class MusE:
       def deletePart(self, part): # delete a part
             return muse.deletePart((part))
 
+      def getEventRecordFormat(self): # field names and types of the packed event records, usable as a numpy dtype
+            return muse.getEventRecordFormat()
+
+      def getPartEvents(self, partid): # notes and controllers of a part, as a bytearray of packed records
+            return muse.getPartEvents(partid)
+
+      def setPartEvents(self, partid, events): # replace notes and controllers of a part with packed records
+            return muse.setPartEvents(partid, events)
+
+      def beginTransaction(self): # collect setPartEvents calls until commitTransaction
+            return muse.beginTransaction()
+
+      def commitTransaction(self): # apply the collected edits as one operation
+            return muse.commitTransaction()
+
+      def abortTransaction(self): # discard the collected edits
+            return muse.abortTransaction()
+
       def getSelectedTrack(self): # get first selected track in arranger window
             return muse.getSelectedTrack()
 
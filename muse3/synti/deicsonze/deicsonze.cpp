@@ -1933,7 +1933,7 @@ inline double coefAttack(unsigned char attack) {
 //   envelope state, making evoluate the envelope
 //  sr is the sample rate and st the sine_table
 //---------------------------------------------------------
-inline double env2AmpR(double sr, float* wt, Eg eg, OpVoice* p_opVoice) {
+inline double env2AmpR(double sr, float* wt, const Eg& eg, OpVoice* p_opVoice) {
   switch(p_opVoice->envState) {
   case ATTACK:
     p_opVoice->envIndex+=p_opVoice->envInct;
@@ -4088,341 +4088,315 @@ void DeicsOnze::processMessages()
 }
 
 //---------------------------------------------------------
-//   write
-//    synthesize n samples into buffer+offset
+// routeSample
+//  apply the algorithm routing to the operators of one voice
+//  for one sample, return the voice output.
+//  The algorithm is a template parameter so that the routing
+//  is resolved once per voice and block, not per sample.
 //---------------------------------------------------------
-void DeicsOnze::process(unsigned pos, float** buffer, int offset, int n) {
-  /*
-  //Process messages from the gui
-  while (_gui->fifoSize()) {
-    MusECore::MidiPlayEvent ev = _gui->readEvent();
-    if (ev.type() == MusECore::ME_SYSEX) {
-      sysex(ev.len(), ev.data(), true);
-      sendEvent(ev);
-    }
-    else if (ev.type() == MusECore::ME_CONTROLLER) {
-      setController(ev.channel(), ev.dataA(), ev.dataB(), true);
-      sendEvent(ev);
+template <int A>
+inline float routeSample(float* sampleOp, const float* ampOp,
+			 const double* index, float feedback,
+			 float* const* wt) {
+  sampleOp[3]=ampOp[3]
+    *wt[3][(int)plusMod(index[3], (float)RESOLUTION*feedback)];
+  switch(A) {
+  case FIRST :
+    sampleOp[2]=ampOp[2]*wt[2][(int)plusMod(index[2],
+					    (float)RESOLUTION*sampleOp[3])];
+    sampleOp[1]=ampOp[1]*wt[1][(int)plusMod(index[1],
+					    (float)RESOLUTION*sampleOp[2])];
+    sampleOp[0]=ampOp[0]*wt[0][(int)plusMod(index[0],
+					    (float)RESOLUTION*sampleOp[1])];
+    return sampleOp[0];
+  case SECOND :
+    sampleOp[2]=ampOp[2]*wt[2][(int)index[2]];
+    sampleOp[1]=ampOp[1]*wt[1][(int)plusMod(index[1],
+					    (float)RESOLUTION
+					    *(sampleOp[2]+sampleOp[3])/2.0)];
+    sampleOp[0]=ampOp[0]*wt[0][(int)plusMod(index[0],
+					    (float)RESOLUTION*sampleOp[1])];
+    return sampleOp[0];
+  case THIRD :
+    sampleOp[2]=ampOp[2]*wt[2][(int)index[2]];
+    sampleOp[1]=ampOp[1]*wt[1][(int)plusMod(index[1],
+					    (float)RESOLUTION*sampleOp[2])];
+    sampleOp[0]=ampOp[0]*wt[0][(int)plusMod(index[0],
+					    (float)RESOLUTION
+					    *(sampleOp[3]+sampleOp[1])/2.0)];
+    return sampleOp[0];
+  case FOURTH :
+    sampleOp[2]=ampOp[2]*wt[2][(int)plusMod(index[2],
+					    (float)RESOLUTION*sampleOp[3])];
+    sampleOp[1]=ampOp[1]*wt[1][(int)index[1]];
+    sampleOp[0]=ampOp[0]*wt[0][(int)plusMod(index[0],
+					    (float)RESOLUTION
+					    *(sampleOp[1]+sampleOp[2])/2.0)];
+    return sampleOp[0];
+  case FIFTH :
+    sampleOp[2]=ampOp[2]*wt[2][(int)plusMod(index[2],
+					    (float)RESOLUTION*sampleOp[3])];
+    sampleOp[1]=ampOp[1]*wt[1][(int)index[1]];
+    sampleOp[0]=ampOp[0]*wt[0][(int)plusMod(index[0],
+					    (float)RESOLUTION*sampleOp[1])];
+    return (sampleOp[0]+sampleOp[2])/2.0;
+  case SIXTH :
+    sampleOp[2]=ampOp[2]*wt[2][(int)plusMod(index[2],
+					    (float)RESOLUTION*sampleOp[3])];
+    sampleOp[1]=ampOp[1]*wt[1][(int)plusMod(index[1],
+					    (float)RESOLUTION*sampleOp[3])];
+    sampleOp[0]=ampOp[0]*wt[0][(int)plusMod(index[0],
+					    (float)RESOLUTION*sampleOp[3])];
+    return (sampleOp[0]+sampleOp[1]+sampleOp[2])/3.0;
+  case SEVENTH :
+    sampleOp[2]=ampOp[2]*wt[2][(int)plusMod(index[2],
+					    (float)RESOLUTION*sampleOp[3])];
+    sampleOp[1]=ampOp[1]*wt[1][(int)index[1]];
+    sampleOp[0]=ampOp[0]*wt[0][(int)index[0]];
+    return (sampleOp[0]+sampleOp[1]+sampleOp[2])/3.0;
+  case EIGHTH :
+    sampleOp[2]=ampOp[2]*wt[2][(int)index[2]];
+    sampleOp[1]=ampOp[1]*wt[1][(int)index[1]];
+    sampleOp[0]=ampOp[0]*wt[0][(int)index[0]];
+    return (sampleOp[0]+sampleOp[1]+sampleOp[2]+sampleOp[3])/4.0;
+  }
+  return 0.0;
+}
+
+//---------------------------------------------------------
+// isVoiceOn
+//  true while one of the carriers of the algorithm is sounding
+//---------------------------------------------------------
+inline bool isVoiceOn(const Voice* v, Algorithm a) {
+  switch(a) {
+  case FIFTH :
+    return v->op[0].envState!=OFF || v->op[2].envState!=OFF;
+  case EIGHTH :
+    return v->op[0].envState!=OFF || v->op[1].envState!=OFF
+      || v->op[2].envState!=OFF || v->op[3].envState!=OFF;
+  default :
+    return v->op[0].envState!=OFF;
+  }
+}
+
+//---------------------------------------------------------
+// renderVoiceA
+//  render up to nr samples of a voice routed by the algorithm
+//  A into channelOut. Portamento, pitch envelope, phase indexes,
+//  envelopes and routing are evaluated per sample in the same
+//  order as the former per sample renderer, so the output is
+//  identical, only the algorithm switch is hoisted out of the
+//  sample loop.
+//---------------------------------------------------------
+template <int A>
+inline void renderVoiceA(Preset* p, Channel* p_c, Voice* v,
+			 float* const* wt, float* ampTable, double sr,
+			 const float* blockInc, const float* blockLfoAmp,
+			 float* channelOut, int nr) {
+  float sampleOp[NBROP];
+  float ampOp[NBROP];
+  double index[NBROP];
+  const float feedbackAmp = p_c->feedbackAmp;
+  float feedback = v->sampleFeedback;
+  for(int m = 0; m < nr; m++) {
+    portamentoUpdate(p_c, v);
+    pitchEnvelopeUpdate(v, &p->pitchEg, sr);
+    for(int k = 0; k < NBROP; k++) {
+      OpVoice* op = &v->op[k];
+      //compute the next index on the wavetable,
+      //without taking account of the feedback and FM modulation
+      op->index = plusMod(op->index,
+			  op->inct * blockInc[m] * v->pitchEnvCoefInct);
+      index[k] = op->index;
+      ampOp[k] = op->amp*COEFLEVEL
+	*(p->sensitivity.ampOn[k]?blockLfoAmp[m]:1.0)
+	*env2AmpR(sr, ampTable, p->eg[k], op);
     }
+    channelOut[m] += routeSample<A>(sampleOp, ampOp, index, feedback, wt);
+    feedback = sampleOp[3]*feedbackAmp;
+    v->isOn = isVoiceOn(v, (Algorithm)A);
+    if(!v->isOn) break;
   }
-  */
-  
-  float* leftOutput = buffer[0] + offset;
-  float* rightOutput = buffer[1] + offset; 
+  v->sampleFeedback = feedback;
+  v->volume = ampOp[0]+ampOp[1]+ampOp[2]+ampOp[3];
+}
 
-  float sample[MAXNBRVOICES];
-  float tempLeftOutput;
-  float tempRightOutput;
-  float tempChannelOutput;
+//---------------------------------------------------------
+// renderVoice
+//  render up to nr samples of a voice into channelOut
+//---------------------------------------------------------
+void DeicsOnze::renderVoice(int c, Voice* v, const float* blockInc,
+			    const float* blockLfoAmp, float* channelOut,
+			    int nr) {
+  Preset* p = _preset[c];
+  Channel* p_c = &_global.channel[c];
+  double sr = _global.deiSampleRate;
+  float* wt[NBROP];
+  for(int k = 0; k < NBROP; k++) wt[k] = waveTable[p->oscWave[k]];
+  switch(p->algorithm) {
+  case FIRST :
+    renderVoiceA<FIRST>(p, p_c, v, wt, waveTable[W2], sr,
+			blockInc, blockLfoAmp, channelOut, nr);
+    break;
+  case SECOND :
+    renderVoiceA<SECOND>(p, p_c, v, wt, waveTable[W2], sr,
+			 blockInc, blockLfoAmp, channelOut, nr);
+    break;
+  case THIRD :
+    renderVoiceA<THIRD>(p, p_c, v, wt, waveTable[W2], sr,
+			blockInc, blockLfoAmp, channelOut, nr);
+    break;
+  case FOURTH :
+    renderVoiceA<FOURTH>(p, p_c, v, wt, waveTable[W2], sr,
+			 blockInc, blockLfoAmp, channelOut, nr);
+    break;
+  case FIFTH :
+    renderVoiceA<FIFTH>(p, p_c, v, wt, waveTable[W2], sr,
+			blockInc, blockLfoAmp, channelOut, nr);
+    break;
+  case SIXTH :
+    renderVoiceA<SIXTH>(p, p_c, v, wt, waveTable[W2], sr,
+			blockInc, blockLfoAmp, channelOut, nr);
+    break;
+  case SEVENTH :
+    renderVoiceA<SEVENTH>(p, p_c, v, wt, waveTable[W2], sr,
+			  blockInc, blockLfoAmp, channelOut, nr);
+    break;
+  case EIGHTH :
+    renderVoiceA<EIGHTH>(p, p_c, v, wt, waveTable[W2], sr,
+			 blockInc, blockLfoAmp, channelOut, nr);
+    break;
+  default : printf("Error : No algorithm");
+    break;
+  }
+}
+
+//---------------------------------------------------------
+// renderBlock
+//  render nr DeicsOnze samples (that is, samples at the
+//  DeicsOnze sample rate which depends on the quality) into
+//  the dry and fx send accumulators. Voices are rendered one
+//  after the other over the whole block so that their state
+//  stays local, the channel lfo is computed once per block.
+//---------------------------------------------------------
+void DeicsOnze::renderBlock(int nr, float* left, float* right,
+			    float* chorusLeft, float* chorusRight,
+			    float* reverbLeft, float* reverbRight,
+			    float* delayLeft, float* delayRight) {
+  float blockInc[DEICSONZE_RENDERBLOCK];
+  float blockLfoAmp[DEICSONZE_RENDERBLOCK];
+  float channelOut[DEICSONZE_RENDERBLOCK];
   float tempChannelLeftOutput;
   float tempChannelRightOutput;
-  float tempIncChannel; //for optimization
-  float sampleOp[NBROP];
-  for(int i = 0; i < NBROP; i++) sampleOp[i] = 0.0;
-  float ampOp[NBROP];
-  for(int i = 0; i < n; i++) {
-    if(_global.qualityCounter == 0) {
-      tempLeftOutput = 0.0;
-      tempRightOutput = 0.0;
-      _global.lastInputLeftChorusSample = 0.0;
-      _global.lastInputRightChorusSample = 0.0;
-      _global.lastInputLeftReverbSample = 0.0;
-      _global.lastInputRightReverbSample = 0.0;
-      _global.lastInputLeftDelaySample = 0.0;
-      _global.lastInputRightDelaySample = 0.0;
-      //per channel
-      for(int c = 0; c < NBRCHANNELS; c++) {
-	tempChannelOutput = 0.0;
-	if(_global.channel[c].isEnable) {
-	  //lfo, trick : we use the first quater of the wave W2
-	  lfoUpdate(_preset[c], &_global.channel[c], waveTable[W2]);
-	  
-	  //optimization
-	  tempIncChannel =
-	    _global.channel[c].lfoCoefInct * _global.channel[c].pitchBendCoef;
-	  
-	  //per voice
-	  for(int j=0; j<_global.channel[c].nbrVoices; j++) {
-	    if (_global.channel[c].voices[j].isOn) {
-	      //portamento
-	      portamentoUpdate(&_global.channel[c],
-			       &_global.channel[c].voices[j]);
-	      //pitch envelope
-	      pitchEnvelopeUpdate(&_global.channel[c].voices[j],
-				  &_preset[c]->pitchEg, _global.deiSampleRate);
-	      //per op
-	      for(int k=0; k<NBROP; k++) {
-		//compute the next index on the wavetable,
-		//without taking account of the feedback and FM modulation
-		_global.channel[c].voices[j].op[k].index=
-		  plusMod(_global.channel[c].voices[j].op[k].index,
-			  _global.channel[c].voices[j].op[k].inct
-			  * tempIncChannel
-			  * _global.channel[c].voices[j].pitchEnvCoefInct);
-		
-		ampOp[k]=_global.channel[c].voices[j].op[k].amp*COEFLEVEL
-		  *(_preset[c]->sensitivity.ampOn[k]?
-		    _global.channel[c].lfoAmp:1.0)
-		  *env2AmpR(_global.deiSampleRate, waveTable[W2],
-			    _preset[c]->eg[k],
-			    &_global.channel[c].voices[j].op[k]);
-	      }
-	      switch(_preset[c]->algorithm) {
-	      case FIRST :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[2].index,
-				(float)RESOLUTION*sampleOp[3])];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[1].index,
-				(float)RESOLUTION*sampleOp[2])];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION*sampleOp[1])];
-		
-		sample[j]=sampleOp[0];///COEFLEVEL;
-		
-		_global.channel[c].voices[j].isOn =
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;
-	      case SECOND :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)_global.channel[c].voices[j].op[2].index];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[1].index,
-				(float)RESOLUTION
-				*(sampleOp[2]+sampleOp[3])/2.0)];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION
-				*sampleOp[1])];
-		
-		sample[j]=sampleOp[0];///COEFLEVEL;
-		
-		_global.channel[c].voices[j].isOn =
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;
-	      case THIRD :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)_global.channel[c].voices[j].op[2].index];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[1].index,
-				(float)RESOLUTION*sampleOp[2])];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION
-				*(sampleOp[3]+sampleOp[1])/2.0)];
-		
-		sample[j]=sampleOp[0];///COEFLEVEL;
-		
-		_global.channel[c].voices[j].isOn = 
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;
-	      case FOURTH :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[2].index,
-				(float)RESOLUTION
-				*sampleOp[3])];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)_global.channel[c].voices[j].op[1].index];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION
-				*(sampleOp[1]+sampleOp[2])/2.0)];
-		
-		sample[j]=sampleOp[0];///COEFLEVEL;
-		
-		_global.channel[c].voices[j].isOn =
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;
-	      case FIFTH :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[2].index,
-				(float)RESOLUTION*sampleOp[3])];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)_global.channel[c].voices[j].op[1].index];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION*sampleOp[1])];
-		
-		sample[j]=(sampleOp[0]+sampleOp[2])/2.0;///COEFLEVEL;
-		
-		_global.channel[c].voices[j].isOn = 
-		  (_global.channel[c].voices[j].op[0].envState!=OFF
-		   ||_global.channel[c].voices[j].op[2].envState!=OFF);
-		break;
-	      case SIXTH :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[2].index,
-				(float)RESOLUTION*sampleOp[3])];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[1].index,
-				(float)RESOLUTION*sampleOp[3])];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION*sampleOp[3])];
-		
-		sample[j]=(sampleOp[0]+sampleOp[1]+sampleOp[2])/3.0;
-		
-		_global.channel[c].voices[j].isOn = 
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;
-	      case SEVENTH :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[2].index,
-				(float)RESOLUTION*sampleOp[3])];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)_global.channel[c].voices[j].op[1].index];
-		sampleOp[0]=ampOp[0]*waveTable[_preset[c]->oscWave[0]]
-		  [(int)_global.channel[c].voices[j].op[0].index];
-		
-		sample[j]=(sampleOp[0]+sampleOp[1]+sampleOp[2])/3.0;
-		
-		_global.channel[c].voices[j].isOn =
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;		
-	      case EIGHTH :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)_global.channel[c].voices[j].op[2].index];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)_global.channel[c].voices[j].op[1].index];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)_global.channel[c].voices[j].op[0].index];
-		
-		sample[j]=
-		  (sampleOp[0]+sampleOp[1]+sampleOp[2]+sampleOp[3])
-		  /4.0;
-		
-		_global.channel[c].voices[j].isOn =
-		  (_global.channel[c].voices[j].op[0].envState!=OFF
-		   || _global.channel[c].voices[j].op[1].envState!=OFF
-		   || _global.channel[c].voices[j].op[2].envState!=OFF
-		   || _global.channel[c].voices[j].op[3].envState!=OFF);
-		break;
-	      default : printf("Error : No algorithm");
-		break;
-	      }
-	      
-	      _global.channel[c].voices[j].volume=
-		ampOp[0]+ampOp[1]+ampOp[2]+ampOp[3];
-	      
-	      _global.channel[c].voices[j].sampleFeedback =
-		sampleOp[3]*_global.channel[c].feedbackAmp;
-	      
-	      tempChannelOutput += sample[j];
-	    }
-	  }
-	  //printf("left out = %f, temp out = %f, left amp = %f\n",
-	  //tempLeftOutput, tempChannelOutput, _global.channel[c].ampLeft);
- 
-	  tempChannelLeftOutput = tempChannelOutput*_global.channel[c].ampLeft;
-	  tempChannelRightOutput=tempChannelOutput*_global.channel[c].ampRight;
-	  
-	  if(_global.isChorusActivated) {
-	    _global.lastInputLeftChorusSample += tempChannelLeftOutput *
-	      _global.channel[c].chorusAmount;
-	    _global.lastInputRightChorusSample += tempChannelRightOutput *
-	      _global.channel[c].chorusAmount;
-	  }
-	  if(_global.isReverbActivated) {
-	    _global.lastInputLeftReverbSample += tempChannelLeftOutput *
-	      _global.channel[c].reverbAmount;
-	    _global.lastInputRightReverbSample += tempChannelRightOutput *
-	      _global.channel[c].reverbAmount;
-	  }
-	  if(_global.isDelayActivated) {
-	    _global.lastInputLeftDelaySample += tempChannelLeftOutput *
-	      _global.channel[c].delayAmount;
-	    _global.lastInputRightDelaySample += tempChannelRightOutput *
-	      _global.channel[c].delayAmount;
-	  }
-	  tempLeftOutput += tempChannelLeftOutput;
-	  tempRightOutput += tempChannelRightOutput;
-	}
+
+  for(int r = 0; r < nr; r++) {
+    left[r] = right[r] = 0.0;
+    chorusLeft[r] = chorusRight[r] = 0.0;
+    reverbLeft[r] = reverbRight[r] = 0.0;
+    delayLeft[r] = delayRight[r] = 0.0;
+  }
+
+  //per channel
+  for(int c = 0; c < NBRCHANNELS; c++) {
+    if(!_global.channel[c].isEnable) continue;
+    Channel* p_c = &_global.channel[c];
+
+    //lfo, trick : we use the first quater of the wave W2
+    for(int r = 0; r < nr; r++) {
+      lfoUpdate(_preset[c], p_c, waveTable[W2]);
+      blockInc[r] = p_c->lfoCoefInct * p_c->pitchBendCoef;
+      blockLfoAmp[r] = p_c->lfoAmp;
+      channelOut[r] = 0.0;
+    }
+
+    //per voice
+    for(int j = 0; j < p_c->nbrVoices; j++)
+      if(p_c->voices[j].isOn)
+	renderVoice(c, &p_c->voices[j], blockInc, blockLfoAmp, channelOut, nr);
+
+    for(int r = 0; r < nr; r++) {
+      tempChannelLeftOutput = channelOut[r]*p_c->ampLeft;
+      tempChannelRightOutput = channelOut[r]*p_c->ampRight;
+      if(_global.isChorusActivated) {
+	chorusLeft[r] += tempChannelLeftOutput * p_c->chorusAmount;
+	chorusRight[r] += tempChannelRightOutput * p_c->chorusAmount;
+      }
+      if(_global.isReverbActivated) {
+	reverbLeft[r] += tempChannelLeftOutput * p_c->reverbAmount;
+	reverbRight[r] += tempChannelRightOutput * p_c->reverbAmount;
       }
-      _global.lastLeftSample = tempLeftOutput * _global.masterVolume;
-      _global.lastRightSample = tempRightOutput * _global.masterVolume;
+      if(_global.isDelayActivated) {
+	delayLeft[r] += tempChannelLeftOutput * p_c->delayAmount;
+	delayRight[r] += tempChannelRightOutput * p_c->delayAmount;
+      }
+      left[r] += tempChannelLeftOutput;
+      right[r] += tempChannelRightOutput;
     }
-    leftOutput[i] += _global.lastLeftSample;
-    rightOutput[i] += _global.lastRightSample;
-	  
-    if(_global.isChorusActivated) {
-      tempInputChorus[0][i] = _global.lastInputLeftChorusSample;
-      tempInputChorus[1][i] = _global.lastInputRightChorusSample;
+  }
+}
+
+//---------------------------------------------------------
+//   write
+//    synthesize n samples into buffer+offset
+//---------------------------------------------------------
+void DeicsOnze::process(unsigned pos, float** buffer, int offset, int n) {
+  float* leftOutput = buffer[0] + offset;
+  float* rightOutput = buffer[1] + offset; 
+
+  float left[DEICSONZE_RENDERBLOCK];
+  float right[DEICSONZE_RENDERBLOCK];
+  float chorusLeft[DEICSONZE_RENDERBLOCK];
+  float chorusRight[DEICSONZE_RENDERBLOCK];
+  float reverbLeft[DEICSONZE_RENDERBLOCK];
+  float reverbRight[DEICSONZE_RENDERBLOCK];
+  float delayLeft[DEICSONZE_RENDERBLOCK];
+  float delayRight[DEICSONZE_RENDERBLOCK];
+
+  for(int b = 0; b < n; b += DEICSONZE_RENDERBLOCK) {
+    int bn = n - b < DEICSONZE_RENDERBLOCK ? n - b : DEICSONZE_RENDERBLOCK;
+    //count the samples to compute, depending on quality the
+    //others repeat the last computed sample
+    int nr = 0;
+    for(int i = 0, qc = _global.qualityCounter; i < bn; i++) {
+      if(qc == 0) nr++;
+      qc = (qc + 1) % _global.qualityCounterTop;
+    }
+    if(nr)
+      renderBlock(nr, left, right, chorusLeft, chorusRight,
+		  reverbLeft, reverbRight, delayLeft, delayRight);
+
+    int r = 0;
+    for(int i = b; i < b + bn; i++) {
+      if(_global.qualityCounter == 0) {
+	_global.lastLeftSample = left[r] * _global.masterVolume;
+	_global.lastRightSample = right[r] * _global.masterVolume;
+	_global.lastInputLeftChorusSample = chorusLeft[r];
+	_global.lastInputRightChorusSample = chorusRight[r];
+	_global.lastInputLeftReverbSample = reverbLeft[r];
+	_global.lastInputRightReverbSample = reverbRight[r];
+	_global.lastInputLeftDelaySample = delayLeft[r];
+	_global.lastInputRightDelaySample = delayRight[r];
+	r++;
+      }
+      leftOutput[i] += _global.lastLeftSample;
+      rightOutput[i] += _global.lastRightSample;
+
+      if(_global.isChorusActivated) {
+	tempInputChorus[0][i] = _global.lastInputLeftChorusSample;
+	tempInputChorus[1][i] = _global.lastInputRightChorusSample;
+      }
+      if(_global.isReverbActivated) {
+	tempInputReverb[0][i] = _global.lastInputLeftReverbSample;
+	tempInputReverb[1][i] = _global.lastInputRightReverbSample;
+      }    
+      if(_global.isDelayActivated) {
+	tempInputDelay[0][i] = _global.lastInputLeftDelaySample;
+	tempInputDelay[1][i] = _global.lastInputRightDelaySample;
+      }    
+
+      _global.qualityCounter++;
+      _global.qualityCounter %= _global.qualityCounterTop;
     }
-    if(_global.isReverbActivated) {
-      tempInputReverb[0][i] = _global.lastInputLeftReverbSample;
-      tempInputReverb[1][i] = _global.lastInputRightReverbSample;
-    }    
-    if(_global.isDelayActivated) {
-      tempInputDelay[0][i] = _global.lastInputLeftDelaySample;
-      tempInputDelay[1][i] = _global.lastInputRightDelaySample;
-    }    
-    
-    _global.qualityCounter++;
-    _global.qualityCounter %= _global.qualityCounterTop;
   }
   //apply Filter
   if(_global.filter) _dryFilter->process(leftOutput, rightOutput, n);
@@ -96,6 +96,7 @@
 #define NBRWAVES 8 //number wave forms, do not change
 #define NBRBANKPRESETS 32
 #define MAXNBRVOICES 64
+#define DEICSONZE_RENDERBLOCK 64 //max number of samples rendered per voice at once
 #define NBRCHANNELS 16
 
 #define SYSEX_INIT_DATA 1
@@ -446,6 +447,12 @@ class DeicsOnze : public Mess {
   static float waveTable[NBRWAVES][RESOLUTION];
 
  private:
+  void renderVoice(int c, Voice* v, const float* blockInc,
+		   const float* blockLfoAmp, float* channelOut, int nr);
+  void renderBlock(int nr, float* left, float* right,
+		   float* chorusLeft, float* chorusRight,
+		   float* reverbLeft, float* reverbRight,
+		   float* delayLeft, float* delayRight);
   void parseInitData(int length, const unsigned char* data);
   void loadConfiguration(QString fileName);
   void setupInitBuffer(int len);
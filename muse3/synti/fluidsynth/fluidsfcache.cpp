@@ -0,0 +1,163 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//  $Id: ./synti/fluidsynth/fluidsfcache.cpp $
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <stdio.h>
+
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#include "fluidsfcache.h"
+
+#ifdef FLUIDSYNTI_SHARE_SOUNDFONTS
+
+FluidSoundFontCache fluidSoundFontCache;
+
+//---------------------------------------------------------
+//   FluidSoundFontCache
+//---------------------------------------------------------
+
+FluidSoundFontCache::FluidSoundFontCache()
+      {
+      _settings = 0;
+      _owner = 0;
+      }
+
+FluidSoundFontCache::~FluidSoundFontCache()
+      {
+      // Deleting the owner deletes any font still loaded.
+      if (_owner)
+            delete_fluid_synth(_owner);
+      if (_settings)
+            delete_fluid_settings(_settings);
+      }
+
+//---------------------------------------------------------
+//   createOwner
+//    The hidden synth is created with the first font, so
+//     that merely loading the plugin costs nothing.
+//---------------------------------------------------------
+
+bool FluidSoundFontCache::createOwner()
+      {
+      if (_owner)
+            return true;
+      _settings = new_fluid_settings();
+      if (!_settings)
+            return false;
+      // It never plays, keep it small.
+      fluid_settings_setint(_settings, "synth.polyphony", 1);
+      fluid_settings_setint(_settings, "synth.reverb.active", 0);
+      fluid_settings_setint(_settings, "synth.chorus.active", 0);
+      _owner = new_fluid_synth(_settings);
+      if (!_owner) {
+            delete_fluid_settings(_settings);
+            _settings = 0;
+            fprintf(stderr, "FluidSoundFontCache: Error creating the soundfont owner synth\n");
+            return false;
+            }
+      return true;
+      }
+
+//---------------------------------------------------------
+//   acquire
+//---------------------------------------------------------
+
+fluid_sfont_t* FluidSoundFontCache::acquire(fluid_synth_t* synth, const QString& file_name)
+      {
+      QFileInfo fi(file_name);
+      QString path = fi.canonicalFilePath();
+      if (path.isEmpty())
+            path = fi.absoluteFilePath();
+      const qint64 size = fi.size();
+      const QDateTime modified = fi.lastModified();
+
+      QMutexLocker ml(&_mutex);
+
+      std::list<Entry>::iterator ie = _entries.begin();
+      for ( ; ie != _entries.end(); ++ie) {
+            if (ie->path == path && ie->size == size && ie->modified == modified)
+                  break;
+            }
+
+      if (ie == _entries.end()) {
+            if (!createOwner())
+                  return 0;
+            const int id = fluid_synth_sfload(_owner, path.toLocal8Bit().constData(), 0);
+            if (id == FLUID_FAILED)
+                  return 0;
+            Entry e;
+            e.path = path;
+            e.size = size;
+            e.modified = modified;
+            e.sfont = fluid_synth_get_sfont_by_id(_owner, id);
+            e.refs = 0;
+            ie = _entries.insert(_entries.end(), e);
+            }
+
+      // Instances only add fonts under the lock, so no id changes behind unload()'s back.
+      if (fluid_synth_add_sfont(synth, ie->sfont) == FLUID_FAILED) {
+            if (ie->refs == 0) {
+                  unload(ie->sfont);
+                  _entries.erase(ie);
+                  }
+            return 0;
+            }
+      ++ie->refs;
+      return ie->sfont;
+      }
+
+//---------------------------------------------------------
+//   release
+//---------------------------------------------------------
+
+void FluidSoundFontCache::release(fluid_synth_t* synth, fluid_sfont_t* sfont)
+      {
+      QMutexLocker ml(&_mutex);
+      fluid_synth_remove_sfont(synth, sfont);
+      for (std::list<Entry>::iterator ie = _entries.begin(); ie != _entries.end(); ++ie) {
+            if (ie->sfont != sfont)
+                  continue;
+            if (--ie->refs <= 0) {
+                  unload(sfont);
+                  _entries.erase(ie);
+                  }
+            return;
+            }
+      fprintf(stderr, "FluidSoundFontCache::release: Soundfont not found\n");
+      }
+
+//---------------------------------------------------------
+//   unload
+//    The font's id was likely overwritten by an instance.
+//     Adding it to the owner again gives it a fresh id, to
+//     unload it by. Fluidsynth defers the deletion until
+//     no voice plays its samples any more.
+//---------------------------------------------------------
+
+void FluidSoundFontCache::unload(fluid_sfont_t* sfont)
+      {
+      fluid_synth_remove_sfont(_owner, sfont);
+      const int id = fluid_synth_add_sfont(_owner, sfont);
+      if (id == FLUID_FAILED || fluid_synth_sfunload(_owner, id, 0) == FLUID_FAILED)
+            fprintf(stderr, "FluidSoundFontCache: Error unloading soundfont\n");
+      }
+
+#endif // FLUIDSYNTI_SHARE_SOUNDFONTS
@@ -0,0 +1,88 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//  $Id: ./synti/fluidsynth/fluidsfcache.h $
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __MUSE_FLUIDSFCACHE_H__
+#define __MUSE_FLUIDSFCACHE_H__
+
+#include <fluidsynth.h>
+#include <list>
+
+#include <QString>
+#include <QDateTime>
+#include <QMutex>
+
+// Fluidsynth 2 can add one loaded soundfont to several synths.
+#if FLUIDSYNTH_VERSION_MAJOR >= 2
+#define FLUIDSYNTI_SHARE_SOUNDFONTS 1
+#endif
+
+#ifdef FLUIDSYNTI_SHARE_SOUNDFONTS
+
+//---------------------------------------------------------
+//   FluidSoundFontCache
+//    Soundfonts loaded once for the whole process and
+//     shared by all fluidsynth instances, reference counted
+//     by file and fingerprint (size and modification time),
+//     so a file changed on disk is loaded afresh.
+//    The fonts are owned by a hidden synth which never plays.
+//     Instances add them to their own synth with acquire()
+//     and take them off again with release(), which must be
+//     done before the instance's synth is deleted.
+//    Fluidsynth overwrites a font's id each time it is added
+//     to a synth, so instances must not look shared fonts up
+//     by id.
+//---------------------------------------------------------
+
+class FluidSoundFontCache
+      {
+      struct Entry
+            {
+            QString path;
+            qint64 size;
+            QDateTime modified;
+            fluid_sfont_t* sfont;
+            int refs;
+            };
+
+      QMutex _mutex;
+      fluid_settings_t* _settings;
+      fluid_synth_t* _owner;
+      std::list<Entry> _entries;
+
+      bool createOwner();
+      void unload(fluid_sfont_t* sfont);
+
+   public:
+      FluidSoundFontCache();
+      ~FluidSoundFontCache();
+
+      // Adds the font in the file to the synth, loading it first if no
+      //  other instance has it. Returns the font or null on error.
+      fluid_sfont_t* acquire(fluid_synth_t* synth, const QString& file_name);
+      // Removes the font from the synth and unloads it once no instance uses it.
+      void release(fluid_synth_t* synth, fluid_sfont_t* sfont);
+      };
+
+extern FluidSoundFontCache fluidSoundFontCache;
+
+#endif // FLUIDSYNTI_SHARE_SOUNDFONTS
+
+#endif
@@ -39,6 +39,8 @@
 #include <QTableWidgetItem>
 #include <QTreeWidgetItem>
 #include <QHeaderView>
+#include <QSpinBox>
+#include <QSettings>
 
 #include "muse_math.h"
 
@@ -67,6 +69,23 @@ FluidSynthGui::FluidSynthGui()
       fluidLabel->setPixmap(QIcon(":/fluidsynth1.png").pixmap(124, 45));
       FluidGrid->addWidget(fluidLabel, 2, 1, Qt::AlignHCenter);
 
+      // Render threads are a global setting, used by instances created afterwards.
+      renderThreads = new QSpinBox;
+      renderThreads->setRange(1, 16);
+      renderThreads->setPrefix(tr("Threads: "));
+      renderThreads->setToolTip(tr("Number of threads fluidsynth renders voices with.\nApplies to new instances."));
+      QSettings settings("MusE", "MusE-qt");
+      renderThreads->setValue(settings.value("FluidSynth/renderThreads", 1).toInt());
+      GainBox->layout()->addWidget(renderThreads);
+      connect(renderThreads, SIGNAL(valueChanged(int)), SLOT(changeRenderThreads(int)));
+
+      statusLabel = new QLabel;
+      statusLabel->setToolTip(tr("Active voices and fluidsynth's own estimate of its cpu use"));
+      GainBox->layout()->addWidget(statusLabel);
+      statusVoices = -1;
+      statusCpu = 0;
+      updateStatusLabel();
+
       ChorusType->setItemIcon(0, QIcon(*MusEGui::sineIcon));
       ChorusType->setItemIcon(1, QIcon(*MusEGui::sawIcon));
 
@@ -119,6 +138,29 @@ FluidSynthGui::~FluidSynthGui()
       */
       }
 
+//---------------------------------------------------------
+//   changeRenderThreads
+//---------------------------------------------------------
+
+void FluidSynthGui::changeRenderThreads(int val)
+      {
+      QSettings settings("MusE", "MusE-qt");
+      settings.setValue("FluidSynth/renderThreads", val);
+      }
+
+//---------------------------------------------------------
+//   updateStatusLabel
+//---------------------------------------------------------
+
+void FluidSynthGui::updateStatusLabel()
+      {
+      QString cpu = QString::number(statusCpu / 10.0, 'f', 1);
+      if (statusVoices < 0)
+            statusLabel->setText(tr("CPU: %1%").arg(cpu));
+      else
+            statusLabel->setText(tr("Voices: %1  CPU: %2%").arg(statusVoices).arg(cpu));
+      }
+
 void FluidSynthGui::toggleReverb(bool on)         { sendController(0, FS_REVERB_ON, on); }
 void FluidSynthGui::changeReverbLevel(int val)    { sendController(0, FS_REVERB_LEVEL, val); }
 void FluidSynthGui::changeReverbRoomSize(int val) { sendController(0, FS_REVERB_ROOMSIZE, val); }
@@ -394,6 +436,14 @@ void FluidSynthGui::processEvent(const MusECore::MidiPlayEvent& ev)
                               ChorusLevel->blockSignals(false);
                               break;
                               }
+                        case FS_STATUS_VOICES:
+                              statusVoices = val;
+                              updateStatusLabel();
+                              break;
+                        case FS_STATUS_CPU:
+                              statusCpu = val;
+                              updateStatusLabel();
+                              break;
                         default:
                               if (FS_DEBUG)
                                     printf("FluidSynthGui::processEvent() : Unknown controller sent to gui: %x\n",id);
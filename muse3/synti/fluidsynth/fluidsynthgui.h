@@ -38,6 +38,8 @@
 
 class QDialog;
 class QTreeWidgetItem;
+class QLabel;
+class QSpinBox;
 
 struct FluidChannel;
 #define FS_DEBUG 0 //Turn on/off debug
@@ -183,6 +185,12 @@ class FluidSynthGui : public QDialog, public Ui::FLUIDSynthGuiBase, public MessG
 
       int currentlySelectedFont; //Font currently selected in sfListView. -1 if none selected
 
+      QLabel* statusLabel;
+      QSpinBox* renderThreads;
+      int statusVoices;
+      int statusCpu; // Tenths of a percent.
+      void updateStatusLabel();
+
 /*
       unsigned _smallH;
       unsigned _bigH;
@@ -217,6 +225,7 @@ class FluidSynthGui : public QDialog, public Ui::FLUIDSynthGuiBase, public MessG
       void changeChorusSpeed(int);
       void changeChorusDepth(int);
       void changeChorusLevel(int);
+      void changeRenderThreads(int);
 
       void popClicked();
       void sfItemClicked(QTreeWidgetItem* item, int);
@@ -39,6 +39,7 @@
 #include <QObject>
 #include <QMutexLocker>
 #include <QMessageBox>
+#include <QSettings>
 
 //#include "common_defs.h"
 #include "fluidsynti.h"
@@ -118,9 +119,15 @@ QString projPathPtr;
 FluidSynth::FluidSynth(int sr, QMutex &_GlobalSfLoaderMutex) : Mess(2), _sfLoaderMutex(_GlobalSfLoaderMutex)
       {
       gui = 0;
+      statusFrames = 0;
       setSampleRate(sr);
       fluid_settings_t* s = new_fluid_settings();
       fluid_settings_setnum(s, (char*) "synth.sample-rate", float(sampleRate()));
+      // Let fluidsynth render the voices with extra threads. Set in the gui, for new instances.
+      QSettings settings("MusE", "MusE-qt");
+      const int threads = settings.value("FluidSynth/renderThreads", 1).toInt();
+      if (threads > 1)
+            fluid_settings_setint(s, (char*) "synth.cpu-cores", threads);
       fluidsynth = new_fluid_synth(s);
       if (!fluidsynth) {
             printf("Error while creating fluidsynth!\n");
@@ -153,6 +160,11 @@ FluidSynth::~FluidSynth()
       {
         if(it->intid == FS_UNSPECIFIED_FONT || it->intid == FS_UNSPECIFIED_ID) 
           continue;
+#ifdef FLUIDSYNTI_SHARE_SOUNDFONTS
+        // Take the shared font off the synth, before deleting the synth deletes it.
+        fluidSoundFontCache.release(fluidsynth, it->sfont);
+        continue;
+#endif
         //Try to unload soundfont
         int err = fluid_synth_sfunload(fluidsynth, it->intid, 0);
         if(err == -1)  
@@ -280,6 +292,32 @@ void FluidSynth::process(unsigned /*pos*/, float** ports, int offset, int len)
             M_ERROR("Error writing from synth!");
             return;
             }
+      sendStatus(len);
+      }
+
+//---------------------------------------------------------
+//   sendStatus
+//    Send the voice count and cpu load to the gui, a few
+//     times per second while it is shown.
+//---------------------------------------------------------
+
+void FluidSynth::sendStatus(unsigned frames)
+      {
+      statusFrames += frames;
+      if (statusFrames < (unsigned)sampleRate() / 4)
+            return;
+      statusFrames = 0;
+      if (!gui || !gui->isVisible())
+            return;
+#if FLUIDSYNTH_VERSION_MAJOR >= 2
+      MusECore::MidiPlayEvent voices(0, 0, 0, MusECore::ME_CONTROLLER, FS_STATUS_VOICES,
+                                     fluid_synth_get_active_voice_count(fluidsynth));
+      gui->writeEvent(voices);
+#endif
+      // In tenths of a percent of the cycle.
+      MusECore::MidiPlayEvent cpu(0, 0, 0, MusECore::ME_CONTROLLER, FS_STATUS_CPU,
+                                  (int)(fluid_synth_get_cpu_load(fluidsynth) * 10.0));
+      gui->writeEvent(cpu);
       }
 
 //---------------------------------------------------------
@@ -1142,7 +1180,7 @@ void FluidSynth::setController(int channel, int id, int val, bool fromGui)
                   else if(banknum == 0xff)
                     banknum = 0; // Is wise? Else try to keep a previous value when 'off' (0xff) like the HW values?
                   
-                  err = fluid_synth_program_select(fluidsynth, channel, font_intid , banknum, patch);
+                  err = selectProgram(channel, font_intid, banknum, patch);
                   if (err)
 #ifdef FLUIDSYNTI_HAVE_FLUID_SYNTH_ERROR
                         printf("FluidSynth::setController() - Error changing program on soundfont %s, channel: %d\n", fluid_synth_error(fluidsynth), channel);
@@ -1307,6 +1345,57 @@ int FluidSynth::getNextAvailableExternalId()
       return i;
       }
 
+//---------------------------------------------------------
+//   getNextAvailableInternalId
+//    For shared fonts, whose fluidsynth id is not ours.
+//---------------------------------------------------------
+
+int FluidSynth::getNextAvailableInternalId()
+      {
+      unsigned char place[FS_UNSPECIFIED_FONT];
+      for(int i=0; i<FS_UNSPECIFIED_FONT; i++)
+            place[i] = 0;
+      for (std::list<FluidSoundFont>::iterator it = stack.begin(); it != stack.end(); it++)
+            if (it->intid < FS_UNSPECIFIED_FONT)
+                  place[it->intid] = 1;
+
+      int i=1;
+      while (i < FS_UNSPECIFIED_FONT && place[i] == 1)
+            i++;
+
+      return i;
+      }
+
+//---------------------------------------------------------
+//   getFontByInternalId
+//---------------------------------------------------------
+
+fluid_sfont_t* FluidSynth::getFontByInternalId(int int_id) const
+      {
+      for (std::list<FluidSoundFont>::const_iterator it = stack.begin(); it != stack.end(); it++)
+            if (it->intid == int_id)
+                  return it->sfont;
+      return 0;
+      }
+
+//---------------------------------------------------------
+//   selectProgram
+//    Shared fonts get a new id each time another instance adds
+//     them, so they are selected by name instead.
+//---------------------------------------------------------
+
+int FluidSynth::selectProgram(int channel, int int_id, int banknum, int preset)
+      {
+#ifdef FLUIDSYNTI_SHARE_SOUNDFONTS
+      fluid_sfont_t* sfont = getFontByInternalId(int_id);
+      if (!sfont)
+            return FLUID_FAILED;
+      return fluid_synth_program_select_by_sfont_name(fluidsynth, channel, fluid_sfont_get_name(sfont), banknum, preset);
+#else
+      return fluid_synth_program_select(fluidsynth, channel, int_id, banknum, preset);
+#endif
+      }
+
 //---------------------------------------------------------
 //   sfChannelChange
 //---------------------------------------------------------
@@ -1382,7 +1471,7 @@ void FluidSynth::rewriteChannelSettings()
             if (!(preset == FS_UNSPECIFIED_PRESET 
                   || int_id == FS_UNSPECIFIED_FONT
                   || int_id == FS_UNSPECIFIED_ID)) {
-                  int rv = fluid_synth_program_select(fluidsynth, i, int_id, banknum, preset);
+                  int rv = selectProgram(i, int_id, banknum, preset);
                   if (rv)
 #ifdef FLUIDSYNTI_HAVE_FLUID_SYNTH_ERROR
                         std::cerr << DEBUG_ARGS << "Error changing preset! " << fluid_synth_error(fluidsynth) << std::endl;
@@ -1451,7 +1540,9 @@ const MidiPatch* FluidSynth::getFirstPatch (int channel) const
       if (font_id == FS_UNSPECIFIED_FONT || font_id == FS_UNSPECIFIED_ID)
             return 0;
 
-      fluid_sfont_t* sfont = fluid_synth_get_sfont_by_id(fluidsynth, font_id);
+      fluid_sfont_t* sfont = getFontByInternalId(font_id);
+      if (!sfont)
+            return 0;
 
       if (!channels[channel].drumchannel) {
             for (unsigned bank = 0; bank < 128; ++bank) {
@@ -1517,7 +1608,9 @@ const MidiPatch* FluidSynth::getNextPatch (int channel, const MidiPatch* patch)
 
       //printf("Font has internal id: %d\n",font_id);
       fluid_preset_t* preset;
-      fluid_sfont_t* sfont = fluid_synth_get_sfont_by_id(fluidsynth, font_id);
+      fluid_sfont_t* sfont = getFontByInternalId(font_id);
+      if (!sfont)
+            return 0;
 
       if (!channels[channel].drumchannel) {
             unsigned prog = patch->prog + 1;
@@ -1587,7 +1680,12 @@ bool FluidSynth::popSoundfont (int ext_id)
          else
          {
          //Try to unload soundfont
+#ifdef FLUIDSYNTI_SHARE_SOUNDFONTS
+         fluidSoundFontCache.release(fluidsynth, getFontByInternalId(int_id));
+         int err = 0;
+#else
          int err = fluid_synth_sfunload(fluidsynth, int_id, 0);
+#endif
          if (err != -1) {//Success
                //Check all channels that the font is used in
                for (int i=0; i<FS_MAX_NR_OF_CHANNELS;  i++) {
@@ -1648,10 +1746,23 @@ void LoadFontWorker::execLoadFont(void * t)
 
       //Let only one loadThread have access to the fluidsynth-object at the time
       QMutexLocker ml(&fptr->_sfLoaderMutex);
+#ifdef FLUIDSYNTI_SHARE_SOUNDFONTS
+      // Use the samples already loaded by another instance if the file has not changed.
+      fluid_sfont_t* sfont = fluidSoundFontCache.acquire(fptr->fluidsynth, h->file_name);
+      int rv = sfont ? fptr->getNextAvailableInternalId() : -1;
+      if (rv >= FS_UNSPECIFIED_FONT) {
+            fluidSoundFontCache.release(fptr->fluidsynth, sfont);
+            rv = -1;
+            }
+#else
       int rv = fluid_synth_sfload(fptr->fluidsynth, filename, 1);
+      fluid_sfont_t* sfont = rv == -1 ? 0 : fluid_synth_get_sfont_by_id(fptr->fluidsynth, rv);
+#endif
 
       if (rv ==-1) {
-#ifdef FLUIDSYNTI_HAVE_FLUID_SYNTH_ERROR
+#ifdef FLUIDSYNTI_SHARE_SOUNDFONTS
+            fptr->sendError("Error loading soundfont");
+#elif defined(FLUIDSYNTI_HAVE_FLUID_SYNTH_ERROR)
             fptr->sendError(fluid_synth_error(fptr->fluidsynth));
 #endif
             if (FS_DEBUG)
@@ -1672,6 +1783,7 @@ void LoadFontWorker::execLoadFont(void * t)
       font.file_name = h->file_name;
 
       font.intid = rv;
+      font.sfont = sfont;
       if (h->id == FS_UNSPECIFIED_ID) {
             font.extid = fptr->getNextAvailableExternalId();
             if (FS_DEBUG)
@@ -40,6 +40,7 @@
 #include <QThread>
 #include <QMutex>
 #include "fluidsynthgui.h"
+#include "fluidsfcache.h"
 #include "libsynti/mess.h"
 #include "muse/debug.h"
 #include "mpevent.h"   
@@ -61,6 +62,8 @@ struct FluidSoundFont
       QString file_name;
       QString name;
       byte extid, intid;
+      // The loaded font. With shared fonts intid is only this instance's handle for it.
+      fluid_sfont_t* sfont;
       #ifdef HAVE_INSTPATCH
       std::map < int /*patch*/, std::multimap < int /* note */, std::string > > _noteSampleNameList;
       #endif
@@ -89,6 +92,10 @@ static const int FS_CHORUS_DEPTH   = 10 + MusECore::CTRL_NRPN14_OFFSET;
 static const int FS_CHORUS_LEVEL   = 11 + MusECore::CTRL_NRPN14_OFFSET;
 static const int FS_PITCHWHEELSENS  = 0 + MusECore::CTRL_RPN_OFFSET;
 
+// Status sent to the gui only, not midi controllers:
+static const int FS_STATUS_VOICES  = 12 + MusECore::CTRL_NRPN14_OFFSET;
+static const int FS_STATUS_CPU     = 13 + MusECore::CTRL_NRPN14_OFFSET;
+
 // FluidChannel is used to map different soundfonts to different fluid-channels
 // This is to be able to select different presets from specific soundfonts, since
 // Fluidsynth has a quite strange way of dealing with fontloading and channels
@@ -128,6 +135,9 @@ class FluidSynth : public Mess {
       int initLen;
 
       byte getFontInternalIdByExtId (byte channel);
+      fluid_sfont_t* getFontByInternalId(int int_id) const;
+      int selectProgram(int channel, int int_id, int banknum, int preset);
+      void sendStatus(unsigned frames);
 
       void debug(const char* msg) { if (FS_DEBUG) printf("Debug: %s\n",msg); }
       void dumpInfo(); //Prints out debug info
@@ -144,6 +154,9 @@ class FluidSynth : public Mess {
       bool rev_on, cho_on;
       int cho_num, cho_type;
 
+      // Frames since the status was last sent to the gui.
+      unsigned statusFrames;
+
 public:
       FluidSynth(int sr, QMutex &_GlobalSfLoaderMutex);
       virtual ~FluidSynth();
@@ -177,6 +190,7 @@ public:
       bool popSoundfont (int ext_id);
 
       int getNextAvailableExternalId();
+      int getNextAvailableInternalId();
 
       fluid_synth_t* fluidsynth;
       FluidSynthGui* gui;
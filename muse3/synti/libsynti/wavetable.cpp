@@ -0,0 +1,82 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//    software synthesizer helper library
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <string.h>
+#include <math.h>
+
+#include "wavetable.h"
+
+//---------------------------------------------------------
+//   Wavetable
+//    Built from the top level, with the fewest harmonics,
+//     down. Each level is a copy of the one above plus the
+//     harmonics the one above lacks.
+//---------------------------------------------------------
+
+Wavetable::Wavetable(int size, int maxHarmonic, const double* sinCoeffs, const double* cosCoeffs)
+      {
+      _size        = size;
+      _maxHarmonic = maxHarmonic;
+      _levels      = 1;
+      while ((1 << _levels) <= maxHarmonic)
+            ++_levels;
+      _data = new float[_levels * (size + 1)];
+
+      const int mask = size - 1;
+      // cos(x) = sin(x + pi/2)
+      const int quarter = size / 4;
+      double* sine = new double[size];
+      for (int i = 0; i < size; ++i)
+            sine[i] = sin(2.0 * M_PI * i / size);
+      double* acc = new double[size];
+      memset(acc, 0, sizeof(double) * size);
+
+      int h = 1;
+      for (int k = _levels - 1; k >= 0; --k) {
+            const int top = maxHarmonic >> k;
+            for (; h <= top; ++h) {
+                  const double s = sinCoeffs ? sinCoeffs[h - 1] : 0.0;
+                  const double c = cosCoeffs ? cosCoeffs[h - 1] : 0.0;
+                  if (s == 0.0 && c == 0.0)
+                        continue;
+                  for (int i = 0; i < size; ++i) {
+                        const int idx = (h * i) & mask;
+                        acc[i] += s * sine[idx] + c * sine[(idx + quarter) & mask];
+                        }
+                  }
+            float* d = _data + k * (size + 1);
+            for (int i = 0; i < size; ++i)
+                  d[i] = acc[i];
+            d[size] = d[0];
+            }
+      delete[] acc;
+      delete[] sine;
+      }
+
+//---------------------------------------------------------
+//   ~Wavetable
+//---------------------------------------------------------
+
+Wavetable::~Wavetable()
+      {
+      delete[] _data;
+      }
+
@@ -0,0 +1,64 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//    software synthesizer helper library
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __SYNTH_WAVETABLE_H__
+#define __SYNTH_WAVETABLE_H__
+
+//---------------------------------------------------------
+//   Wavetable
+//    One cycle of a waveform, built from its harmonics.
+//    Level k holds only the harmonics up to maxHarmonic >> k,
+//     so each octave the pitch goes up is played from the
+//     next level, without aliasing.
+//    Each level is followed by a copy of its first point,
+//     for readers which interpolate.
+//---------------------------------------------------------
+
+class Wavetable {
+      int _size;
+      int _levels;
+      int _maxHarmonic;
+      float* _data;
+
+   public:
+      // size and maxHarmonic must be powers of two. sinCoeffs and cosCoeffs
+      //  hold the amplitudes of harmonics 1 to maxHarmonic, either can be null.
+      Wavetable(int size, int maxHarmonic, const double* sinCoeffs, const double* cosCoeffs);
+      ~Wavetable();
+
+      int size() const       { return _size; }
+      int levels() const     { return _levels; }
+      const float* level(int k) const { return _data + k * (_size + 1); }
+
+      // The first level without harmonics at or above nyquist when played
+      //  at the given cycles per sample, or -1 if there is none.
+      int levelFor(double cyclesPerSample) const {
+            int h = _maxHarmonic;
+            for (int k = 0; k < _levels; ++k, h >>= 1) {
+                  if (h * cyclesPerSample < 0.5)
+                        return k;
+                  }
+            return -1;
+            }
+      };
+
+#endif
+
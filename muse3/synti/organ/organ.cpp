@@ -26,6 +26,7 @@
 //=========================================================
 
 #include <stdio.h>
+#include <string.h>
 
 #include "muse_math.h"
 #include "midi_consts.h"
@@ -63,9 +64,9 @@ SynthCtrl Organ::synthCtrl[] = {
 static int NUM_CONTROLLER = sizeof(Organ::synthCtrl)/sizeof(*(Organ::synthCtrl));
 static int NUM_INIT_CONTROLLER = NUM_CONTROLLER - 1;
 
-float* Organ::sine_table;
-float* Organ::g_triangle_table;
-float* Organ::g_pulse_table;
+Wavetable* Organ::sine_table;
+Wavetable* Organ::g_triangle_table;
+Wavetable* Organ::g_pulse_table;
 int Organ::useCount = 0;
 double Organ::cb2amp_tab[MAX_ATTENUATION];
 unsigned Organ::freq256[128];
@@ -108,35 +109,28 @@ Organ::Organ(int sr)
             double freq = 8.176 * exp(double(i)*log(2.0)/12.0);
             freq256[i]  = (int) (freq * ((double) RESOLUTION) / sr * 256.0);
             }
-      int size  = RESOLUTION;
-      int half  = size / 2;
-      int slope = size / 10;
-      int i;
-
-      // Initialize sine table.
-      sine_table = new float[size];
-      for (i = 0; i < size; i++)
-            sine_table[i] = sin ((i * 2.0 * M_PI) / size) / 6.0;
-
-      // Initialize triangle table.
-      g_triangle_table = new float[size];
-      for (i = 0; i < half; i++)
-            g_triangle_table[i] = (4.0 / size * i - 1.0) / 6.0;
-      for (; i < size; i++)
-            g_triangle_table[i] = (4.0 / size * (size - i) - 1.0) / 6.0;
-
-      // Initialize pulse table.
-      g_pulse_table = new float[size];
-      for (i = 0; i < slope; i++)
-            g_pulse_table[i] = (((double) -i) / slope) / 6.0;
-      for (; i < half - slope; i++)
-            g_pulse_table[i] = -1.0 / 6.0;
-      for (; i < half + slope; i++)
-            g_pulse_table[i] = (((double) i - half) / slope) / 6.0;
-      for (; i < size - slope; i++)
-            g_pulse_table[i] = 1.0 / 6.0;
-      for (; i < size; i++)
-            g_pulse_table[i] = (((double) size - i) / slope) / 6.0;
+
+      // The triangle and pulse waves are built from their harmonics,
+      //  and played with fewer of them the higher the partial is,
+      //  so that none goes above nyquist.
+      const int harmonics = 1024;
+      double* coeffs = new double[harmonics];
+      memset(coeffs, 0, sizeof(double) * harmonics);
+
+      coeffs[0] = 1.0 / 6.0;
+      sine_table = new Wavetable(RESOLUTION, 1, coeffs, 0);
+
+      // Triangle, rising from -1 to 1 over the first half.
+      for (int h = 1; h <= harmonics; h += 2)
+            coeffs[h - 1] = -8.0 / (M_PI * M_PI * h * h) / 6.0;
+      g_triangle_table = new Wavetable(RESOLUTION, harmonics, 0, coeffs);
+
+      // Pulse, falling to -1 over the first tenth and rising to 1 around the middle.
+      const double slope = 2.0 * M_PI * (RESOLUTION / 10) / RESOLUTION;
+      for (int h = 1; h <= harmonics; h += 2)
+            coeffs[h - 1] = -4.0 * sin(h * slope) / (M_PI * h * h * slope) / 6.0;
+      g_pulse_table = new Wavetable(RESOLUTION, harmonics, coeffs, 0);
+      delete[] coeffs;
       }
 
 //---------------------------------------------------------
@@ -151,24 +145,12 @@ Organ::~Organ()
       delete [] idata;   // p4.0.27
       --useCount;
       if (useCount == 0) {
-            delete[] g_pulse_table;
-            delete[] g_triangle_table;
-            delete[] sine_table;
+            delete g_pulse_table;
+            delete g_triangle_table;
+            delete sine_table;
             }
       }
 
-//---------------------------------------------------------
-//   table_pos
-//---------------------------------------------------------
-
-static inline float table_pos (float* table, unsigned long freq_256, unsigned *accum)
-      {
-      *accum += freq_256;
-      while (*accum >= RESOLUTION * 256)
-            *accum -= RESOLUTION * 256;
-      return table[*accum >> 8];
-      }
-
 //---------------------------------------------------------
 //   init
 //---------------------------------------------------------
@@ -249,6 +231,9 @@ void Organ::process(unsigned /*pos*/, float** ports, int offset, int sampleCount
       */
       
       float* buffer = *ports + offset;
+      float lo[RENDER_BLOCK], hi[RENDER_BLOCK];
+      float gainLo[RENDER_BLOCK], gainHi[RENDER_BLOCK];
+
       for (int i = 0; i < VOICES; ++i) {
             Voice* v = &voices[i];
             if (!v->isOn)
@@ -256,157 +241,161 @@ void Organ::process(unsigned /*pos*/, float** ports, int offset, int sampleCount
             double vol = velo ? v->velocity : 1.0;
             vol *= volume;
 
+            // Frequency and table of each partial. The first three
+            //  follow the low, the others the high envelope.
             unsigned freq_256 = freq256[v->pitch];
-            unsigned* harm0_accum = &(v->harm0_accum);
-            unsigned* harm1_accum = &(v->harm1_accum);
-            unsigned* harm2_accum = &(v->harm2_accum);
-            unsigned* harm3_accum = &(v->harm3_accum);
-            unsigned* harm4_accum = &(v->harm4_accum);
-            unsigned* harm5_accum = &(v->harm5_accum);
+            unsigned freq[PARTIALS];
+            const Wavetable* table[PARTIALS];
+            const Wavetable* reed_table  = reed  ? g_pulse_table    : sine_table;
+            const Wavetable* flute_table = flute ? g_triangle_table : sine_table;
+
+            freq[0] = freq_256 / 2;
+            freq[1] = freq_256;
+            table[0] = sine_table;
+            table[1] = sine_table;
+            if (brass) {
+                  freq[2] = freq_256 * 2;
+                  freq[3] = freq[2]  * 2;
+                  freq[4] = freq[3]  * 2;
+                  freq[5] = freq[4]  * 2;
+                  table[2] = reed_table;
+                  table[3] = sine_table;
+                  table[4] = flute_table;
+                  table[5] = flute_table;
+                  }
+            else {
+                  freq[2] = freq_256 * 3 / 2;
+                  freq[3] = freq_256 * 2;
+                  freq[4] = freq_256 * 3;
+                  freq[5] = freq[3]  * 2;
+                  table[2] = sine_table;
+                  table[3] = reed_table;
+                  table[4] = sine_table;
+                  table[5] = flute_table;
+                  }
 
-            unsigned long freq_256_harm2, freq_256_harm3;
-            unsigned long freq_256_harm4, freq_256_harm5;
+            // Each partial plays from the table level band limited for
+            //  its frequency. Those above nyquist are muted.
+            const unsigned mask = RESOLUTION * 256 - 1;
+            const float* t[PARTIALS];
+            float amp[PARTIALS];
+            unsigned acc[PARTIALS];
+            for (int p = 0; p < PARTIALS; ++p) {
+                  int k = table[p]->levelFor(double(freq[p]) / (RESOLUTION * 256.0));
+                  t[p]   = table[p]->level(k < 0 ? 0 : k);
+                  amp[p] = k < 0 ? 0.0f : harm[p];
+                  acc[p] = v->accum[p];
+                  }
 
-            float* reed_table  = reed  ? g_pulse_table    : sine_table;
-            float* flute_table = flute ? g_triangle_table : sine_table;
+            for (int pos = 0; pos < sampleCount; pos += RENDER_BLOCK) {
+                  int n = sampleCount - pos;
+                  if (n > RENDER_BLOCK)
+                        n = RENDER_BLOCK;
+                  int len = stepEnvelopes(v, gainLo, gainHi, n, vol);
+
+                  // One partial at a time, skipping the muted ones.
+                  for (int k = 0; k < len; ++k)
+                        lo[k] = hi[k] = 0.0f;
+                  for (int p = 0; p < PARTIALS; ++p) {
+                        const unsigned base = acc[p];
+                        const unsigned f    = freq[p];
+                        acc[p] = (base + f * unsigned(len)) & mask;
+                        if (amp[p] == 0.0f)
+                              continue;
+                        float* d        = p < 3 ? lo : hi;
+                        const float* tp = t[p];
+                        const float a   = amp[p];
+                        for (int k = 0; k < len; ++k)
+                              d[k] += tp[((base + f * unsigned(k + 1)) & mask) >> 8] * a;
+                        }
 
-            unsigned freq_256_harm0 = freq_256 / 2;
-            unsigned freq_256_harm1 = freq_256;
+                  float* out = buffer + pos;
+                  for (int k = 0; k < len; ++k)
+                        out[k] += lo[k] * gainLo[k] + hi[k] * gainHi[k];
 
-            if (brass) {
-                  freq_256_harm2 = freq_256       * 2;
-                  freq_256_harm3 = freq_256_harm2 * 2;
-                  freq_256_harm4 = freq_256_harm3 * 2;
-                  freq_256_harm5 = freq_256_harm4 * 2;
-                  for (int i = 0; i < sampleCount; i++) {
-                        int a1=0, a2=0;	//prevent compiler warning: uninitialized usage of vars a1 & a2
-                        switch(v->state1) {
-                              case ATTACK:
-                                    if (v->envL1.step(&a1))
-                                          break;
-                                    v->state1 = DECAY;
-                                    // NOTE: Error suppressor for new gcc 7 'fallthrough' level 3 and 4:
-                                    // FALLTHROUGH
-                              case DECAY:
-                                    if (v->envL2.step(&a1))
-                                          break;
-                                    v->state1 = SUSTAIN;
-                                    // NOTE: Error suppressor for new gcc 7 'fallthrough' level 3 and 4:
-                                    // FALLTHROUGH
-                              case SUSTAIN:
-                                    a1 = sustain0;
-                                    break;
-                              case RELEASE:
-                                    if (v->envL3.step(&a1))
-                                          break;
-                                    v->state1 = OFF;
-                                    a1 = MAX_ATTENUATION;
-                                    break;
-                              }
-                        switch(v->state2) {
-                              case ATTACK:
-                                    if (v->envH1.step(&a2))
-                                          break;
-                                    v->state2 = DECAY;
-                                    // NOTE: Error suppressor for new gcc 7 'fallthrough' level 3 and 4:
-                                    // FALLTHROUGH
-                              case DECAY:
-                                    if (v->envH2.step(&a2))
-                                          break;
-                                    v->state2 = SUSTAIN;
-                                    // NOTE: Error suppressor for new gcc 7 'fallthrough' level 3 and 4:
-                                    // FALLTHROUGH
-                              case SUSTAIN:
-                                    a2 = sustain1;
-                                    break;
-                              case RELEASE:
-                                    if (v->envH3.step(&a2))
-                                          break;
-                                    v->state2 = OFF;
-                                    a1 = MAX_ATTENUATION;
-                                    break;
-                              }
-                        if (v->state1 == OFF && v->state2 == OFF) {
-                              v->isOn = false;
-                              break;
-                              }
-                        buffer[i] +=
-                            (table_pos (sine_table, freq_256_harm0, harm0_accum) * harm0
-                           + table_pos (sine_table, freq_256_harm1, harm1_accum) * harm1
-                           + table_pos (reed_table, freq_256_harm2, harm2_accum) * harm2)
-                              * cb2amp(a1) * vol
-                           + (table_pos (sine_table,  freq_256_harm3, harm3_accum) * harm3
-                           +  table_pos (flute_table, freq_256_harm4, harm4_accum) * harm4
-                           +  table_pos (flute_table, freq_256_harm5, harm5_accum) * harm5)
-                             * cb2amp(a2) * vol;
+                  if (len < n) {
+                        v->isOn = false;
+                        break;
                         }
                   }
-            else {
-                  freq_256_harm2 = freq_256 * 3 / 2;
-                  freq_256_harm3 = freq_256 * 2;
-                  freq_256_harm4 = freq_256 * 3;
-                  freq_256_harm5 = freq_256_harm3 * 2;
-                  for (int i = 0; i < sampleCount; i++) {
-                        int a1=0, a2=0;//prevent compiler warning: uninitialized usage of vars a1 & a2
-                        switch(v->state1) {
-                              case ATTACK:
-                                    if (v->envL1.step(&a1))
-                                          break;
-                                    v->state1 = DECAY;
-                                    // NOTE: Error suppressor for new gcc 7 'fallthrough' level 3 and 4:
-                                    // FALLTHROUGH
-                              case DECAY:
-                                    if (v->envL2.step(&a1))
-                                          break;
-                                    v->state1 = SUSTAIN;
-                                    // FALLTHROUGH
-                              case SUSTAIN:
-                                    a1 = sustain0;
-                                    break;
-                              case RELEASE:
-                                    if (v->envL3.step(&a1))
-                                          break;
-                                    v->state1 = OFF;
-                                    a1 = MAX_ATTENUATION;
-                                    break;
-                              }
-                        switch(v->state2) {
-                              case ATTACK:
-                                    if (v->envH1.step(&a2))
-                                          break;
-                                    v->state2 = DECAY;
-                                    // FALLTHROUGH
-                              case DECAY:
-                                    if (v->envH2.step(&a2))
-                                          break;
-                                    v->state2 = SUSTAIN;
-                                    // FALLTHROUGH
-                              case SUSTAIN:
-                                    a2 = sustain1;
-                                    break;
-                              case RELEASE:
-                                    if (v->envH3.step(&a2))
-                                          break;
-                                    v->state2 = OFF;
-                                    a1 = MAX_ATTENUATION;
-                                    break;
-                              }
-                        if (v->state1 == OFF && v->state2 == OFF) {
-                              v->isOn = false;
+            for (int p = 0; p < PARTIALS; ++p)
+                  v->accum[p] = acc[p];
+            }
+      }
+
+//---------------------------------------------------------
+//   stepEnvelopes
+//    Steps the voice's low and high envelopes over n samples
+//     and stores their gains, including the volume.
+//    Returns the number of samples before the voice ended,
+//     n if it is still on.
+//---------------------------------------------------------
+
+int Organ::stepEnvelopes(Voice* v, float* gainLo, float* gainHi, int n, double vol)
+      {
+      if (v->state1 == SUSTAIN && v->state2 == SUSTAIN) {
+            const float g1 = cb2amp(sustain0) * vol;
+            const float g2 = cb2amp(sustain1) * vol;
+            for (int i = 0; i < n; ++i) {
+                  gainLo[i] = g1;
+                  gainHi[i] = g2;
+                  }
+            return n;
+            }
+      for (int i = 0; i < n; i++) {
+            int a1=0, a2=0;	//prevent compiler warning: uninitialized usage of vars a1 & a2
+            switch(v->state1) {
+                  case ATTACK:
+                        if (v->envL1.step(&a1))
                               break;
-                              }
-                        buffer[i] +=
-                           (table_pos (sine_table, freq_256_harm0, harm0_accum) * harm0
-                           + table_pos (sine_table, freq_256_harm1, harm1_accum) * harm1
-                           + table_pos (sine_table, freq_256_harm2, harm2_accum) * harm2)
-                              * cb2amp(a1) * vol
-                           + (table_pos (reed_table, freq_256_harm3, harm3_accum) * harm3
-                           + table_pos (sine_table, freq_256_harm4,  harm4_accum) * harm4
-                           + table_pos (flute_table, freq_256_harm5, harm5_accum) * harm5)
-                             * cb2amp(a2) * vol;
-                        }
+                        v->state1 = DECAY;
+                        // NOTE: Error suppressor for new gcc 7 'fallthrough' level 3 and 4:
+                        // FALLTHROUGH
+                  case DECAY:
+                        if (v->envL2.step(&a1))
+                              break;
+                        v->state1 = SUSTAIN;
+                        // NOTE: Error suppressor for new gcc 7 'fallthrough' level 3 and 4:
+                        // FALLTHROUGH
+                  case SUSTAIN:
+                        a1 = sustain0;
+                        break;
+                  case RELEASE:
+                        if (v->envL3.step(&a1))
+                              break;
+                        v->state1 = OFF;
+                        a1 = MAX_ATTENUATION;
+                        break;
+                  }
+            switch(v->state2) {
+                  case ATTACK:
+                        if (v->envH1.step(&a2))
+                              break;
+                        v->state2 = DECAY;
+                        // NOTE: Error suppressor for new gcc 7 'fallthrough' level 3 and 4:
+                        // FALLTHROUGH
+                  case DECAY:
+                        if (v->envH2.step(&a2))
+                              break;
+                        v->state2 = SUSTAIN;
+                        // NOTE: Error suppressor for new gcc 7 'fallthrough' level 3 and 4:
+                        // FALLTHROUGH
+                  case SUSTAIN:
+                        a2 = sustain1;
+                        break;
+                  case RELEASE:
+                        if (v->envH3.step(&a2))
+                              break;
+                        v->state2 = OFF;
+                        a1 = MAX_ATTENUATION;
+                        break;
                   }
+            if (v->state1 == OFF && v->state2 == OFF)
+                  return i;
+            gainLo[i] = cb2amp(a1) * vol;
+            gainHi[i] = cb2amp(a2) * vol;
             }
+      return n;
       }
 
 //---------------------------------------------------------
@@ -437,12 +426,8 @@ bool Organ::playNote(int channel, int pitch, int velo)
             voices[i].envH2.set(decay1,   MAX_ATTENUATION, sustain1);
             voices[i].envH3.set(release1, sustain1, MAX_ATTENUATION);
 
-            voices[i].harm0_accum = 0;
-            voices[i].harm1_accum = 0;
-            voices[i].harm2_accum = 0;
-            voices[i].harm3_accum = 0;
-            voices[i].harm4_accum = 0;
-            voices[i].harm5_accum = 0;
+            for (int k = 0; k < PARTIALS; ++k)
+                  voices[i].accum[k] = 0;
             return false;
             }
       #ifdef ORGAN_DEBUG
@@ -489,27 +474,27 @@ void Organ::setController(int ctrl, int data)
       switch (ctrl) {
             case HARM0:
                   //harm0 = cb2amp(-data);
-                  harm0 = cb2amp(-data + 8192);
+                  harm[0] = cb2amp(-data + 8192);
                   break;
             case HARM1:
                   //harm1 = cb2amp(-data);
-                  harm1 = cb2amp(-data + 8192);
+                  harm[1] = cb2amp(-data + 8192);
                   break;
             case HARM2:
                   //harm2 = cb2amp(-data);
-                  harm2 = cb2amp(-data + 8192);
+                  harm[2] = cb2amp(-data + 8192);
                   break;
             case HARM3:
                   //harm3 = cb2amp(-data);
-                  harm3 = cb2amp(-data + 8192);
+                  harm[3] = cb2amp(-data + 8192);
                   break;
             case HARM4:
                   //harm4 = cb2amp(-data);
-                  harm4 = cb2amp(-data + 8192);
+                  harm[4] = cb2amp(-data + 8192);
                   break;
             case HARM5:
                   //harm5 = cb2amp(-data);
-                  harm5 = cb2amp(-data + 8192);
+                  harm[5] = cb2amp(-data + 8192);
                   break;
             case ATTACK_LO:   // maxval -> 500msec
                   attack0 = (data * sr) / 1000;
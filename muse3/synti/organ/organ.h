@@ -31,9 +31,12 @@
 #include "muse/midictrl_consts.h"
 #include "libsynti/mess.h"
 #include "common_defs.h"
+#include "libsynti/wavetable.h"
 
 #define RESOLUTION   (16384*2)
 #define VOICES          128    // max polyphony
+#define PARTIALS          6
+#define RENDER_BLOCK     64    // samples rendered per voice at a time
 #define INIT_DATA_CMD   1
 
 class OrganGui;
@@ -133,12 +136,8 @@ struct Voice {
       Envelope envL1, envL2, envL3;
       Envelope envH1, envH2, envH3;
 
-      unsigned harm0_accum;
-      unsigned harm1_accum;
-      unsigned harm2_accum;
-      unsigned harm3_accum;
-      unsigned harm4_accum;
-      unsigned harm5_accum;
+      // phase of each partial, 8 bit fraction
+      unsigned accum[PARTIALS];
       };
 
 //---------------------------------------------------------
@@ -177,14 +176,15 @@ class Organ : public Mess {
       bool velo;
       double volume;
 
-      double harm0, harm1, harm2, harm3, harm4, harm5;
+      double harm[PARTIALS];
 
       Voice voices[VOICES];
 
-      static float* sine_table;
-      static float* g_triangle_table;
-      static float* g_pulse_table;
+      static Wavetable* sine_table;
+      static Wavetable* g_triangle_table;
+      static Wavetable* g_pulse_table;
 
+      int stepEnvelopes(Voice* v, float* gainLo, float* gainHi, int n, double vol);
       void noteoff(int channel, int pitch);
       void setController(int ctrl, int val);
 
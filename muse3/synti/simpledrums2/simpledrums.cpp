@@ -32,7 +32,6 @@
 #include "muse_math.h"
 #include <string.h>
 
-#include <samplerate.h>
 #include <QString>
 #include <QFileDialog>
 
@@ -134,8 +133,8 @@ SimpleSynth::SimpleSynth(int sr)
    //initialize
    for (int i=0; i<SS_NR_OF_CHANNELS; i++) {
       channels[i].sample = 0;
-      channels[i].originalSample = 0;
-      channels[i].playoffset = 0;
+      channels[i].playpos = 0.0;
+      channels[i].playstep = 1.0;
       channels[i].noteoff_ignore = true /* false */; //ignore note-offs by default (good for drum editors with fixed note lengths)
       channels[i].volume = (double) (100.0/SS_CHANNEL_VOLUME_QUOT );
       channels[i].volume_ctrlval = 100;
@@ -154,6 +153,11 @@ SimpleSynth::SimpleSynth(int sr)
    //Process buffer:
    processBuffer[0] = new double[SS_PROCESS_BUFFER_SIZE]; //left
    processBuffer[1] = new double[SS_PROCESS_BUFFER_SIZE]; //right
+   renderBuffer[0] = new float[SS_PROCESS_BUFFER_SIZE];
+   renderBuffer[1] = new float[SS_PROCESS_BUFFER_SIZE];
+
+   // Sample tails are streamed by a disk thread shared with the other instances:
+   SS_sampleStreamer.attach();
 
    //Send effects
    for (int i=0; i<SS_NR_OF_SENDEFFECTS; i++) {
@@ -260,11 +264,10 @@ SimpleSynth::~SimpleSynth()
    // Cleanup channels and samples:
    SS_DBG("Cleaning up sample data");
    for (int i=0; i<SS_NR_OF_CHANNELS; i++) {
-      if (channels[i].sample) {
-         delete[] channels[i].sample->data;
-         delete channels[i].sample;
-      }
+      SS_sampleStreamer.retire(channels[i].sample);
+      channels[i].sample = 0;
    }
+   SS_sampleStreamer.detach();
 
    SS_DBG("Deleting plugin instances");
    for (int i=0; i<SS_NR_OF_SENDEFFECTS; i++) {
@@ -285,6 +288,8 @@ SimpleSynth::~SimpleSynth()
    SS_DBG("Deleting process buffer");
    delete[] processBuffer[0];
    delete[] processBuffer[1];
+   delete[] renderBuffer[0];
+   delete[] renderBuffer[1];
    if (initBuffer)
    {
       SS_DBG("Deleting init buffer");
@@ -352,7 +357,8 @@ bool SimpleSynth::playNote(int /*channel*/, int pitch, int velo)
       if(!noteOff) {
          if (channels[ch].sample) {
             //Turn on the white stuff:
-            channels[ch].playoffset = 0;
+            channels[ch].playpos = 0.0;
+            channels[ch].sample->trigger();
             SWITCH_CHAN_STATE(ch , SS_SAMPLE_PLAYING);
             channels[ch].cur_velo = (double) velo / 127.0;
             channels[ch].gain_factor = channels[ch].cur_velo * channels[ch].volume;
@@ -369,7 +375,7 @@ bool SimpleSynth::playNote(int /*channel*/, int pitch, int velo)
                printf("Note off on channel %d\n", ch);
             }
             SWITCH_CHAN_STATE(ch , SS_CHANNEL_INACTIVE);
-            channels[ch].playoffset = 0;
+            channels[ch].playpos = 0.0;
             channels[ch].cur_velo = 0;
          }
       }
@@ -455,17 +461,7 @@ bool SimpleSynth::setController(int channel, int id, int val)
       case SS_CHANNEL_CTRL_PITCH:
          if (SS_DEBUG_MIDI)
             printf("Received channel ctrl pitch %d for channel %d\n", val, ch);
-         channels[ch].pitchInt = val;
-         printf("SS_CHANNEL_CTRL_PITCH %d\n", channels[channel].pitchInt);
-
-         if (channels[ch].sample != 0)
-         {
-            std::string bkStr = channels[ch].sample->filename;
-            resample(channels[ch].originalSample,
-                     channels[ch].sample,
-                     rangeToPitch(channels[ch].pitchInt),
-                     sampleRate());
-         }
+         updatePitch(ch, val);
          break;
 
       case SS_CHANNEL_CTRL_NOFF:
@@ -492,7 +488,7 @@ bool SimpleSynth::setController(int channel, int id, int val)
          }
          else if (val == true && channels[ch].channel_on == false) { // if it actually _was_ off:
             SWITCH_CHAN_STATE(ch, SS_CHANNEL_INACTIVE);
-            channels[ch].playoffset = 0;
+            channels[ch].playpos = 0.0;
             channels[ch].channel_on = val;
          }
          break;
@@ -617,7 +613,7 @@ bool SimpleSynth::sysex(int len, const unsigned char* d)
    case SS_SYSEX_PITCH_SAMPLE:
    {
       int channel = data[1];
-      channels[channel].pitchInt = data[2];
+      updatePitch(channel, data[2]);
 
       printf("SS_SYSEX_PITCH_SAMPLE %d\n", channels[channel].pitchInt);
 
@@ -841,7 +837,6 @@ void SimpleSynth::process(unsigned /*pos*/, float** out, int offset, int len)
       //Temporary mix-doubles
       double out1, out2;
       //double ltemp, rtemp;
-      float* data;
       // Velocity factor:
       double gain_factor;
 
@@ -875,29 +870,15 @@ void SimpleSynth::process(unsigned /*pos*/, float** out, int offset, int len)
             memset(processBuffer[0], 0, SS_PROCESS_BUFFER_SIZE * sizeof(double));
             memset(processBuffer[1], 0, SS_PROCESS_BUFFER_SIZE * sizeof(double));
 
-            for (int i=0; i<len; i++) {
-               // Current channel sample data:
-               data = channels[ch].sample->data;
-               gain_factor = channels[ch].gain_factor;
-               // Current velocity factor:
-
-               if (channels[ch].sample->channels == 2) {
-                  //
-                  // Stereo sample:
-                  //
-                  // Add from sample:
-                  out1 = (double) (data[channels[ch].playoffset] * gain_factor * channels[ch].balanceFactorL);
-                  out2 = (double) (data[channels[ch].playoffset + 1] * gain_factor * channels[ch].balanceFactorR);
-                  channels[ch].playoffset += 2;
-               }
-               else {
-                  //
-                  // Mono sample:
-                  //
-                  out1 = (double) (data[channels[ch].playoffset] * gain_factor * channels[ch].balanceFactorL);
-                  out2 = (double) (data[channels[ch].playoffset] * gain_factor * channels[ch].balanceFactorR);
-                  channels[ch].playoffset++;
-               }
+            // Interpolate the sample at the channel's pitch:
+            const int frames = channels[ch].sample->render(channels[ch].playpos, channels[ch].playstep,
+                                                           renderBuffer[0], renderBuffer[1], len);
+            // Current velocity factor:
+            gain_factor = channels[ch].gain_factor;
+
+            for (int i=0; i<frames; i++) {
+               out1 = (double) (renderBuffer[0][i] * gain_factor * channels[ch].balanceFactorL);
+               out2 = (double) (renderBuffer[1][i] * gain_factor * channels[ch].balanceFactorR);
 
                processBuffer[0][i] = out1;
                processBuffer[1][i] = out2;
@@ -918,14 +899,13 @@ void SimpleSynth::process(unsigned /*pos*/, float** out, int offset, int len)
                   }
                }
 
-               //
-               // If we've reached the last sample, set state to inactive
-               //
-               if (channels[ch].playoffset >= channels[ch].sample->samples) {
-                  SWITCH_CHAN_STATE(ch, SS_CHANNEL_INACTIVE);
-                  channels[ch].playoffset = 0;
-                  break;
-               }
+            }
+            //
+            // If we've reached the last sample, set state to inactive
+            //
+            if (frames < len) {
+               SWITCH_CHAN_STATE(ch, SS_CHANNEL_INACTIVE);
+               channels[ch].playpos = 0.0;
             }
             // Add contribution for this channel, for this frame, to final result:
             for (int i=0; i<len; i++) {
@@ -1327,8 +1307,9 @@ void SimpleSynth::parseInitData(const unsigned char* data)
       bool hasSample = *(ptr);
       ptr++;
 
+      SS_sampleStreamer.retire(channels[ch].sample);
       channels[ch].sample = 0;
-      channels[ch].playoffset = 0;
+      channels[ch].playpos = 0.0;
       SWITCH_CHAN_STATE(ch, SS_CHANNEL_INACTIVE);
       if (SS_DEBUG_INIT) {
          printf("parseInitData: channel %d, volume: %f pan: %d bfL %f bfR %f chON %d s1: %f s2: %f s3: %f s4: %f\n",
@@ -1516,50 +1497,10 @@ bool SimpleSynth::loadSample(int chno, const char* filename)
 }
 
 
-void resample(SS_Sample *origSample, SS_Sample* newSample, double pitch, int sample_rate)
-{
-   // Get new nr of frames:
-   double srcratio = (double) sample_rate / (double) origSample->samplerate * pitch;
-   newSample->frames = (long) floor(((double) origSample->frames * srcratio));
-   //smp->frames = (sfi.channels == 1 ? smp->frames * 2 : smp->frames ); // Double nr of new frames if mono->stereo
-   newSample->samples = newSample->frames * newSample->channels;
-   newSample->samplerate = sample_rate;
-
-   // Allocate mem for the new one
-   float* newData = new float[newSample->frames * newSample->channels];
-   memset(newData, 0, sizeof(float)* newSample->frames * newSample->channels);
-
-   // libsamplerate & co (secret rabbits in the code!)
-   SRC_DATA srcdata;
-   srcdata.data_in  = origSample->data;
-   srcdata.data_out = newData;
-   srcdata.input_frames  = origSample->frames;
-   srcdata.output_frames = newSample->frames;
-   srcdata.src_ratio = (double) newSample->samplerate / (double) origSample->samplerate  * pitch;
-
-   if (SS_DEBUG) {
-      printf("Converting sample....\n");
-   }
-
-   if (src_simple(&srcdata, SRC_SINC_BEST_QUALITY, origSample->channels)) {
-      SS_ERROR("Error when resampling, ignoring current sample");
-      //TODO: deallocate and stuff
-   }
-   else if (SS_DEBUG) {
-      printf("Sample converted. %ld input frames used, %ld output frames generated\n",
-             srcdata.input_frames_used,
-             srcdata.output_frames_gen);
-   }
-   float *oldData = newSample->data;
-   newSample->data = newData;
-   if (oldData) {
-      delete oldData;
-   }
-}
-
 /*!
     \fn loadSampleThread(void* p)
     \brief Since process needs to respond within a certain time, loading of samples need to be done in a separate thread
+    Only the head of a long sample is read here. The rest is streamed while playing.
  */
 static void* loadSampleThread(void* p)
 {
@@ -1576,10 +1517,8 @@ static void* loadSampleThread(void* p)
    const int ch_no      = loader->ch_no;
    const int sample_rate = loader->sampleRate;
 
-   if (ch->sample) {
-      delete[] ch->sample->data;
-      delete ch->sample;
-   }
+   SS_sampleStreamer.retire(ch->sample);
+   ch->sample = 0;
 
    SNDFILE* sf;
    const char* filename = loader->filename.c_str();
@@ -1593,7 +1532,6 @@ static void* loadSampleThread(void* p)
       fprintf(stderr,"Error opening file: %s\n", filename);
       synth->SWITCH_SYNTH_STATE(prevState);
       synth->guiSendSampleLoaded(false, loader->ch_no, filename);
-      delete ch->sample; ch->sample = 0;
       delete loader;
       pthread_mutex_unlock(&SS_LoaderMutex);
       SS_TRACE_OUT
@@ -1609,57 +1547,51 @@ static void* loadSampleThread(void* p)
    }
 
    //
-   // Allocate and read the thingie
+   // Allocate and read the head
    //
+   SS_Sample* smp = new SS_Sample;
+   smp->channels = sfi.channels;
+   smp->frames = sfi.frames;
+   smp->samplerate = sfi.samplerate;
+   smp->filename = loader->filename;
+
+   // Keep short samples whole, rather than streaming a few frames:
+   if (sfi.frames <= SS_STREAM_HEAD_FRAMES + SS_STREAM_RING_FRAMES / 4)
+      smp->headFrames = sfi.frames;
+   else {
+      smp->headFrames = SS_STREAM_HEAD_FRAMES;
+      smp->ringFrames = sfi.frames - SS_STREAM_HEAD_FRAMES;
+      if (smp->ringFrames > SS_STREAM_RING_FRAMES)
+         smp->ringFrames = SS_STREAM_RING_FRAMES;
+   }
 
-   //      // If current samplerate is the same as MusE's and no pitching is needed:
-   //      if (SS_samplerate == sfi.samplerate && (ch->pitch -1.0) < 0.001) {
-   //            smp->data = new float[sfi.channels * sfi.frames];
-   //            sf_count_t n = sf_readf_float(sf, smp->data, sfi.frames);
-   //            smp->frames = sfi.frames;
-   //            smp->samples = (n * sfi.channels);
-   //            smp->channels = sfi.channels;
-   //            if (SS_DEBUG) {
-   //                  printf("%ld frames read\n", (long) n);
-   //                  }
-   //            }
-   //      else  // otherwise, resample:
-   {
-      ch->sample = new SS_Sample;
-      SS_Sample* smp = ch->sample;
-      //smp->data = 0; // reset the data so we won't accidentally delete unallocated data
-      ch->originalSample = new SS_Sample;
-      SS_Sample* origSmp = ch->originalSample;
-
-      smp->channels = sfi.channels;
-      origSmp->channels = sfi.channels;
-
-      // Read to original sample storage:
-      float *origSample = new float[sfi.frames * sfi.channels];
-      int frames_read = sf_readf_float(sf, origSample, sfi.frames);
-      if (frames_read != sfi.frames) {
-         fprintf(stderr,"Error reading sample %s\n", filename);
-         synth->guiSendSampleLoaded(false, loader->ch_no, filename);
-         sf_close(sf);
-         synth->SWITCH_SYNTH_STATE(prevState);
-         delete ch->sample; ch->sample = 0;
-         delete loader;
-         pthread_mutex_unlock(&SS_LoaderMutex);
-         pthread_exit(0);
-         SS_TRACE_OUT
-      }
-
-      origSmp->channels = sfi.channels;
-      origSmp->frames = sfi.frames;
-      origSmp->samplerate = sfi.samplerate;
-      origSmp->data = origSample;
+   smp->head = new float[smp->headFrames * sfi.channels];
+   sf_count_t frames_read = sf_readf_float(sf, smp->head, smp->headFrames);
+   if (frames_read != smp->headFrames) {
+      fprintf(stderr,"Error reading sample %s\n", filename);
+      synth->guiSendSampleLoaded(false, loader->ch_no, filename);
+      sf_close(sf);
+      delete smp;
+      synth->SWITCH_SYNTH_STATE(prevState);
+      delete loader;
+      pthread_mutex_unlock(&SS_LoaderMutex);
+      SS_TRACE_OUT
+            pthread_exit(0);
+   }
 
-      resample(origSmp, smp, rangeToPitch(ch->pitchInt), sample_rate);
+   if (smp->ringFrames) {
+      // The streamer reads the rest through the open file.
+      smp->ring = new float[smp->ringFrames * sfi.channels];
+      smp->sf = sf;
    }
-   //Just close the dam thing
-   sf_close(sf);
+   else
+      //Just close the dam thing
+      sf_close(sf);
+
+   SS_sampleStreamer.add(smp);
+   ch->playstep = smp->step(rangeToPitch(ch->pitchInt), sample_rate);
+   ch->sample = smp;
    synth->SWITCH_SYNTH_STATE(prevState);
-   ch->sample->filename = loader->filename;
    synth->guiSendSampleLoaded(true, ch_no, filename);
    delete loader;
    pthread_mutex_unlock(&SS_LoaderMutex);
@@ -1713,6 +1645,19 @@ void SimpleSynth::updatePitch(int ch, int inpitch_ctrlval)
 {
    SS_TRACE_IN
          channels[ch].pitchInt = inpitch_ctrlval;
+   updateStep(ch);
+   SS_TRACE_OUT
+}
+
+/*!
+    \fn SimpleSynth::updateStep(int ch)
+    \brief Pitch is applied while playing, so retuning takes effect at once
+ */
+void SimpleSynth::updateStep(int ch)
+{
+   SS_TRACE_IN
+         if (channels[ch].sample)
+      channels[ch].playstep = channels[ch].sample->step(rangeToPitch(channels[ch].pitchInt), sampleRate());
    SS_TRACE_OUT
 }
 
@@ -2077,14 +2022,8 @@ void SimpleSynth::clearSample(int ch)
       SS_State prevstate = synth_state;
       SWITCH_CHAN_STATE(ch, SS_CHANNEL_INACTIVE);
       SWITCH_SYNTH_STATE(SS_CLEARING_SAMPLE);
-      if (channels[ch].sample->data) {
-         delete[] channels[ch].sample->data;
-         channels[ch].sample->data = 0;
-      }
-      if (channels[ch].sample) {
-         delete channels[ch].sample;
-         channels[ch].sample = 0;
-      }
+      SS_sampleStreamer.retire(channels[ch].sample);
+      channels[ch].sample = 0;
       SWITCH_SYNTH_STATE(prevstate);
       guiNotifySampleCleared(ch);
       if (SS_DEBUG) {
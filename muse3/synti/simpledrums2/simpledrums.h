@@ -32,6 +32,7 @@
 #include "common_defs.h"
 #include "mpevent.h"   
 #include "simpledrumsgui.h"
+#include "sssample.h"
 #include "libsimpleplugin/simpler_plugin.h"
 
 #define SS_NO_SAMPLE       0
@@ -71,19 +72,6 @@ struct SS_SendFx
    int            nrofparameters;
 };
 
-struct SS_Sample
-{
-   SS_Sample() { data = 0; }
-   float*      data;
-   int         samplerate;
-   //int         bits;
-   std::string filename;
-   long        samples;
-   long        frames;
-   int         channels;
-   //SF_INFO     sfinfo;
-};
-
 enum SS_ChannelRoute
 {
    SS_CHN_ROUTE_MIX = 0,
@@ -95,8 +83,9 @@ struct SS_Channel
    SS_ChannelState state;
    const char*     name;
    SS_Sample*      sample;
-   SS_Sample*      originalSample;
-   int             playoffset;
+   // Position in the sample's frames, and how far it moves per output frame.
+   double          playpos;
+   double          playstep;
    bool            noteoff_ignore;
 
    double          volume;
@@ -174,6 +163,7 @@ private:
    void parseInitData(const unsigned char* data);
    void updateVolume(int ch, int in_volume_ctrlval);
    void updatePitch(int ch, int inpitch_ctrlval);
+   void updateStep(int ch);
    void updateBalance(int ch, int pan);
    void guiNotifySampleCleared(int ch);
    void guiUpdateBalance(int ch, int bal);
@@ -200,6 +190,7 @@ private:
    float* sendFxLineOut[SS_NR_OF_SENDEFFECTS][2]; //stereo output (fed into LADSPA inputs),sent from the individual channels -> LADSPA fx
    float* sendFxReturn[SS_NR_OF_SENDEFFECTS][2];  //stereo inputs, from LADSPA plugins, sent from LADSPA -> SS and added to the mix
    double* processBuffer[2];
+   float* renderBuffer[2];
 };
 
 struct SS_SampleLoader
@@ -211,7 +202,6 @@ struct SS_SampleLoader
    int sampleRate;
 };
 
-void resample(SS_Sample *origSmp, SS_Sample* newSample, double pitch, int sample_rate);
 static void* loadSampleThread(void*);
 static pthread_mutex_t SS_LoaderMutex;
 
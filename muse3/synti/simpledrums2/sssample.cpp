@@ -0,0 +1,462 @@
+//
+// C++ Implementation: sssample
+//
+// Description:
+// Streamed samples and the playback interpolator for SimpleDrums
+//
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//
+//
+
+#include "sssample.h"
+#include "common.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+SS_SampleStreamer SS_sampleStreamer;
+
+// Coefficients for each table, phase and tap. Phase SS_INTERP_PHASES
+//  is the next sample's phase zero, so that phases can be interpolated.
+static float interpTables[SS_INTERP_TABLES][SS_INTERP_PHASES + 1][SS_INTERP_TAPS];
+static bool interpTablesReady = false;
+
+static inline uint64_t packFrame(unsigned gen, long frame)
+{
+   return ((uint64_t)gen << 32) | (uint32_t)frame;
+}
+
+//---------------------------------------------------------
+//   initInterpTables
+//    Blackman windowed sinc, normalized to unity gain.
+//---------------------------------------------------------
+
+static void initInterpTables()
+{
+   const int half = SS_INTERP_TAPS / 2;
+   for (int t = 0; t < SS_INTERP_TABLES; t++) {
+      // Table t plays steps up to 2^(t/2). Just under nyquist for the first.
+      const double cutoff = 0.95 / pow(2.0, t * 0.5);
+      for (int ph = 0; ph <= SS_INTERP_PHASES; ph++) {
+         const double frac = (double)ph / SS_INTERP_PHASES;
+         double sum = 0.0;
+         for (int k = 0; k < SS_INTERP_TAPS; k++) {
+            const double x = (k - (half - 1)) - frac;
+            const double sx = M_PI * cutoff * x;
+            const double sinc = fabs(sx) < 1e-9 ? 1.0 : sin(sx) / sx;
+            const double w = 0.42 + 0.5 * cos(M_PI * x / half) + 0.08 * cos(2.0 * M_PI * x / half);
+            const double h = fabs(x) >= half ? 0.0 : sinc * w;
+            interpTables[t][ph][k] = h;
+            sum += h;
+         }
+         for (int k = 0; k < SS_INTERP_TAPS; k++)
+            interpTables[t][ph][k] /= sum;
+      }
+   }
+   interpTablesReady = true;
+}
+
+//---------------------------------------------------------
+//   SS_Sample
+//---------------------------------------------------------
+
+SS_Sample::SS_Sample()
+   : gen(0), filled(0), consumed(0), wakePending(false), retired(false)
+{
+   samplerate = 0;
+   channels = 0;
+   frames = 0;
+   head = 0;
+   headFrames = 0;
+   ring = 0;
+   ringFrames = 0;
+   sf = 0;
+   ioGen = 0;
+   ioPos = 0;
+}
+
+SS_Sample::~SS_Sample()
+{
+   if (sf)
+      sf_close(sf);
+   delete[] head;
+   delete[] ring;
+}
+
+//---------------------------------------------------------
+//   step
+//    A pitch above one plays the sample slower, as when
+//     it was resampled to more frames.
+//---------------------------------------------------------
+
+double SS_Sample::step(double pitch, int sampleRate) const
+{
+   double s = (double)samplerate / ((double)sampleRate * pitch);
+   if (s > SS_MAX_STEP)
+      s = SS_MAX_STEP;
+   return s;
+}
+
+//---------------------------------------------------------
+//   trigger
+//---------------------------------------------------------
+
+void SS_Sample::trigger()
+{
+   if (!isStreamed())
+      return;
+   const unsigned g = gen.load(std::memory_order_relaxed) + 1;
+   // Claim the whole ring before announcing the generation.
+   consumed.store(packFrame(g, 0), std::memory_order_relaxed);
+   gen.store(g, std::memory_order_release);
+   SS_sampleStreamer.wake();
+}
+
+//---------------------------------------------------------
+//   fetch
+//    Copy frames to dst with one or two channels, from the
+//     head or the ring. Frames outside the sample, or not
+//     streamed in yet, are silent.
+//---------------------------------------------------------
+
+void SS_Sample::fetch(long first, long count, float* dst, int outChannels)
+{
+   const unsigned g = gen.load(std::memory_order_relaxed);
+   long avail = headFrames;
+   if (isStreamed()) {
+      const uint64_t f = filled.load(std::memory_order_acquire);
+      if ((unsigned)(f >> 32) == g)
+         avail = (long)(uint32_t)f;
+   }
+   const int step = channels;
+   const int right = channels > 1 ? 1 : 0;
+
+   long idx = first;
+   const long end = first + count;
+   while (idx < end) {
+      long n;
+      const float* src;
+      if (idx < 0 || idx >= avail) {
+         // Before the start, past the end, or an underrun.
+         n = idx < 0 ? (end < 0 ? end : 0) - idx : end - idx;
+         memset(dst, 0, n * outChannels * sizeof(float));
+         dst += n * outChannels;
+         idx += n;
+         if (SS_DEBUG && idx > avail && avail < frames)
+            fprintf(stderr, "SS_Sample::fetch: underrun in %s\n", filename.c_str());
+         continue;
+      }
+      if (idx < headFrames) {
+         n = (end < headFrames ? end : headFrames) - idx;
+         src = head + idx * step;
+      }
+      else {
+         const long slot = (idx - headFrames) % ringFrames;
+         n = ringFrames - slot;
+         if (n > end - idx)
+            n = end - idx;
+         if (n > avail - idx)
+            n = avail - idx;
+         src = ring + slot * step;
+      }
+      if (outChannels == 1) {
+         for (long i = 0; i < n; i++)
+            dst[i] = src[i * step];
+      }
+      else {
+         for (long i = 0; i < n; i++) {
+            dst[i * 2]     = src[i * step];
+            dst[i * 2 + 1] = src[i * step + right];
+         }
+      }
+      dst += n * outChannels;
+      idx += n;
+   }
+}
+
+//---------------------------------------------------------
+//   render
+//---------------------------------------------------------
+
+int SS_Sample::render(double& pos, double step, float* left, float* right, int n)
+{
+   const int half = SS_INTERP_TAPS / 2;
+   const int outChannels = channels > 1 ? 2 : 1;
+   int table = 0;
+   if (step > 1.0) {
+      table = (int)ceil(2.0 * log2(step));
+      if (table >= SS_INTERP_TABLES)
+         table = SS_INTERP_TABLES - 1;
+   }
+   const float (*coeffs)[SS_INTERP_TAPS] = interpTables[table];
+   // Playing at the sample's own rate needs no interpolation, as long as it stays on whole frames.
+   const bool direct = step == 1.0 && pos == floor(pos);
+
+   float window[(long(SS_RENDER_CHUNK * SS_MAX_STEP) + SS_INTERP_TAPS + 2) * 2];
+
+   int done = 0;
+   while (done < n) {
+      if (pos >= frames)
+         break;
+      int chunk = n - done;
+      if (chunk > SS_RENDER_CHUNK)
+         chunk = SS_RENDER_CHUNK;
+      // Don't render past the end of the sample.
+      const double remaining = ceil((frames - pos) / step);
+      if (chunk > remaining)
+         chunk = (int)remaining;
+
+      const long first = (long)floor(pos) - (half - 1);
+      const long last = (long)floor(pos + (chunk - 1) * step) + half;
+      fetch(first, last - first + 1, window, outChannels);
+
+      float* l = left + done;
+      float* r = right + done;
+      if (direct) {
+         const float* x = window + (half - 1) * outChannels;
+         if (outChannels == 1) {
+            for (int i = 0; i < chunk; i++)
+               l[i] = r[i] = x[i];
+         }
+         else {
+            for (int i = 0; i < chunk; i++) {
+               l[i] = x[i * 2];
+               r[i] = x[i * 2 + 1];
+            }
+         }
+         pos += chunk;
+      }
+      else {
+         double p = pos - first;
+         for (int i = 0; i < chunk; i++) {
+            const long ip = (long)p;
+            const float fp = (float)(p - ip) * SS_INTERP_PHASES;
+            const int ph = (int)fp;
+            const float f = fp - ph;
+            const float* c0 = coeffs[ph];
+            const float* c1 = coeffs[ph + 1];
+            const float* x = window + (ip - (half - 1)) * outChannels;
+            if (outChannels == 1) {
+               float s = 0.0f;
+               for (int k = 0; k < SS_INTERP_TAPS; k++)
+                  s += x[k] * (c0[k] + f * (c1[k] - c0[k]));
+               l[i] = r[i] = s;
+            }
+            else {
+               float sl = 0.0f;
+               float sr = 0.0f;
+               for (int k = 0; k < SS_INTERP_TAPS; k++) {
+                  const float c = c0[k] + f * (c1[k] - c0[k]);
+                  sl += x[k * 2] * c;
+                  sr += x[k * 2 + 1] * c;
+               }
+               l[i] = sl;
+               r[i] = sr;
+            }
+            p += step;
+         }
+         pos += chunk * step;
+      }
+      done += chunk;
+
+      if (isStreamed()) {
+         const unsigned g = gen.load(std::memory_order_relaxed);
+         const long low = (long)floor(pos) - (half - 1);
+         consumed.store(packFrame(g, low < 0 ? 0 : low), std::memory_order_release);
+         // Wake the streamer once the ring is half empty.
+         const uint64_t f = filled.load(std::memory_order_relaxed);
+         const long avail = (unsigned)(f >> 32) == g ? (long)(uint32_t)f : headFrames;
+         if (avail < frames && avail - low < ringFrames / 2 && !wakePending.exchange(true))
+            SS_sampleStreamer.wake();
+      }
+   }
+   return done;
+}
+
+//---------------------------------------------------------
+//   SS_SampleStreamer
+//---------------------------------------------------------
+
+SS_SampleStreamer::SS_SampleStreamer()
+{
+   _users = 0;
+   _quit = false;
+   sem_init(&_sem, 0, 0);
+   pthread_mutex_init(&_lock, 0);
+}
+
+SS_SampleStreamer::~SS_SampleStreamer()
+{
+   sem_destroy(&_sem);
+   pthread_mutex_destroy(&_lock);
+}
+
+//---------------------------------------------------------
+//   attach
+//---------------------------------------------------------
+
+void SS_SampleStreamer::attach()
+{
+   if (!interpTablesReady)
+      initInterpTables();
+   if (_users++ > 0)
+      return;
+   _quit = false;
+   if (pthread_create(&_thread, 0, threadFunc, this)) {
+      perror("SS_SampleStreamer: creating thread failed:");
+      _users = 0;
+   }
+}
+
+//---------------------------------------------------------
+//   detach
+//---------------------------------------------------------
+
+void SS_SampleStreamer::detach()
+{
+   if (_users <= 0 || --_users > 0)
+      return;
+   _quit = true;
+   sem_post(&_sem);
+   pthread_join(_thread, 0);
+   for (std::list<SS_Sample*>::iterator i = _samples.begin(); i != _samples.end(); ++i)
+      delete *i;
+   _samples.clear();
+}
+
+//---------------------------------------------------------
+//   add
+//---------------------------------------------------------
+
+void SS_SampleStreamer::add(SS_Sample* s)
+{
+   s->ioPos = s->headFrames;
+   s->filled.store(packFrame(s->gen.load(), s->headFrames), std::memory_order_release);
+   pthread_mutex_lock(&_lock);
+   _samples.push_back(s);
+   pthread_mutex_unlock(&_lock);
+   // Start filling the ring, so that the first note finds it ready.
+   sem_post(&_sem);
+}
+
+//---------------------------------------------------------
+//   retire
+//---------------------------------------------------------
+
+void SS_SampleStreamer::retire(SS_Sample* s)
+{
+   if (!s)
+      return;
+   s->retired.store(true, std::memory_order_release);
+   sem_post(&_sem);
+}
+
+//---------------------------------------------------------
+//   wake
+//---------------------------------------------------------
+
+void SS_SampleStreamer::wake()
+{
+   sem_post(&_sem);
+}
+
+void* SS_SampleStreamer::threadFunc(void* p)
+{
+   ((SS_SampleStreamer*)p)->run();
+   return 0;
+}
+
+//---------------------------------------------------------
+//   run
+//---------------------------------------------------------
+
+void SS_SampleStreamer::run()
+{
+   while (!_quit) {
+      sem_wait(&_sem);
+      if (_quit)
+         break;
+      pthread_mutex_lock(&_lock);
+      for (std::list<SS_Sample*>::iterator i = _samples.begin(); i != _samples.end(); ) {
+         SS_Sample* s = *i;
+         if (s->retired.load(std::memory_order_acquire)) {
+            delete s;
+            i = _samples.erase(i);
+            continue;
+         }
+         if (s->isStreamed())
+            service(s);
+         ++i;
+      }
+      pthread_mutex_unlock(&_lock);
+   }
+}
+
+//---------------------------------------------------------
+//   service
+//    Read ahead as far as the ring allows.
+//---------------------------------------------------------
+
+void SS_SampleStreamer::service(SS_Sample* s)
+{
+   s->wakePending.store(false, std::memory_order_relaxed);
+   float buf[SS_STREAM_READ_FRAMES * 2];
+   const int maxRead = (SS_STREAM_READ_FRAMES * 2) / s->channels;
+
+   for (;;) {
+      const unsigned g = s->gen.load(std::memory_order_acquire);
+      if (g != s->ioGen) {
+         // Retriggered. If the ring never wrapped it still holds the frames after the head.
+         s->ioGen = g;
+         if (s->ioPos - s->headFrames > s->ringFrames)
+            s->ioPos = s->headFrames;
+         s->filled.store(packFrame(g, s->ioPos), std::memory_order_release);
+      }
+
+      const uint64_t c = s->consumed.load(std::memory_order_acquire);
+      long low = (unsigned)(c >> 32) == g ? (long)(uint32_t)c : 0;
+      if (low < s->headFrames)
+         low = s->headFrames;
+      long n = s->ringFrames - (s->ioPos - low);
+      if (n > s->frames - s->ioPos)
+         n = s->frames - s->ioPos;
+      if (n > maxRead)
+         n = maxRead;
+      if (n <= 0)
+         return;
+
+      if (sf_seek(s->sf, s->ioPos, SEEK_SET) < 0)
+         return;
+      const long got = sf_readf_float(s->sf, buf, n);
+      if (got <= 0) {
+         fprintf(stderr, "SS_SampleStreamer: error reading %s\n", s->filename.c_str());
+         return;
+      }
+      long idx = 0;
+      while (idx < got) {
+         const long slot = (s->ioPos + idx - s->headFrames) % s->ringFrames;
+         long m = s->ringFrames - slot;
+         if (m > got - idx)
+            m = got - idx;
+         memcpy(s->ring + slot * s->channels, buf + idx * s->channels, m * s->channels * sizeof(float));
+         idx += m;
+      }
+      s->ioPos += got;
+      s->filled.store(packFrame(g, s->ioPos), std::memory_order_release);
+   }
+}
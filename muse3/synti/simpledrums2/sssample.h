@@ -0,0 +1,147 @@
+//
+// C++ Interface: sssample
+//
+// Description:
+// Streamed samples and the playback interpolator for SimpleDrums
+//
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//
+//
+#ifndef __MUSE_SSSAMPLE_H__
+#define __MUSE_SSSAMPLE_H__
+
+#include <sndfile.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdint.h>
+#include <atomic>
+#include <list>
+#include <string>
+
+// Windowed sinc interpolator. Taps must be even.
+#define SS_INTERP_TAPS         16
+#define SS_INTERP_PHASES      128
+// One table per half octave of playback step, the higher ones
+//  with a lower cutoff against aliasing.
+#define SS_INTERP_TABLES        7
+#define SS_MAX_STEP           8.0
+
+// Frames of each sample kept in memory. Samples not much longer are kept whole.
+#define SS_STREAM_HEAD_FRAMES  16384
+// Frames of the streamed rest buffered ahead of the playing position.
+#define SS_STREAM_RING_FRAMES  65536
+// Frames read from disk at a time.
+#define SS_STREAM_READ_FRAMES   4096
+// Frames interpolated at a time.
+#define SS_RENDER_CHUNK           64
+
+//---------------------------------------------------------
+//   SS_Sample
+//    The head of the sample is loaded with it. The rest is
+//     read from the file by the streamer thread into a ring
+//     buffer, from where the audio thread plays it.
+//    Pitch is applied while playing, by stepping through the
+//     sample at a rate other than one.
+//---------------------------------------------------------
+
+struct SS_Sample
+{
+   SS_Sample();
+   ~SS_Sample();
+
+   std::string filename;
+   int         samplerate;
+   int         channels;
+   long        frames;
+
+   // The first frames, interleaved. All of them if the sample is not streamed.
+   float*      head;
+   long        headFrames;
+
+   // Frame headFrames + i goes to slot i % ringFrames. Null if not streamed.
+   float*      ring;
+   long        ringFrames;
+   // Streamer thread only, once added to it.
+   SNDFILE*    sf;
+   unsigned    ioGen;
+   long        ioPos;
+
+   // Bumped by the audio thread on each trigger, so the streamer
+   //  knows where to read from.
+   std::atomic<unsigned> gen;
+   // Generation in the high and frame in the low 32 bits:
+   // Frames up to which the ring holds data. Written by the streamer.
+   std::atomic<uint64_t> filled;
+   // Lowest frame the audio thread still needs. Written by the audio thread.
+   std::atomic<uint64_t> consumed;
+   std::atomic<bool> wakePending;
+   std::atomic<bool> retired;
+
+   bool isStreamed() const { return ring != 0; }
+   // Playback step for the pitch, at the given output rate.
+   double step(double pitch, int sampleRate) const;
+
+   // Audio thread. Restarts the stream from the end of the head.
+   void trigger();
+   // Audio thread. Renders up to n frames from pos on, advancing it by step.
+   // Mono samples are rendered to both sides. Returns the number of frames
+   //  rendered, less than n if the sample ended.
+   int render(double& pos, double step, float* left, float* right, int n);
+
+private:
+   void fetch(long first, long count, float* dst, int outChannels);
+};
+
+//---------------------------------------------------------
+//   SS_SampleStreamer
+//    One disk thread shared by all SimpleDrums instances.
+//    It also deletes samples, once retired, since it is the
+//     only thread which can tell when it is done with them.
+//---------------------------------------------------------
+
+class SS_SampleStreamer
+{
+   pthread_t _thread;
+   sem_t _sem;
+   pthread_mutex_t _lock;
+   std::list<SS_Sample*> _samples;
+   int _users;
+   volatile bool _quit;
+
+   static void* threadFunc(void*);
+   void run();
+   void service(SS_Sample* s);
+
+public:
+   SS_SampleStreamer();
+   ~SS_SampleStreamer();
+
+   // Gui thread. Each synth instance attaches while it exists.
+   void attach();
+   void detach();
+
+   // Loader thread. Takes over the sample and starts filling its ring.
+   void add(SS_Sample* s);
+   // Any thread. The sample must not be touched afterwards.
+   void retire(SS_Sample* s);
+   // Any thread, realtime safe.
+   void wake();
+};
+
+extern SS_SampleStreamer SS_sampleStreamer;
+
+#endif
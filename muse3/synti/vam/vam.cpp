@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include <list>
+#include <algorithm>
 
 #include "muse_math.h"
 #include "libsynti/mess.h"
@@ -38,6 +39,7 @@
 #include "vam.h"
 #include "vamgui.h"
 #include "libsynti/mono.h"
+#include "libsynti/wavetable.h"
 
 std::string VAM_configPath;
 
@@ -160,6 +162,8 @@ class VAM : public MessMono {
       static int useCount;
       static const int CB_AMP_SIZE = 961;
       static const int LIN2EXP_SIZE = 256;
+      static const int TABLE_SIZE = 4096;
+      static const int BLOCK_SIZE = 64;
 
       static double cb2amp_tab[CB_AMP_SIZE];
       static double cb2amp(double cb);
@@ -167,7 +171,7 @@ class VAM : public MessMono {
       static float lin2exp[LIN2EXP_SIZE];
 
             /*	Synthvariables */
-      static float *sin_tbl, *tri_tbl, *saw_tbl, *squ_tbl;
+      static Wavetable *sin_tbl, *tri_tbl, *saw_tbl, *squ_tbl;
       bool isOn;
       int pitch, channel;
       float velocity;
@@ -193,8 +197,9 @@ class VAM : public MessMono {
       int controller[NUM_CONTROLLER];
       void noteoff(int channel, int pitch);
       void setController(int ctrl, int data);
-      float *wave_tbl(int wave);
-      double lowpass_filter(double cutoff, double resonance, double input, LPFilter *f);
+      Wavetable* wave_tbl(int wave);
+      const float* osc_tbl(const Oscillator& osc, float pw, float lfo);
+      void lowpass_filter(const double* cutoff, double resonance, float* buf, int n, LPFilter* f);
 
 
       VAMGui* gui;
@@ -219,10 +224,10 @@ class VAM : public MessMono {
       bool init(const char* name);
 };
 
-float* VAM::sin_tbl;
-float* VAM::tri_tbl;
-float* VAM::saw_tbl;
-float* VAM::squ_tbl;
+Wavetable* VAM::sin_tbl;
+Wavetable* VAM::tri_tbl;
+Wavetable* VAM::saw_tbl;
+Wavetable* VAM::squ_tbl;
 int VAM::useCount = 0;
 double VAM::cb2amp_tab[VAM::CB_AMP_SIZE];
 float VAM::lin2exp[VAM::LIN2EXP_SIZE];
@@ -252,10 +257,10 @@ VAM::~VAM()
       delete [] idata;   // p4.0.27
       --useCount;
       if (useCount == 0) {
-          delete[] sin_tbl;
-          delete[] tri_tbl;
-          delete[] saw_tbl;
-          delete[] squ_tbl;
+          delete sin_tbl;
+          delete tri_tbl;
+          delete saw_tbl;
+          delete squ_tbl;
           }
       }
 
@@ -279,32 +284,41 @@ double VAM::cb2amp(double cb)
       return cb2amp_tab[int(cb)];
       }
 
-double VAM::lowpass_filter(double cutoff, double resonance, double input, LPFilter *f)
-      {
-      double output;
-      cutoff *= 1.16;
-
-      input -= f->out[3] * (resonance * 4.0) * (1.0 - 0.15 * cutoff * cutoff);
-      input *= 0.35013 * cutoff * cutoff * cutoff * cutoff;
-
-      f->out[0] = input + 0.3 * f->in[0] + (1.0 - cutoff) * f->out[0]; // Pole 1
-      f->in[0]  = input;
-      f->out[1] = f->out[0] + 0.3 * f->in[1] + (1.0 - cutoff) * f->out[1];  // Pole 2
-      f->in[1]  = f->out[0];
-      f->out[2] = f->out[1] + 0.3 * f->in[2] + (1.0 - cutoff) * f->out[2];  // Pole 3
-      f->in[2]  = f->out[1];
-      f->out[3] = f->out[2] + 0.3 * f->in[3] + (1.0 - cutoff) * f->out[3];  // Pole 4
-      f->in[3]  = f->out[2];
-
-      //	if(f.out[3] > 1.0) f.out[3] = 1.0;
-
-      output = f->out[3];
-
+//---------------------------------------------------------
+//   lowpass_filter
+//    Four pole lowpass. Filters n samples in place, each
+//     with its own cutoff. The state is kept in locals
+//     while filtering the block.
+//---------------------------------------------------------
 
-      return output;
+void VAM::lowpass_filter(const double* cutoff, double resonance, float* buf, int n, LPFilter* f)
+      {
+      double out0 = f->out[0], out1 = f->out[1], out2 = f->out[2], out3 = f->out[3];
+      double in0  = f->in[0],  in1  = f->in[1],  in2  = f->in[2],  in3  = f->in[3];
+      for (int i = 0; i < n; ++i) {
+            double c = cutoff[i] * 1.16;
+            double input = buf[i];
+            input -= out3 * (resonance * 4.0) * (1.0 - 0.15 * c * c);
+            input *= 0.35013 * c * c * c * c;
+            double o0 = input + 0.3 * in0 + (1.0 - c) * out0;  // Pole 1
+            double o1 = o0 + 0.3 * in1 + (1.0 - c) * out1;     // Pole 2
+            double o2 = o1 + 0.3 * in2 + (1.0 - c) * out2;     // Pole 3
+            double o3 = o2 + 0.3 * in3 + (1.0 - c) * out3;     // Pole 4
+            in0 = input;
+            in1 = o0;
+            in2 = o1;
+            in3 = o2;
+            out0 = o0;
+            out1 = o1;
+            out2 = o2;
+            out3 = o3;
+            buf[i] = o3;
+            }
+      f->out[0] = out0; f->out[1] = out1; f->out[2] = out2; f->out[3] = out3;
+      f->in[0]  = in0;  f->in[1]  = in1;  f->in[2]  = in2;  f->in[3]  = in3;
       }
 
-float *VAM::wave_tbl(int wave)
+Wavetable* VAM::wave_tbl(int wave)
       {
               if (wave == 0) {
                       return sin_tbl;
@@ -321,6 +335,40 @@ float *VAM::wave_tbl(int wave)
       return sin_tbl;
       }
 
+//---------------------------------------------------------
+//   osc_tbl
+//    The level of the oscillator's table for its pitch.
+//    The first part of the cycle is squeezed by the pulse
+//     width pw, raising its pitch; the second part is
+//     stretched and needs no more than the plain pitch, so
+//     it is read with pw 0. lfo is the largest lfo magnitude
+//     seen in the block, for the frequency modulation.
+//---------------------------------------------------------
+
+const float* VAM::osc_tbl(const Oscillator& osc, float pw, float lfo)
+      {
+      Wavetable* tbl = wave_tbl(osc.waveform);
+      pw = LIMIT(pw, 0.0, 0.99);
+      double cps = (fabs(osc.freq) + fabs(osc.fm) * lfo * 1500.0) / sampleRate() / (1.0 - pw);
+      int k = tbl->levelFor(cps);
+      return tbl->level(k < 0 ? tbl->levels() - 1 : k);
+      }
+
+//---------------------------------------------------------
+//   table_read
+//    Linear interpolation, phase is in samples of a
+//     sample rate long cycle.
+//---------------------------------------------------------
+
+static inline float table_read(const float* tbl, float phase, float scale, int mask)
+      {
+      float x = phase * scale;
+      int i = int(x);
+      float frac = x - i;
+      i &= mask;
+      return tbl[i] + (tbl[i + 1] - tbl[i]) * frac;
+      }
+
 //---------------------------------------------------------
 //   init
 //---------------------------------------------------------
@@ -342,50 +390,37 @@ bool VAM::init(const char* name)
               tmp = i/255.0;
               lin2exp[i] = 1.5 * tmp * tmp * tmp - 0.69 * tmp * tmp + 0.16 * tmp;
               }
-          int sr = sampleRate();
-          /* Build up denormalised oscilator wavetables, these are sample_rate
-             long, costs more RAM to create them but makes frequency calcs much
-             cheaper, and means that interpolation isn't that necessary, esp if
-             you use integer frequencies */
-          
-          float *tmp_tbl = new float[sr];
-          const int lag = sr/50;
-          sin_tbl = new float[sr];
-          for (i = 0; i < sr; i++) {
-                tmp = sin(i * 2.0 * PI / sr);
-                sin_tbl[i] = DENORMALISE(tmp);
-                }
-          tri_tbl = new float[sr];
-          for (i = 0; i < sr; i++) {
-                tmp = acos(cos(i * 2.0 * PI / sr)) / PI * 2.0 - 1.0;
-                tri_tbl[i] = DENORMALISE(tmp);
+          /* Build up the oscillator wavetables from their harmonics, with
+             fewer of them on each level, so that the oscillators can play
+             without aliasing whatever their pitch. */
+          const int harmonics = 1024;
+          double* coeffs = new double[harmonics];
+          for (i = 0; i < harmonics; i++)
+                coeffs[i] = 0.0;
+          coeffs[0] = 1.0;
+          sin_tbl = new Wavetable(TABLE_SIZE, 1, coeffs, 0);
+          // Triangle, from -1 up to 1 at half the cycle.
+          for (i = 1; i <= harmonics; i += 2)
+                coeffs[i - 1] = -8.0 / (PI * PI * i * i);
+          tri_tbl = new Wavetable(TABLE_SIZE, harmonics, 0, coeffs);
+          // Square, -1 for the first half of the cycle, rising to 0 over
+          //  1/25 of it in the middle before going up to 1, and saw, rising
+          //  from -1 to 1. Both softened by averaging each point with
+          //  those 1/50 of a cycle before and after it.
+          const double ramp = 2.0 * PI / 50.0;
+          double* cos_coeffs = new double[harmonics];
+          for (i = 1; i <= harmonics; i++) {
+                double sign = i & 1 ? -1.0 : 1.0;
+                double soft = cos(i * ramp) / (PI * i);
+                coeffs[i - 1]     = (sign * (sin(i * ramp) / (i * ramp) + cos(i * ramp)) - 2.0) * soft;
+                cos_coeffs[i - 1] = -sign * sin(i * ramp) * soft;
                 }
-          squ_tbl = new float[sr];
-          for (i = 0; i < sr/2; i++) {
-                tmp_tbl[i] = -1.0f;
-                }
-          for (i = sr/2; i < sr; i++) {
-                tmp_tbl[i] = +1.0f;
-                }
-          tmp = -1.0f;
-          for (i = (sr/2)-lag; i < (sr/2)+lag; i++) {
-                tmp_tbl[i] = tmp;
-                tmp += 1.0/(lag * 2.0);
-                }
-          for (i = 0; i < sr; i++) {
-                squ_tbl[i] = (tmp_tbl[MOD(i-lag, sr)] +
-                tmp_tbl[MOD(i+lag, sr)]) * 0.5;
-                }
-          saw_tbl = new float[sr];
-          for (i = 0; i < sr; i++) {
-                tmp = ((2.0 * i) - (float)sr) / (float)sr;
-                tmp_tbl[i] = DENORMALISE(tmp);
-                }
-          for (i = 0; i < sr; i++) {
-                saw_tbl[i] = (tmp_tbl[MOD(i-lag, sr)] +
-                tmp_tbl[MOD(i+lag, sr)]) * 0.5;
-                }
-          delete[] tmp_tbl;
+          squ_tbl = new Wavetable(TABLE_SIZE, harmonics, coeffs, cos_coeffs);
+          delete[] cos_coeffs;
+          for (i = 1; i <= harmonics; i++)
+                coeffs[i - 1] = -2.0 / (PI * i) * cos(i * ramp);
+          saw_tbl = new Wavetable(TABLE_SIZE, harmonics, coeffs, 0);
+          delete[] coeffs;
           }
       
       dco1_filter.out[0] = dco1_filter.out[1] = dco1_filter.out[2] = dco1_filter.out[3] = 0.0;
@@ -498,75 +533,117 @@ void VAM::process(unsigned /*pos*/, float** ports, int offset, int sampleCount)
       if (!isOn)
             return;
 
-      float sample, osc, lfol, *dco1_tbl, *dco2_tbl, *lfo_tbl, pw;
+      float osc1[BLOCK_SIZE], osc2[BLOCK_SIZE];
+      float gain1[BLOCK_SIZE], gain2[BLOCK_SIZE];
+      double fcut[BLOCK_SIZE];
+      float sample, osc, lfol, pw;
       float cutoff;
       int sr = sampleRate();
-      
-      dco1_tbl = wave_tbl(dco1.waveform);
-      dco2_tbl = wave_tbl(dco2.waveform);
-      lfo_tbl = wave_tbl(lfo.waveform);
+      const float scale = float(TABLE_SIZE) / sr;
+      const int mask = TABLE_SIZE - 1;
+
+      const float* lfo_tbl = wave_tbl(lfo.waveform)->level(0);
       
       cutoff = filt_keytrack ? (dco1.freq /500.0 + filt_cutoff)/2 : filt_cutoff;
       cutoff = LIMIT(cutoff, 0.0, 1.0);
       
-      for (int i = 0; i < sampleCount; i++) {
-            if(!(dco1_env.step() + dco2_env.step())) {
-                  isOn = false;
-                  break;
+      for (int pos = 0; pos < sampleCount; pos += BLOCK_SIZE) {
+            int n = sampleCount - pos;
+            if (n > BLOCK_SIZE)
+                  n = BLOCK_SIZE;
+            // The lfo's range over the block picks the table levels,
+            //  so only the part of the cycle the pulse width really
+            //  squeezes is read from a duller table.
+            float lfo_min = 0.0, lfo_max = 0.0;
+            float lfo_phase = lfo.phase;
+            for (int i = 0; i < n; i++) {
+                  lfol = table_read(lfo_tbl, lfo_phase, scale, mask);
+                  if (i == 0 || lfol < lfo_min)
+                        lfo_min = lfol;
+                  if (i == 0 || lfol > lfo_max)
+                        lfo_max = lfol;
+                  lfo_phase += lfo.freq * 50.0;
+                  while(lfo_phase > sr)
+                        lfo_phase -= sr;
+                  while(lfo_phase < 0.0)
+                        lfo_phase += sr;
                   }
-            filt_env.step();
-
-            /* DCO 1 */
-            lfol = lfo_tbl[(int)lfo.phase];
-            pw = dco1.pw + dco1.pwm * lfol * 0.5;
-            pw = LIMIT(pw, 0.0, 1.0);
-            if(dco1.phase < sr/2 * ( 1.0 - pw))
-                  osc = dco1_tbl[int(dco1.phase / (1.0 - pw))];
-            else
-                  osc = dco1_tbl[int(dco1.phase / (1.0 + pw))];
-            lfol = lfo_tbl[(int)lfo.phase];
-            dco1.phase += dco1.freq + dco1.fm * lfol * 1500.0;
-            lfo.phase += lfo.freq * 50.0;
-            if(!filt_invert)
-                  sample = lowpass_filter((cb2amp(960.0 * (1.0 - filt_env_mod * filt_env.env))
-                        + 1.0 - filt_env_mod) * cutoff,
-                        filt_res, osc, &dco1_filter) * cb2amp(960.0 * (1.0 - dco1_env.env));
-            else 
-                  sample = lowpass_filter((cb2amp(960.0 * (1.0 - filt_env_mod * (1.0 - filt_env.env)))
-                        + 1.0 - filt_env_mod) * cutoff,
-                        filt_res, osc, &dco1_filter) * cb2amp(960.0 * (1.0 - dco1_env.env));
-            while(dco1.phase > sr) 
-                  dco1.phase -= sr;
-            while(dco1.phase < 0.0) 
-                  dco1.phase += sr;
-      
-            /* DCO 2 */
-            if(dco2.on) {
-                  pw = dco2.pw + dco2.pwm * lfol * 0.5;
+            const float lfo_abs = std::max(fabs(lfo_min), fabs(lfo_max));
+            const float* dco1_tbl = osc_tbl(dco1, dco1.pw + 0.5 * std::max(dco1.pwm * lfo_min, dco1.pwm * lfo_max), lfo_abs);
+            const float* dco1_tbl2 = osc_tbl(dco1, 0.0, lfo_abs);
+            const float* dco2_tbl = osc_tbl(dco2, dco2.pw + 0.5 * std::max(dco2.pwm * lfo_min, dco2.pwm * lfo_max), lfo_abs);
+            const float* dco2_tbl2 = osc_tbl(dco2, 0.0, lfo_abs);
+
+            // Envelopes, lfo and oscillators.
+            int len = n;
+            for (int i = 0; i < n; i++) {
+                  if(!(dco1_env.step() + dco2_env.step())) {
+                        isOn = false;
+                        len = i;
+                        break;
+                        }
+                  filt_env.step();
+                  if(!filt_invert)
+                        fcut[i] = (cb2amp(960.0 * (1.0 - filt_env_mod * filt_env.env))
+                              + 1.0 - filt_env_mod) * cutoff;
+                  else
+                        fcut[i] = (cb2amp(960.0 * (1.0 - filt_env_mod * (1.0 - filt_env.env)))
+                              + 1.0 - filt_env_mod) * cutoff;
+
+                  /* DCO 1 */
+                  lfol = table_read(lfo_tbl, lfo.phase, scale, mask);
+                  pw = dco1.pw + dco1.pwm * lfol * 0.5;
                   pw = LIMIT(pw, 0.0, 1.0);
-                  if(dco2.phase < sr/2 * (1 - pw))
-                      osc = dco2_tbl[int(dco2.phase / (1.0 - pw))];
+                  if(dco1.phase < sr/2 * ( 1.0 - pw))
+                        osc = table_read(dco1_tbl, dco1.phase / (1.0 - pw), scale, mask);
                   else
-                      osc = dco2_tbl[int(dco2.phase / (1.0 + pw))];
-                  dco2.phase += dco2.freq + dco2.fm * lfol * 1500.0;
-                  if(!filt_invert)
-                  sample += lowpass_filter((cb2amp(960.0 * (1.0 - filt_env_mod * filt_env.env)) + 1.0 - filt_env_mod) * cutoff,
-                      filt_res, osc, &dco2_filter) * cb2amp(960.0 * (1.0 - dco2_env.env));
-                  else sample += lowpass_filter((cb2amp(960.0 * (1.0 - filt_env_mod * (1.0 - filt_env.env))) + 1.0 - filt_env_mod) 
-                      * cutoff, filt_res, osc, &dco2_filter) * cb2amp(960.0 * (1.0 - dco2_env.env));
-      
-                  while (dco2.phase > sr)  dco2.phase -= sr;
-                  while (dco2.phase < 0.0) dco2.phase += sr;
+                        osc = table_read(dco1_tbl2, dco1.phase / (1.0 + pw), scale, mask);
+                  osc1[i]  = osc;
+                  gain1[i] = cb2amp(960.0 * (1.0 - dco1_env.env));
+                  dco1.phase += dco1.freq + dco1.fm * lfol * 1500.0;
+                  lfo.phase += lfo.freq * 50.0;
+                  while(dco1.phase > sr) 
+                        dco1.phase -= sr;
+                  while(dco1.phase < 0.0) 
+                        dco1.phase += sr;
+            
+                  /* DCO 2 */
+                  if(dco2.on) {
+                        pw = dco2.pw + dco2.pwm * lfol * 0.5;
+                        pw = LIMIT(pw, 0.0, 1.0);
+                        if(dco2.phase < sr/2 * (1 - pw))
+                            osc = table_read(dco2_tbl, dco2.phase / (1.0 - pw), scale, mask);
+                        else
+                            osc = table_read(dco2_tbl2, dco2.phase / (1.0 + pw), scale, mask);
+                        osc2[i]  = osc;
+                        gain2[i] = cb2amp(960.0 * (1.0 - dco2_env.env));
+                        dco2.phase += dco2.freq + dco2.fm * lfol * 1500.0;
+                        while (dco2.phase > sr)  dco2.phase -= sr;
+                        while (dco2.phase < 0.0) dco2.phase += sr;
+                        }
+                  while(lfo.phase > sr)
+                        lfo.phase -= sr;
+                  while(lfo.phase < 0.0)
+                        lfo.phase += sr;
                   }
-            while(lfo.phase > sr)
-                  lfo.phase -= sr;
-            while(lfo.phase < 0.0)
-                  lfo.phase += sr;
-            sample *= velocity * 0.5;
-            sample = LIMIT(sample, -1.0, 1.0);
-      
-            //if(sample > 1.0) fprintf(stderr, "oooops %f\n", sample);
-            buffer[i] = sample;
+
+            // Filters.
+            lowpass_filter(fcut, filt_res, osc1, len, &dco1_filter);
+            if(dco2.on)
+                  lowpass_filter(fcut, filt_res, osc2, len, &dco2_filter);
+            float* out = buffer + pos;
+            for (int i = 0; i < len; i++) {
+                  sample = osc1[i] * gain1[i];
+                  if(dco2.on)
+                        sample += osc2[i] * gain2[i];
+                  sample *= velocity * 0.5;
+                  sample = LIMIT(sample, -1.0, 1.0);
+            
+                  //if(sample > 1.0) fprintf(stderr, "oooops %f\n", sample);
+                  out[i] = sample;
+                  }
+            if (!isOn)
+                  break;
             }
       }
 